@@ -43,11 +43,19 @@ BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, uint32_t
 }
 
 BufferPoolManagerInstance::~BufferPoolManagerInstance() {
+  {
+    std::lock_guard<std::mutex> guard(prefetch_latch_);
+    prefetch_stop_ = true;
+  }
+  prefetch_cv_.notify_all();
+  if (prefetch_thread_.joinable()) {
+    prefetch_thread_.join();
+  }
   delete[] pages_;
   delete replacer_;
 }
 
-// 刷新页面，除非是在 Pinned 状态下
+// 刷新页面, 被 Pinned 的页面同样会写回磁盘, 以便常驻内存的页面也能持久化
 bool BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) {
   // Make sure you call DiskManager::WritePage!
   // return false;
@@ -55,8 +63,9 @@ bool BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) {
   for(size_t i = 0; i < this->pool_size_; i++) {
     Page* P = &this->pages_[i];
     P->RLatch();
-    if(P->GetPageId() == page_id && P->GetPinCount() == 0) {
+    if(P->GetPageId() == page_id) {
       this->disk_manager_->WritePage(page_id, P->GetData());
+      P->is_dirty_ = false;
       this->latch_.unlock();
       P->RUnlatch();
       return true;
@@ -72,11 +81,9 @@ void BufferPoolManagerInstance::FlushAllPgsImp() {
   for(size_t i = 0; i < this->pool_size_; i++) {
     Page* P = &this->pages_[i];
     P->RLatch();
-    if(P->GetPinCount() == 0) {
+    if(P->GetPageId() != INVALID_PAGE_ID) {
       this->disk_manager_->WritePage(P->GetPageId(), P->GetData());
-      this->latch_.unlock();
-      P->RUnlatch();
-      return;
+      P->is_dirty_ = false;
     }
     P->RUnlatch();
   }
@@ -137,8 +144,9 @@ Page *BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) {
   for(size_t i = 0; i < this->pool_size_; i++) {
     Page* P = &this->pages_[i];
     if(P->page_id_ == page_id) {
-      // 找到了内存中对应的物理页，将其固定并返回指针
+      // 找到了内存中对应的物理页，将其固定并返回指针; 预取进来的页面未被 Pin, 需要从 replacer 中移除
       P->pin_count_ += 1;
+      this->replacer_->Pin(i);
       this->latch_.unlock();
       return P;
     }
@@ -180,32 +188,27 @@ bool BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) {
   // 2.   If P exists, but has a non-zero pin-count, return false. Someone is using the page.
   // 3.   Otherwise, P can be deleted. Remove P from the page table, reset its metadata and return it to the free list.
   // return false;
+  // 页表元数据由 latch_ 保护; 不能在持有 latch_ 时获取页面锁, 否则会与持有页面锁并等待 latch_ 的线程死锁
   this->latch_.lock();
   for(size_t i = 0; i < this->pool_size_; i++){
     Page* P = &this->pages_[i];
-    P->WLatch();
     if(P->GetPageId() == page_id){
       if(P->GetPinCount() > 0) {
         // Pin 大于 0，不能直接删除，返回 false
         this->latch_.unlock();
-        P->WUnlatch();
         return false;
-      }else{
-        // 此时页面是 Unpinned 状态, 删除页面并更新物理页面上的元数据
-        // this->DeallocatePage(page_id);
-        this->free_list_.push_back(i);
-        this->replacer_->Unpin(i);
-        P->ResetMemory();
-        P->page_id_ = INVALID_PAGE_ID;
-        P->is_dirty_ = false;
-        P->pin_count_ = 0;
-        // 解锁
-        P->WUnlatch();
-        this->latch_.unlock();
-        return true;
       }
+      // 此时页面是 Unpinned 状态, 删除页面并更新物理页面上的元数据
+      // this->DeallocatePage(page_id);
+      this->free_list_.push_back(i);
+      this->replacer_->Unpin(i);
+      P->ResetMemory();
+      P->page_id_ = INVALID_PAGE_ID;
+      P->is_dirty_ = false;
+      P->pin_count_ = 0;
+      this->latch_.unlock();
+      return true;
     }
-    P->WUnlatch();
   }
   // 没有找到，直接返回true
   this->latch_.unlock();
@@ -220,9 +223,11 @@ bool BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) {
     // P->WLatch();
     if(P->GetPageId() == page_id && P->GetPinCount() > 0) {
       P->pin_count_ -= 1;
+      // 记录页面被 Pinned 期间是否被修改过, 避免中间的 Unpin 丢失脏标记
+      P->is_dirty_ = P->is_dirty_ || is_dirty;
       if(P->pin_count_ == 0) {
         // 获取到对应的 page_id
-        if(is_dirty){
+        if(P->is_dirty_){
           this->disk_manager_->WritePage(page_id, P->GetData());
         }
         this->DeallocatePage(page_id);
@@ -247,6 +252,53 @@ bool BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) {
   return false;
 }
 
+void BufferPoolManagerInstance::PrefetchPgImp(page_id_t page_id) {
+  std::lock_guard<std::mutex> guard(prefetch_latch_);
+  if (prefetch_stop_ || prefetch_queue_.size() >= pool_size_) {
+    return;
+  }
+  if (!prefetch_thread_.joinable()) {
+    prefetch_thread_ = std::thread(&BufferPoolManagerInstance::PrefetchLoop, this);
+  }
+  prefetch_queue_.push_back(page_id);
+  prefetch_cv_.notify_one();
+}
+
+void BufferPoolManagerInstance::PrefetchLoop() {
+  while (true) {
+    page_id_t page_id;
+    {
+      std::unique_lock<std::mutex> lock(prefetch_latch_);
+      prefetch_cv_.wait(lock, [this] { return prefetch_stop_ || !prefetch_queue_.empty(); });
+      if (prefetch_stop_) {
+        return;
+      }
+      page_id = prefetch_queue_.front();
+      prefetch_queue_.pop_front();
+    }
+    std::lock_guard<std::mutex> guard(latch_);
+    bool resident = false;
+    for (size_t i = 0; i < pool_size_ && !resident; i++) {
+      resident = pages_[i].page_id_ == page_id;
+    }
+    // 只使用空闲的帧, 预取不会为了一个提示而驱逐其他页面
+    if (resident || free_list_.empty()) {
+      continue;
+    }
+    frame_id_t frame_id = free_list_.front();
+    free_list_.pop_front();
+    Page *P = &pages_[frame_id];
+    P->WLatch();
+    P->page_id_ = page_id;
+    P->pin_count_ = 0;
+    P->is_dirty_ = false;
+    disk_manager_->ReadPage(page_id, P->GetData());
+    P->WUnlatch();
+    // 页面没有被 Pin, 交给 replacer 管理, 需要帧的时候可以被替换
+    replacer_->Unpin(frame_id);
+  }
+}
+
 // 分配页面，并返回页号
 page_id_t BufferPoolManagerInstance::AllocatePage() {
   const page_id_t next_page_id = next_page_id_;
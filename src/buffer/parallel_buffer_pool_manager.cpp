@@ -116,4 +116,12 @@ void ParallelBufferPoolManager::FlushAllPgsImp() {
   this->latch_.unlock();
 }
 
+void ParallelBufferPoolManager::PrefetchPgImp(page_id_t page_id) {
+  // 预取提示交给负责该页面的 BufferPoolManagerInstance
+  this->latch_.lock();
+  BufferPoolManager* buffer_manager = this->GetBufferPoolManager(page_id);
+  buffer_manager->PrefetchPage(page_id);
+  this->latch_.unlock();
+}
+
 }  // namespace bustub
@@ -10,7 +10,9 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <iostream>
+#include <numeric>
 #include <string>
 #include <utility>
 #include <vector>
@@ -24,26 +26,46 @@ namespace bustub {
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 HASH_TABLE_TYPE::ExtendibleHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
-                                     const KeyComparator &comparator, HashFunction<KeyType> hash_fn)
-    : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {
+                                     const KeyComparator &comparator, HashFunction<KeyType> hash_fn, bool pin_pages)
+    : buffer_pool_manager_(buffer_pool_manager),
+      comparator_(comparator),
+      hash_fn_(std::move(hash_fn)),
+      pin_pages_(pin_pages) {
   //  implement me!
   // 分配页作为 Directory Page
   page_id_t page_id;
   Page* page = this->buffer_pool_manager_->NewPage(&page_id);
-  if(page != nullptr){
-    this->directory_page_id_ = page_id;
-    // 为 Directory Page 设置元数据
-    auto directory_page = reinterpret_cast<HashTableDirectoryPage *>(page->GetData());
-    directory_page->SetLSN(1);
-    directory_page->SetPageId(page_id);
-    // 分配页作为 Bucket Page, 初始的深度为0, 因此只需要分配1页即可
-    page = this->buffer_pool_manager_->NewPage(&page_id);
-    if(page != nullptr){
-      directory_page->SetBucketPageId(0, page_id);
-      directory_page->SetLocalDepth(0,0);
-    }
+  if(page == nullptr){
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "ExtendibleHashTable: no free frame for the directory page");
+  }
+  this->directory_page_id_ = page_id;
+  // 为 Directory Page 设置元数据
+  auto directory_page = reinterpret_cast<HashTableDirectoryPage *>(page->GetData());
+  directory_page->SetLSN(1);
+  directory_page->SetPageId(page_id);
+  // 分配页作为 Bucket Page, 初始的深度为0, 因此只需要分配1页即可
+  if(this->pin_pages_){
+    this->pinned_directory_page_ = directory_page;
   }
+  if(this->NewBucketPage(&page_id) == nullptr){
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "ExtendibleHashTable: no free frame for the first bucket page");
+  }
+  directory_page->SetBucketPageId(0, page_id);
+  directory_page->SetLocalDepth(0,0);
+  this->UnpinBucketPage(page_id, true);
+  this->UnpinDirectoryPage(true);
+}
 
+template <typename KeyType, typename ValueType, typename KeyComparator>
+HASH_TABLE_TYPE::~ExtendibleHashTable() {
+  if(!this->pin_pages_){
+    return;
+  }
+  // 常驻内存模式下释放整个生命周期内持有的 Pin, 页面在 Pin 降为 0 时写回磁盘
+  for(const auto &entry : this->pinned_bucket_pages_){
+    this->buffer_pool_manager_->UnpinPage(entry.first, true);
+  }
+  this->buffer_pool_manager_->UnpinPage(this->directory_page_id_, true);
 }
 
 /*****************************************************************************
@@ -111,6 +133,10 @@ inline uint32_t HASH_TABLE_TYPE::KeyToPageId(KeyType key, HashTableDirectoryPage
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 HashTableDirectoryPage *HASH_TABLE_TYPE::FetchDirectoryPage() {
+  if(this->pin_pages_){
+    // 常驻内存模式下 Directory Page 一直被 Pin 住, 直接返回指针
+    return this->pinned_directory_page_;
+  }
   auto directory_page = reinterpret_cast<HashTableDirectoryPage*>(this->buffer_pool_manager_->FetchPage(this->directory_page_id_)->GetData());
   return directory_page;
 }
@@ -123,28 +149,127 @@ HashTableDirectoryPage *HASH_TABLE_TYPE::FetchDirectoryPage() {
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 HASH_TABLE_BUCKET_TYPE *HASH_TABLE_TYPE::FetchBucketPage(page_id_t bucket_page_id) {
+  if(this->pin_pages_){
+    return this->pinned_bucket_pages_.at(bucket_page_id);
+  }
   return reinterpret_cast<HashTableBucketPage<KeyType, ValueType, KeyComparator>*>(this->buffer_pool_manager_->FetchPage(bucket_page_id)->GetData());
 }
 
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::UnpinDirectoryPage(bool is_dirty) {
+  if(!this->pin_pages_){
+    this->buffer_pool_manager_->UnpinPage(this->directory_page_id_, is_dirty);
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::UnpinBucketPage(page_id_t bucket_page_id, bool is_dirty) {
+  if(!this->pin_pages_){
+    this->buffer_pool_manager_->UnpinPage(bucket_page_id, is_dirty);
+  }
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+HASH_TABLE_BUCKET_TYPE *HASH_TABLE_TYPE::NewBucketPage(page_id_t *bucket_page_id) {
+  Page *page = this->buffer_pool_manager_->NewPage(bucket_page_id);
+  if(page == nullptr){
+    return nullptr;
+  }
+  auto bucket_page = reinterpret_cast<HASH_TABLE_BUCKET_TYPE *>(page->GetData());
+  if(this->pin_pages_){
+    // NewPage 带来的 Pin 在整个生命周期内保留
+    this->pinned_bucket_pages_.emplace(*bucket_page_id, bucket_page);
+  }
+  return bucket_page;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void HASH_TABLE_TYPE::DeleteBucketPage(page_id_t bucket_page_id) {
+  if(this->pin_pages_){
+    // 先释放生命周期内的 Pin, 否则 DeletePage 会失败
+    this->pinned_bucket_pages_.erase(bucket_page_id);
+    this->buffer_pool_manager_->UnpinPage(bucket_page_id, false);
+  }
+  this->buffer_pool_manager_->DeletePage(bucket_page_id);
+}
+
 /*****************************************************************************
  * SEARCH
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) {
   this->table_latch_.RLock();
-    // 获取 Directory Page
-  auto directory_page = reinterpret_cast<HashTableDirectoryPage*>(this->buffer_pool_manager_->FetchPage(this->directory_page_id_)->GetData());
+  // 获取 Directory Page
+  HashTableDirectoryPage *directory_page = this->FetchDirectoryPage();
   // 根据 key 和 directory 获取 bucket_idx
-  uint32_t bucket_page_id = this->KeyToPageId(key, directory_page);
+  page_id_t bucket_page_id = this->KeyToPageId(key, directory_page);
   // 根据 bucket_id 获取 bucket_page
-  auto bucket_page = this->FetchBucketPage(bucket_page_id);
+  HASH_TABLE_BUCKET_TYPE *bucket_page = this->FetchBucketPage(bucket_page_id);
   // 从 Bucket Page 中获取 value
-  if(bucket_page->GetValue(key, this->comparator_, result)) {
-    this->table_latch_.RUnlock();
-    return true;
+  bool found = bucket_page->GetValue(key, this->comparator_, result);
+  this->UnpinBucketPage(bucket_page_id, false);
+  this->UnpinDirectoryPage(false);
+  this->table_latch_.RUnlock();
+  return found;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::GetValues(Transaction *transaction, const std::vector<KeyType> &keys,
+                                std::vector<std::vector<ValueType>> *results) {
+  results->clear();
+  results->resize(keys.size());
+  if (keys.empty()) {
+    return false;
+  }
+
+  this->table_latch_.RLock();
+  // 整个批次只获取一次 Directory Page, 先把所有 key 映射到对应的 bucket page
+  HashTableDirectoryPage *directory_page = this->FetchDirectoryPage();
+  std::vector<page_id_t> bucket_page_ids(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    bucket_page_ids[i] = this->KeyToPageId(keys[i], directory_page);
+  }
+  this->UnpinDirectoryPage(false);
+
+  // 按 bucket page 分组, 同一个 bucket 中的 key 只需要获取一次页面
+  std::vector<size_t> order(keys.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(),
+            [&bucket_page_ids](size_t lhs, size_t rhs) { return bucket_page_ids[lhs] < bucket_page_ids[rhs]; });
+
+  bool found = false;
+  size_t group_begin = 0;
+  HASH_TABLE_BUCKET_TYPE *bucket_page = this->FetchBucketPage(bucket_page_ids[order[0]]);
+  while (group_begin < order.size()) {
+    page_id_t bucket_page_id = bucket_page_ids[order[group_begin]];
+    size_t group_end = group_begin;
+    while (group_end < order.size() && bucket_page_ids[order[group_end]] == bucket_page_id) {
+      group_end++;
+    }
+
+    // 在探测当前 bucket 之前先获取下一个 bucket, 并预取它的 bitmap 和前几个键值对
+    HASH_TABLE_BUCKET_TYPE *next_bucket_page = nullptr;
+    if (group_end < order.size()) {
+      next_bucket_page = this->FetchBucketPage(bucket_page_ids[order[group_end]]);
+      const char *data = reinterpret_cast<const char *>(next_bucket_page);
+      for (size_t offset = 0; offset < 4 * 64; offset += 64) {
+        __builtin_prefetch(data + offset);
+      }
+    }
+
+    for (size_t i = group_begin; i < group_end; i++) {
+      if (i + 1 < group_end) {
+        __builtin_prefetch(&keys[order[i + 1]]);
+      }
+      found = bucket_page->GetValue(keys[order[i]], this->comparator_, &(*results)[order[i]]) || found;
+    }
+    this->UnpinBucketPage(bucket_page_id, false);
+
+    bucket_page = next_bucket_page;
+    group_begin = group_end;
   }
   this->table_latch_.RUnlock();
-  return false;
+  return found;
 }
 
 /*****************************************************************************
@@ -153,110 +278,110 @@ bool HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) {
   this->table_latch_.WLock();
-  // 获取 Directory Page
-  auto directory_page = reinterpret_cast<HashTableDirectoryPage*>(this->buffer_pool_manager_->FetchPage(this->directory_page_id_)->GetData());
-  // 根据 key 和 directory 获取 bucket_idx
-  uint32_t bucket_page_id = this->KeyToPageId(key, directory_page);
-  // 根据 bucket_id 获取 bucket_page
-  HashTableBucketPage<KeyType, ValueType, KeyComparator>* bucket_page = this->FetchBucketPage(bucket_page_id);
-  if(bucket_page->IsFull()) {
-    // 当 Bucket 满了之后调用 SplitInsert
-    bool res = this->SplitInsert(transaction, key, value);
+  bool res = false;
+  try {
+    while(true) {
+      // 获取 Directory Page
+      HashTableDirectoryPage *directory_page = this->FetchDirectoryPage();
+      // 根据 key 和 directory 获取 bucket_idx
+      page_id_t bucket_page_id = this->KeyToPageId(key, directory_page);
+      // 根据 bucket_id 获取 bucket_page
+      HASH_TABLE_BUCKET_TYPE *bucket_page = this->FetchBucketPage(bucket_page_id);
+      if(!bucket_page->IsFull()) {
+        res = bucket_page->Insert(key, value, this->comparator_);
+        this->UnpinBucketPage(bucket_page_id, res);
+        this->UnpinDirectoryPage(false);
+        break;
+      }
+      this->UnpinBucketPage(bucket_page_id, false);
+      this->UnpinDirectoryPage(false);
+      // 当 Bucket 满了之后调用 SplitInsert 分裂, 分裂后的 bucket 仍可能是满的, 因此循环重试
+      if(!this->SplitInsert(transaction, key, value)) {
+        break;
+      }
+    }
+  } catch(Exception &e) {
+    // 缓冲池耗尽时释放表锁后把错误抛给调用者
     this->table_latch_.WUnlock();
-    return res;
+    throw;
   }
-  bool res = bucket_page->Insert(key, value, this->comparator_);
   this->table_latch_.WUnlock();
   return res;
-
 }
 
 /**
  * Performs insertion with an optional bucket splitting.
  *
+ * Splits the bucket the key maps to, doubling the directory first if the
+ * bucket's local depth equals the global depth. The caller retries the insert.
+ *
  * @param transaction a pointer to the current transaction
  * @param key the key to insert
  * @param value the value to insert
- * @return whether or not the insertion was successful
+ * @return whether or not the bucket could be split
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key, const ValueType &value) {
   // 获取 Directory Page
-  auto directory_page = reinterpret_cast<HashTableDirectoryPage*>(this->buffer_pool_manager_->FetchPage(this->directory_page_id_)->GetData());
-  // 根据 key 和 directory 获取 bucket_idx
-  uint32_t bucket_page_id = this->KeyToPageId(key, directory_page);
-  // 根据 bucket_id 获取 bucket_page
-  HashTableBucketPage<KeyType, ValueType, KeyComparator>* bucket_page = this->FetchBucketPage(bucket_page_id);
-  // 获取 global_depth
-  uint32_t global_depth = directory_page->GetGlobalDepth();
-  // 获取 bucket_idx
+  HashTableDirectoryPage *directory_page = this->FetchDirectoryPage();
+  // 获取 bucket_idx 以及对应的 bucket_page_id 和 local_depth
   uint32_t bucket_idx = this->KeyToDirectoryIndex(key, directory_page);
-  // 获取 local_depth 和 local_depth_mask
+  page_id_t bucket_page_id = directory_page->GetBucketPageId(bucket_idx);
   uint32_t local_depth = directory_page->GetLocalDepth(bucket_idx);
-  size_t local_depth_mask = directory_page->GetLocalDepthMask(bucket_idx);
-
-  uint32_t flag = bucket_idx & local_depth_mask;
-  if(local_depth < global_depth) {
-    // local_depth 比 global_depth 小
-    // 新分配页以进行分离
-    page_id_t new_bucket_page_id;
-    Page* new_page = this->buffer_pool_manager_->NewPage(&new_bucket_page_id);
-    new_page->GetData();
-
-    // 获取可扩展哈希表所有可用的插槽范围
-    size_t global_size = 1 << global_depth;
-    // 遍历所有插槽，获取对应的 bucket_idx 重新映射页
-    for(size_t slot_idx = 0; slot_idx < global_size; slot_idx++){
-      if((slot_idx & local_depth_mask) == flag) {
-        size_t new_local_depth_mask = local_depth_mask + (1 << local_depth);
-        if(((slot_idx & new_local_depth_mask) >> local_depth) == 0) {
-          directory_page->SetBucketPageId(slot_idx, bucket_page_id);
-          directory_page->SetLocalDepth(slot_idx, local_depth + 1);
-        }else if(((slot_idx & new_local_depth_mask) >> local_depth) == 1) {
-          directory_page->SetBucketPageId(slot_idx, new_bucket_page_id);
-          directory_page->SetLocalDepth(slot_idx, local_depth + 1);
-        }
-      }
+  uint32_t global_size = directory_page->Size();
+
+  if(local_depth == directory_page->GetGlobalDepth()) {
+    // 此时 GLOBAL DEPTH 和 LOCAL DEPTH 相同，需要先将 directory 翻倍
+    if(2 * global_size > DIRECTORY_ARRAY_SIZE) {
+      this->UnpinDirectoryPage(false);
+      return false;
     }
-    // 遍历原有的 bucket 的内容进行分离
-    size_t bucket_size = bucket_page->Size();
-    for(size_t i = 0; i < bucket_size; i++) {
-      auto item_key = bucket_page->KeyAt(0);
-      auto item_value = bucket_page->ValueAt(0);
-      // 移除并重新进行插入
-      bucket_page->Remove(item_key, item_value, this->comparator_);
-      uint32_t item_bucket_page_id = this->KeyToPageId(item_key, directory_page);
-      HashTableBucketPage<KeyType, ValueType, KeyComparator>* item_bucket_page = this->FetchBucketPage(item_bucket_page_id);
-      item_bucket_page->Insert(item_key, item_value, this->comparator_);
+    // 新增的一半插槽与旧的一半一一对应
+    directory_page->IncrGlobalDepth();
+    for(uint32_t slot_idx = 0; slot_idx < global_size; slot_idx++) {
+      directory_page->SetBucketPageId(slot_idx + global_size, directory_page->GetBucketPageId(slot_idx));
+      directory_page->SetLocalDepth(slot_idx + global_size, directory_page->GetLocalDepth(slot_idx));
     }
+    global_size *= 2;
+  }
 
-    bucket_page_id = this->KeyToPageId(key, directory_page);
-    bucket_page = this->FetchBucketPage(bucket_page_id);
-    bucket_page->Insert(key, value, this->comparator_);
-
-  }else{
-    // 此时 GLOBAL DEPTH 和 LOCAL DEPTH 相同，应当同时增长 GLOBAL DEPTH 和 LOCAL DEPTH
-      size_t old_global_size = 1 << directory_page->GetGlobalDepth();
-      directory_page->IncrGlobalDepth();
-
-      for(size_t slot_idx = 0; slot_idx < old_global_size; slot_idx++) {
-        // 遍历所有存在的 bucket page 并将其映射到新建的插槽中
-        page_id_t bucket_item_page_id = directory_page->GetBucketPageId(slot_idx);
-        uint32_t item_local_depth = directory_page->GetLocalDepth(bucket_item_page_id);
-        uint32_t diff_bits = directory_page->GetGlobalDepth() - item_local_depth;
-        // 计算应该映射到扩增的 directory bucket page 的 page id 映射
-        size_t nums = 1 << diff_bits;
-        for(size_t num = 0; num < nums; num++){
-          uint32_t map_bucket_idx = (num << item_local_depth) + slot_idx;
-          directory_page->SetBucketPageId(map_bucket_idx, bucket_item_page_id);
-          directory_page->SetLocalDepth(map_bucket_idx, item_local_depth);
-        }
+  // 新分配页作为分裂出来的 bucket
+  page_id_t image_page_id;
+  HASH_TABLE_BUCKET_TYPE *image_page = this->NewBucketPage(&image_page_id);
+  if(image_page == nullptr) {
+    // 此时目录可能已经翻倍, 翻倍出来的插槽与原插槽一致, 目录仍然有效
+    this->UnpinDirectoryPage(true);
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "ExtendibleHashTable: no free frame for a split bucket page");
+  }
+
+  // 遍历所有指向原 bucket 的插槽, 第 local_depth 位为 1 的插槽重新映射到新的 bucket
+  uint32_t high_bit = 1 << local_depth;
+  for(uint32_t slot_idx = 0; slot_idx < global_size; slot_idx++) {
+    if(directory_page->GetBucketPageId(slot_idx) == bucket_page_id) {
+      directory_page->IncrLocalDepth(slot_idx);
+      if((slot_idx & high_bit) != 0) {
+        directory_page->SetBucketPageId(slot_idx, image_page_id);
       }
+    }
+  }
 
-      // 此时 GLOBAL DEPTH 已经扩增完毕，并将所有 bucket_idx 进行重新映射，此时进行递归
-      this->SplitInsert(transaction, key, value);
+  // 遍历原有的 bucket 的内容进行分离
+  HASH_TABLE_BUCKET_TYPE *bucket_page = this->FetchBucketPage(bucket_page_id);
+  std::vector<std::pair<KeyType, ValueType>> moved;
+  size_t bucket_size = bucket_page->Size();
+  for(size_t i = 0; i < bucket_size; i++) {
+    if((this->Hash(bucket_page->KeyAt(i)) & high_bit) != 0) {
+      moved.emplace_back(bucket_page->KeyAt(i), bucket_page->ValueAt(i));
+    }
+  }
+  for(const auto &item : moved) {
+    bucket_page->Remove(item.first, item.second, this->comparator_);
+    image_page->Insert(item.first, item.second, this->comparator_);
   }
 
+  this->UnpinBucketPage(bucket_page_id, true);
+  this->UnpinBucketPage(image_page_id, true);
+  this->UnpinDirectoryPage(true);
   return true;
 }
 
@@ -266,20 +391,20 @@ bool HASH_TABLE_TYPE::SplitInsert(Transaction *transaction, const KeyType &key,
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) {
   this->table_latch_.WLock();
-  auto directory_page = this->FetchDirectoryPage();
+  HashTableDirectoryPage *directory_page = this->FetchDirectoryPage();
   // 根据 key 和 directory 获取 bucket_idx
-  uint32_t bucket_page_id = this->KeyToPageId(key, directory_page);
+  page_id_t bucket_page_id = this->KeyToPageId(key, directory_page);
   // 根据 bucket_id 获取 bucket_page
-  HashTableBucketPage<KeyType, ValueType, KeyComparator>* bucket_page = this->FetchBucketPage(bucket_page_id);
-  if(bucket_page->Remove(key, value, this->comparator_)){
-    if(bucket_page->IsEmpty()) {
-      this->Merge(transaction, key, value);
-    }
-    this->table_latch_.WUnlock();
-    return true;
+  HASH_TABLE_BUCKET_TYPE *bucket_page = this->FetchBucketPage(bucket_page_id);
+  bool res = bucket_page->Remove(key, value, this->comparator_);
+  bool empty = res && bucket_page->IsEmpty();
+  this->UnpinBucketPage(bucket_page_id, res);
+  this->UnpinDirectoryPage(false);
+  if(empty) {
+    this->Merge(transaction, key, value);
   }
   this->table_latch_.WUnlock();
-  return false;
+  return res;
 }
 
 /*****************************************************************************
@@ -289,10 +414,8 @@ bool HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const
  * Optionally merges an empty bucket into it's pair.  This is called by Remove,
  * if Remove makes a bucket empty.
  *
- * There are three conditions under which we skip the merge:
- * 1. The bucket is no longer empty.
- * 2. The bucket has local depth 0.
- * 3. The bucket's local depth doesn't match its split image's local depth.
+ * Merging repeats with the merged bucket's new split image for as long as one
+ * side of the pair is empty, and the directory is shrunk after every merge.
  *
  * @param transaction a pointer to the current transaction
  * @param key the key that was removed
@@ -302,42 +425,94 @@ template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_TYPE::Merge(Transaction *transaction, const KeyType &key, const ValueType &value) {
   // 此时 key hash 出来的对应的某个 bucket 为空, 应当对其进行合并
   HashTableDirectoryPage* dir_page = this->FetchDirectoryPage();
-  uint32_t bucket_idx = this->Hash(key) & dir_page->GetGlobalDepthMask();
-  page_id_t bucket_page_id = dir_page->GetBucketPageId(bucket_idx);
+  uint32_t bucket_idx = this->KeyToDirectoryIndex(key, dir_page);
+  bool dirty = false;
+  // 合并后的 bucket 可能与它新的 split image 继续合并, 直到无法合并为止
+  while(this->MergeBuckets(dir_page, bucket_idx, 0)) {
+    dirty = true;
+    while(dir_page->CanShrink()) {
+      dir_page->DecrGlobalDepth();
+    }
+    bucket_idx &= dir_page->GetGlobalDepthMask();
+  }
+  this->UnpinDirectoryPage(dirty);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool HASH_TABLE_TYPE::MergeBuckets(HashTableDirectoryPage *dir_page, uint32_t bucket_idx, size_t max_size) {
   uint32_t local_depth = dir_page->GetLocalDepth(bucket_idx);
-  if(local_depth == 0){
-    // LOCAL DEPTH 为 0，直接返回
-    return;
+  if(local_depth == 0) {
+    return false;
   }
-  // 找出所有在 LOCAL DEPTH 减少后应当重新映射的 bucket_idx, 并将另一个 bucket_page_id 映射到
-  // 已经为空的插槽上, 并删除已经为空的页
-  uint32_t local_mask_bucket_id = bucket_idx & dir_page->GetLocalDepthMask(bucket_idx);
-  // 这里是要找到和它对称的那个 bucket_id
-  uint32_t other_local_bucket_id = 0;
-  if(local_mask_bucket_id > ((uint32_t)(1 << local_depth))) {
-    uint32_t mask = 0;
-    for(size_t i = 0; i < local_depth - 1; i++) {
-      mask += 1 << i;
-    }
-    other_local_bucket_id = local_mask_bucket_id & mask;
-  }else{
-    uint32_t mask = 0;
-    for(size_t i = 0; i < local_depth - 1; i++) {
-      mask += 1 << i;
-    }
-    other_local_bucket_id = (local_mask_bucket_id & mask) + (1 << (local_depth - 1));
+  uint32_t image_idx = dir_page->GetSplitImageIndex(bucket_idx);
+  if(dir_page->GetLocalDepth(image_idx) != local_depth) {
+    return false;
   }
-  page_id_t other_bucket_page_id = dir_page->GetBucketPageId(other_local_bucket_id);
-  // 找到所有相关的插槽，并将其 bucket_page_id 进行替换
-  for(size_t slot_idx = 0; slot_idx < dir_page->Size(); slot_idx++){
-    page_id_t bucket_page_item_id = dir_page->GetBucketPageId(slot_idx);
-    if(bucket_page_item_id == bucket_page_id){
-      dir_page->SetBucketPageId(slot_idx, other_bucket_page_id);
+  page_id_t bucket_page_id = dir_page->GetBucketPageId(bucket_idx);
+  page_id_t image_page_id = dir_page->GetBucketPageId(image_idx);
+  HASH_TABLE_BUCKET_TYPE *bucket_page = this->FetchBucketPage(bucket_page_id);
+  HASH_TABLE_BUCKET_TYPE *image_page = this->FetchBucketPage(image_page_id);
+  size_t bucket_size = bucket_page->Size();
+  size_t image_size = image_page->Size();
+  if(bucket_size != 0 && image_size != 0 && bucket_size + image_size > max_size) {
+    this->UnpinBucketPage(bucket_page_id, false);
+    this->UnpinBucketPage(image_page_id, false);
+    return false;
+  }
+
+  // 保留 high bit 为 0 的一侧, 将另一侧的键值对搬过来
+  bool keep_bucket = (bucket_idx & dir_page->GetLocalHighBit(bucket_idx)) == 0;
+  page_id_t kept_page_id = keep_bucket ? bucket_page_id : image_page_id;
+  page_id_t dropped_page_id = keep_bucket ? image_page_id : bucket_page_id;
+  HASH_TABLE_BUCKET_TYPE *kept_page = keep_bucket ? bucket_page : image_page;
+  HASH_TABLE_BUCKET_TYPE *dropped_page = keep_bucket ? image_page : bucket_page;
+  size_t dropped_size = keep_bucket ? image_size : bucket_size;
+  for(size_t i = 0; i < dropped_size; i++) {
+    kept_page->Insert(dropped_page->KeyAt(i), dropped_page->ValueAt(i), this->comparator_);
+  }
+
+  // 找到所有相关的插槽，将其指向保留的 bucket 并减少 LOCAL DEPTH
+  uint32_t size = dir_page->Size();
+  for(uint32_t slot_idx = 0; slot_idx < size; slot_idx++) {
+    page_id_t slot_page_id = dir_page->GetBucketPageId(slot_idx);
+    if(slot_page_id == bucket_page_id || slot_page_id == image_page_id) {
+      dir_page->SetBucketPageId(slot_idx, kept_page_id);
       dir_page->DecrLocalDepth(slot_idx);
     }
   }
-  // 将已经空了的页移除
-  this->buffer_pool_manager_->DeletePage(bucket_page_id);
+
+  this->UnpinBucketPage(kept_page_id, dropped_size > 0);
+  this->UnpinBucketPage(dropped_page_id, false);
+  // 将已经合并掉的页移除
+  this->DeleteBucketPage(dropped_page_id);
+  return true;
+}
+
+/*****************************************************************************
+ * COMPACT
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+size_t HASH_TABLE_TYPE::Compact(Transaction *transaction) {
+  this->table_latch_.WLock();
+  HashTableDirectoryPage *dir_page = this->FetchDirectoryPage();
+  size_t freed = 0;
+  // 合并会降低 local depth, 使更多的 bucket 对满足合并条件, 因此反复扫描直到没有可合并的
+  bool merged = true;
+  while(merged) {
+    merged = false;
+    for(uint32_t slot_idx = 0; slot_idx < dir_page->Size(); slot_idx++) {
+      if(this->MergeBuckets(dir_page, slot_idx, BUCKET_ARRAY_SIZE / 2)) {
+        freed++;
+        merged = true;
+      }
+    }
+    while(dir_page->CanShrink()) {
+      dir_page->DecrGlobalDepth();
+    }
+  }
+  this->UnpinDirectoryPage(freed > 0);
+  this->table_latch_.WUnlock();
+  return freed;
 }
 
 /*****************************************************************************
@@ -348,7 +523,7 @@ uint32_t HASH_TABLE_TYPE::GetGlobalDepth() {
   table_latch_.RLock();
   HashTableDirectoryPage *dir_page = FetchDirectoryPage();
   uint32_t global_depth = dir_page->GetGlobalDepth();
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr));
+  UnpinDirectoryPage(false);
   table_latch_.RUnlock();
   return global_depth;
 }
@@ -361,7 +536,7 @@ void HASH_TABLE_TYPE::VerifyIntegrity() {
   table_latch_.RLock();
   HashTableDirectoryPage *dir_page = FetchDirectoryPage();
   dir_page->VerifyIntegrity();
-  assert(buffer_pool_manager_->UnpinPage(directory_page_id_, false, nullptr));
+  UnpinDirectoryPage(false);
   table_latch_.RUnlock();
 }
 
@@ -10,7 +10,9 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
 #include <string>
 #include <utility>
 #include <vector>
@@ -23,46 +25,382 @@
 namespace bustub {
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
-HASH_TABLE_TYPE::LinearProbeHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
+LINEAR_PROBE_HASH_TABLE_TYPE::LinearProbeHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
                                       const KeyComparator &comparator, size_t num_buckets,
                                       HashFunction<KeyType> hash_fn)
-    : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {}
+    : buffer_pool_manager_(buffer_pool_manager), comparator_(comparator), hash_fn_(std::move(hash_fn)) {
+  header_page_id_ = NewTable(num_buckets);
+}
+
+/*****************************************************************************
+ * HELPERS
+ *****************************************************************************/
+template <typename KeyType, typename ValueType, typename KeyComparator>
+page_id_t LINEAR_PROBE_HASH_TABLE_TYPE::NewTable(size_t num_buckets) {
+  // 按 block 对齐, 至少分配一个 block
+  size_t num_blocks = std::max<size_t>(1, (num_buckets + BLOCK_ARRAY_SIZE - 1) / BLOCK_ARRAY_SIZE);
+  size_t per_page = HashTableHeaderPage::MaxNumBlocks();
+  if (num_blocks > per_page * per_page) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "linear probe hash table exceeds the capacity of its directory pages");
+  }
+
+  page_id_t header_page_id;
+  Page *page = buffer_pool_manager_->NewPage(&header_page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate linear probe hash table header page");
+  }
+  auto header_page = reinterpret_cast<HashTableHeaderPage *>(page->GetData());
+  header_page->SetPageId(header_page_id);
+  header_page->SetSize(num_blocks * BLOCK_ARRAY_SIZE);
+
+  // 头页放不下所有 block 时, 头页记录目录页, 每个目录页记录 MaxNumBlocks 个 block
+  HashTableHeaderPage *directory_page = header_page;
+  try {
+    for (size_t i = 0; i < num_blocks; i++) {
+      if (num_blocks > per_page && i % per_page == 0) {
+        if (directory_page != header_page) {
+          buffer_pool_manager_->UnpinPage(directory_page->GetPageId(), true);
+          directory_page = header_page;
+        }
+        page_id_t directory_page_id;
+        Page *new_page = buffer_pool_manager_->NewPage(&directory_page_id);
+        if (new_page == nullptr) {
+          throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate linear probe hash table directory page");
+        }
+        header_page->AddBlockPageId(directory_page_id);
+        directory_page = reinterpret_cast<HashTableHeaderPage *>(new_page->GetData());
+        directory_page->SetPageId(directory_page_id);
+      }
+      page_id_t block_page_id;
+      if (buffer_pool_manager_->NewPage(&block_page_id) == nullptr) {
+        throw Exception(ExceptionType::OUT_OF_MEMORY, "cannot allocate linear probe hash table block page");
+      }
+      directory_page->AddBlockPageId(block_page_id);
+      buffer_pool_manager_->UnpinPage(block_page_id, true);
+    }
+  } catch (Exception &e) {
+    // 分配失败时归还已经分配的页, 调用者的哈希表保持不变
+    if (directory_page != header_page) {
+      buffer_pool_manager_->UnpinPage(directory_page->GetPageId(), true);
+    }
+    buffer_pool_manager_->UnpinPage(header_page_id, true);
+    DeleteTable(header_page_id);
+    throw;
+  }
+  if (directory_page != header_page) {
+    buffer_pool_manager_->UnpinPage(directory_page->GetPageId(), true);
+  }
+  buffer_pool_manager_->UnpinPage(header_page_id, true);
+  return header_page_id;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void LINEAR_PROBE_HASH_TABLE_TYPE::DeleteTable(page_id_t header_page_id) {
+  HashTableHeaderPage *header_page = FetchHeaderPage(header_page_id);
+  bool has_directory = HasDirectory(header_page);
+  for (size_t i = 0; i < header_page->NumBlocks(); i++) {
+    page_id_t page_id = header_page->GetBlockPageId(i);
+    if (has_directory) {
+      HashTableHeaderPage *directory_page = FetchHeaderPage(page_id);
+      for (size_t j = 0; j < directory_page->NumBlocks(); j++) {
+        buffer_pool_manager_->DeletePage(directory_page->GetBlockPageId(j));
+      }
+      buffer_pool_manager_->UnpinPage(page_id, false);
+    }
+    buffer_pool_manager_->DeletePage(page_id);
+  }
+  buffer_pool_manager_->UnpinPage(header_page_id, false);
+  buffer_pool_manager_->DeletePage(header_page_id);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool LINEAR_PROBE_HASH_TABLE_TYPE::HasDirectory(HashTableHeaderPage *header_page) {
+  return header_page->GetSize() / BLOCK_ARRAY_SIZE > HashTableHeaderPage::MaxNumBlocks();
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+page_id_t LINEAR_PROBE_HASH_TABLE_TYPE::GetBlockPageId(HashTableHeaderPage *header_page, size_t block_idx) {
+  if (!HasDirectory(header_page)) {
+    return header_page->GetBlockPageId(block_idx);
+  }
+  size_t per_page = HashTableHeaderPage::MaxNumBlocks();
+  page_id_t directory_page_id = header_page->GetBlockPageId(block_idx / per_page);
+  HashTableHeaderPage *directory_page = FetchHeaderPage(directory_page_id);
+  page_id_t block_page_id = directory_page->GetBlockPageId(block_idx % per_page);
+  buffer_pool_manager_->UnpinPage(directory_page_id, false);
+  return block_page_id;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+HashTableHeaderPage *LINEAR_PROBE_HASH_TABLE_TYPE::FetchHeaderPage(page_id_t header_page_id) {
+  return reinterpret_cast<HashTableHeaderPage *>(buffer_pool_manager_->FetchPage(header_page_id)->GetData());
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+HASH_TABLE_BLOCK_TYPE *LINEAR_PROBE_HASH_TABLE_TYPE::FetchBlockPage(page_id_t block_page_id) {
+  return reinterpret_cast<HASH_TABLE_BLOCK_TYPE *>(buffer_pool_manager_->FetchPage(block_page_id)->GetData());
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool LINEAR_PROBE_HASH_TABLE_TYPE::GetValueFrom(page_id_t header_page_id, const KeyType &key,
+                                                std::vector<ValueType> *result) {
+  HashTableHeaderPage *header_page = FetchHeaderPage(header_page_id);
+  size_t size = header_page->GetSize();
+  size_t start = hash_fn_.GetHash(key) % size;
+
+  bool found = false;
+  size_t block_idx = start / BLOCK_ARRAY_SIZE;
+  page_id_t block_page_id = GetBlockPageId(header_page, block_idx);
+  HASH_TABLE_BLOCK_TYPE *block = FetchBlockPage(block_page_id);
+  // 从 hash 出的插槽开始线性探测, 直到遇到从未被占用的插槽或者绕回起点
+  for (size_t i = 0; i < size; i++) {
+    size_t slot = (start + i) % size;
+    if (slot / BLOCK_ARRAY_SIZE != block_idx) {
+      buffer_pool_manager_->UnpinPage(block_page_id, false);
+      block_idx = slot / BLOCK_ARRAY_SIZE;
+      block_page_id = GetBlockPageId(header_page, block_idx);
+      block = FetchBlockPage(block_page_id);
+    }
+    slot_offset_t offset = slot % BLOCK_ARRAY_SIZE;
+    if (!block->IsOccupied(offset)) {
+      break;
+    }
+    if (block->IsReadable(offset) && comparator_(block->KeyAt(offset), key) == 0) {
+      result->push_back(block->ValueAt(offset));
+      found = true;
+    }
+  }
+  buffer_pool_manager_->UnpinPage(block_page_id, false);
+  buffer_pool_manager_->UnpinPage(header_page_id, false);
+  return found;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool LINEAR_PROBE_HASH_TABLE_TYPE::InsertInto(page_id_t header_page_id, const KeyType &key, const ValueType &value,
+                                              bool *full) {
+  HashTableHeaderPage *header_page = FetchHeaderPage(header_page_id);
+  size_t size = header_page->GetSize();
+  size_t start = hash_fn_.GetHash(key) % size;
+
+  bool inserted = false;
+  bool dirty = false;
+  *full = true;
+  size_t block_idx = start / BLOCK_ARRAY_SIZE;
+  page_id_t block_page_id = GetBlockPageId(header_page, block_idx);
+  HASH_TABLE_BLOCK_TYPE *block = FetchBlockPage(block_page_id);
+  for (size_t i = 0; i < size; i++) {
+    size_t slot = (start + i) % size;
+    if (slot / BLOCK_ARRAY_SIZE != block_idx) {
+      buffer_pool_manager_->UnpinPage(block_page_id, false);
+      block_idx = slot / BLOCK_ARRAY_SIZE;
+      block_page_id = GetBlockPageId(header_page, block_idx);
+      block = FetchBlockPage(block_page_id);
+    }
+    slot_offset_t offset = slot % BLOCK_ARRAY_SIZE;
+    if (!block->IsOccupied(offset)) {
+      // 探测链上没有重复的键值对, 插入到第一个空闲插槽
+      *full = false;
+      inserted = block->Insert(offset, key, value);
+      dirty = inserted;
+      break;
+    }
+    if (block->IsReadable(offset) && comparator_(block->KeyAt(offset), key) == 0 && block->ValueAt(offset) == value) {
+      *full = false;
+      break;
+    }
+  }
+  buffer_pool_manager_->UnpinPage(block_page_id, dirty);
+  buffer_pool_manager_->UnpinPage(header_page_id, false);
+  return inserted;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+bool LINEAR_PROBE_HASH_TABLE_TYPE::RemoveFrom(page_id_t header_page_id, const KeyType &key, const ValueType &value) {
+  HashTableHeaderPage *header_page = FetchHeaderPage(header_page_id);
+  size_t size = header_page->GetSize();
+  size_t start = hash_fn_.GetHash(key) % size;
+
+  bool removed = false;
+  size_t block_idx = start / BLOCK_ARRAY_SIZE;
+  page_id_t block_page_id = GetBlockPageId(header_page, block_idx);
+  HASH_TABLE_BLOCK_TYPE *block = FetchBlockPage(block_page_id);
+  for (size_t i = 0; i < size; i++) {
+    size_t slot = (start + i) % size;
+    if (slot / BLOCK_ARRAY_SIZE != block_idx) {
+      buffer_pool_manager_->UnpinPage(block_page_id, false);
+      block_idx = slot / BLOCK_ARRAY_SIZE;
+      block_page_id = GetBlockPageId(header_page, block_idx);
+      block = FetchBlockPage(block_page_id);
+    }
+    slot_offset_t offset = slot % BLOCK_ARRAY_SIZE;
+    if (!block->IsOccupied(offset)) {
+      break;
+    }
+    if (block->IsReadable(offset) && comparator_(block->KeyAt(offset), key) == 0 && block->ValueAt(offset) == value) {
+      block->Remove(offset);
+      removed = true;
+      break;
+    }
+  }
+  buffer_pool_manager_->UnpinPage(block_page_id, removed);
+  buffer_pool_manager_->UnpinPage(header_page_id, false);
+  return removed;
+}
 
 /*****************************************************************************
  * SEARCH
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-bool HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result) {
-  return false;
+bool LINEAR_PROBE_HASH_TABLE_TYPE::GetValue(Transaction *transaction, const KeyType &key,
+                                            std::vector<ValueType> *result) {
+  table_latch_.RLock();
+  bool found = false;
+  // 扩容过程中, 尚未迁移的键值对仍然在旧的哈希表里
+  if (old_header_page_id_ != INVALID_PAGE_ID) {
+    found = GetValueFrom(old_header_page_id_, key, result);
+  }
+  found = GetValueFrom(header_page_id_, key, result) || found;
+  table_latch_.RUnlock();
+  return found;
 }
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-bool HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) {
-  return false;
+bool LINEAR_PROBE_HASH_TABLE_TYPE::Insert(Transaction *transaction, const KeyType &key, const ValueType &value) {
+  table_latch_.WLock();
+  bool inserted = false;
+  try {
+    if (old_header_page_id_ != INVALID_PAGE_ID) {
+      std::vector<ValueType> values;
+      GetValueFrom(old_header_page_id_, key, &values);
+      if (std::find(values.begin(), values.end(), value) != values.end()) {
+        MigrateBlocks(MIGRATE_BLOCKS_PER_OP);
+        table_latch_.WUnlock();
+        return false;
+      }
+    }
+
+    MaybeGrow();
+    bool full = false;
+    inserted = InsertInto(header_page_id_, key, value, &full);
+    if (full) {
+      // 负载因子保证了这里基本不会发生, 保险起见立即完成扩容后重试
+      MigrateBlocks(std::numeric_limits<size_t>::max());
+      Resize(GetSize());
+      inserted = InsertInto(header_page_id_, key, value, &full);
+    }
+    if (inserted) {
+      num_occupied_++;
+      num_readable_++;
+    }
+    MigrateBlocks(MIGRATE_BLOCKS_PER_OP);
+  } catch (Exception &e) {
+    // 扩容分配失败时哈希表保持不变, 释放表锁后把错误抛给调用者
+    table_latch_.WUnlock();
+    throw;
+  }
+  table_latch_.WUnlock();
+  return inserted;
 }
 
 /*****************************************************************************
  * REMOVE
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-bool HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) {
-  return false;
+bool LINEAR_PROBE_HASH_TABLE_TYPE::Remove(Transaction *transaction, const KeyType &key, const ValueType &value) {
+  table_latch_.WLock();
+  bool removed = false;
+  if (old_header_page_id_ != INVALID_PAGE_ID && RemoveFrom(old_header_page_id_, key, value)) {
+    old_num_readable_--;
+    removed = true;
+  } else if (RemoveFrom(header_page_id_, key, value)) {
+    num_readable_--;
+    removed = true;
+  }
+  MigrateBlocks(MIGRATE_BLOCKS_PER_OP);
+  table_latch_.WUnlock();
+  return removed;
 }
 
 /*****************************************************************************
  * RESIZE
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-void HASH_TABLE_TYPE::Resize(size_t initial_size) {}
+void LINEAR_PROBE_HASH_TABLE_TYPE::Resize(size_t initial_size) {
+  // 同一时间只允许存在两代哈希表, 开始新的扩容之前先把上一次扩容迁移完
+  MigrateBlocks(std::numeric_limits<size_t>::max());
+
+  // 先分配新的一代, 分配失败时两代哈希表的状态都不变
+  page_id_t header_page_id = NewTable(2 * initial_size);
+  old_header_page_id_ = header_page_id_;
+  old_num_readable_ = num_readable_;
+  migrate_block_idx_ = 0;
+  header_page_id_ = header_page_id;
+  num_occupied_ = 0;
+  num_readable_ = 0;
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void LINEAR_PROBE_HASH_TABLE_TYPE::MaybeGrow() {
+  size_t size = GetSize();
+  if (static_cast<double>(num_occupied_ + old_num_readable_ + 1) <= MAX_LOAD_FACTOR * static_cast<double>(size)) {
+    return;
+  }
+  // 有效元素不到一半(其余是墓碑)时按当前大小重建, 否则容量翻倍;
+  // Resize 分配的容量是参数的两倍
+  MigrateBlocks(std::numeric_limits<size_t>::max());
+  Resize(num_readable_ < size / 2 ? size / 2 : size);
+}
+
+template <typename KeyType, typename ValueType, typename KeyComparator>
+void LINEAR_PROBE_HASH_TABLE_TYPE::MigrateBlocks(size_t max_blocks) {
+  if (old_header_page_id_ == INVALID_PAGE_ID) {
+    return;
+  }
+  HashTableHeaderPage *old_header_page = FetchHeaderPage(old_header_page_id_);
+  size_t num_blocks = old_header_page->GetSize() / BLOCK_ARRAY_SIZE;
+  for (size_t migrated = 0; migrated < max_blocks && migrate_block_idx_ < num_blocks; migrated++) {
+    page_id_t block_page_id = GetBlockPageId(old_header_page, migrate_block_idx_);
+    HASH_TABLE_BLOCK_TYPE *block = FetchBlockPage(block_page_id);
+    bool dirty = false;
+    for (slot_offset_t offset = 0; offset < BLOCK_ARRAY_SIZE; offset++) {
+      if (!block->IsReadable(offset)) {
+        continue;
+      }
+      bool full = false;
+      if (InsertInto(header_page_id_, block->KeyAt(offset), block->ValueAt(offset), &full)) {
+        num_occupied_++;
+        num_readable_++;
+      }
+      BUSTUB_ASSERT(!full, "new generation of linear probe hash table is full");
+      // 迁移后在旧表中留下墓碑, 保证旧表的探测链完整且不会重复读到该键值对
+      block->Remove(offset);
+      old_num_readable_--;
+      dirty = true;
+    }
+    buffer_pool_manager_->UnpinPage(block_page_id, dirty);
+    migrate_block_idx_++;
+  }
+  buffer_pool_manager_->UnpinPage(old_header_page_id_, false);
+
+  if (migrate_block_idx_ == num_blocks) {
+    DeleteTable(old_header_page_id_);
+    old_header_page_id_ = INVALID_PAGE_ID;
+    old_num_readable_ = 0;
+    migrate_block_idx_ = 0;
+  }
+}
 
 /*****************************************************************************
  * GETSIZE
  *****************************************************************************/
 template <typename KeyType, typename ValueType, typename KeyComparator>
-size_t HASH_TABLE_TYPE::GetSize() {
-  return 0;
+size_t LINEAR_PROBE_HASH_TABLE_TYPE::GetSize() {
+  HashTableHeaderPage *header_page = FetchHeaderPage(header_page_id_);
+  size_t size = header_page->GetSize();
+  buffer_pool_manager_->UnpinPage(header_page_id_, false);
+  return size;
 }
 
 template class LinearProbeHashTable<int, int, IntComparator>;
@@ -14,8 +14,77 @@
 
 #include "execution/executors/aggregation_executor.h"
 
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+
+#include "execution/expressions/column_value_expression.h"
+
 namespace bustub {
 
+namespace {
+
+/** Folds the selected rows of a column without NULLs into the sum, min or max, @return false for other types */
+template <typename T, typename Acc>
+bool FoldTyped(const ColumnVector &column, const SelectionVector &sel, AggregationType agg_type, Value *result) {
+  const T *data = column.Data<T>();
+  Acc acc;
+  switch (agg_type) {
+    case AggregationType::SumAggregate:
+      acc = 0;
+      for (size_t i = 0; i < sel.Size(); i++) {
+        if constexpr (std::is_integral_v<Acc>) {
+          if (__builtin_add_overflow(acc, static_cast<Acc>(data[sel[i]]), &acc)) {
+            return false;
+          }
+        } else {
+          acc += data[sel[i]];
+        }
+      }
+      // 部分和必须仍然能用列的类型表示, 否则退回逐行计算
+      if (acc < static_cast<Acc>(std::numeric_limits<T>::lowest()) ||
+          acc > static_cast<Acc>(std::numeric_limits<T>::max())) {
+        return false;
+      }
+      break;
+    case AggregationType::MinAggregate:
+      acc = data[sel[0]];
+      for (size_t i = 1; i < sel.Size(); i++) {
+        acc = std::min<Acc>(acc, data[sel[i]]);
+      }
+      break;
+    case AggregationType::MaxAggregate:
+      acc = data[sel[0]];
+      for (size_t i = 1; i < sel.Size(); i++) {
+        acc = std::max<Acc>(acc, data[sel[i]]);
+      }
+      break;
+    default:
+      return false;
+  }
+  *result = Value(column.GetType(), static_cast<T>(acc));
+  return true;
+}
+
+bool FoldColumn(const ColumnVector &column, const SelectionVector &sel, AggregationType agg_type, Value *result) {
+  switch (column.GetType()) {
+    case TypeId::TINYINT:
+      return FoldTyped<int8_t, int64_t>(column, sel, agg_type, result);
+    case TypeId::SMALLINT:
+      return FoldTyped<int16_t, int64_t>(column, sel, agg_type, result);
+    case TypeId::INTEGER:
+      return FoldTyped<int32_t, int64_t>(column, sel, agg_type, result);
+    case TypeId::BIGINT:
+      return FoldTyped<int64_t, int64_t>(column, sel, agg_type, result);
+    case TypeId::DECIMAL:
+      return FoldTyped<double, double>(column, sel, agg_type, result);
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
 AggregationExecutor::AggregationExecutor(ExecutorContext *exec_ctx, const AggregationPlanNode *plan,
                                          std::unique_ptr<AbstractExecutor> &&child)
     : AbstractExecutor(exec_ctx),
@@ -26,14 +95,14 @@ AggregationExecutor::AggregationExecutor(ExecutorContext *exec_ctx, const Aggreg
 
 
 void AggregationExecutor::Init() {
-  Tuple tuple;
-  RID rid;
-
   child_->Init();
+  having_.CompileAggregate(plan_->GetHaving());
 
-  // 将查询的所有 tuple hash 后插入到 aht 中
-  while (child_->Next(&tuple, &rid)){
-    aht_.InsertCombine(MakeAggregateKey(&tuple), MakeAggregateValue(&tuple));
+  // 将查询的所有 tuple hash 后插入到 aht 中, 子执行器按列式的批次读取
+  DataChunk chunk;
+  chunk.Initialize(child_->GetOutputSchema());
+  while (child_->NextChunk(&chunk)){
+    AggregateChunk(chunk);
   }
   aht_iterator_ = aht_.Begin();
 
@@ -43,9 +112,7 @@ bool AggregationExecutor::Next(Tuple *tuple, RID *rid) {
   if(this->aht_iterator_ != aht_.End()) {
     auto values = this->aht_iterator_.Val().aggregates_;
 //    auto out_tuple = Tuple(values, this->GetOutputSchema());
-    auto having = this->plan_->GetHaving();
-    if(having == nullptr ||
-        having->EvaluateAggregate(this->aht_iterator_.Key().group_bys_, this->aht_iterator_.Val().aggregates_).GetAs<bool>()){
+    if(this->having_.EvaluateAggregate(this->aht_iterator_.Key().group_bys_, this->aht_iterator_.Val().aggregates_)){
       *tuple = this->GenerateOutputTuple();
       *rid = tuple->GetRid();
       ++this->aht_iterator_;
@@ -57,6 +124,75 @@ bool AggregationExecutor::Next(Tuple *tuple, RID *rid) {
   return false;
 }
 
+bool AggregationExecutor::NextBatch(TupleBatch *batch) {
+  batch->Clear();
+  for (; !batch->IsFull() && this->aht_iterator_ != aht_.End(); ++this->aht_iterator_) {
+    if (this->having_.EvaluateAggregate(this->aht_iterator_.Key().group_bys_, this->aht_iterator_.Val().aggregates_)) {
+      Tuple tuple = this->GenerateOutputTuple();
+      RID rid = tuple.GetRid();
+      batch->Append(std::move(tuple), rid);
+    }
+  }
+  return !batch->IsEmpty();
+}
+
+void AggregationExecutor::AggregateChunk(const DataChunk &chunk) {
+  const SelectionVector &sel = chunk.GetSelection();
+  if (sel.IsEmpty()) {
+    return;
+  }
+  // 先把 group by 和聚合的输入按列求出来, 直接引用子执行器输出的列时不拷贝
+  const auto &group_bys = plan_->GetGroupBys();
+  const auto &aggregates = plan_->GetAggregates();
+  std::vector<ColumnVector> scratch;
+  scratch.reserve(group_bys.size() + aggregates.size());
+  auto evaluate = [&](const AbstractExpression *expr) -> const ColumnVector * {
+    if (auto column = dynamic_cast<const ColumnValueExpression *>(expr); column != nullptr) {
+      return &chunk.GetColumn(column->GetColIdx());
+    }
+    scratch.emplace_back(expr->GetReturnType(), chunk.Capacity());
+    expr->EvaluateColumn(chunk, &scratch.back());
+    return &scratch.back();
+  };
+  std::vector<const ColumnVector *> group_by_columns;
+  std::vector<const ColumnVector *> aggregate_columns;
+  for (const auto *expr : group_bys) {
+    group_by_columns.push_back(evaluate(expr));
+  }
+  for (const auto *expr : aggregates) {
+    aggregate_columns.push_back(evaluate(expr));
+  }
+
+  // 没有 group by 时整列折叠成一个部分聚合值
+  if (group_bys.empty()) {
+    const auto &agg_types = plan_->GetAggregateTypes();
+    AggregateValue partial{std::vector<Value>(aggregates.size(), ValueFactory::GetIntegerValue(0))};
+    bool folded = true;
+    for (uint32_t i = 0; i < aggregates.size() && folded; i++) {
+      if (agg_types[i] != AggregationType::CountAggregate) {
+        folded = aggregate_columns[i]->AllValid(sel) &&
+                 FoldColumn(*aggregate_columns[i], sel, agg_types[i], &partial.aggregates_[i]);
+      }
+    }
+    if (folded) {
+      aht_.InsertCombinePartial(AggregateKey{}, partial, static_cast<uint32_t>(sel.Size()));
+      return;
+    }
+  }
+
+  for (size_t i = 0; i < sel.Size(); i++) {
+    AggregateKey key;
+    AggregateValue value;
+    for (const auto *column : group_by_columns) {
+      key.group_bys_.push_back(column->GetValue(sel[i]));
+    }
+    for (const auto *column : aggregate_columns) {
+      value.aggregates_.push_back(column->GetValue(sel[i]));
+    }
+    aht_.InsertCombine(key, value);
+  }
+}
+
 Tuple AggregationExecutor::GenerateOutputTuple() {
   std::vector<Value> values;
   for (const auto &col: GetOutputSchema()->GetColumns()){
@@ -0,0 +1,341 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compiled_predicate.cpp
+//
+// Identification: src/execution/compiled_predicate.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/compiled_predicate.h"
+
+#include <cstring>
+#include <type_traits>
+
+#include "common/exception.h"
+#include "execution/expressions/aggregate_value_expression.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "type/limits.h"
+
+namespace bustub {
+
+namespace {
+
+template <ComparisonType OP>
+using OpTag = std::integral_constant<ComparisonType, OP>;
+
+/** Instantiates kernel for op, which it receives as an OpTag */
+template <typename Kernel>
+auto Dispatch(ComparisonType op, Kernel &&kernel) {
+  switch (op) {
+    case ComparisonType::Equal:
+      return kernel(OpTag<ComparisonType::Equal>());
+    case ComparisonType::NotEqual:
+      return kernel(OpTag<ComparisonType::NotEqual>());
+    case ComparisonType::LessThan:
+      return kernel(OpTag<ComparisonType::LessThan>());
+    case ComparisonType::LessThanOrEqual:
+      return kernel(OpTag<ComparisonType::LessThanOrEqual>());
+    case ComparisonType::GreaterThan:
+      return kernel(OpTag<ComparisonType::GreaterThan>());
+    default:
+      return kernel(OpTag<ComparisonType::GreaterThanOrEqual>());
+  }
+}
+
+/** The value a column of C++ type T stores for NULL */
+template <typename T>
+constexpr T NullOf() {
+  if constexpr (std::is_same_v<T, int8_t>) {
+    return BUSTUB_INT8_NULL;
+  } else if constexpr (std::is_same_v<T, int16_t>) {
+    return BUSTUB_INT16_NULL;
+  } else if constexpr (std::is_same_v<T, int32_t>) {
+    return BUSTUB_INT32_NULL;
+  } else if constexpr (std::is_same_v<T, int64_t>) {
+    return BUSTUB_INT64_NULL;
+  } else if constexpr (std::is_same_v<T, double>) {
+    return BUSTUB_DECIMAL_NULL;
+  } else {
+    return BUSTUB_TIMESTAMP_NULL;
+  }
+}
+
+}  // namespace
+
+void CompiledPredicate::Compile(const AbstractExpression *predicate, const Schema *schema) {
+  schemas_[0] = schema;
+  schemas_[1] = nullptr;
+  Reset(predicate, Mode::TUPLE);
+}
+
+void CompiledPredicate::CompileJoin(const AbstractExpression *predicate, const Schema *left_schema,
+                                    const Schema *right_schema) {
+  schemas_[0] = left_schema;
+  schemas_[1] = right_schema;
+  Reset(predicate, Mode::JOIN);
+}
+
+void CompiledPredicate::CompileAggregate(const AbstractExpression *predicate) {
+  schemas_[0] = nullptr;
+  schemas_[1] = nullptr;
+  Reset(predicate, Mode::AGGREGATE);
+}
+
+void CompiledPredicate::Reset(const AbstractExpression *predicate, Mode mode) {
+  mode_ = mode;
+  program_.clear();
+  registers_.clear();
+  if (predicate == nullptr) {
+    return;
+  }
+  auto [result, kind] = CompileNode(predicate);
+  if (kind != Kind::BOOLEAN && kind != Kind::INTEGER) {
+    throw Exception(ExceptionType::MISMATCH_TYPE, "CompiledPredicate: the predicate is not a boolean expression");
+  }
+  result_ = result;
+}
+
+size_t CompiledPredicate::FallbackCount() const {
+  size_t count = 0;
+  for (const auto &instruction : program_) {
+    count += static_cast<size_t>(instruction.operation_ == &RunFallback);
+  }
+  return count;
+}
+
+uint32_t CompiledPredicate::NewRegister() {
+  registers_.push_back(Register{0, 0, false});
+  return static_cast<uint32_t>(registers_.size() - 1);
+}
+
+CompiledPredicate::Kind CompiledPredicate::KindOf(TypeId type) {
+  switch (type) {
+    case TypeId::TINYINT:
+    case TypeId::SMALLINT:
+    case TypeId::INTEGER:
+    case TypeId::BIGINT:
+      return Kind::INTEGER;
+    case TypeId::BOOLEAN:
+      return Kind::BOOLEAN;
+    case TypeId::DECIMAL:
+      return Kind::DECIMAL;
+    case TypeId::TIMESTAMP:
+      return Kind::TIMESTAMP;
+    default:
+      return Kind::NONE;
+  }
+}
+
+void CompiledPredicate::LoadValue(const Value &value, Register *reg) {
+  reg->is_null_ = value.IsNull();
+  if (reg->is_null_) {
+    return;
+  }
+  switch (value.GetTypeId()) {
+    case TypeId::BOOLEAN:
+    case TypeId::TINYINT:
+      reg->integer_ = value.GetAs<int8_t>();
+      break;
+    case TypeId::SMALLINT:
+      reg->integer_ = value.GetAs<int16_t>();
+      break;
+    case TypeId::INTEGER:
+      reg->integer_ = value.GetAs<int32_t>();
+      break;
+    case TypeId::BIGINT:
+      reg->integer_ = value.GetAs<int64_t>();
+      break;
+    case TypeId::DECIMAL:
+      reg->integer_ = 0;
+      reg->decimal_ = value.GetAs<double>();
+      return;
+    case TypeId::TIMESTAMP:
+      reg->integer_ = static_cast<int64_t>(value.GetAs<uint64_t>());
+      return;
+    default:
+      reg->integer_ = 0;
+      break;
+  }
+  reg->decimal_ = static_cast<double>(reg->integer_);
+}
+
+std::pair<uint32_t, CompiledPredicate::Kind> CompiledPredicate::CompileNode(const AbstractExpression *expr) {
+  if (auto constant = dynamic_cast<const ConstantValueExpression *>(expr); constant != nullptr) {
+    // 常量在编译时就放进寄存器, 运行时不需要指令
+    Kind kind = KindOf(constant->GetValue().GetTypeId());
+    uint32_t reg = NewRegister();
+    LoadValue(constant->GetValue(), &registers_[reg]);
+    return {reg, kind};
+  }
+
+  if (auto column = dynamic_cast<const ColumnValueExpression *>(expr); column != nullptr) {
+    if (mode_ == Mode::AGGREGATE) {
+      return EmitFallback(expr);
+    }
+    // 单个元组的谓词忽略 tuple_idx, 与 Evaluate() 一致
+    uint32_t side = mode_ == Mode::JOIN && column->GetTupleIdx() != 0 ? 1 : 0;
+    const Column &schema_column = schemas_[side]->GetColumn(column->GetColIdx());
+    Operation operation;
+    switch (schema_column.GetType()) {
+      case TypeId::BOOLEAN:
+      case TypeId::TINYINT:
+        operation = &RunLoadColumn<int8_t>;
+        break;
+      case TypeId::SMALLINT:
+        operation = &RunLoadColumn<int16_t>;
+        break;
+      case TypeId::INTEGER:
+        operation = &RunLoadColumn<int32_t>;
+        break;
+      case TypeId::BIGINT:
+        operation = &RunLoadColumn<int64_t>;
+        break;
+      case TypeId::DECIMAL:
+        operation = &RunLoadColumn<double>;
+        break;
+      case TypeId::TIMESTAMP:
+        operation = &RunLoadColumn<uint64_t>;
+        break;
+      default:
+        return {0, Kind::NONE};
+    }
+    uint32_t reg = NewRegister();
+    program_.push_back(Instruction{operation, reg, side, schema_column.GetOffset(), expr});
+    return {reg, KindOf(schema_column.GetType())};
+  }
+
+  if (auto term = dynamic_cast<const AggregateValueExpression *>(expr); term != nullptr) {
+    Kind kind = KindOf(term->GetReturnType());
+    if (mode_ != Mode::AGGREGATE || kind == Kind::NONE) {
+      return EmitFallback(expr);
+    }
+    uint32_t reg = NewRegister();
+    program_.push_back(
+        Instruction{&RunLoadTerm, reg, static_cast<uint32_t>(term->IsGroupByTerm()), term->GetTermIdx(), expr});
+    return {reg, kind};
+  }
+
+  if (auto comparison = dynamic_cast<const ComparisonExpression *>(expr); comparison != nullptr) {
+    size_t program_size = program_.size();
+    size_t register_count = registers_.size();
+    auto [lhs, lhs_kind] = CompileNode(comparison->GetChildAt(0));
+    auto [rhs, rhs_kind] = CompileNode(comparison->GetChildAt(1));
+    // 两侧按同一种原生类型比较, 与 Value 的比较结果一致
+    Kind kind = Kind::NONE;
+    if (lhs_kind == rhs_kind && lhs_kind != Kind::DECIMAL) {
+      kind = lhs_kind;
+    } else if ((lhs_kind == Kind::INTEGER || lhs_kind == Kind::DECIMAL) &&
+               (rhs_kind == Kind::INTEGER || rhs_kind == Kind::DECIMAL)) {
+      kind = Kind::DECIMAL;
+    }
+    if (kind == Kind::NONE) {
+      // 操作数不能放进寄存器时, 丢掉已经生成的指令, 整个比较退回到解释执行
+      program_.resize(program_size);
+      registers_.resize(register_count);
+      return EmitFallback(expr);
+    }
+    Operation operation = Dispatch(comparison->GetComparisonType(), [kind](auto tag) -> Operation {
+      constexpr ComparisonType OP = decltype(tag)::value;
+      switch (kind) {
+        case Kind::DECIMAL:
+          return &RunCompare<OP, Kind::DECIMAL>;
+        case Kind::TIMESTAMP:
+          return &RunCompare<OP, Kind::TIMESTAMP>;
+        default:
+          return &RunCompare<OP, Kind::INTEGER>;
+      }
+    });
+    uint32_t reg = NewRegister();
+    program_.push_back(Instruction{operation, reg, lhs, rhs, expr});
+    return {reg, Kind::BOOLEAN};
+  }
+
+  return EmitFallback(expr);
+}
+
+std::pair<uint32_t, CompiledPredicate::Kind> CompiledPredicate::EmitFallback(const AbstractExpression *expr) {
+  Kind kind = KindOf(expr->GetReturnType());
+  if (kind == Kind::NONE) {
+    return {0, Kind::NONE};
+  }
+  uint32_t reg = NewRegister();
+  program_.push_back(Instruction{&RunFallback, reg, 0, 0, expr});
+  return {reg, kind};
+}
+
+void CompiledPredicate::RunFallback(const Instruction &instruction, const CompiledPredicate &program, Frame *frame) {
+  Value value;
+  switch (program.mode_) {
+    case Mode::TUPLE:
+      value = instruction.expr_->Evaluate(frame->tuples_[0], program.schemas_[0]);
+      break;
+    case Mode::JOIN:
+      value = instruction.expr_->EvaluateJoin(frame->tuples_[0], program.schemas_[0], frame->tuples_[1],
+                                              program.schemas_[1]);
+      break;
+    case Mode::AGGREGATE:
+      value = instruction.expr_->EvaluateAggregate(*frame->group_bys_, *frame->aggregates_);
+      break;
+  }
+  LoadValue(value, &frame->registers_[instruction.dst_]);
+}
+
+void CompiledPredicate::RunLoadTerm(const Instruction &instruction, const CompiledPredicate &program, Frame *frame) {
+  const std::vector<Value> &terms = instruction.lhs_ != 0 ? *frame->group_bys_ : *frame->aggregates_;
+  LoadValue(terms[instruction.rhs_], &frame->registers_[instruction.dst_]);
+}
+
+template <typename T>
+void CompiledPredicate::RunLoadColumn(const Instruction &instruction, const CompiledPredicate &program,
+                                      Frame *frame) {
+  T value;
+  memcpy(&value, frame->tuples_[instruction.lhs_]->GetData() + instruction.rhs_, sizeof(T));
+  Register &reg = frame->registers_[instruction.dst_];
+  reg.is_null_ = value == NullOf<T>();
+  if constexpr (std::is_same_v<T, double>) {
+    reg.decimal_ = value;
+  } else {
+    reg.integer_ = static_cast<int64_t>(value);
+    reg.decimal_ = static_cast<double>(value);
+  }
+}
+
+template <ComparisonType OP, CompiledPredicate::Kind KIND>
+void CompiledPredicate::RunCompare(const Instruction &instruction, const CompiledPredicate &program, Frame *frame) {
+  const Register &lhs = frame->registers_[instruction.lhs_];
+  const Register &rhs = frame->registers_[instruction.rhs_];
+  bool result;
+  if constexpr (KIND == Kind::DECIMAL) {
+    result = ComparisonExpression::Compare<OP>(lhs.decimal_, rhs.decimal_);
+  } else if constexpr (KIND == Kind::TIMESTAMP) {
+    // TIMESTAMP 在寄存器中按位存放, 比较时还原成无符号数
+    result =
+        ComparisonExpression::Compare<OP>(static_cast<uint64_t>(lhs.integer_), static_cast<uint64_t>(rhs.integer_));
+  } else {
+    result = ComparisonExpression::Compare<OP>(lhs.integer_, rhs.integer_);
+  }
+  Register &dst = frame->registers_[instruction.dst_];
+  dst.is_null_ = lhs.is_null_ || rhs.is_null_;
+  dst.integer_ = static_cast<int64_t>(result);
+  dst.decimal_ = static_cast<double>(result);
+}
+
+bool CompiledPredicate::Run(const Tuple *left_tuple, const Tuple *right_tuple, const std::vector<Value> *group_bys,
+                            const std::vector<Value> *aggregates) {
+  if (program_.empty() && registers_.empty()) {
+    return true;
+  }
+  Frame frame{registers_.data(), {left_tuple, right_tuple}, group_bys, aggregates};
+  for (const auto &instruction : program_) {
+    instruction.operation_(instruction, *this, &frame);
+  }
+  const Register &result = registers_[result_];
+  return !result.is_null_ && result.integer_ != 0;
+}
+
+}  // namespace bustub
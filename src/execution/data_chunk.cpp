@@ -0,0 +1,258 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// data_chunk.cpp
+//
+// Identification: src/execution/data_chunk.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/data_chunk.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "common/exception.h"
+#include "type/limits.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+template <typename T>
+bool IsNullSentinel(const char *storage, T null_value) {
+  T value;
+  memcpy(&value, storage, sizeof(T));
+  return value == null_value;
+}
+
+}  // namespace
+
+ColumnVector::ColumnVector(TypeId type, size_t capacity)
+    : type_(type), capacity_(capacity), data_(capacity * ElementSize(type)), validity_((capacity + 63) / 64, 0) {}
+
+size_t ColumnVector::ElementSize(TypeId type) {
+  switch (type) {
+    case TypeId::BOOLEAN:
+    case TypeId::TINYINT:
+      return sizeof(int8_t);
+    case TypeId::SMALLINT:
+      return sizeof(int16_t);
+    case TypeId::INTEGER:
+      return sizeof(int32_t);
+    case TypeId::BIGINT:
+      return sizeof(int64_t);
+    case TypeId::DECIMAL:
+      return sizeof(double);
+    case TypeId::TIMESTAMP:
+      return sizeof(uint64_t);
+    case TypeId::VARCHAR:
+      return sizeof(VarcharEntry);
+    default:
+      throw Exception(ExceptionType::UNKNOWN_TYPE, "ColumnVector: unknown column type");
+  }
+}
+
+bool ColumnVector::AllValid(const SelectionVector &sel) const {
+  for (size_t i = 0; i < sel.Size(); i++) {
+    if (!IsValid(sel[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void ColumnVector::SetVarchar(size_t row, const char *data, uint32_t length) {
+  auto &entry = Data<VarcharEntry>()[row];
+  entry.offset_ = static_cast<uint32_t>(heap_.size());
+  entry.length_ = length;
+  heap_.insert(heap_.end(), data, data + length);
+  SetValid(row);
+}
+
+void ColumnVector::Reset() {
+  std::fill(validity_.begin(), validity_.end(), 0);
+  heap_.clear();
+}
+
+void ColumnVector::DecodeFrom(size_t row, const char *storage) {
+  bool is_null;
+  switch (type_) {
+    case TypeId::BOOLEAN:
+      is_null = IsNullSentinel<int8_t>(storage, BUSTUB_BOOLEAN_NULL);
+      break;
+    case TypeId::TINYINT:
+      is_null = IsNullSentinel<int8_t>(storage, BUSTUB_INT8_NULL);
+      break;
+    case TypeId::SMALLINT:
+      is_null = IsNullSentinel<int16_t>(storage, BUSTUB_INT16_NULL);
+      break;
+    case TypeId::INTEGER:
+      is_null = IsNullSentinel<int32_t>(storage, BUSTUB_INT32_NULL);
+      break;
+    case TypeId::BIGINT:
+      is_null = IsNullSentinel<int64_t>(storage, BUSTUB_INT64_NULL);
+      break;
+    case TypeId::DECIMAL:
+      is_null = IsNullSentinel<double>(storage, BUSTUB_DECIMAL_NULL);
+      break;
+    case TypeId::TIMESTAMP:
+      is_null = IsNullSentinel<uint64_t>(storage, BUSTUB_TIMESTAMP_NULL);
+      break;
+    case TypeId::VARCHAR: {
+      // 变长类型先存 4 字节长度, 然后是数据
+      uint32_t length;
+      memcpy(&length, storage, sizeof(uint32_t));
+      if (length == BUSTUB_VALUE_NULL) {
+        SetNull(row);
+      } else {
+        SetVarchar(row, storage + sizeof(uint32_t), length);
+      }
+      return;
+    }
+    default:
+      throw Exception(ExceptionType::UNKNOWN_TYPE, "ColumnVector: unknown column type");
+  }
+  // NULL 行也把哨兵值拷贝进来, 这样数组中的值与 Value 中的值一致
+  size_t width = ElementSize(type_);
+  memcpy(data_.data() + row * width, storage, width);
+  if (is_null) {
+    SetNull(row);
+  } else {
+    SetValid(row);
+  }
+}
+
+Value ColumnVector::GetValue(size_t row) const {
+  if (type_ == TypeId::VARCHAR) {
+    if (!IsValid(row)) {
+      return Value(type_, nullptr, BUSTUB_VALUE_NULL, false);
+    }
+    std::string_view bytes = GetVarchar(row);
+    return Value(type_, bytes.data(), static_cast<uint32_t>(bytes.size()), true);
+  }
+  if (!IsValid(row)) {
+    return ValueFactory::GetNullValueByType(type_);
+  }
+  return Value::DeserializeFrom(data_.data() + row * ElementSize(type_), type_);
+}
+
+void ColumnVector::SetValue(size_t row, const Value &value) {
+  if (value.IsNull()) {
+    SetNull(row);
+    return;
+  }
+  if (value.GetTypeId() != type_) {
+    SetValue(row, value.CastAs(type_));
+    return;
+  }
+  if (type_ == TypeId::VARCHAR) {
+    SetVarchar(row, value.GetData(), value.GetLength());
+    return;
+  }
+  value.SerializeTo(data_.data() + row * ElementSize(type_));
+  SetValid(row);
+}
+
+void ColumnVector::CopyRows(const ColumnVector &source, const SelectionVector &sel) {
+  size_t width = ElementSize(type_);
+  for (size_t i = 0; i < sel.Size(); i++) {
+    uint32_t row = sel[i];
+    if (!source.IsValid(row)) {
+      SetNull(row);
+    } else if (type_ == TypeId::VARCHAR) {
+      std::string_view bytes = source.GetVarchar(row);
+      SetVarchar(row, bytes.data(), static_cast<uint32_t>(bytes.size()));
+    } else {
+      memcpy(data_.data() + row * width, source.data_.data() + row * width, width);
+      SetValid(row);
+    }
+  }
+}
+
+void ColumnVector::Gather(const ColumnVector &source, const SelectionVector &sel) {
+  if (type_ == TypeId::VARCHAR) {
+    for (size_t i = 0; i < sel.Size(); i++) {
+      if (source.IsValid(sel[i])) {
+        std::string_view bytes = source.GetVarchar(sel[i]);
+        SetVarchar(i, bytes.data(), static_cast<uint32_t>(bytes.size()));
+      } else {
+        SetNull(i);
+      }
+    }
+    return;
+  }
+  size_t width = ElementSize(type_);
+  for (size_t i = 0; i < sel.Size(); i++) {
+    memcpy(data_.data() + i * width, source.data_.data() + sel[i] * width, width);
+    if (source.IsValid(sel[i])) {
+      SetValid(i);
+    } else {
+      SetNull(i);
+    }
+  }
+}
+
+void DataChunk::Initialize(const Schema *schema, size_t capacity) {
+  schema_ = schema;
+  capacity_ = capacity;
+  size_ = 0;
+  columns_.clear();
+  columns_.reserve(schema->GetColumnCount());
+  for (const auto &column : schema->GetColumns()) {
+    columns_.emplace_back(column.GetType(), capacity);
+  }
+  sel_.SetIdentity(0);
+}
+
+void DataChunk::Reset() {
+  size_ = 0;
+  for (auto &column : columns_) {
+    column.Reset();
+  }
+  sel_.SetIdentity(0);
+}
+
+void DataChunk::AppendTuple(const Tuple &tuple) {
+  size_t row = size_;
+  const char *data = tuple.GetData();
+  for (uint32_t i = 0; i < columns_.size(); i++) {
+    const Column &column = schema_->GetColumn(i);
+    const char *storage = data + column.GetOffset();
+    if (!column.IsInlined()) {
+      storage = data + *reinterpret_cast<const uint32_t *>(storage);
+    }
+    columns_[i].DecodeFrom(row, storage);
+  }
+  size_++;
+  sel_.Resize(sel_.Size() + 1);
+  sel_.Data()[sel_.Size() - 1] = static_cast<uint32_t>(row);
+}
+
+void DataChunk::AppendRow(const char *tuple_data, const std::vector<uint32_t> &column_ids) {
+  for (uint32_t column_id : column_ids) {
+    const Column &column = schema_->GetColumn(column_id);
+    const char *storage = tuple_data + column.GetOffset();
+    if (!column.IsInlined()) {
+      // 非内联的列在元组中只存放数据相对于元组起始位置的偏移
+      storage = tuple_data + *reinterpret_cast<const uint32_t *>(storage);
+    }
+    columns_[column_id].DecodeFrom(size_, storage);
+  }
+  size_++;
+}
+
+Tuple DataChunk::GetTuple(size_t row) const {
+  std::vector<Value> values;
+  values.reserve(columns_.size());
+  for (const auto &column : columns_) {
+    values.push_back(column.GetValue(row));
+  }
+  return Tuple(values, schema_);
+}
+
+}  // namespace bustub
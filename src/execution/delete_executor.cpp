@@ -33,7 +33,18 @@ bool DeleteExecutor::Next([[maybe_unused]] Tuple *tuple, RID *rid) {
   Tuple delete_tuple;
   RID delete_rid;
   if(this->child_executor_->Next(&delete_tuple, &delete_rid)) {
-    this->table_info_->table_->ApplyDelete(delete_rid, this->exec_ctx_->GetTransaction());
+    // 子执行器输出的是投影后的元组, 需要从表中取出完整的元组来构造索引键
+    Tuple full_tuple;
+    Transaction *txn = this->exec_ctx_->GetTransaction();
+    bool fetched = this->table_info_->table_->GetTuple(delete_rid, &full_tuple, txn);
+    this->table_info_->table_->ApplyDelete(delete_rid, txn);
+    if(fetched) {
+      for(auto index_info : this->exec_ctx_->GetCatalog()->GetTableIndexes(this->table_info_->name_)) {
+        Tuple key = full_tuple.KeyFromTuple(this->table_info_->schema_, index_info->key_schema_,
+                                            index_info->index_->GetKeyAttrs());
+        index_info->index_->DeleteEntry(key, delete_rid, txn);
+      }
+    }
     return true;
   }
   return false;
@@ -12,6 +12,8 @@
 
 #include "execution/executors/distinct_executor.h"
 
+#include <algorithm>
+
 namespace bustub {
 
 DistinctExecutor::DistinctExecutor(ExecutorContext *exec_ctx, const DistinctPlanNode *plan,
@@ -23,22 +25,55 @@ DistinctExecutor::DistinctExecutor(ExecutorContext *exec_ctx, const DistinctPlan
 
 void DistinctExecutor::Init() {
       this->child_executor_->Init();
+      this->tuples_.clear();
+      this->ht_.clear();
+      this->pos_ = 0;
       Tuple tuple;
       RID rid;
       while(this->child_executor_->Next(&tuple, &rid)) {
-          auto hash_val = this->Hash(tuple);
-          if(this->ht_.count(hash_val) == 0){
-            this->ht_.insert({hash_val, tuple});
+          auto &bucket = this->ht_[this->Hash(tuple)];
+          bool duplicate = std::any_of(bucket.begin(), bucket.end(),
+                                       [&](size_t idx) { return this->Equals(this->tuples_[idx], tuple); });
+          if(!duplicate) {
+            bucket.push_back(this->tuples_.size());
+            this->tuples_.push_back(tuple);
+          }
+      }
+}
+
+hash_t DistinctExecutor::Hash(const Tuple &tuple) {
+      auto out_schema = this->GetOutputSchema();
+      hash_t hash_val = 0;
+      for(uint32_t idx = 0; idx < out_schema->GetColumnCount(); idx++){
+          auto value = tuple.GetValue(out_schema, idx);
+          hash_t column_hash = value.IsNull() ? NULL_HASH : HashUtil::HashValue(&value);
+          hash_val = HashUtil::CombineHashes(hash_val, column_hash);
+      }
+      return hash_val;
+}
+
+bool DistinctExecutor::Equals(const Tuple &lhs, const Tuple &rhs) {
+      auto out_schema = this->GetOutputSchema();
+      for(uint32_t idx = 0; idx < out_schema->GetColumnCount(); idx++){
+          auto l = lhs.GetValue(out_schema, idx);
+          auto r = rhs.GetValue(out_schema, idx);
+          if(l.IsNull() || r.IsNull()) {
+              if(l.IsNull() != r.IsNull()) {
+                  return false;
+              }
+              continue;
+          }
+          if(l.CompareEquals(r) != CmpBool::CmpTrue) {
+              return false;
           }
       }
-      this->iter_ = this->ht_.cbegin();
+      return true;
 }
 
 bool DistinctExecutor::Next(Tuple *tuple, RID *rid) {
-    if(this->iter_ != this->ht_.cend()) {
-      *tuple = this->GenerateTuple();
+    if(this->pos_ < this->tuples_.size()) {
+      *tuple = this->tuples_[this->pos_++];
       *rid = tuple->GetRid();
-      ++this->iter_;
       return true;
     }
     return false;
@@ -0,0 +1,403 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// external_sort.cpp
+//
+// Identification: src/execution/external_sort.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/external_sort.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+ExternalSort::ExternalSort(BufferPoolManager *bpm, const Schema *schema, std::vector<SortKey> keys,
+                           size_t memory_budget)
+    : bpm_(bpm),
+      schema_(schema),
+      keys_(std::move(keys)),
+      memory_budget_(memory_budget),
+      prefix_exact_(!keys_.empty() && IsNormalizable(keys_[0].expr_->GetReturnType())) {}
+
+ExternalSort::~ExternalSort() {
+  for (Run &run : this->runs_) {
+    this->DropRun(&run);
+  }
+  for (auto &reader : this->readers_) {
+    reader->run_.erase(reader->run_.begin(), reader->run_.begin() + reader->next_page_);
+    this->DropRun(&reader->run_);
+  }
+}
+
+bool ExternalSort::IsNormalizable(TypeId type) {
+  switch (type) {
+    case TypeId::BOOLEAN:
+    case TypeId::TINYINT:
+    case TypeId::SMALLINT:
+    case TypeId::INTEGER:
+    case TypeId::BIGINT:
+    case TypeId::DECIMAL:
+      return true;
+    default:
+      return false;
+  }
+}
+
+uint64_t ExternalSort::NormalizeKey(const Value &value) {
+  constexpr uint64_t sign_bit = uint64_t{1} << 63;
+  if (value.IsNull()) {
+    return 0;
+  }
+  // 整数翻转符号位后按无符号数比较，非 NULL 的最小值也大于 0
+  switch (value.GetTypeId()) {
+    case TypeId::BOOLEAN:
+    case TypeId::TINYINT:
+      return static_cast<uint64_t>(static_cast<int64_t>(value.GetAs<int8_t>())) ^ sign_bit;
+    case TypeId::SMALLINT:
+      return static_cast<uint64_t>(static_cast<int64_t>(value.GetAs<int16_t>())) ^ sign_bit;
+    case TypeId::INTEGER:
+      return static_cast<uint64_t>(static_cast<int64_t>(value.GetAs<int32_t>())) ^ sign_bit;
+    case TypeId::BIGINT:
+      return static_cast<uint64_t>(value.GetAs<int64_t>()) ^ sign_bit;
+    case TypeId::DECIMAL: {
+      // 负数翻转所有位，非负数只翻转符号位；-0.0 与 0.0 相等
+      double decimal = value.GetAs<double>();
+      if (decimal == 0) {
+        decimal = 0;
+      }
+      uint64_t bits;
+      std::memcpy(&bits, &decimal, sizeof(bits));
+      return (bits & sign_bit) != 0 ? ~bits : bits | sign_bit;
+    }
+    default:
+      UNREACHABLE("Only BOOLEANs, integers and DECIMALs are normalized.");
+  }
+}
+
+int ExternalSort::CompareKeys(const std::vector<Value> &lhs, const std::vector<Value> &rhs, size_t begin) const {
+  for (size_t i = begin; i < this->keys_.size(); i++) {
+    const Value &l = lhs[i];
+    const Value &r = rhs[i];
+    int cmp;
+    // NULL 排在所有值之前
+    if (l.IsNull() || r.IsNull()) {
+      cmp = static_cast<int>(!l.IsNull()) - static_cast<int>(!r.IsNull());
+    } else if (l.CompareLessThan(r) == CmpBool::CmpTrue) {
+      cmp = -1;
+    } else {
+      cmp = l.CompareGreaterThan(r) == CmpBool::CmpTrue ? 1 : 0;
+    }
+    if (cmp != 0) {
+      return this->keys_[i].ascending_ ? cmp : -cmp;
+    }
+  }
+  return 0;
+}
+
+int ExternalSort::Compare(const Entry &lhs, const Entry &rhs) const {
+  if (!this->prefix_exact_) {
+    return this->CompareKeys(lhs.keys_, rhs.keys_, 0);
+  }
+  if (lhs.prefix_ != rhs.prefix_) {
+    return lhs.prefix_ < rhs.prefix_ ? -1 : 1;
+  }
+  return this->CompareKeys(lhs.keys_, rhs.keys_, 1);
+}
+
+ExternalSort::Entry ExternalSort::MakeEntry(Tuple tuple) const {
+  Entry entry{0, {}, std::move(tuple)};
+  entry.keys_.reserve(this->keys_.size());
+  for (const SortKey &key : this->keys_) {
+    entry.keys_.push_back(key.expr_->Evaluate(&entry.tuple_, this->schema_));
+  }
+  if (this->prefix_exact_) {
+    // 降序时取反，NULL 随之排到最后，与 CompareKeys 一致
+    entry.prefix_ = NormalizeKey(entry.keys_[0]);
+    if (!this->keys_[0].ascending_) {
+      entry.prefix_ = ~entry.prefix_;
+    }
+  }
+  return entry;
+}
+
+void ExternalSort::SortBuffer() {
+  auto less = [this](const Entry &lhs, const Entry &rhs) { return this->Less(lhs, rhs); };
+  size_t size = this->buffer_.size();
+  if (!this->prefix_exact_ || size < RADIX_SORT_THRESHOLD) {
+    // 稳定排序，键相同的 tuple 保持加入的顺序
+    std::stable_sort(this->buffer_.begin(), this->buffer_.end(), less);
+    return;
+  }
+
+  // 对归一化的第一个键做 LSD 基数排序，一遍统计出 8 个字节的直方图，
+  // 所有 tuple 在某个字节上相同时跳过这一趟
+  std::vector<SortItem> items(size);
+  std::vector<SortItem> scratch(size);
+  std::vector<std::array<uint32_t, 256>> counts(sizeof(uint64_t));
+  for (auto &count : counts) {
+    count.fill(0);
+  }
+  for (size_t i = 0; i < size; i++) {
+    uint64_t prefix = this->buffer_[i].prefix_;
+    items[i] = SortItem{prefix, static_cast<uint32_t>(i)};
+    for (size_t byte = 0; byte < sizeof(uint64_t); byte++) {
+      counts[byte][(prefix >> (byte * 8)) & 0xFF]++;
+    }
+  }
+  for (size_t byte = 0; byte < sizeof(uint64_t); byte++) {
+    size_t shift = byte * 8;
+    std::array<uint32_t, 256> &count = counts[byte];
+    if (count[(items[0].prefix_ >> shift) & 0xFF] == size) {
+      continue;
+    }
+    uint32_t offset = 0;
+    for (uint32_t &bucket : count) {
+      uint32_t bucket_size = bucket;
+      bucket = offset;
+      offset += bucket_size;
+    }
+    for (const SortItem &item : items) {
+      scratch[count[(item.prefix_ >> shift) & 0xFF]++] = item;
+    }
+    items.swap(scratch);
+  }
+
+  std::vector<Entry> sorted;
+  sorted.reserve(size);
+  for (const SortItem &item : items) {
+    sorted.push_back(std::move(this->buffer_[item.index_]));
+  }
+  this->buffer_ = std::move(sorted);
+
+  // 第一个键相同的 tuple 再按其余的键排序
+  if (this->keys_.size() > 1) {
+    for (size_t begin = 0; begin < size;) {
+      size_t end = begin + 1;
+      while (end < size && this->buffer_[end].prefix_ == this->buffer_[begin].prefix_) {
+        end++;
+      }
+      if (end - begin > 1) {
+        std::stable_sort(this->buffer_.begin() + begin, this->buffer_.begin() + end, less);
+      }
+      begin = end;
+    }
+  }
+}
+
+void ExternalSort::Add(const Tuple &tuple) {
+  BUSTUB_ASSERT(!this->finished_, "Tuples cannot be added once the sort is finished.");
+  this->buffer_.push_back(this->MakeEntry(tuple));
+  this->buffer_bytes_ += EntryBytes(this->buffer_.back());
+  if (this->buffer_bytes_ > this->memory_budget_) {
+    this->SpillRun();
+  }
+}
+
+void ExternalSort::SpillRun() {
+  this->SortBuffer();
+  RunWriter writer;
+  for (const Entry &entry : this->buffer_) {
+    this->WriteTuple(&writer, entry.tuple_);
+  }
+  this->runs_.push_back(this->CloseRun(&writer));
+  this->run_count_++;
+  this->buffer_.clear();
+  this->buffer_bytes_ = 0;
+}
+
+void ExternalSort::Finish() {
+  this->finished_ = true;
+  if (this->runs_.empty()) {
+    this->SortBuffer();
+    this->buffer_pos_ = 0;
+    return;
+  }
+  if (!this->buffer_.empty()) {
+    this->SpillRun();
+  }
+  this->buffer_.shrink_to_fit();
+
+  // 每个参与归并的 run 在内存中保留一个页面，run 太多时先把相邻的 run 归并成更长的 run
+  size_t fan_in = std::clamp<size_t>(this->memory_budget_ / PAGE_SIZE, 2, MAX_FAN_IN);
+  while (this->runs_.size() > fan_in) {
+    std::vector<Run> merged;
+    for (size_t begin = 0; begin < this->runs_.size(); begin += fan_in) {
+      size_t end = std::min(begin + fan_in, this->runs_.size());
+      if (end - begin == 1) {
+        merged.push_back(std::move(this->runs_[begin]));
+        continue;
+      }
+      this->StartMerge(std::vector<Run>(std::make_move_iterator(this->runs_.begin() + begin),
+                                        std::make_move_iterator(this->runs_.begin() + end)));
+      RunWriter writer;
+      Entry entry;
+      while (this->PopMerged(&entry)) {
+        this->WriteTuple(&writer, entry.tuple_);
+      }
+      merged.push_back(this->CloseRun(&writer));
+    }
+    this->runs_ = std::move(merged);
+  }
+  this->StartMerge(std::move(this->runs_));
+  this->runs_.clear();
+}
+
+bool ExternalSort::Next(Tuple *tuple) {
+  BUSTUB_ASSERT(this->finished_, "Tuples can only be read once the sort is finished.");
+  if (this->readers_.empty()) {
+    if (this->buffer_pos_ == this->buffer_.size()) {
+      return false;
+    }
+    *tuple = std::move(this->buffer_[this->buffer_pos_++].tuple_);
+    return true;
+  }
+  Entry entry;
+  if (!this->PopMerged(&entry)) {
+    return false;
+  }
+  *tuple = std::move(entry.tuple_);
+  return true;
+}
+
+void ExternalSort::WriteTuple(RunWriter *writer, const Tuple &tuple) {
+  TmpTuple tmp_tuple(INVALID_PAGE_ID, 0);
+  if (writer->page_ != nullptr && writer->page_->Insert(tuple, &tmp_tuple)) {
+    return;
+  }
+  if (writer->page_ != nullptr) {
+    this->bpm_->UnpinPage(writer->page_->GetTablePageId(), true);
+  }
+  page_id_t page_id;
+  Page *page = this->bpm_->NewPage(&page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "external sort cannot allocate a page for a run");
+  }
+  writer->page_ = reinterpret_cast<TmpTuplePage *>(page);
+  writer->page_->Init(page_id, PAGE_SIZE);
+  writer->run_.push_back(page_id);
+  if (!writer->page_->Insert(tuple, &tmp_tuple)) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "external sort cannot write a tuple larger than a page");
+  }
+}
+
+ExternalSort::Run ExternalSort::CloseRun(RunWriter *writer) {
+  if (writer->page_ != nullptr) {
+    this->bpm_->UnpinPage(writer->page_->GetTablePageId(), true);
+    writer->page_ = nullptr;
+  }
+  return std::move(writer->run_);
+}
+
+bool ExternalSort::Advance(RunReader *reader) {
+  if (reader->pos_ < reader->page_.size()) {
+    reader->pos_++;
+  }
+  if (reader->pos_ < reader->page_.size()) {
+    return true;
+  }
+  if (reader->next_page_ == reader->run_.size()) {
+    reader->page_.clear();
+    reader->done_ = true;
+    return false;
+  }
+  page_id_t page_id = reader->run_[reader->next_page_++];
+  Page *page = this->bpm_->FetchPage(page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "external sort cannot fetch a page of a run");
+  }
+  // TmpTuplePage 从页尾向前存放，读出来的顺序与写入的顺序相反
+  auto *tmp_page = reinterpret_cast<TmpTuplePage *>(page);
+  reader->page_.clear();
+  for (uint32_t offset = tmp_page->GetFreeSpacePointer(); offset < PAGE_SIZE;) {
+    Tuple tuple;
+    offset = tmp_page->Get(offset, &tuple);
+    reader->page_.push_back(this->MakeEntry(std::move(tuple)));
+  }
+  this->bpm_->UnpinPage(page_id, false);
+  this->bpm_->DeletePage(page_id);
+  std::reverse(reader->page_.begin(), reader->page_.end());
+  reader->pos_ = 0;
+  reader->done_ = reader->page_.empty();
+  return !reader->done_;
+}
+
+void ExternalSort::StartMerge(std::vector<Run> runs) {
+  this->readers_.clear();
+  for (size_t i = 0; i < runs.size(); i++) {
+    auto reader = std::make_unique<RunReader>();
+    reader->index_ = i;
+    reader->run_ = std::move(runs[i]);
+    this->Advance(reader.get());
+    this->readers_.push_back(std::move(reader));
+  }
+
+  // 自底向上建立败者树，叶子 i 位于 winners[k + i]，内部节点记录落败者并把胜者送往上层
+  size_t k = this->readers_.size();
+  if (k == 0) {
+    return;
+  }
+  this->tree_.assign(k, 0);
+  std::vector<size_t> winners(2 * k);
+  for (size_t i = 0; i < k; i++) {
+    winners[k + i] = i;
+  }
+  for (size_t node = k - 1; node >= 1; node--) {
+    size_t lhs = winners[2 * node];
+    size_t rhs = winners[2 * node + 1];
+    bool lhs_wins = this->Beats(lhs, rhs);
+    winners[node] = lhs_wins ? lhs : rhs;
+    this->tree_[node] = lhs_wins ? rhs : lhs;
+  }
+  this->tree_[0] = winners[1];
+}
+
+bool ExternalSort::Beats(size_t lhs, size_t rhs) const {
+  const RunReader &l = *this->readers_[lhs];
+  const RunReader &r = *this->readers_[rhs];
+  // 读完的 run 视为无穷大，键相同时先输出前面的 run
+  if (l.done_ || r.done_) {
+    return !l.done_ && (r.done_ || lhs < rhs);
+  }
+  int cmp = this->Compare(l.page_[l.pos_], r.page_[r.pos_]);
+  return cmp != 0 ? cmp < 0 : l.index_ < r.index_;
+}
+
+bool ExternalSort::PopMerged(Entry *entry) {
+  if (this->readers_.empty()) {
+    return false;
+  }
+  size_t winner = this->tree_[0];
+  RunReader *reader = this->readers_[winner].get();
+  if (reader->done_) {
+    return false;
+  }
+  *entry = std::move(reader->page_[reader->pos_]);
+  this->Advance(reader);
+  // 只需沿胜者叶子到根的路径重新比较，每层与该节点记录的落败者比较一次
+  size_t k = this->readers_.size();
+  for (size_t node = (winner + k) / 2; node >= 1; node /= 2) {
+    if (this->Beats(this->tree_[node], winner)) {
+      std::swap(this->tree_[node], winner);
+    }
+  }
+  this->tree_[0] = winner;
+  return true;
+}
+
+void ExternalSort::DropRun(Run *run) {
+  for (page_id_t page_id : *run) {
+    this->bpm_->DeletePage(page_id);
+  }
+  run->clear();
+}
+
+}  // namespace bustub
@@ -11,100 +11,690 @@
 //===----------------------------------------------------------------------===//
 
 #include "execution/executors/hash_join_executor.h"
-#include "execution/expressions/column_value_expression.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+
+#include "common/exception.h"
 
 namespace bustub {
 
 HashJoinExecutor::HashJoinExecutor(ExecutorContext *exec_ctx, const HashJoinPlanNode *plan,
                                    std::unique_ptr<AbstractExecutor> &&left_child,
                                    std::unique_ptr<AbstractExecutor> &&right_child)
-    : AbstractExecutor(exec_ctx) {
-        this->plan_ = plan;
-        this->left_child_ = std::move(left_child);
-        this->right_child_ = std::move(right_child);
-        this->tuple_idx = 0;
-    }
+    : AbstractExecutor(exec_ctx),
+      plan_(plan),
+      left_child_(std::move(left_child)),
+      right_child_(std::move(right_child)) {}
 
 void HashJoinExecutor::Init() {
-    this->left_child_.get()->Init();
-    this->right_child_.get()->Init();
-    // 初始化的时候应当建立哈希表
-    const ColumnValueExpression* left_join_key_expression = dynamic_cast<const ColumnValueExpression*>(this->plan_->LeftJoinKeyExpression());
-    auto left_schema = this->plan_->GetLeftPlan()->OutputSchema();
-    Tuple tuple;
-    RID rid;
-    while(this->left_child_.get()->Next(&tuple, &rid)) {
-        // 获得进行 hash join 的 index 的值
-        Value value = tuple.GetValue(left_schema, left_join_key_expression->GetColIdx());
-        auto data = value.ToString();
-        auto hash_val = this->Hash(data);
-        if(this->ht_.count(hash_val) == 0){
-            std::vector<Tuple> bucket;
-            bucket.push_back(tuple);
-            this->ht_.insert({hash_val, bucket});
+  this->left_child_->Init();
+  this->right_child_->Init();
+
+  // 整数类型之间的哈希与比较是一致的，只有与 DECIMAL 比较时需要先统一类型
+  TypeId left_type = this->plan_->LeftJoinKeyExpression()->GetReturnType();
+  TypeId right_type = this->plan_->RightJoinKeyExpression()->GetReturnType();
+  this->key_type_ = TypeId::INVALID;
+  if (left_type != right_type && (left_type == TypeId::DECIMAL || right_type == TypeId::DECIMAL)) {
+    this->key_type_ = TypeId::DECIMAL;
+  }
+
+  this->Build();
+
+  this->probe_batch_.Clear();
+  this->probe_keys_.clear();
+  this->probe_hashes_.clear();
+  this->probe_order_.clear();
+  this->probe_pos_ = 0;
+  this->probe_idx_ = 0;
+  this->chain_ = INVALID_ENTRY;
+  this->probe_tuples_.clear();
+  this->outputs_.clear();
+  this->output_thread_ = 0;
+  this->output_pos_ = 0;
+}
+
+HashJoinExecutor::~HashJoinExecutor() {
+  {
+    std::lock_guard<std::mutex> guard(this->pool_latch_);
+    this->pool_stop_ = true;
+  }
+  this->pool_cv_.notify_all();
+  for (auto &worker : this->workers_) {
+    worker.join();
+  }
+  this->DropSpills();
+}
+
+void HashJoinExecutor::ParallelFor(size_t task_count, const std::function<void(size_t, size_t)> &task) {
+  size_t parallelism = this->plan_->GetParallelism();
+  if (parallelism <= 1 || task_count <= 1) {
+    for (size_t i = 0; i < task_count; i++) {
+      task(0, i);
+    }
+    return;
+  }
+  // 工作线程只在第一次并行时创建，之后每一步都复用
+  while (this->workers_.size() + 1 < parallelism) {
+    this->workers_.emplace_back(&HashJoinExecutor::WorkerLoop, this, this->workers_.size() + 1);
+  }
+  {
+    std::lock_guard<std::mutex> guard(this->pool_latch_);
+    this->pool_task_ = &task;
+    this->pool_task_count_ = task_count;
+    this->pool_next_ = 0;
+    this->pool_error_ = nullptr;
+    this->pool_busy_ = this->workers_.size();
+    this->pool_round_++;
+  }
+  this->pool_cv_.notify_all();
+  // 当前线程作为 0 号线程一起领取任务，再等待其他线程做完手上的任务
+  this->RunTasks(0);
+  std::unique_lock<std::mutex> lock(this->pool_latch_);
+  this->pool_done_cv_.wait(lock, [this] { return this->pool_busy_ == 0; });
+  this->pool_task_ = nullptr;
+  if (this->pool_error_) {
+    std::rethrow_exception(this->pool_error_);
+  }
+}
+
+void HashJoinExecutor::RunTasks(size_t thread) {
+  // 任务按 morsel 动态分配，先做完的线程继续领取下一个
+  size_t task_count = this->pool_task_count_;
+  try {
+    for (size_t i = this->pool_next_++; i < task_count; i = this->pool_next_++) {
+      (*this->pool_task_)(thread, i);
+    }
+  } catch (...) {
+    std::lock_guard<std::mutex> guard(this->pool_latch_);
+    this->pool_error_ = std::current_exception();
+    this->pool_next_ = task_count;
+  }
+}
+
+void HashJoinExecutor::WorkerLoop(size_t thread) {
+  uint64_t round = 0;
+  std::unique_lock<std::mutex> lock(this->pool_latch_);
+  while (true) {
+    this->pool_cv_.wait(lock, [&] { return this->pool_stop_ || this->pool_round_ != round; });
+    if (this->pool_stop_) {
+      return;
+    }
+    round = this->pool_round_;
+    lock.unlock();
+    this->RunTasks(thread);
+    lock.lock();
+    if (--this->pool_busy_ == 0) {
+      this->pool_done_cv_.notify_one();
+    }
+  }
+}
+
+Value HashJoinExecutor::EvaluateKey(const AbstractExpression *expr, const Tuple &tuple, const Schema *schema) const {
+  Value key = expr->Evaluate(&tuple, schema);
+  if (this->key_type_ != TypeId::INVALID && !key.IsNull() && key.GetTypeId() != this->key_type_) {
+    return key.CastAs(this->key_type_);
+  }
+  return key;
+}
+
+void HashJoinExecutor::Build() {
+  this->DropSpills();
+  this->spilled_ = false;
+  this->entries_.clear();
+
+  // 子执行器只能由当前线程读取，key 的计算与哈希留给 HashEntries 并行完成
+  // VARCHAR key 在堆上另有缓冲区，需要读取时就求值才能计入预算
+  // 估算构建侧在内存中的大小，超出预算时改为落盘分区
+  const AbstractExpression *key_expr = this->plan_->LeftJoinKeyExpression();
+  const Schema *left_schema = this->plan_->GetLeftPlan()->OutputSchema();
+  bool varchar_key = key_expr->GetReturnType() == TypeId::VARCHAR;
+  size_t bytes = 0;
+  TupleBatch batch;
+  while (this->left_child_->NextBatch(&batch)) {
+    for (size_t i = 0; i < batch.Size(); i++) {
+      const Tuple &tuple = batch.TupleAt(i);
+      Value key = varchar_key ? this->EvaluateKey(key_expr, tuple, left_schema) : Value();
+      bytes += EntryBytes(tuple, key);
+      this->entries_.push_back(Entry{0, INVALID_ENTRY, std::move(key), tuple});
+      if (bytes > this->plan_->GetMemoryBudget()) {
+        this->HashEntries();
+        this->SpillInputs(batch, i + 1);
+        this->LoadNextPartition();
+        return;
+      }
+    }
+  }
+  this->HashEntries();
+  this->BuildTable();
+}
+
+void HashJoinExecutor::HashEntries() {
+  const AbstractExpression *key_expr = this->plan_->LeftJoinKeyExpression();
+  const Schema *left_schema = this->plan_->GetLeftPlan()->OutputSchema();
+  size_t size = this->entries_.size();
+  this->ParallelFor((size + MORSEL_SIZE - 1) / MORSEL_SIZE, [&](size_t thread, size_t morsel) {
+    for (size_t i = morsel * MORSEL_SIZE; i < std::min(size, (morsel + 1) * MORSEL_SIZE); i++) {
+      Entry &entry = this->entries_[i];
+      // 已经在读取时求值的 key 不再重复计算
+      if (entry.key_.GetTypeId() == TypeId::INVALID) {
+        entry.key_ = this->EvaluateKey(key_expr, entry.tuple_, left_schema);
+      }
+      if (!entry.key_.IsNull()) {
+        entry.hash_ = HashUtil::HashValue(&entry.key_);
+      }
+    }
+  });
+  // NULL 不与任何值相等，不需要放进哈希表
+  this->entries_.erase(std::remove_if(this->entries_.begin(), this->entries_.end(),
+                                      [](const Entry &entry) { return entry.key_.IsNull(); }),
+                       this->entries_.end());
+}
+
+void HashJoinExecutor::BuildTable() {
+  this->slots_.clear();
+  this->partitions_.clear();
+  size_t bytes = 0;
+  for (const Entry &entry : this->entries_) {
+    bytes += EntryBytes(entry.tuple_, entry.key_);
+  }
+
+  size_t parallelism = this->plan_->GetParallelism();
+  this->radix_bits_ = 0;
+  while (this->radix_bits_ < MAX_RADIX_BITS && (bytes >> this->radix_bits_) > PARTITION_BYTES) {
+    this->radix_bits_++;
+  }
+  // 并行构建时每个线程负责若干个分区的表，分区数至少要让各线程都有活干
+  if (parallelism > 1 && this->entries_.size() >= MORSEL_SIZE) {
+    while (this->radix_bits_ < MAX_RADIX_BITS && (static_cast<size_t>(1) << this->radix_bits_) < parallelism * 4) {
+      this->radix_bits_++;
+    }
+  }
+  size_t partition_count = static_cast<size_t>(1) << this->radix_bits_;
+
+  // 按哈希值的高位对 entry 做一趟计数排序，使每个分区的 entry 连续存放
+  // entry 被切成每个线程一段，先统计各段在各分区的数量，再各自写到互不重叠的位置
+  size_t size = this->entries_.size();
+  size_t chunk_count = std::max<size_t>(1, std::min(parallelism, size / MORSEL_SIZE));
+  size_t chunk_size = (size + chunk_count - 1) / chunk_count;
+  std::vector<std::vector<size_t>> histograms(chunk_count, std::vector<size_t>(partition_count, 0));
+  this->ParallelFor(chunk_count, [&](size_t thread, size_t chunk) {
+    for (size_t i = chunk * chunk_size; i < std::min(size, (chunk + 1) * chunk_size); i++) {
+      histograms[chunk][this->PartitionOf(this->entries_[i].hash_)]++;
+    }
+  });
+  std::vector<size_t> offsets(partition_count + 1, 0);
+  for (size_t p = 0; p < partition_count; p++) {
+    offsets[p + 1] = offsets[p];
+    for (size_t chunk = 0; chunk < chunk_count; chunk++) {
+      size_t count = histograms[chunk][p];
+      histograms[chunk][p] = offsets[p + 1];
+      offsets[p + 1] += count;
+    }
+  }
+  if (partition_count > 1) {
+    std::vector<Entry> partitioned(size);
+    this->ParallelFor(chunk_count, [&](size_t thread, size_t chunk) {
+      std::vector<size_t> &cursor = histograms[chunk];
+      for (size_t i = chunk * chunk_size; i < std::min(size, (chunk + 1) * chunk_size); i++) {
+        Entry &entry = this->entries_[i];
+        partitioned[cursor[this->PartitionOf(entry.hash_)]++] = std::move(entry);
+      }
+    });
+    this->entries_ = std::move(partitioned);
+  }
+
+  // 每个分区一张开放寻址表，容量是 entry 数两倍以上的 2 的幂，槽位用哈希值的低位
+  this->partitions_.resize(partition_count);
+  size_t slot_count = 0;
+  for (size_t p = 0; p < partition_count; p++) {
+    size_t capacity = 1;
+    while (capacity < 2 * (offsets[p + 1] - offsets[p])) {
+      capacity <<= 1;
+    }
+    this->partitions_[p] = Partition{slot_count, capacity - 1};
+    slot_count += capacity;
+  }
+  this->slots_.assign(slot_count, Slot{0, INVALID_ENTRY});
+
+  // 各分区的表互不相交，每个分区由一个线程构建，不需要加锁
+  this->ParallelFor(partition_count, [&](size_t thread, size_t p) {
+    const Partition &partition = this->partitions_[p];
+    // 倒序插入并头插到链上，这样链上的顺序与输入顺序一致
+    for (size_t e = offsets[p + 1]; e > offsets[p]; e--) {
+      uint32_t idx = static_cast<uint32_t>(e - 1);
+      Entry &entry = this->entries_[idx];
+      size_t pos = entry.hash_ & partition.mask_;
+      while (true) {
+        Slot &slot = this->slots_[partition.slot_begin_ + pos];
+        if (slot.head_ == INVALID_ENTRY) {
+          slot = Slot{entry.hash_, idx};
+          break;
         }
+        if (slot.hash_ == entry.hash_ &&
+            this->entries_[slot.head_].key_.CompareEquals(entry.key_) == CmpBool::CmpTrue) {
+          entry.next_ = slot.head_;
+          slot.head_ = idx;
+          break;
+        }
+        pos = (pos + 1) & partition.mask_;
+      }
+    }
+  });
+}
+
+bool HashJoinExecutor::ReadProbeBatch(TupleBatch *batch) {
+  if (!this->spilled_) {
+    return this->right_child_->NextBatch(batch);
+  }
+  if (this->probe_file_.pages_.empty()) {
+    return false;
+  }
+  this->ReadSpillPage(&this->probe_file_, batch);
+  return true;
+}
+
+bool HashJoinExecutor::FetchProbeBatch() {
+  if (!this->ReadProbeBatch(&this->probe_batch_)) {
+    return false;
+  }
+  const AbstractExpression *key_expr = this->plan_->RightJoinKeyExpression();
+  const Schema *right_schema = this->plan_->GetRightPlan()->OutputSchema();
+  size_t size = this->probe_batch_.Size();
+  this->probe_keys_.resize(size);
+  this->probe_hashes_.resize(size);
+
+  size_t partition_count = this->partitions_.size();
+  std::vector<size_t> offsets(partition_count + 1, 0);
+  for (size_t i = 0; i < size; i++) {
+    this->probe_keys_[i] = this->EvaluateKey(key_expr, this->probe_batch_.TupleAt(i), right_schema);
+    if (this->probe_keys_[i].IsNull()) {
+      continue;
+    }
+    this->probe_hashes_[i] = HashUtil::HashValue(&this->probe_keys_[i]);
+    offsets[this->PartitionOf(this->probe_hashes_[i]) + 1]++;
+  }
+  for (size_t p = 0; p < partition_count; p++) {
+    offsets[p + 1] += offsets[p];
+  }
+
+  // 按分区分组探测，同一分区的表与 entry 在被探测时留在缓存中
+  this->probe_order_.resize(offsets[partition_count]);
+  for (size_t i = 0; i < size; i++) {
+    if (!this->probe_keys_[i].IsNull()) {
+      this->probe_order_[offsets[this->PartitionOf(this->probe_hashes_[i])]++] = static_cast<uint32_t>(i);
+    }
+  }
+  this->probe_pos_ = 0;
+  return true;
+}
+
+size_t HashJoinExecutor::SpillFanout() const {
+  // 每个分区写入时固定一个页面，分区数受缓冲池大小和内存预算限制
+  size_t fanout = std::min(MAX_SPILL_FANOUT, this->exec_ctx_->GetBufferPoolManager()->GetPoolSize() / 4);
+  fanout = std::min(fanout, this->plan_->GetMemoryBudget() / PAGE_SIZE);
+  return std::max<size_t>(fanout, 2);
+}
+
+void HashJoinExecutor::SpillInputs(const TupleBatch &left_batch, size_t left_pos) {
+  size_t fanout = this->SpillFanout();
+  const uint32_t level = 1;
+
+  // 先把已经读入内存的构建侧 tuple 写出，再继续读取左侧剩余的 tuple
+  std::vector<SpillWriter> left(fanout);
+  for (const Entry &entry : this->entries_) {
+    this->SpillTuple(&left[this->SpillPartitionOf(entry.hash_, level, fanout)], entry.tuple_, entry.key_);
+  }
+  this->entries_.clear();
+  this->entries_.shrink_to_fit();
+
+  const AbstractExpression *left_key = this->plan_->LeftJoinKeyExpression();
+  const Schema *left_schema = this->plan_->GetLeftPlan()->OutputSchema();
+  auto spill_left = [&](const Tuple &tuple) {
+    Value key = this->EvaluateKey(left_key, tuple, left_schema);
+    if (!key.IsNull()) {
+      this->SpillTuple(&left[this->SpillPartitionOf(HashUtil::HashValue(&key), level, fanout)], tuple, key);
+    }
+  };
+  for (size_t i = left_pos; i < left_batch.Size(); i++) {
+    spill_left(left_batch.TupleAt(i));
+  }
+  TupleBatch batch;
+  while (this->left_child_->NextBatch(&batch)) {
+    for (size_t i = 0; i < batch.Size(); i++) {
+      spill_left(batch.TupleAt(i));
+    }
+  }
+  for (SpillWriter &writer : left) {
+    this->CloseSpill(&writer);
+  }
+
+  // 探测侧只需要写出左侧分区非空的 tuple
+  const AbstractExpression *right_key = this->plan_->RightJoinKeyExpression();
+  const Schema *right_schema = this->plan_->GetRightPlan()->OutputSchema();
+  std::vector<SpillWriter> right(fanout);
+  while (this->right_child_->NextBatch(&batch)) {
+    for (size_t i = 0; i < batch.Size(); i++) {
+      Value key = this->EvaluateKey(right_key, batch.TupleAt(i), right_schema);
+      if (key.IsNull()) {
+        continue;
+      }
+      size_t partition = this->SpillPartitionOf(HashUtil::HashValue(&key), level, fanout);
+      if (!left[partition].file_.pages_.empty()) {
+        this->SpillTuple(&right[partition], batch.TupleAt(i), key);
+      }
     }
+  }
+  for (SpillWriter &writer : right) {
+    this->CloseSpill(&writer);
+  }
 
-    // 这里实际把 Next() 要做的事情放到 Init() 来做，然后放到
-    // 一个成员变量里
-    Tuple right_tuple;
-    RID right_rid;
-    while(this->right_child_.get()->Next(&right_tuple, &right_rid)){
-        // this->current_tuple = right_tuple;
-        auto right_schema = this->plan_->GetRightPlan()->OutputSchema();
-        auto right_join_key_experssion = dynamic_cast<const ColumnValueExpression*>(this->plan_->RightJoinKeyExpression());
-        auto value = right_tuple.GetValue(right_schema, right_join_key_experssion->GetColIdx());
-        auto data = value.ToString();
-        auto hash_val = this->Hash(data);
-        if(this->ht_.find(hash_val) != this->ht_.end()) {
-            auto bucket = this->ht_.find(hash_val)->second;
-            for(auto left_tuple_item: bucket) {
-                // left_tuple_item 为存储的 Tuple
-                // 此时对其执行 join 操作
-                // 也就是根据 out_schema 将其拼接成输出的 Tuple
-                
-                std::vector<Value> tuple_values;
-                // 获取到输出的所有 Column
-                // std::vector<Column> columns = this->plan_->OutputSchema()->GetColumns();
-                // for(auto column: columns){
-                //     auto left_columns = this->plan_->GetLeftPlan()->OutputSchema()->GetColumns();
-                //     auto right_columns = this->plan_->GetRightPlan()->OutputSchema()->GetColumns();
-                //     // 分别将输出的 column 与左右 column 进行比较并 push 到 tuple_values 中
-                //     for(auto left_column: left_columns){
-                //         if (left_column.GetExpr() == column.GetExpr()) {
-                //             // auto value = left_tuple_item.GetValue()
-                //         }
-                //     }
-                // }
-                for(uint32_t column_idx = 0; column_idx < left_schema->GetColumnCount(); column_idx++){
-                    auto left_value = left_tuple_item.GetValue(left_schema, column_idx);
-                    tuple_values.push_back(left_value);
-                }
-                for(uint32_t column_idx = 0; column_idx < right_schema->GetColumnCount(); column_idx++){
-                    auto right_value = right_tuple.GetValue(right_schema, column_idx);
-                    tuple_values.push_back(right_value);
-                }
-                auto out_tuple = Tuple(tuple_values, this->GetOutputSchema());
-                auto out_rid = out_tuple.GetRid();
-                this->results.push_back({out_rid, out_tuple});
-            }
+  this->spilled_ = true;
+  this->AddPartitions(&left, &right, level);
+}
+
+void HashJoinExecutor::Repartition(SpillPartition *partition) {
+  size_t fanout = this->SpillFanout();
+  uint32_t level = partition->level_ + 1;
+  auto spill = [&](SpillFile *file, const AbstractExpression *key_expr, const Schema *schema,
+                   std::vector<SpillWriter> *writers, const std::vector<SpillWriter> *filter) {
+    TupleBatch batch;
+    while (!file->pages_.empty()) {
+      this->ReadSpillPage(file, &batch);
+      for (size_t i = 0; i < batch.Size(); i++) {
+        Value key = this->EvaluateKey(key_expr, batch.TupleAt(i), schema);
+        size_t idx = this->SpillPartitionOf(HashUtil::HashValue(&key), level, fanout);
+        if (filter == nullptr || !(*filter)[idx].file_.pages_.empty()) {
+          this->SpillTuple(&(*writers)[idx], batch.TupleAt(i), key);
         }
+      }
     }
+    for (SpillWriter &writer : *writers) {
+      this->CloseSpill(&writer);
+    }
+  };
+
+  std::vector<SpillWriter> left(fanout);
+  spill(&partition->left_, this->plan_->LeftJoinKeyExpression(), this->plan_->GetLeftPlan()->OutputSchema(), &left,
+        nullptr);
+  std::vector<SpillWriter> right(fanout);
+  spill(&partition->right_, this->plan_->RightJoinKeyExpression(), this->plan_->GetRightPlan()->OutputSchema(),
+        &right, &left);
+  this->AddPartitions(&left, &right, level);
 }
 
-bool HashJoinExecutor::Next(Tuple *tuple, RID *rid) {
-    // 这里需要不断遍历 right_child 每条 tuple 并进行 hash 与
-    // 构建哈希表中的进行连接,需要考虑一下如何判断连接的 tuple 是否
-    // 该调用 Next() 方法
-    // printf("[Debug] Call Next.\n");
-    if(this->tuple_idx >= this->results.size()) {
+void HashJoinExecutor::AddPartitions(std::vector<SpillWriter> *left, std::vector<SpillWriter> *right,
+                                     uint32_t level) {
+  for (size_t i = 0; i < left->size(); i++) {
+    SpillFile &left_file = (*left)[i].file_;
+    SpillFile &right_file = (*right)[i].file_;
+    if (left_file.pages_.empty() || right_file.pages_.empty()) {
+      this->DropSpillFile(&left_file);
+      this->DropSpillFile(&right_file);
+      continue;
+    }
+    this->pending_.push_back(SpillPartition{std::move(left_file), std::move(right_file), level});
+  }
+}
+
+bool HashJoinExecutor::LoadNextPartition() {
+  this->DropSpillFile(&this->probe_file_);
+  this->probe_order_.clear();
+  this->probe_pos_ = 0;
+  this->chain_ = INVALID_ENTRY;
+
+  while (!this->pending_.empty()) {
+    SpillPartition partition = std::move(this->pending_.back());
+    this->pending_.pop_back();
+    // 仍然超出预算的分区换一个哈希函数再分区
+    // 同一个 key 的 tuple 无法再拆分，达到层数上限后直接构建
+    if (partition.left_.bytes_ > this->plan_->GetMemoryBudget() && partition.level_ < MAX_SPILL_LEVEL) {
+      this->Repartition(&partition);
+      continue;
+    }
+
+    this->entries_.clear();
+    TupleBatch batch;
+    while (!partition.left_.pages_.empty()) {
+      this->ReadSpillPage(&partition.left_, &batch);
+      for (size_t i = 0; i < batch.Size(); i++) {
+        this->entries_.push_back(Entry{0, INVALID_ENTRY, Value(), batch.TupleAt(i)});
+      }
+    }
+    this->HashEntries();
+    this->BuildTable();
+    this->probe_file_ = std::move(partition.right_);
+    return true;
+  }
+  this->entries_.clear();
+  return false;
+}
+
+void HashJoinExecutor::SpillTuple(SpillWriter *writer, const Tuple &tuple, const Value &key) {
+  BufferPoolManager *bpm = this->exec_ctx_->GetBufferPoolManager();
+  TmpTuple tmp_tuple(INVALID_PAGE_ID, 0);
+  if (writer->page_ == nullptr || !writer->page_->Insert(tuple, &tmp_tuple)) {
+    this->CloseSpill(writer);
+    page_id_t page_id;
+    Page *page = bpm->NewPage(&page_id);
+    if (page == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "hash join cannot allocate a page to spill to");
+    }
+    writer->page_ = reinterpret_cast<TmpTuplePage *>(page);
+    writer->page_->Init(page_id, PAGE_SIZE);
+    writer->file_.pages_.push_back(page_id);
+    if (!writer->page_->Insert(tuple, &tmp_tuple)) {
+      throw Exception(ExceptionType::OUT_OF_RANGE, "hash join cannot spill a tuple larger than a page");
+    }
+  }
+  writer->file_.bytes_ += EntryBytes(tuple, key);
+}
+
+void HashJoinExecutor::CloseSpill(SpillWriter *writer) {
+  if (writer->page_ != nullptr) {
+    this->exec_ctx_->GetBufferPoolManager()->UnpinPage(writer->page_->GetTablePageId(), true);
+    writer->page_ = nullptr;
+  }
+}
+
+void HashJoinExecutor::ReadSpillPage(SpillFile *file, TupleBatch *batch) {
+  BufferPoolManager *bpm = this->exec_ctx_->GetBufferPoolManager();
+  page_id_t page_id = file->pages_.back();
+  file->pages_.pop_back();
+  Page *page = bpm->FetchPage(page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "hash join cannot fetch a spilled page");
+  }
+  auto *tmp_page = reinterpret_cast<TmpTuplePage *>(page);
+  batch->Clear();
+  for (uint32_t offset = tmp_page->GetFreeSpacePointer(); offset < PAGE_SIZE;) {
+    Tuple tuple;
+    offset = tmp_page->Get(offset, &tuple);
+    batch->Append(std::move(tuple), RID());
+  }
+  // 页面只会被读取一次，读完即可删除
+  bpm->UnpinPage(page_id, false);
+  bpm->DeletePage(page_id);
+}
+
+void HashJoinExecutor::DropSpillFile(SpillFile *file) {
+  BufferPoolManager *bpm = this->exec_ctx_->GetBufferPoolManager();
+  for (page_id_t page_id : file->pages_) {
+    bpm->DeletePage(page_id);
+  }
+  file->pages_.clear();
+  file->bytes_ = 0;
+}
+
+void HashJoinExecutor::DropSpills() {
+  for (SpillPartition &partition : this->pending_) {
+    this->DropSpillFile(&partition.left_);
+    this->DropSpillFile(&partition.right_);
+  }
+  this->pending_.clear();
+  this->DropSpillFile(&this->probe_file_);
+}
+
+uint32_t HashJoinExecutor::Lookup(hash_t hash, const Value &key) const {
+  const Partition &partition = this->partitions_[this->PartitionOf(hash)];
+  size_t pos = hash & partition.mask_;
+  while (true) {
+    const Slot &slot = this->slots_[partition.slot_begin_ + pos];
+    if (slot.head_ == INVALID_ENTRY) {
+      return INVALID_ENTRY;
+    }
+    // 先比较哈希值，只有哈希相同时才去读 entry 比较 key
+    if (slot.hash_ == hash && this->entries_[slot.head_].key_.CompareEquals(key) == CmpBool::CmpTrue) {
+      return slot.head_;
+    }
+    pos = (pos + 1) & partition.mask_;
+  }
+}
+
+bool HashJoinExecutor::NextMatch(const Tuple **left_tuple, const Tuple **right_tuple) {
+  while (true) {
+    if (this->chain_ != INVALID_ENTRY) {
+      const Entry &entry = this->entries_[this->chain_];
+      this->chain_ = entry.next_;
+      *left_tuple = &entry.tuple_;
+      *right_tuple = &this->probe_batch_.TupleAt(this->probe_idx_);
+      return true;
+    }
+    if (this->probe_pos_ < this->probe_order_.size()) {
+      if (this->probe_pos_ + PREFETCH_DISTANCE < this->probe_order_.size()) {
+        hash_t ahead = this->probe_hashes_[this->probe_order_[this->probe_pos_ + PREFETCH_DISTANCE]];
+        __builtin_prefetch(this->SlotOf(this->PartitionOf(ahead), ahead));
+      }
+      this->probe_idx_ = this->probe_order_[this->probe_pos_++];
+      this->chain_ = this->Lookup(this->probe_hashes_[this->probe_idx_], this->probe_keys_[this->probe_idx_]);
+      continue;
+    }
+    // 构建侧为空时不需要读取探测侧
+    if (!this->entries_.empty() && this->FetchProbeBatch()) {
+      continue;
+    }
+    if (!this->spilled_ || !this->LoadNextPartition()) {
+      return false;
+    }
+  }
+}
+
+bool HashJoinExecutor::ProbeRound() {
+  const AbstractExpression *key_expr = this->plan_->RightJoinKeyExpression();
+  const Schema *right_schema = this->plan_->GetRightPlan()->OutputSchema();
+  size_t parallelism = this->plan_->GetParallelism();
+  while (true) {
+    // 子执行器由当前线程读取一轮的探测 tuple
+    this->probe_tuples_.clear();
+    if (!this->entries_.empty()) {
+      while (this->probe_tuples_.size() < parallelism * MORSELS_PER_THREAD * MORSEL_SIZE &&
+             this->ReadProbeBatch(&this->probe_batch_)) {
+        for (size_t i = 0; i < this->probe_batch_.Size(); i++) {
+          this->probe_tuples_.push_back(std::move(this->probe_batch_.TupleAt(i)));
+        }
+      }
+    }
+    if (this->probe_tuples_.empty()) {
+      if (!this->spilled_ || !this->LoadNextPartition()) {
         return false;
-    }else{
-        auto pair = this->results[tuple_idx++];
-        *rid = pair.first;
-        *tuple = pair.second;
+      }
+      continue;
+    }
+
+    // 各线程把结果写到自己的输出缓冲，不需要同步
+    this->outputs_.resize(parallelism);
+    for (auto &output : this->outputs_) {
+      output.clear();
+    }
+    size_t size = this->probe_tuples_.size();
+    this->ParallelFor((size + MORSEL_SIZE - 1) / MORSEL_SIZE, [&](size_t thread, size_t morsel) {
+      std::vector<Tuple> &output = this->outputs_[thread];
+      for (size_t i = morsel * MORSEL_SIZE; i < std::min(size, (morsel + 1) * MORSEL_SIZE); i++) {
+        const Tuple &right_tuple = this->probe_tuples_[i];
+        Value key = this->EvaluateKey(key_expr, right_tuple, right_schema);
+        if (key.IsNull()) {
+          continue;
+        }
+        for (uint32_t e = this->Lookup(HashUtil::HashValue(&key), key); e != INVALID_ENTRY;
+             e = this->entries_[e].next_) {
+          output.push_back(this->MakeOutputTuple(&this->entries_[e].tuple_, &right_tuple));
+        }
+      }
+    });
+    this->output_thread_ = 0;
+    this->output_pos_ = 0;
+    return true;
+  }
+}
+
+bool HashJoinExecutor::NextParallel(Tuple *tuple) {
+  while (true) {
+    while (this->output_thread_ < this->outputs_.size()) {
+      std::vector<Tuple> &output = this->outputs_[this->output_thread_];
+      if (this->output_pos_ < output.size()) {
+        *tuple = std::move(output[this->output_pos_++]);
         return true;
+      }
+      this->output_thread_++;
+      this->output_pos_ = 0;
+    }
+    if (!this->ProbeRound()) {
+      return false;
+    }
+  }
+}
+
+Tuple HashJoinExecutor::MakeOutputTuple(const Tuple *left_tuple, const Tuple *right_tuple) const {
+  const Schema *left_schema = this->plan_->GetLeftPlan()->OutputSchema();
+  const Schema *right_schema = this->plan_->GetRightPlan()->OutputSchema();
+  const Schema *output_schema = this->plan_->OutputSchema();
+  std::vector<Value> values;
+  values.reserve(output_schema->GetColumnCount());
+  for (const Column &column : output_schema->GetColumns()) {
+    values.push_back(column.GetExpr()->EvaluateJoin(left_tuple, left_schema, right_tuple, right_schema));
+  }
+  return Tuple(values, output_schema);
+}
+
+bool HashJoinExecutor::Next(Tuple *tuple, RID *rid) {
+  if (this->plan_->GetParallelism() > 1) {
+    if (!this->NextParallel(tuple)) {
+      return false;
+    }
+    *rid = tuple->GetRid();
+    return true;
+  }
+  const Tuple *left_tuple;
+  const Tuple *right_tuple;
+  if (!this->NextMatch(&left_tuple, &right_tuple)) {
+    return false;
+  }
+  *tuple = this->MakeOutputTuple(left_tuple, right_tuple);
+  *rid = tuple->GetRid();
+  return true;
+}
+
+bool HashJoinExecutor::NextBatch(TupleBatch *batch) {
+  batch->Clear();
+  if (this->plan_->GetParallelism() > 1) {
+    Tuple out_tuple;
+    while (!batch->IsFull() && this->NextParallel(&out_tuple)) {
+      RID out_rid = out_tuple.GetRid();
+      batch->Append(std::move(out_tuple), out_rid);
     }
+    return !batch->IsEmpty();
+  }
+  const Tuple *left_tuple;
+  const Tuple *right_tuple;
+  while (!batch->IsFull() && this->NextMatch(&left_tuple, &right_tuple)) {
+    Tuple out_tuple = this->MakeOutputTuple(left_tuple, right_tuple);
+    RID out_rid = out_tuple.GetRid();
+    batch->Append(std::move(out_tuple), out_rid);
+  }
+  return !batch->IsEmpty();
 }
 
 }  // namespace bustub
@@ -11,12 +11,160 @@
 //===----------------------------------------------------------------------===//
 #include "execution/executors/index_scan_executor.h"
 
+#include <utility>
+
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+
 namespace bustub {
+
+namespace {
+
+bool IsNumeric(TypeId type) {
+  return type == TypeId::TINYINT || type == TypeId::SMALLINT || type == TypeId::INTEGER || type == TypeId::BIGINT ||
+         type == TypeId::DECIMAL;
+}
+
+}  // namespace
+
 IndexScanExecutor::IndexScanExecutor(ExecutorContext *exec_ctx, const IndexScanPlanNode *plan)
-    : AbstractExecutor(exec_ctx) {}
+    : AbstractExecutor(exec_ctx), plan_(plan) {}
+
+void IndexScanExecutor::Init() {
+  Catalog *catalog = exec_ctx_->GetCatalog();
+  index_info_ = catalog->GetIndex(plan_->GetIndexOid());
+  table_info_ = catalog->GetTable(index_info_->table_name_);
+  predicate_.Compile(plan_->GetPredicate(), &table_info_->schema_);
+  cursor_.reset();
+  point_rids_.clear();
+  batch_.clear();
+  found_.clear();
+  batch_pos_ = 0;
+
+  Index *index = index_info_->index_.get();
+  std::vector<Value> low;
+  std::vector<Value> high;
+  if (DeriveBounds(&low, &high)) {
+    // 单列键上的等值查询, 哈希索引和 B+ 树都支持
+    TypeId key_type = index_info_->key_schema_.GetColumn(0).GetType();
+    if (Index::CompareToKeyRange(low[0], key_type) != 0) {
+      // 常量超出键的类型范围, 不可能有相等的键
+      return;
+    }
+    Value key = low[0].GetTypeId() == key_type ? low[0] : low[0].CastAs(key_type);
+    index->ScanKey(Tuple({key}, &index_info_->key_schema_), &point_rids_, exec_ctx_->GetTransaction());
+    return;
+  }
+  if (!index->SupportsRangeScan()) {
+    throw Exception(ExceptionType::NOT_IMPLEMENTED,
+                    "IndexScanExecutor: the predicate is not an equality on the key of an unordered index");
+  }
+  cursor_ = index->OpenRangeCursor(low, high, exec_ctx_->GetTransaction());
+}
+
+bool IndexScanExecutor::Next(Tuple *tuple, RID *rid) {
+  while (true) {
+    while (batch_pos_ < batch_.size()) {
+      size_t pos = batch_pos_++;
+      // 索引中的 RID 可能已经被删除
+      if (!found_[pos]) {
+        continue;
+      }
+      const Tuple &table_tuple = batch_[pos];
+      if (!predicate_.Evaluate(&table_tuple)) {
+        continue;
+      }
+      *tuple = GenerateTuple(table_tuple);
+      *rid = table_tuple.GetRid();
+      return true;
+    }
+    if (!FetchBatch()) {
+      return false;
+    }
+  }
+}
+
+bool IndexScanExecutor::DeriveBounds(std::vector<Value> *low, std::vector<Value> *high) {
+  auto comparison = dynamic_cast<const ComparisonExpression *>(plan_->GetPredicate());
+  if (comparison == nullptr) {
+    return false;
+  }
+  ComparisonType comp_type = comparison->GetComparisonType();
+  auto column = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(0));
+  auto constant = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(1));
+  if (column == nullptr) {
+    // 常量在左侧时交换两侧, 比较的方向也随之翻转
+    column = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(1));
+    constant = dynamic_cast<const ConstantValueExpression *>(comparison->GetChildAt(0));
+    switch (comp_type) {
+      case ComparisonType::LessThan:
+        comp_type = ComparisonType::GreaterThan;
+        break;
+      case ComparisonType::LessThanOrEqual:
+        comp_type = ComparisonType::GreaterThanOrEqual;
+        break;
+      case ComparisonType::GreaterThan:
+        comp_type = ComparisonType::LessThan;
+        break;
+      case ComparisonType::GreaterThanOrEqual:
+        comp_type = ComparisonType::LessThanOrEqual;
+        break;
+      default:
+        break;
+    }
+  }
+  if (column == nullptr || constant == nullptr || column->GetColIdx() != index_info_->index_->GetKeyAttrs()[0]) {
+    return false;
+  }
+  Value value = constant->Evaluate(nullptr, nullptr);
+  TypeId key_type = index_info_->key_schema_.GetColumn(0).GetType();
+  if (value.IsNull() || (value.GetTypeId() != key_type && !(IsNumeric(value.GetTypeId()) && IsNumeric(key_type)))) {
+    return false;
+  }
+  // 边界按闭区间处理, 开区间的端点由谓词过滤掉
+  switch (comp_type) {
+    case ComparisonType::Equal:
+      low->push_back(value);
+      high->push_back(value);
+      return index_info_->key_schema_.GetColumnCount() == 1;
+    case ComparisonType::LessThan:
+    case ComparisonType::LessThanOrEqual:
+      high->push_back(value);
+      return false;
+    case ComparisonType::GreaterThan:
+    case ComparisonType::GreaterThanOrEqual:
+      low->push_back(value);
+      return false;
+    default:
+      return false;
+  }
+}
 
-void IndexScanExecutor::Init() {}
+bool IndexScanExecutor::FetchBatch() {
+  std::vector<RID> rids;
+  if (cursor_ != nullptr) {
+    if (!cursor_->NextBatch(&rids, BATCH_SIZE)) {
+      return false;
+    }
+  } else {
+    if (point_rids_.empty()) {
+      return false;
+    }
+    rids = std::move(point_rids_);
+    point_rids_.clear();
+  }
+  table_info_->table_->GetTuples(rids, &batch_, &found_, exec_ctx_->GetTransaction());
+  batch_pos_ = 0;
+  return true;
+}
 
-bool IndexScanExecutor::Next(Tuple *tuple, RID *rid) { return false; }
+Tuple IndexScanExecutor::GenerateTuple(const Tuple &tuple) {
+  std::vector<Value> values;
+  for (const auto &column : GetOutputSchema()->GetColumns()) {
+    values.push_back(column.GetExpr()->Evaluate(&tuple, &table_info_->schema_));
+  }
+  return Tuple(values, GetOutputSchema());
+}
 
 }  // namespace bustub
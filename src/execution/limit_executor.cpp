@@ -12,6 +12,8 @@
 
 #include "execution/executors/limit_executor.h"
 
+#include <algorithm>
+
 namespace bustub {
 
 LimitExecutor::LimitExecutor(ExecutorContext *exec_ctx, const LimitPlanNode *plan,
@@ -37,4 +39,24 @@ bool LimitExecutor::Next(Tuple *tuple, RID *rid) {
     return false;
 }
 
+bool LimitExecutor::NextBatch(TupleBatch *batch) {
+    batch->Clear();
+    size_t remaining = this->plan_->GetLimit() - std::min<size_t>(this->counts, this->plan_->GetLimit());
+    if (remaining == 0) {
+        return false;
+    }
+    if (remaining >= batch->Capacity()) {
+        this->child_executor_->NextBatch(batch);
+    } else {
+        // 只向子执行器要剩下的数量, 避免多扫描的元组被丢弃
+        TupleBatch last_batch(remaining);
+        this->child_executor_->NextBatch(&last_batch);
+        for (size_t i = 0; i < last_batch.Size(); i++) {
+            batch->Append(std::move(last_batch.TupleAt(i)), last_batch.RidAt(i));
+        }
+    }
+    this->counts += batch->Size();
+    return !batch->IsEmpty();
+}
+
 }  // namespace bustub
@@ -0,0 +1,262 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// merge_join_executor.cpp
+//
+// Identification: src/execution/merge_join_executor.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/executors/merge_join_executor.h"
+
+#include <algorithm>
+
+#include "common/exception.h"
+
+namespace bustub {
+
+MergeJoinExecutor::MergeJoinExecutor(ExecutorContext *exec_ctx, const MergeJoinPlanNode *plan,
+                                     std::unique_ptr<AbstractExecutor> &&left_child,
+                                     std::unique_ptr<AbstractExecutor> &&right_child)
+    : AbstractExecutor(exec_ctx),
+      plan_(plan),
+      left_child_(std::move(left_child)),
+      right_child_(std::move(right_child)) {}
+
+MergeJoinExecutor::~MergeJoinExecutor() { this->DropGroup(); }
+
+void MergeJoinExecutor::Init() {
+  this->left_child_->Init();
+  this->right_child_->Init();
+  this->OpenInput(&this->left_, this->left_child_.get(), this->plan_->LeftJoinKeyExpression(),
+                  this->plan_->IsLeftSorted());
+  this->OpenInput(&this->right_, this->right_child_.get(), this->plan_->RightJoinKeyExpression(),
+                  this->plan_->IsRightSorted());
+  this->Advance(&this->left_);
+  this->Advance(&this->right_);
+  this->DropGroup();
+}
+
+void MergeJoinExecutor::OpenInput(Input *input, AbstractExecutor *child, const AbstractExpression *key_expr,
+                                  bool sorted) {
+  input->child_ = child;
+  input->key_expr_ = key_expr;
+  input->schema_ = child->GetOutputSchema();
+  input->sort_.reset();
+  input->valid_ = false;
+  if (sorted) {
+    return;
+  }
+  // 两侧各使用一半的内存预算排序，键为 NULL 的 tuple 不会匹配，不参与排序
+  input->sort_ = std::make_unique<ExternalSort>(this->exec_ctx_->GetBufferPoolManager(), input->schema_,
+                                                std::vector<ExternalSort::SortKey>{{key_expr, true}},
+                                                std::max<size_t>(this->plan_->GetMemoryBudget() / 2, 1));
+  TupleBatch batch;
+  while (child->NextBatch(&batch)) {
+    for (size_t i = 0; i < batch.Size(); i++) {
+      const Tuple &tuple = batch.TupleAt(i);
+      if (!key_expr->Evaluate(&tuple, input->schema_).IsNull()) {
+        input->sort_->Add(tuple);
+      }
+    }
+  }
+  input->sort_->Finish();
+}
+
+bool MergeJoinExecutor::Advance(Input *input) {
+  while (true) {
+    if (input->sort_ != nullptr) {
+      input->valid_ = input->sort_->Next(&input->tuple_);
+    } else {
+      RID rid;
+      input->valid_ = input->child_->Next(&input->tuple_, &rid);
+    }
+    if (!input->valid_) {
+      return false;
+    }
+    input->key_ = input->key_expr_->Evaluate(&input->tuple_, input->schema_);
+    if (!input->key_.IsNull()) {
+      return true;
+    }
+  }
+}
+
+int MergeJoinExecutor::CompareKeys(const Value &lhs, const Value &rhs) {
+  if (lhs.CompareLessThan(rhs) == CmpBool::CmpTrue) {
+    return -1;
+  }
+  return lhs.CompareGreaterThan(rhs) == CmpBool::CmpTrue ? 1 : 0;
+}
+
+bool MergeJoinExecutor::NextMatch(const Tuple **left_tuple, const Tuple **right_tuple) {
+  while (true) {
+    if (this->group_pos_ < this->group_.size()) {
+      *left_tuple = &this->left_.tuple_;
+      *right_tuple = &this->group_[this->group_pos_++];
+      return true;
+    }
+    // 落盘的组每次只把一页读回内存
+    if (this->group_page_ < this->group_pages_.size()) {
+      this->LoadGroupPage();
+      continue;
+    }
+    if (this->in_group_) {
+      // 当前左侧 tuple 已与整组匹配，下一个左侧 tuple 键相同时重新输出这一组
+      if (!this->Advance(&this->left_)) {
+        return false;
+      }
+      if (CompareKeys(this->left_.key_, this->group_key_) == 0) {
+        this->group_pos_ = 0;
+        if (!this->group_pages_.empty()) {
+          this->group_.clear();
+          this->group_page_ = 0;
+        }
+        continue;
+      }
+      this->DropGroup();
+    }
+    if (!this->left_.valid_ || !this->right_.valid_) {
+      return false;
+    }
+    int cmp = CompareKeys(this->left_.key_, this->right_.key_);
+    if (cmp < 0) {
+      this->Advance(&this->left_);
+    } else if (cmp > 0) {
+      this->Advance(&this->right_);
+    } else {
+      // 收集右侧键相同的一组 tuple
+      this->group_key_ = this->right_.key_;
+      this->in_group_ = true;
+      do {
+        this->AddToGroup(std::move(this->right_.tuple_));
+      } while (this->Advance(&this->right_) && CompareKeys(this->right_.key_, this->group_key_) == 0);
+      if (this->group_writer_ != nullptr) {
+        // 组已经落盘，从第一页开始读回
+        this->exec_ctx_->GetBufferPoolManager()->UnpinPage(this->group_writer_->GetTablePageId(), true);
+        this->group_writer_ = nullptr;
+        this->group_.clear();
+        this->group_page_ = 0;
+      }
+      this->group_pos_ = 0;
+    }
+  }
+}
+
+void MergeJoinExecutor::AddToGroup(Tuple tuple) {
+  // 组与右侧的排序一样最多使用一半的内存预算
+  size_t bytes = sizeof(Tuple) + tuple.GetLength();
+  if (this->group_pages_.empty() &&
+      this->group_bytes_ + bytes <= std::max<size_t>(this->plan_->GetMemoryBudget() / 2, 1)) {
+    this->group_bytes_ += bytes;
+    this->group_.push_back(std::move(tuple));
+    return;
+  }
+  // 超出预算时先把已经收集的 tuple 写出，之后的 tuple 直接写到页上
+  for (const Tuple &group_tuple : this->group_) {
+    this->SpillGroupTuple(group_tuple);
+  }
+  this->group_.clear();
+  this->group_bytes_ = 0;
+  this->SpillGroupTuple(tuple);
+}
+
+void MergeJoinExecutor::SpillGroupTuple(const Tuple &tuple) {
+  BufferPoolManager *bpm = this->exec_ctx_->GetBufferPoolManager();
+  TmpTuple tmp_tuple(INVALID_PAGE_ID, 0);
+  if (this->group_writer_ != nullptr && this->group_writer_->Insert(tuple, &tmp_tuple)) {
+    return;
+  }
+  if (this->group_writer_ != nullptr) {
+    bpm->UnpinPage(this->group_writer_->GetTablePageId(), true);
+    this->group_writer_ = nullptr;
+  }
+  page_id_t page_id;
+  Page *page = bpm->NewPage(&page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "merge join cannot allocate a page for a group of duplicates");
+  }
+  this->group_writer_ = reinterpret_cast<TmpTuplePage *>(page);
+  this->group_writer_->Init(page_id, PAGE_SIZE);
+  this->group_pages_.push_back(page_id);
+  if (!this->group_writer_->Insert(tuple, &tmp_tuple)) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "merge join cannot spill a tuple larger than a page");
+  }
+}
+
+void MergeJoinExecutor::LoadGroupPage() {
+  BufferPoolManager *bpm = this->exec_ctx_->GetBufferPoolManager();
+  page_id_t page_id = this->group_pages_[this->group_page_++];
+  Page *page = bpm->FetchPage(page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "merge join cannot fetch a page of a group of duplicates");
+  }
+  // 每个左侧 tuple 都要重新读一遍组，页读完后保留到组结束再删除
+  auto *tmp_page = reinterpret_cast<TmpTuplePage *>(page);
+  this->group_.clear();
+  for (uint32_t offset = tmp_page->GetFreeSpacePointer(); offset < PAGE_SIZE;) {
+    Tuple tuple;
+    offset = tmp_page->Get(offset, &tuple);
+    this->group_.push_back(std::move(tuple));
+  }
+  bpm->UnpinPage(page_id, false);
+  // TmpTuplePage 从页尾向前存放，反转后与写入的顺序一致
+  std::reverse(this->group_.begin(), this->group_.end());
+  this->group_pos_ = 0;
+}
+
+void MergeJoinExecutor::DropGroup() {
+  BufferPoolManager *bpm = this->exec_ctx_->GetBufferPoolManager();
+  if (this->group_writer_ != nullptr) {
+    bpm->UnpinPage(this->group_writer_->GetTablePageId(), true);
+    this->group_writer_ = nullptr;
+  }
+  for (page_id_t page_id : this->group_pages_) {
+    bpm->DeletePage(page_id);
+  }
+  this->group_pages_.clear();
+  this->group_page_ = 0;
+  this->group_.clear();
+  this->group_pos_ = 0;
+  this->group_bytes_ = 0;
+  this->in_group_ = false;
+}
+
+Tuple MergeJoinExecutor::MakeOutputTuple(const Tuple *left_tuple, const Tuple *right_tuple) const {
+  const Schema *left_schema = this->left_.schema_;
+  const Schema *right_schema = this->right_.schema_;
+  const Schema *output_schema = this->plan_->OutputSchema();
+  std::vector<Value> values;
+  values.reserve(output_schema->GetColumnCount());
+  for (const Column &column : output_schema->GetColumns()) {
+    values.push_back(column.GetExpr()->EvaluateJoin(left_tuple, left_schema, right_tuple, right_schema));
+  }
+  return Tuple(values, output_schema);
+}
+
+bool MergeJoinExecutor::Next(Tuple *tuple, RID *rid) {
+  const Tuple *left_tuple;
+  const Tuple *right_tuple;
+  if (!this->NextMatch(&left_tuple, &right_tuple)) {
+    return false;
+  }
+  *tuple = this->MakeOutputTuple(left_tuple, right_tuple);
+  *rid = tuple->GetRid();
+  return true;
+}
+
+bool MergeJoinExecutor::NextBatch(TupleBatch *batch) {
+  batch->Clear();
+  const Tuple *left_tuple;
+  const Tuple *right_tuple;
+  while (!batch->IsFull() && this->NextMatch(&left_tuple, &right_tuple)) {
+    Tuple out_tuple = this->MakeOutputTuple(left_tuple, right_tuple);
+    RID out_rid = out_tuple.GetRid();
+    batch->Append(std::move(out_tuple), out_rid);
+  }
+  return !batch->IsEmpty();
+}
+
+}  // namespace bustub
@@ -12,14 +12,118 @@
 
 #include "execution/executors/nested_index_join_executor.h"
 
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+
 namespace bustub {
 
 NestIndexJoinExecutor::NestIndexJoinExecutor(ExecutorContext *exec_ctx, const NestedIndexJoinPlanNode *plan,
                                              std::unique_ptr<AbstractExecutor> &&child_executor)
-    : AbstractExecutor(exec_ctx) {}
+    : AbstractExecutor(exec_ctx), plan_(plan), child_executor_(std::move(child_executor)) {}
+
+void NestIndexJoinExecutor::Init() {
+  child_executor_->Init();
+  Catalog *catalog = exec_ctx_->GetCatalog();
+  inner_table_info_ = catalog->GetTable(plan_->GetInnerTableOid());
+  index_info_ = catalog->GetIndex(plan_->GetIndexName(), inner_table_info_->name_);
+  if (index_info_ == nullptr) {
+    throw Exception(ExceptionType::INVALID, "NestIndexJoinExecutor: the inner table has no such index");
+  }
+  outer_key_ = FindOuterKey();
+  if (outer_key_ == nullptr) {
+    throw Exception(ExceptionType::NOT_IMPLEMENTED,
+                    "NestIndexJoinExecutor: the predicate is not an equality on the key of the inner index");
+  }
+  predicate_.CompileJoin(plan_->Predicate(), plan_->OuterTableSchema(), plan_->InnerTableSchema());
+  results_.clear();
+  result_pos_ = 0;
+}
+
+bool NestIndexJoinExecutor::Next(Tuple *tuple, RID *rid) {
+  while (result_pos_ == results_.size()) {
+    if (!JoinBatch()) {
+      return false;
+    }
+  }
+  *tuple = results_[result_pos_++];
+  *rid = tuple->GetRid();
+  return true;
+}
+
+const AbstractExpression *NestIndexJoinExecutor::FindOuterKey() const {
+  auto comparison = dynamic_cast<const ComparisonExpression *>(plan_->Predicate());
+  if (comparison == nullptr || comparison->GetComparisonType() != ComparisonType::Equal ||
+      index_info_->key_schema_.GetColumnCount() != 1) {
+    return nullptr;
+  }
+  // 一侧是内表上索引的键列, 另一侧就是外表元组的键
+  uint32_t key_attr = index_info_->index_->GetKeyAttrs()[0];
+  for (uint32_t side = 0; side < 2; side++) {
+    auto column = dynamic_cast<const ColumnValueExpression *>(comparison->GetChildAt(side));
+    if (column != nullptr && column->GetTupleIdx() == 1 && column->GetColIdx() == key_attr) {
+      return comparison->GetChildAt(1 - side);
+    }
+  }
+  return nullptr;
+}
+
+bool NestIndexJoinExecutor::JoinBatch() {
+  const Schema *outer_schema = plan_->OuterTableSchema();
+  const Schema *inner_schema = plan_->InnerTableSchema();
+  const Schema *key_schema = &index_info_->key_schema_;
+  TypeId key_type = key_schema->GetColumn(0).GetType();
+
+  // 读入一批外表元组并计算键, 键为 NULL 或超出键列类型范围的元组不可能匹配
+  std::vector<Tuple> outer_tuples;
+  std::vector<Tuple> keys;
+  Tuple outer_tuple;
+  RID outer_rid;
+  while (outer_tuples.size() < BATCH_SIZE && child_executor_->Next(&outer_tuple, &outer_rid)) {
+    Value key = outer_key_->Evaluate(&outer_tuple, outer_schema);
+    if (key.IsNull() || Index::CompareToKeyRange(key, key_type) != 0) {
+      continue;
+    }
+    if (key.GetTypeId() != key_type) {
+      key = key.CastAs(key_type);
+    }
+    outer_tuples.push_back(outer_tuple);
+    keys.emplace_back(std::vector<Value>{key}, key_schema);
+  }
+  if (outer_tuples.empty()) {
+    return false;
+  }
 
-void NestIndexJoinExecutor::Init() {}
+  // 整批键一次查找, 匹配的内表元组按页面批量读取
+  std::vector<std::vector<RID>> matches;
+  index_info_->index_->ScanKeys(keys, &matches, exec_ctx_->GetTransaction());
+  std::vector<RID> rids;
+  for (const auto &match : matches) {
+    rids.insert(rids.end(), match.begin(), match.end());
+  }
+  std::vector<Tuple> inner_tuples;
+  std::vector<bool> found;
+  inner_table_info_->table_->GetTuples(rids, &inner_tuples, &found, exec_ctx_->GetTransaction());
 
-bool NestIndexJoinExecutor::Next(Tuple *tuple, RID *rid) { return false; }
+  results_.clear();
+  result_pos_ = 0;
+  size_t pos = 0;
+  for (size_t i = 0; i < outer_tuples.size(); i++) {
+    for (size_t j = 0; j < matches[i].size(); j++, pos++) {
+      if (!found[pos]) {
+        continue;
+      }
+      const Tuple &inner_tuple = inner_tuples[pos];
+      if (!predicate_.EvaluateJoin(&outer_tuples[i], &inner_tuple)) {
+        continue;
+      }
+      std::vector<Value> values;
+      for (const auto &column : GetOutputSchema()->GetColumns()) {
+        values.push_back(column.GetExpr()->EvaluateJoin(&outer_tuples[i], outer_schema, &inner_tuple, inner_schema));
+      }
+      results_.emplace_back(values, GetOutputSchema());
+    }
+  }
+  return true;
+}
 
 }  // namespace bustub
@@ -17,53 +17,114 @@ namespace bustub {
 NestedLoopJoinExecutor::NestedLoopJoinExecutor(ExecutorContext *exec_ctx, const NestedLoopJoinPlanNode *plan,
                                                std::unique_ptr<AbstractExecutor> &&left_executor,
                                                std::unique_ptr<AbstractExecutor> &&right_executor)
-    : AbstractExecutor(exec_ctx) {
-      this->plan_ = plan;
-      this->left_executor_ = std::move(left_executor);
-      this->right_executor_ = std::move(right_executor);
-}
+    : AbstractExecutor(exec_ctx),
+      plan_(plan),
+      left_executor_(std::move(left_executor)),
+      right_executor_(std::move(right_executor)) {}
 
 void NestedLoopJoinExecutor::Init() {
-    this->left_executor_->Init();
-    this->right_executor_->Init();
+  this->left_executor_->Init();
+  this->predicate_.CompileJoin(this->plan_->Predicate(), this->plan_->GetLeftPlan()->OutputSchema(),
+                               this->plan_->GetRightPlan()->OutputSchema());
+  this->outer_block_.clear();
+  this->outer_batch_.Clear();
+  this->outer_pos_ = 0;
+  this->outer_done_ = false;
+  this->inner_batch_.Clear();
+  this->inner_pos_ = 0;
+  this->matches_.clear();
+  this->match_pos_ = 0;
 }
 
-// Stupied Algorithm
-bool NestedLoopJoinExecutor::Next(Tuple *tuple, RID *rid) {
-    Tuple left_tuple;
-    RID left_rid;
-    Tuple right_tuple;
-    RID right_rid;
-    auto left_schema = this->plan_->GetLeftPlan()->OutputSchema();
-    auto right_schema = this->plan_->GetRightPlan()->OutputSchema();
-    if(this->left_executor_->Next(&left_tuple, &left_rid)) {
-      if(this->right_executor_->Next(&right_tuple, &right_rid)) {
-        auto predicate = this->plan_->Predicate();
-        auto value = predicate->EvaluateJoin(&left_tuple, left_schema, &right_tuple, right_schema);
-        auto allow_join = value.GetAs<bool>();
-        if(allow_join) {
-          // 这里需要根据 out_schema 拼接两个 tuple
-          std::vector<Value> tuple_values;
-          for(uint32_t column_idx = 0; column_idx < left_schema->GetColumnCount(); column_idx++){
-            auto left_value = left_tuple.GetValue(left_schema, column_idx);
-            tuple_values.push_back(left_value);
-          }
-          for(uint32_t column_idx = 0; column_idx < right_schema->GetColumnCount(); column_idx++){
-            auto right_value = right_tuple.GetValue(right_schema, column_idx);
-            tuple_values.push_back(right_value);
-          }
-          auto out_tuple = Tuple(tuple_values, this->GetOutputSchema());
-          *tuple = out_tuple;
-          *rid = out_tuple.GetRid();
-//          printf("[Debug] nested loop join executor return\n");
-          return true;
+bool NestedLoopJoinExecutor::LoadOuterBlock() {
+  this->outer_block_.clear();
+  size_t block_bytes = this->plan_->GetBlockPages() * PAGE_SIZE;
+  size_t bytes = 0;
+  // 块至少包含一个外侧 tuple，块大小为 0 或 tuple 大于块时退化为逐个 tuple 的嵌套循环
+  while (this->outer_block_.empty() || bytes < block_bytes) {
+    if (this->outer_pos_ >= this->outer_batch_.Size()) {
+      if (this->outer_done_ || !this->left_executor_->NextBatch(&this->outer_batch_)) {
+        this->outer_done_ = true;
+        break;
+      }
+      this->outer_pos_ = 0;
+    }
+    Tuple &tuple = this->outer_batch_.TupleAt(this->outer_pos_++);
+    bytes += sizeof(Tuple) + tuple.GetLength();
+    this->outer_block_.push_back(std::move(tuple));
+  }
+  if (this->outer_block_.empty()) {
+    return false;
+  }
+  // 每个外侧块只扫描一遍内侧
+  this->right_executor_->Init();
+  this->inner_batch_.Clear();
+  this->inner_pos_ = 0;
+  return true;
+}
+
+bool NestedLoopJoinExecutor::NextMatch(const Tuple **left_tuple, const Tuple **right_tuple) {
+  while (true) {
+    if (this->match_pos_ < this->matches_.size()) {
+      *left_tuple = &this->outer_block_[this->matches_[this->match_pos_++]];
+      *right_tuple = &this->inner_batch_.TupleAt(this->inner_pos_ - 1);
+      return true;
+    }
+    if (this->inner_pos_ < this->inner_batch_.Size()) {
+      // 一个内侧 tuple 与整个外侧块比较，匹配的外侧 tuple 记录在 matches_ 中
+      const Tuple &inner = this->inner_batch_.TupleAt(this->inner_pos_++);
+      this->matches_.clear();
+      this->match_pos_ = 0;
+      for (size_t i = 0; i < this->outer_block_.size(); i++) {
+        if (this->predicate_.EvaluateJoin(&this->outer_block_[i], &inner)) {
+          this->matches_.push_back(static_cast<uint32_t>(i));
         }
-        return this->Next(tuple, rid);
       }
-      this->right_executor_->Init();
-      return this->Next(tuple, rid);
+      continue;
+    }
+    if (!this->outer_block_.empty() && this->right_executor_->NextBatch(&this->inner_batch_)) {
+      this->inner_pos_ = 0;
+      continue;
     }
+    if (!this->LoadOuterBlock()) {
+      return false;
+    }
+  }
+}
+
+Tuple NestedLoopJoinExecutor::MakeOutputTuple(const Tuple *left_tuple, const Tuple *right_tuple) const {
+  const Schema *left_schema = this->plan_->GetLeftPlan()->OutputSchema();
+  const Schema *right_schema = this->plan_->GetRightPlan()->OutputSchema();
+  const Schema *output_schema = this->plan_->OutputSchema();
+  std::vector<Value> values;
+  values.reserve(output_schema->GetColumnCount());
+  for (const Column &column : output_schema->GetColumns()) {
+    values.push_back(column.GetExpr()->EvaluateJoin(left_tuple, left_schema, right_tuple, right_schema));
+  }
+  return Tuple(values, output_schema);
+}
+
+bool NestedLoopJoinExecutor::Next(Tuple *tuple, RID *rid) {
+  const Tuple *left_tuple;
+  const Tuple *right_tuple;
+  if (!this->NextMatch(&left_tuple, &right_tuple)) {
     return false;
+  }
+  *tuple = this->MakeOutputTuple(left_tuple, right_tuple);
+  *rid = tuple->GetRid();
+  return true;
+}
+
+bool NestedLoopJoinExecutor::NextBatch(TupleBatch *batch) {
+  batch->Clear();
+  const Tuple *left_tuple;
+  const Tuple *right_tuple;
+  while (!batch->IsFull() && this->NextMatch(&left_tuple, &right_tuple)) {
+    Tuple out_tuple = this->MakeOutputTuple(left_tuple, right_tuple);
+    RID out_rid = out_tuple.GetRid();
+    batch->Append(std::move(out_tuple), out_rid);
+  }
+  return !batch->IsEmpty();
 }
 
 }  // namespace bustub
@@ -12,8 +12,27 @@
 
 #include "execution/executors/seq_scan_executor.h"
 
+#include <set>
+
 namespace bustub {
 
+namespace {
+
+/** Collects the columns an expression reads */
+void CollectColumns(const AbstractExpression *expr, std::set<uint32_t> *columns) {
+  if (expr == nullptr) {
+    return;
+  }
+  if (auto column = dynamic_cast<const ColumnValueExpression *>(expr); column != nullptr) {
+    columns->insert(column->GetColIdx());
+  }
+  for (const auto *child : expr->GetChildren()) {
+    CollectColumns(child, columns);
+  }
+}
+
+}  // namespace
+
 SeqScanExecutor::SeqScanExecutor(ExecutorContext *exec_ctx, const SeqScanPlanNode *plan) : AbstractExecutor(exec_ctx) {
     this->plan_ = plan;
     this->table_iterator = nullptr;
@@ -21,44 +40,100 @@ SeqScanExecutor::SeqScanExecutor(ExecutorContext *exec_ctx, const SeqScanPlanNod
 
 void SeqScanExecutor::Init() {
     // 获取 TableInfo
-    TableInfo* table_info = this->exec_ctx_->GetCatalog()->GetTable(this->plan_->GetTableOid());
+    this->table_info_ = this->exec_ctx_->GetCatalog()->GetTable(this->plan_->GetTableOid());
     // 获取对应的 table_heap
-    TableHeap* table_heap = table_info->table_.get();
+    TableHeap* table_heap = this->table_info_->table_.get();
     // 通过 TableHeap 构造 TableIterator
     if(this->table_iterator != nullptr) {
       delete this->table_iterator;
     }
     auto local_table_iterator = table_heap->Begin(this->exec_ctx_->GetTransaction());
     this->table_iterator = new TableIterator(local_table_iterator);
+
+    // 谓词中的列下标是相对于表的 schema 的
+    this->predicate_.Compile(this->plan_->GetPredicate(), &this->table_info_->schema_);
+
+    // 列式扫描只解码谓词和输出中出现的列
+    this->scan_position_ = RID(table_heap->GetFirstPageId(), 0);
+    std::set<uint32_t> columns;
+    CollectColumns(this->plan_->GetPredicate(), &columns);
+    for (const auto &column : this->GetOutputSchema()->GetColumns()) {
+      CollectColumns(column.GetExpr(), &columns);
+    }
+    this->decoded_columns_.assign(columns.begin(), columns.end());
 }
 
-bool SeqScanExecutor::Next(Tuple *tuple, RID *rid) { 
-    // 获取 TableInfo
-    TableInfo* table_info = this->exec_ctx_->GetCatalog()->GetTable(this->plan_->GetTableOid());
-    // 获取对应的 table_heap
-    TableHeap* table_heap = table_info->table_.get();
-//    TableIterator table_heap_end = table_heap->End();
-    if(*this->table_iterator != table_heap->End()){
-        // 获取该 table_iterator 的 tuple
-        Tuple table_tuple = **this->table_iterator;
-        // 将当前的 table_iterator 指向下一个元组
-        ++(*this->table_iterator);
-        const AbstractExpression* predicate = this->plan_->GetPredicate();
-        if(predicate == nullptr) {
-//          *tuple = table_tuple;
-          *tuple = GenerateTuple(table_tuple);
-          *rid = table_tuple.GetRid();
-          return true;
-        }
-        auto value = predicate->Evaluate(&table_tuple, this->GetOutputSchema());
-        auto is_allowed = value.GetAs<bool>();
-        if (is_allowed){
-//            *tuple = table_tuple;
-            *tuple = GenerateTuple(table_tuple);
-            *rid = table_tuple.GetRid();
-            return true;
-        }
-        return this->Next(tuple, rid);
+bool SeqScanExecutor::Next(Tuple *tuple, RID *rid) {
+    Tuple table_tuple;
+    if (!this->NextTableTuple(&table_tuple)) {
+      return false;
+    }
+    *tuple = GenerateTuple(table_tuple);
+    *rid = table_tuple.GetRid();
+    return true;
+}
+
+bool SeqScanExecutor::NextBatch(TupleBatch *batch) {
+    batch->Clear();
+    Tuple table_tuple;
+    // 在一次调用中连续扫描和过滤, 直到填满整个批次
+    while (!batch->IsFull() && this->NextTableTuple(&table_tuple)) {
+      batch->Append(GenerateTuple(table_tuple), table_tuple.GetRid());
+    }
+    return !batch->IsEmpty();
+}
+
+bool SeqScanExecutor::NextChunk(DataChunk *chunk) {
+    chunk->Reset();
+    if (this->table_chunk_.GetSchema() == nullptr || this->table_chunk_.Capacity() != chunk->Capacity()) {
+      this->table_chunk_.Initialize(&this->table_info_->schema_, chunk->Capacity());
+    }
+    TableHeap* table_heap = this->table_info_->table_.get();
+    const AbstractExpression* predicate = this->plan_->GetPredicate();
+    SelectionVector &sel = this->table_chunk_.GetSelection();
+    // 一次读入一批元组, 全部被过滤掉时继续读下一批
+    do {
+      this->table_chunk_.Reset();
+      table_heap->ScanTuples(
+          &this->scan_position_, this->table_chunk_.Capacity(),
+          [this](const char *data, const RID &rid) { this->table_chunk_.AppendRow(data, this->decoded_columns_); },
+          this->exec_ctx_->GetTransaction());
+      if (this->table_chunk_.Size() == 0) {
+        return false;
+      }
+      sel.SetIdentity(this->table_chunk_.Size());
+      if (predicate != nullptr) {
+        predicate->Select(&this->table_chunk_);
+      }
+    } while (sel.IsEmpty());
+
+    // 按输出的 schema 计算每一列, 并把选中的行紧凑地放到输出中
+    const auto &out_columns = this->GetOutputSchema()->GetColumns();
+    for (uint32_t i = 0; i < out_columns.size(); i++) {
+      const AbstractExpression *expr = out_columns[i].GetExpr();
+      if (auto column = dynamic_cast<const ColumnValueExpression *>(expr); column != nullptr) {
+        chunk->GetColumn(i).Gather(this->table_chunk_.GetColumn(column->GetColIdx()), sel);
+      } else {
+        ColumnVector result(out_columns[i].GetType(), this->table_chunk_.Capacity());
+        expr->EvaluateColumn(this->table_chunk_, &result);
+        chunk->GetColumn(i).Gather(result, sel);
+      }
+    }
+    chunk->SetSize(sel.Size());
+    chunk->GetSelection().SetIdentity(sel.Size());
+    return true;
+}
+
+bool SeqScanExecutor::NextTableTuple(Tuple *table_tuple) {
+    TableHeap* table_heap = this->table_info_->table_.get();
+    const TableIterator end = table_heap->End();
+    while (*this->table_iterator != end) {
+      // 获取该 table_iterator 的 tuple, 并将 table_iterator 指向下一个元组
+      *table_tuple = **this->table_iterator;
+      ++(*this->table_iterator);
+      if (this->predicate_.Evaluate(table_tuple)) {
+        return true;
+      }
     }
     return false;
 }
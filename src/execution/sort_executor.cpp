@@ -0,0 +1,61 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// sort_executor.cpp
+//
+// Identification: src/execution/sort_executor.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/executors/sort_executor.h"
+
+#include <vector>
+
+namespace bustub {
+
+SortExecutor::SortExecutor(ExecutorContext *exec_ctx, const SortPlanNode *plan,
+                           std::unique_ptr<AbstractExecutor> &&child_executor)
+    : AbstractExecutor(exec_ctx), plan_(plan), child_executor_(std::move(child_executor)) {}
+
+void SortExecutor::Init() {
+  this->child_executor_->Init();
+  std::vector<ExternalSort::SortKey> keys;
+  for (const auto &[order_by_type, expr] : this->plan_->GetOrderBy()) {
+    keys.push_back(ExternalSort::SortKey{expr, order_by_type == OrderByType::ASC});
+  }
+  // 先释放上一次排序留下的 run，再建立新的排序
+  this->sort_.reset();
+  this->sort_ = std::make_unique<ExternalSort>(this->exec_ctx_->GetBufferPoolManager(),
+                                               this->child_executor_->GetOutputSchema(), std::move(keys),
+                                               this->plan_->GetMemoryBudget());
+  TupleBatch batch;
+  while (this->child_executor_->NextBatch(&batch)) {
+    for (size_t i = 0; i < batch.Size(); i++) {
+      this->sort_->Add(batch.TupleAt(i));
+    }
+  }
+  this->sort_->Finish();
+}
+
+bool SortExecutor::Next(Tuple *tuple, RID *rid) {
+  if (!this->sort_->Next(tuple)) {
+    return false;
+  }
+  *rid = tuple->GetRid();
+  return true;
+}
+
+bool SortExecutor::NextBatch(TupleBatch *batch) {
+  batch->Clear();
+  Tuple tuple;
+  while (!batch->IsFull() && this->sort_->Next(&tuple)) {
+    RID rid = tuple.GetRid();
+    batch->Append(std::move(tuple), rid);
+  }
+  return !batch->IsEmpty();
+}
+
+}  // namespace bustub
@@ -0,0 +1,464 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// vector_operations.cpp
+//
+// Identification: src/execution/vector_operations.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "execution/vector_operations.h"
+
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#include "execution/expressions/comparison_expression.h"
+
+namespace bustub {
+
+namespace {
+
+template <ComparisonType OP>
+using OpTag = std::integral_constant<ComparisonType, OP>;
+
+bool IsInteger(TypeId type) {
+  return type == TypeId::TINYINT || type == TypeId::SMALLINT || type == TypeId::INTEGER || type == TypeId::BIGINT;
+}
+
+/** Reads row of a numeric column widened to T */
+template <typename T>
+T Widen(const ColumnVector &column, size_t row) {
+  switch (column.GetType()) {
+    case TypeId::TINYINT:
+      return static_cast<T>(column.Data<int8_t>()[row]);
+    case TypeId::SMALLINT:
+      return static_cast<T>(column.Data<int16_t>()[row]);
+    case TypeId::INTEGER:
+      return static_cast<T>(column.Data<int32_t>()[row]);
+    case TypeId::BIGINT:
+      return static_cast<T>(column.Data<int64_t>()[row]);
+    default:
+      return static_cast<T>(column.Data<double>()[row]);
+  }
+}
+
+template <ComparisonType OP, typename T>
+inline bool Compare(T lhs, T rhs) {
+  return ComparisonExpression::Compare<OP>(lhs, rhs);
+}
+
+/**
+ * The selection loop of the scalar kernels. The output is written
+ * unconditionally and the cursor advanced by the predicate, so the loop has no
+ * data dependent branch.
+ */
+template <typename Predicate>
+void SelectRows(const ColumnVector *nullable_lhs, const ColumnVector *nullable_rhs, SelectionVector *sel,
+                Predicate &&predicate) {
+  uint32_t *rows = sel->Data();
+  size_t count = sel->Size();
+  size_t kept = 0;
+  bool check_nulls = (nullable_lhs != nullptr && !nullable_lhs->AllValid(*sel)) ||
+                     (nullable_rhs != nullptr && !nullable_rhs->AllValid(*sel));
+  if (check_nulls) {
+    for (size_t i = 0; i < count; i++) {
+      uint32_t row = rows[i];
+      rows[kept] = row;
+      kept += static_cast<size_t>(predicate(row) && nullable_lhs->IsValid(row) &&
+                                  (nullable_rhs == nullptr || nullable_rhs->IsValid(row)));
+    }
+  } else {
+    for (size_t i = 0; i < count; i++) {
+      uint32_t row = rows[i];
+      rows[kept] = row;
+      kept += static_cast<size_t>(predicate(row));
+    }
+  }
+  sel->Resize(kept);
+}
+
+#ifdef __AVX2__
+/** @return bit i set when lane i of (lhs OP rhs) holds, for 8 int32 lanes */
+template <ComparisonType OP>
+inline uint32_t CompareInt32x8(__m256i lhs, __m256i rhs) {
+  __m256i result;
+  if constexpr (OP == ComparisonType::Equal || OP == ComparisonType::NotEqual) {
+    result = _mm256_cmpeq_epi32(lhs, rhs);
+  } else if constexpr (OP == ComparisonType::LessThan || OP == ComparisonType::GreaterThanOrEqual) {
+    result = _mm256_cmpgt_epi32(rhs, lhs);
+  } else {
+    result = _mm256_cmpgt_epi32(lhs, rhs);
+  }
+  auto bits = static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(result)));
+  // AVX2 只有相等和大于, 不等/小于等于/大于等于由它们取反得到
+  if constexpr (OP == ComparisonType::NotEqual || OP == ComparisonType::LessThanOrEqual ||
+                OP == ComparisonType::GreaterThanOrEqual) {
+    bits ^= 0xFFU;
+  }
+  return bits;
+}
+
+/** @return bit i set when lane i of (lhs OP rhs) holds, for 4 int64 lanes */
+template <ComparisonType OP>
+inline uint32_t CompareInt64x4(__m256i lhs, __m256i rhs) {
+  __m256i result;
+  if constexpr (OP == ComparisonType::Equal || OP == ComparisonType::NotEqual) {
+    result = _mm256_cmpeq_epi64(lhs, rhs);
+  } else if constexpr (OP == ComparisonType::LessThan || OP == ComparisonType::GreaterThanOrEqual) {
+    result = _mm256_cmpgt_epi64(rhs, lhs);
+  } else {
+    result = _mm256_cmpgt_epi64(lhs, rhs);
+  }
+  auto bits = static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(result)));
+  if constexpr (OP == ComparisonType::NotEqual || OP == ComparisonType::LessThanOrEqual ||
+                OP == ComparisonType::GreaterThanOrEqual) {
+    bits ^= 0xFU;
+  }
+  return bits;
+}
+
+/** @return bit i set when lane i of (lhs OP rhs) holds, for 4 double lanes, with the NaN behaviour of Compare() */
+template <ComparisonType OP>
+inline uint32_t CompareDoublex4(__m256d lhs, __m256d rhs) {
+  constexpr int PREDICATE = OP == ComparisonType::Equal             ? _CMP_EQ_OQ
+                            : OP == ComparisonType::NotEqual        ? _CMP_NEQ_UQ
+                            : OP == ComparisonType::LessThan        ? _CMP_LT_OQ
+                            : OP == ComparisonType::LessThanOrEqual ? _CMP_LE_OQ
+                            : OP == ComparisonType::GreaterThan     ? _CMP_GT_OQ
+                                                                    : _CMP_GE_OQ;
+  return static_cast<uint32_t>(_mm256_movemask_pd(_mm256_cmp_pd(lhs, rhs, PREDICATE)));
+}
+
+/**
+ * Compares the whole vectors of rows in [0, count) with AVX2, OR-ing the
+ * results into bits.
+ * @return the number of rows compared, the caller compares the rest
+ */
+template <ComparisonType OP, bool CONSTANT, typename T>
+size_t CompareBlockAvx2(const T *lhs, const T *rhs, size_t count, uint64_t *bits) {
+  constexpr size_t LANES = sizeof(__m256i) / sizeof(T);
+  size_t i = 0;
+  if constexpr (std::is_same_v<T, double>) {
+    const __m256d constant = _mm256_set1_pd(rhs[0]);
+    for (; i + LANES <= count; i += LANES) {
+      __m256d right = CONSTANT ? constant : _mm256_loadu_pd(rhs + i);
+      *bits |= static_cast<uint64_t>(CompareDoublex4<OP>(_mm256_loadu_pd(lhs + i), right)) << i;
+    }
+  } else {
+    const __m256i constant = sizeof(T) == 4 ? _mm256_set1_epi32(static_cast<int32_t>(rhs[0]))
+                                            : _mm256_set1_epi64x(static_cast<int64_t>(rhs[0]));
+    const __m256i sign_bit = _mm256_set1_epi64x(std::numeric_limits<int64_t>::min());
+    for (; i + LANES <= count; i += LANES) {
+      __m256i left = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(lhs + i));
+      __m256i right = CONSTANT ? constant : _mm256_loadu_si256(reinterpret_cast<const __m256i *>(rhs + i));
+      if constexpr (sizeof(T) == 4) {
+        *bits |= static_cast<uint64_t>(CompareInt32x8<OP>(left, right)) << i;
+      } else {
+        if constexpr (std::is_same_v<T, uint64_t>) {
+          // 无符号的 TIMESTAMP 翻转符号位后按有符号数比较
+          left = _mm256_xor_si256(left, sign_bit);
+          right = _mm256_xor_si256(right, sign_bit);
+        }
+        *bits |= static_cast<uint64_t>(CompareInt64x4<OP>(left, right)) << i;
+      }
+    }
+  }
+  return i;
+}
+#endif
+
+/**
+ * @return the bitmap of the rows i in [0, count), count <= 64, for which
+ * (lhs[i] OP rhs[i]) holds; if CONSTANT, every row is compared with rhs[0]
+ */
+template <ComparisonType OP, bool CONSTANT, typename T>
+uint64_t CompareBlock(const T *lhs, const T *rhs, size_t count) {
+  uint64_t bits = 0;
+  size_t i = 0;
+#ifdef __AVX2__
+  i = CompareBlockAvx2<OP, CONSTANT>(lhs, rhs, count, &bits);
+#endif
+  for (; i < count; i++) {
+    bits |= static_cast<uint64_t>(Compare<OP>(lhs[i], CONSTANT ? rhs[0] : rhs[i])) << i;
+  }
+  return bits;
+}
+
+#ifdef __AVX2__
+/** PACK_TABLE[m] lists the positions of the set bits of the byte m, then zeros */
+struct PackTable {
+  constexpr PackTable() : positions_() {
+    for (uint32_t mask = 0; mask < 256; mask++) {
+      uint32_t count = 0;
+      for (uint32_t bit = 0; bit < 8; bit++) {
+        if ((mask >> bit & 1) != 0) {
+          positions_[mask][count++] = bit;
+        }
+      }
+    }
+  }
+  alignas(32) uint32_t positions_[256][8];
+};
+
+constexpr PackTable PACK_TABLE;
+#endif
+
+/**
+ * Writes base + i for every set bit i of bits, i < block, to rows[kept...].
+ * @return kept plus the number of rows written
+ */
+inline size_t AppendRows(uint64_t bits, uint32_t base, size_t block, uint32_t *rows, size_t kept) {
+#ifdef __AVX2__
+  // 每次处理 8 位: 查表得到置位的下标, 加上行号后一次写出 8 项, 其中前 popcount 项有效.
+  // kept 不超过已处理的行数, 所以这 8 项都落在 rows 之内
+  size_t byte = 0;
+  for (; byte * 8 + 8 <= block; byte++) {
+    auto mask = static_cast<uint32_t>((bits >> (byte * 8)) & 0xFF);
+    __m256i positions = _mm256_load_si256(reinterpret_cast<const __m256i *>(PACK_TABLE.positions_[mask]));
+    __m256i row_ids = _mm256_add_epi32(positions, _mm256_set1_epi32(static_cast<int32_t>(base + byte * 8)));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(rows + kept), row_ids);
+    kept += static_cast<size_t>(__builtin_popcount(mask));
+  }
+  bits = byte * 8 < 64 ? bits >> (byte * 8) << (byte * 8) : 0;
+#endif
+  for (; bits != 0; bits &= bits - 1) {
+    rows[kept++] = base + static_cast<uint32_t>(__builtin_ctzll(bits));
+  }
+  return kept;
+}
+
+/** @return true if sel selects every row in [0, sel.Size()), which is how a scan hands over a chunk */
+bool IsDense(const SelectionVector &sel) { return !sel.IsEmpty() && sel[sel.Size() - 1] == sel.Size() - 1; }
+
+/**
+ * The kernel for a dense selection: compares 64 rows at a time into a bitmap,
+ * masks it with the validity bitmaps and turns the set bits into row numbers.
+ */
+template <ComparisonType OP, bool CONSTANT, typename T>
+void SelectDense(const ColumnVector &lhs, const T *rhs, const ColumnVector *nullable_rhs, SelectionVector *sel) {
+  const T *left = lhs.Data<T>();
+  uint32_t *rows = sel->Data();
+  size_t count = sel->Size();
+  size_t kept = 0;
+  for (size_t base = 0; base < count; base += 64) {
+    size_t block = std::min<size_t>(64, count - base);
+    uint64_t bits = CompareBlock<OP, CONSTANT>(left + base, CONSTANT ? rhs : rhs + base, block);
+    bits &= lhs.Validity()[base / 64];
+    if (nullable_rhs != nullptr) {
+      bits &= nullable_rhs->Validity()[base / 64];
+    }
+    kept = AppendRows(bits, static_cast<uint32_t>(base), block, rows, kept);
+  }
+  sel->Resize(kept);
+}
+
+template <ComparisonType OP>
+bool SelectDenseConstant(const ColumnVector &column, const Value &constant, SelectionVector *sel) {
+  TypeId constant_type = constant.GetTypeId();
+  switch (column.GetType()) {
+    case TypeId::INTEGER: {
+      if (!IsInteger(constant_type)) {
+        return false;
+      }
+      auto value = constant.CastAs(TypeId::BIGINT).GetAs<int64_t>();
+      if (value < std::numeric_limits<int32_t>::min() || value > std::numeric_limits<int32_t>::max()) {
+        return false;
+      }
+      auto narrow = static_cast<int32_t>(value);
+      SelectDense<OP, true>(column, &narrow, nullptr, sel);
+      return true;
+    }
+    case TypeId::BIGINT: {
+      if (!IsInteger(constant_type)) {
+        return false;
+      }
+      auto value = constant.CastAs(TypeId::BIGINT).GetAs<int64_t>();
+      SelectDense<OP, true>(column, &value, nullptr, sel);
+      return true;
+    }
+    case TypeId::DECIMAL: {
+      if (!IsInteger(constant_type) && constant_type != TypeId::DECIMAL) {
+        return false;
+      }
+      auto value = constant.CastAs(TypeId::DECIMAL).GetAs<double>();
+      SelectDense<OP, true>(column, &value, nullptr, sel);
+      return true;
+    }
+    case TypeId::TIMESTAMP: {
+      if (constant_type != TypeId::TIMESTAMP) {
+        return false;
+      }
+      auto value = constant.GetAs<uint64_t>();
+      SelectDense<OP, true>(column, &value, nullptr, sel);
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+template <ComparisonType OP>
+bool SelectDenseColumns(const ColumnVector &lhs, const ColumnVector &rhs, SelectionVector *sel) {
+  if (lhs.GetType() != rhs.GetType()) {
+    return false;
+  }
+  switch (lhs.GetType()) {
+    case TypeId::INTEGER:
+      SelectDense<OP, false>(lhs, rhs.Data<int32_t>(), &rhs, sel);
+      return true;
+    case TypeId::BIGINT:
+      SelectDense<OP, false>(lhs, rhs.Data<int64_t>(), &rhs, sel);
+      return true;
+    case TypeId::DECIMAL:
+      SelectDense<OP, false>(lhs, rhs.Data<double>(), &rhs, sel);
+      return true;
+    case TypeId::TIMESTAMP:
+      SelectDense<OP, false>(lhs, rhs.Data<uint64_t>(), &rhs, sel);
+      return true;
+    default:
+      return false;
+  }
+}
+
+template <ComparisonType OP>
+bool SelectConstant(const ColumnVector &column, const Value &constant, SelectionVector *sel) {
+  if (IsDense(*sel) && SelectDenseConstant<OP>(column, constant, sel)) {
+    return true;
+  }
+  TypeId type = column.GetType();
+  if (IsInteger(type) && IsInteger(constant.GetTypeId())) {
+    auto value = constant.CastAs(TypeId::BIGINT).GetAs<int64_t>();
+    switch (type) {
+      case TypeId::TINYINT: {
+        const int8_t *data = column.Data<int8_t>();
+        SelectRows(&column, nullptr, sel, [&](uint32_t row) { return Compare<OP>(int64_t{data[row]}, value); });
+        return true;
+      }
+      case TypeId::SMALLINT: {
+        const int16_t *data = column.Data<int16_t>();
+        SelectRows(&column, nullptr, sel, [&](uint32_t row) { return Compare<OP>(int64_t{data[row]}, value); });
+        return true;
+      }
+      case TypeId::INTEGER: {
+        const int32_t *data = column.Data<int32_t>();
+        SelectRows(&column, nullptr, sel, [&](uint32_t row) { return Compare<OP>(int64_t{data[row]}, value); });
+        return true;
+      }
+      default: {
+        const int64_t *data = column.Data<int64_t>();
+        SelectRows(&column, nullptr, sel, [&](uint32_t row) { return Compare<OP>(data[row], value); });
+        return true;
+      }
+    }
+  }
+  if (type == TypeId::TIMESTAMP && constant.GetTypeId() == TypeId::TIMESTAMP) {
+    const uint64_t *data = column.Data<uint64_t>();
+    auto value = constant.GetAs<uint64_t>();
+    SelectRows(&column, nullptr, sel, [&](uint32_t row) { return Compare<OP>(data[row], value); });
+    return true;
+  }
+  // 有一侧是 DECIMAL 时和 Value 一样按 double 比较
+  bool numeric = (IsInteger(type) || type == TypeId::DECIMAL) &&
+                 (IsInteger(constant.GetTypeId()) || constant.GetTypeId() == TypeId::DECIMAL);
+  if (numeric) {
+    auto value = constant.CastAs(TypeId::DECIMAL).GetAs<double>();
+    SelectRows(&column, nullptr, sel, [&](uint32_t row) { return Compare<OP>(Widen<double>(column, row), value); });
+    return true;
+  }
+  return false;
+}
+
+template <ComparisonType OP>
+bool SelectColumns(const ColumnVector &lhs, const ColumnVector &rhs, SelectionVector *sel) {
+  if (IsDense(*sel) && SelectDenseColumns<OP>(lhs, rhs, sel)) {
+    return true;
+  }
+  if (IsInteger(lhs.GetType()) && IsInteger(rhs.GetType())) {
+    if (lhs.GetType() == TypeId::INTEGER && rhs.GetType() == TypeId::INTEGER) {
+      const int32_t *left = lhs.Data<int32_t>();
+      const int32_t *right = rhs.Data<int32_t>();
+      SelectRows(&lhs, &rhs, sel, [&](uint32_t row) { return Compare<OP>(left[row], right[row]); });
+      return true;
+    }
+    SelectRows(&lhs, &rhs, sel,
+               [&](uint32_t row) { return Compare<OP>(Widen<int64_t>(lhs, row), Widen<int64_t>(rhs, row)); });
+    return true;
+  }
+  if (lhs.GetType() == TypeId::TIMESTAMP && rhs.GetType() == TypeId::TIMESTAMP) {
+    const uint64_t *left = lhs.Data<uint64_t>();
+    const uint64_t *right = rhs.Data<uint64_t>();
+    SelectRows(&lhs, &rhs, sel, [&](uint32_t row) { return Compare<OP>(left[row], right[row]); });
+    return true;
+  }
+  bool numeric = (IsInteger(lhs.GetType()) || lhs.GetType() == TypeId::DECIMAL) &&
+                 (IsInteger(rhs.GetType()) || rhs.GetType() == TypeId::DECIMAL);
+  if (numeric) {
+    SelectRows(&lhs, &rhs, sel,
+               [&](uint32_t row) { return Compare<OP>(Widen<double>(lhs, row), Widen<double>(rhs, row)); });
+    return true;
+  }
+  return false;
+}
+
+/** Instantiates kernel for op, which it receives as an OpTag */
+template <typename Kernel>
+bool Dispatch(ComparisonType op, Kernel &&kernel) {
+  switch (op) {
+    case ComparisonType::Equal:
+      return kernel(OpTag<ComparisonType::Equal>());
+    case ComparisonType::NotEqual:
+      return kernel(OpTag<ComparisonType::NotEqual>());
+    case ComparisonType::LessThan:
+      return kernel(OpTag<ComparisonType::LessThan>());
+    case ComparisonType::LessThanOrEqual:
+      return kernel(OpTag<ComparisonType::LessThanOrEqual>());
+    case ComparisonType::GreaterThan:
+      return kernel(OpTag<ComparisonType::GreaterThan>());
+    case ComparisonType::GreaterThanOrEqual:
+      return kernel(OpTag<ComparisonType::GreaterThanOrEqual>());
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+bool VectorOperations::SelectCompareConstant(const ColumnVector &column, ComparisonType op, const Value &constant,
+                                             SelectionVector *sel) {
+  if (constant.IsNull()) {
+    // 与 NULL 的比较结果总是 NULL, 没有行被选中
+    sel->Resize(0);
+    return true;
+  }
+  return Dispatch(op, [&](auto tag) { return SelectConstant<decltype(tag)::value>(column, constant, sel); });
+}
+
+bool VectorOperations::SelectCompareColumns(const ColumnVector &lhs, ComparisonType op, const ColumnVector &rhs,
+                                            SelectionVector *sel) {
+  return Dispatch(op, [&](auto tag) { return SelectColumns<decltype(tag)::value>(lhs, rhs, sel); });
+}
+
+ComparisonType VectorOperations::Flip(ComparisonType op) {
+  switch (op) {
+    case ComparisonType::LessThan:
+      return ComparisonType::GreaterThan;
+    case ComparisonType::LessThanOrEqual:
+      return ComparisonType::GreaterThanOrEqual;
+    case ComparisonType::GreaterThan:
+      return ComparisonType::LessThan;
+    case ComparisonType::GreaterThanOrEqual:
+      return ComparisonType::LessThanOrEqual;
+    default:
+      return op;
+  }
+}
+
+}  // namespace bustub
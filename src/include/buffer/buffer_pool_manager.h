@@ -84,6 +84,14 @@ class BufferPoolManager {
     GradingCallback(callback, CallbackType::AFTER, INVALID_PAGE_ID);
   }
 
+  /**
+   * Hints that a page is about to be fetched so it can be read in ahead of time.
+   * The hint never pins the page: it can still be evicted or deleted before the
+   * fetch, and a buffer pool may ignore the hint.
+   * @param page_id id of the page to read ahead
+   */
+  void PrefetchPage(page_id_t page_id) { PrefetchPgImp(page_id); }
+
   /** @return size of the buffer pool */
   virtual size_t GetPoolSize() = 0;
 
@@ -141,5 +149,11 @@ class BufferPoolManager {
    * Flushes all the pages in the buffer pool to disk.
    */
   virtual void FlushAllPgsImp() = 0;
+
+  /**
+   * Reads a page ahead of a fetch without pinning it. Ignores the hint by default.
+   * @param page_id id of the page to read ahead
+   */
+  virtual void PrefetchPgImp(__attribute__((unused)) page_id_t page_id) {}
 };
 }  // namespace bustub
@@ -12,8 +12,11 @@
 
 #pragma once
 
+#include <condition_variable>  // NOLINT
+#include <deque>
 #include <list>
 #include <mutex>  // NOLINT
+#include <thread>  // NOLINT
 #include <unordered_map>
 
 #include "buffer/buffer_pool_manager.h"
@@ -100,6 +103,20 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   void FlushAllPgsImp() override;
 
+  /**
+   * Queues a page for the prefetch thread, which is started by the first hint.
+   * Hints are dropped while the queue already holds pool_size_ pages.
+   * @param page_id id of the page to read ahead
+   */
+  void PrefetchPgImp(page_id_t page_id) override;
+
+  /**
+   * Body of the prefetch thread. Reads each queued page that is not resident
+   * into a free frame, unpinned and owned by the replacer, so a later fetch
+   * finds it in memory. It never evicts a page to make room for a hint.
+   */
+  void PrefetchLoop();
+
   /**
    * Allocate a page on disk.∂
    * @return the id of the allocated page
@@ -144,5 +161,12 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   std::list<frame_id_t> free_list_;
   /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
   std::mutex latch_;
+
+  /** Pages waiting for the prefetch thread, protected by prefetch_latch_. */
+  std::deque<page_id_t> prefetch_queue_;
+  std::mutex prefetch_latch_;
+  std::condition_variable prefetch_cv_;
+  bool prefetch_stop_{false};
+  std::thread prefetch_thread_;
 };
 }  // namespace bustub
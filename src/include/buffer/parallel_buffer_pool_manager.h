@@ -88,6 +88,12 @@ class ParallelBufferPoolManager : public BufferPoolManager {
    */
   void FlushAllPgsImp() override;
 
+  /**
+   * Passes a read-ahead hint to the responsible BufferPoolManagerInstance.
+   * @param page_id id of the page to read ahead
+   */
+  void PrefetchPgImp(page_id_t page_id) override;
+
   private:
     size_t num_instances;
     size_t pool_size;
@@ -20,9 +20,12 @@
 
 #include "buffer/buffer_pool_manager.h"
 #include "catalog/schema.h"
+#include "common/exception.h"
 #include "container/hash/hash_function.h"
+#include "storage/index/b_plus_tree_index.h"
 #include "storage/index/extendible_hash_table_index.h"
 #include "storage/index/index.h"
+#include "storage/index/linear_probe_hash_table_index.h"
 #include "storage/table/table_heap.h"
 
 namespace bustub {
@@ -34,6 +37,13 @@ using table_oid_t = uint32_t;
 using column_oid_t = uint32_t;
 using index_oid_t = uint32_t;
 
+/**
+ * The access method backing an index. Hash indexes only answer point lookups;
+ * BPLUS_TREE keeps keys ordered and supports Index::ScanRange; it stores every
+ * row as a (key, rid) entry, so duplicate keys are allowed.
+ */
+enum class IndexType { EXTENDIBLE_HASH, BPLUS_TREE, LINEAR_PROBE_HASH };
+
 /**
  * The TableInfo class maintains metadata about a table.
  */
@@ -69,15 +79,17 @@ struct IndexInfo {
    * @param index_oid The unique OID for the index
    * @param table_name The name of the table on which the index is created
    * @param key_size The size of the index key, in bytes
+   * @param index_type The access method backing the index
    */
   IndexInfo(Schema key_schema, std::string name, std::unique_ptr<Index> &&index, index_oid_t index_oid,
-            std::string table_name, size_t key_size)
+            std::string table_name, size_t key_size, IndexType index_type = IndexType::EXTENDIBLE_HASH)
       : key_schema_{std::move(key_schema)},
         name_{std::move(name)},
         index_{std::move(index)},
         index_oid_{index_oid},
         table_name_{std::move(table_name)},
-        key_size_{key_size} {}
+        key_size_{key_size},
+        index_type_{index_type} {}
   /** The schema for the index key */
   Schema key_schema_;
   /** The name of the index */
@@ -90,6 +102,8 @@ struct IndexInfo {
   std::string table_name_;
   /** The size of the index key, in bytes */
   const size_t key_size_;
+  /** The access method backing the index */
+  const IndexType index_type_;
 };
 
 /**
@@ -185,13 +199,15 @@ class Catalog {
    * @param key_schema The schema of the key
    * @param key_attrs Key attributes
    * @param keysize Size of the key
-   * @param hash_function The hash function for the index
+   * @param hash_function The hash function for the index, unused by B+ tree indexes
+   * @param index_type The access method backing the index
    * @return A (non-owning) pointer to the metadata of the new table
    */
   template <class KeyType, class ValueType, class KeyComparator>
   IndexInfo *CreateIndex(Transaction *txn, const std::string &index_name, const std::string &table_name,
                          const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs,
-                         std::size_t keysize, HashFunction<KeyType> hash_function) {
+                         std::size_t keysize, HashFunction<KeyType> hash_function,
+                         IndexType index_type = IndexType::EXTENDIBLE_HASH) {
     // Reject the creation request for nonexistent table
 //    printf("[Debug] Reject the creation request for nonexistent table\n");
     if (table_names_.find(table_name) == table_names_.end()) {
@@ -211,17 +227,41 @@ class Catalog {
     // Construct index metadata
     auto meta = std::make_unique<IndexMetadata>(index_name, table_name, &schema, key_attrs);
 
-    // Construct the index, take ownership of metadata
-    // TODO(Kyle): We should update the API for CreateIndex
-    // to allow specification of the index type itself, not
-    // just the key, value, and comparator types
-    auto index = std::make_unique<ExtendibleHashTableIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_,
-                                                                                               hash_function);
-    // Populate the index with all tuples in table heap
     auto *table_meta = GetTable(table_name);
     auto *heap = table_meta->table_.get();
-    for (auto tuple = heap->Begin(txn); tuple != heap->End(); ++tuple) {
-      index->InsertEntry(tuple->KeyFromTuple(schema, key_schema, key_attrs), tuple->GetRid(), txn);
+
+    // Construct the index, take ownership of metadata
+    std::unique_ptr<Index> index;
+    switch (index_type) {
+      case IndexType::BPLUS_TREE: {
+        // Collect the keys of all tuples in table heap and bulk load them
+        std::vector<std::pair<Tuple, RID>> entries;
+        for (auto tuple = heap->Begin(txn); tuple != heap->End(); ++tuple) {
+          entries.emplace_back(tuple->KeyFromTuple(schema, key_schema, key_attrs), tuple->GetRid());
+        }
+        // The catalog is not persistent, so the tree keeps no root record in the header page
+        auto tree = std::make_unique<BPlusTreeIndex<KeyType, ValueType, KeyComparator>>(
+            std::move(meta), bpm_, BPlusTreeLatchMode::OPTIMISTIC, INVALID_PAGE_ID);
+        if (!tree->BulkLoad(entries)) {
+          throw Exception(ExceptionType::INVALID, "bulk load into a new B+ tree index failed");
+        }
+        index = std::move(tree);
+        break;
+      }
+      case IndexType::LINEAR_PROBE_HASH:
+        index = std::make_unique<LinearProbeHashTableIndex<KeyType, ValueType, KeyComparator>>(
+            std::move(meta), bpm_, DEFAULT_LINEAR_PROBE_BUCKETS, hash_function);
+        break;
+      case IndexType::EXTENDIBLE_HASH:
+        index = std::make_unique<ExtendibleHashTableIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_,
+                                                                                              hash_function);
+        break;
+    }
+    // Populate the hash indexes with all tuples in table heap
+    if (index_type != IndexType::BPLUS_TREE) {
+      for (auto tuple = heap->Begin(txn); tuple != heap->End(); ++tuple) {
+        index->InsertEntry(tuple->KeyFromTuple(schema, key_schema, key_attrs), tuple->GetRid(), txn);
+      }
     }
 
 //    printf("[Debug] Get the next OID for the new index\n");
@@ -229,8 +269,8 @@ class Catalog {
     const auto index_oid = next_index_oid_.fetch_add(1);
 
     // Construct index information; IndexInfo takes ownership of the Index itself
-    auto index_info =
-        std::make_unique<IndexInfo>(key_schema, index_name, std::move(index), index_oid, table_name, keysize);
+    auto index_info = std::make_unique<IndexInfo>(key_schema, index_name, std::move(index), index_oid, table_name,
+                                                  keysize, index_type);
     auto *tmp = index_info.get();
 
 //    printf("[Debug] Update internal tracking\n");
@@ -325,6 +365,9 @@ class Catalog {
   }
 
  private:
+  /** Initial bucket count of a linear probe index; the table grows as needed */
+  static constexpr size_t DEFAULT_LINEAR_PROBE_BUCKETS = 1000;
+
   [[maybe_unused]] BufferPoolManager *bpm_;
   [[maybe_unused]] LockManager *lock_manager_;
   [[maybe_unused]] LogManager *log_manager_;
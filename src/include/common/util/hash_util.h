@@ -13,9 +13,12 @@
 #pragma once
 
 #include <algorithm>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <string>
+#include <type_traits>
 
 #include "common/macros.h"
 #include "type/value.h"
@@ -24,58 +27,133 @@ namespace bustub {
 
 using hash_t = std::size_t;
 
+/**
+ * HashUtil provides the hash functions used by the execution engine (aggregation, distinct, joins).
+ *
+ * HashBytes is a wyhash-style hasher: it consumes input 16/48 bytes per step and folds every
+ * step through a 64x64->128 bit multiply ("mum"), so all input bits reach all output bits.
+ * Fixed width integers skip the byte loop entirely and go through HashInt.
+ */
 class HashUtil {
  private:
   static const hash_t PRIME_FACTOR = 10000019;
 
+  static constexpr uint64_t SECRET0 = 0xa0761d6478bd642fULL;
+  static constexpr uint64_t SECRET1 = 0xe7037ed1a0b428dbULL;
+  static constexpr uint64_t SECRET2 = 0x8ebc6af09c88c6e3ULL;
+  static constexpr uint64_t SECRET3 = 0x589965cc75374cc3ULL;
+
+  /** 64x64 -> 128 bit multiply, folded back to 64 bits by xor-ing the halves */
+  static inline uint64_t Mum(uint64_t a, uint64_t b) {
+    __uint128_t r = static_cast<__uint128_t>(a) * b;
+    return static_cast<uint64_t>(r) ^ static_cast<uint64_t>(r >> 64);
+  }
+
+  static inline uint64_t Read64(const char *p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+  }
+
+  static inline uint64_t Read32(const char *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+  }
+
  public:
   static inline hash_t HashBytes(const char *bytes, size_t length) {
-    // https://github.com/greenplum-db/gpos/blob/b53c1acd6285de94044ff91fbee91589543feba1/libgpos/src/utils.cpp#L126
-    hash_t hash = length;
-    for (size_t i = 0; i < length; ++i) {
-      hash = ((hash << 5) ^ (hash >> 27)) ^ bytes[i];
+    // https://github.com/wangyi-fudan/wyhash
+    const char *p = bytes;
+    uint64_t seed = SECRET0;
+    uint64_t a;
+    uint64_t b;
+    if (length <= 16) {
+      if (length >= 4) {
+        a = (Read32(p) << 32) | Read32(p + ((length >> 3) << 2));
+        b = (Read32(p + length - 4) << 32) | Read32(p + length - 4 - ((length >> 3) << 2));
+      } else if (length > 0) {
+        a = (static_cast<uint64_t>(static_cast<uint8_t>(p[0])) << 16) |
+            (static_cast<uint64_t>(static_cast<uint8_t>(p[length >> 1])) << 8) |
+            static_cast<uint64_t>(static_cast<uint8_t>(p[length - 1]));
+        b = 0;
+      } else {
+        a = 0;
+        b = 0;
+      }
+    } else {
+      size_t i = length;
+      if (i > 48) {
+        // three independent lanes, 48 bytes per step
+        uint64_t see1 = seed;
+        uint64_t see2 = seed;
+        do {
+          seed = Mum(Read64(p) ^ SECRET1, Read64(p + 8) ^ seed);
+          see1 = Mum(Read64(p + 16) ^ SECRET2, Read64(p + 24) ^ see1);
+          see2 = Mum(Read64(p + 32) ^ SECRET3, Read64(p + 40) ^ see2);
+          p += 48;
+          i -= 48;
+        } while (i > 48);
+        seed ^= see1 ^ see2;
+      }
+      while (i > 16) {
+        seed = Mum(Read64(p) ^ SECRET1, Read64(p + 8) ^ seed);
+        p += 16;
+        i -= 16;
+      }
+      // the last 16 bytes may overlap with the previous step
+      a = Read64(p + i - 16);
+      b = Read64(p + i - 8);
     }
-    return hash;
+    return Mum(SECRET1 ^ length, Mum(a ^ SECRET1, b ^ seed));
   }
 
-  static inline hash_t CombineHashes(hash_t l, hash_t r) {
-    hash_t both[2] = {};
-    both[0] = l;
-    both[1] = r;
-    return HashBytes(reinterpret_cast<char *>(both), sizeof(hash_t) * 2);
-  }
+  /** @return the hash of a fixed width integer (narrower integers are zero/sign extended by the caller) */
+  static inline hash_t HashInt(uint64_t val) { return Mum(Mum(val ^ SECRET0, SECRET1), SECRET2); }
+
+  static inline hash_t CombineHashes(hash_t l, hash_t r) { return Mum(l ^ SECRET0, r ^ SECRET3); }
 
   static inline hash_t SumHashes(hash_t l, hash_t r) { return (l % PRIME_FACTOR + r % PRIME_FACTOR) % PRIME_FACTOR; }
 
+  /**
+   * @return the hash of *ptr; signed integers are sign extended like HashValue does, so the same number hashes
+   * the same at every width, and -0.0 hashes like 0.0
+   */
   template <typename T>
   static inline hash_t Hash(const T *ptr) {
-    return HashBytes(reinterpret_cast<const char *>(ptr), sizeof(T));
+    if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+      return HashInt(static_cast<int64_t>(*ptr));
+    } else if constexpr (std::is_floating_point_v<T>) {
+      // -0.0 与 0.0 相等, 哈希值也必须相等
+      T val = *ptr == 0 ? T{0} : *ptr;
+      uint64_t raw = 0;
+      memcpy(&raw, &val, sizeof(T));
+      return HashInt(raw);
+    } else if constexpr (sizeof(T) <= sizeof(uint64_t)) {
+      uint64_t raw = 0;
+      memcpy(&raw, ptr, sizeof(T));
+      return HashInt(raw);
+    } else {
+      return HashBytes(reinterpret_cast<const char *>(ptr), sizeof(T));
+    }
   }
 
   template <typename T>
   static inline hash_t HashPtr(const T *ptr) {
-    return HashBytes(reinterpret_cast<const char *>(&ptr), sizeof(void *));
+    return HashInt(reinterpret_cast<uintptr_t>(ptr));
   }
 
   /** @return the hash of the value */
   static inline hash_t HashValue(const Value *val) {
     switch (val->GetTypeId()) {
-      case TypeId::TINYINT: {
-        auto raw = static_cast<int64_t>(val->GetAs<int8_t>());
-        return Hash<int64_t>(&raw);
-      }
-      case TypeId::SMALLINT: {
-        auto raw = static_cast<int64_t>(val->GetAs<int16_t>());
-        return Hash<int64_t>(&raw);
-      }
-      case TypeId::INTEGER: {
-        auto raw = static_cast<int64_t>(val->GetAs<int32_t>());
-        return Hash<int64_t>(&raw);
-      }
-      case TypeId::BIGINT: {
-        auto raw = static_cast<int64_t>(val->GetAs<int64_t>());
-        return Hash<int64_t>(&raw);
-      }
+      case TypeId::TINYINT:
+        return HashInt(static_cast<int64_t>(val->GetAs<int8_t>()));
+      case TypeId::SMALLINT:
+        return HashInt(static_cast<int64_t>(val->GetAs<int16_t>()));
+      case TypeId::INTEGER:
+        return HashInt(static_cast<int64_t>(val->GetAs<int32_t>()));
+      case TypeId::BIGINT:
+        return HashInt(val->GetAs<int64_t>());
       case TypeId::BOOLEAN: {
         auto raw = val->GetAs<bool>();
         return Hash<bool>(&raw);
@@ -89,10 +167,8 @@ class HashUtil {
         auto len = val->GetLength();
         return HashBytes(raw, len);
       }
-      case TypeId::TIMESTAMP: {
-        auto raw = val->GetAs<uint64_t>();
-        return Hash<uint64_t>(&raw);
-      }
+      case TypeId::TIMESTAMP:
+        return HashInt(val->GetAs<uint64_t>());
       default: {
         BUSTUB_ASSERT(false, "Unsupported type.");
       }
@@ -14,6 +14,7 @@
 
 #include <queue>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
@@ -41,9 +42,21 @@ class ExtendibleHashTable {
    * @param buffer_pool_manager buffer pool manager to be used
    * @param comparator comparator for keys
    * @param hash_fn the hash function
+   * @param pin_pages if true, keep the directory and every bucket page pinned for
+   *        the lifetime of the table (memory-resident mode)
    */
   explicit ExtendibleHashTable(const std::string &name, BufferPoolManager *buffer_pool_manager,
-                               const KeyComparator &comparator, HashFunction<KeyType> hash_fn);
+                               const KeyComparator &comparator, HashFunction<KeyType> hash_fn,
+                               bool pin_pages = false);
+
+  /**
+   * Releases the pages held by a memory-resident table. The buffer pool manager
+   * must outlive the table.
+   */
+  ~ExtendibleHashTable();
+
+  ExtendibleHashTable(const ExtendibleHashTable &) = delete;
+  ExtendibleHashTable &operator=(const ExtendibleHashTable &) = delete;
 
   /**
    * @brief Get the Dir Page object
@@ -58,7 +71,9 @@ class ExtendibleHashTable {
    * @param transaction the current transaction
    * @param key the key to create
    * @param value the value to be associated with the key
-   * @return true if insert succeeded, false otherwise
+   * @return true if insert succeeded, false if the pair already exists or the directory cannot grow
+   * @throws Exception OUT_OF_MEMORY if the buffer pool has no frame for a split bucket, which a
+   *         memory-resident table runs into once every frame holds one of its pages
    */
   bool Insert(Transaction *transaction, const KeyType &key, const ValueType &value);
 
@@ -82,6 +97,32 @@ class ExtendibleHashTable {
    */
   bool GetValue(Transaction *transaction, const KeyType &key, std::vector<ValueType> *result);
 
+  /**
+   * Performs a batch of point queries on the hash table.
+   *
+   * The directory is fetched once for the whole batch, keys are grouped by
+   * bucket page and every bucket page is fetched once. The next bucket page
+   * is fetched and prefetched into cache while the current group is probed.
+   *
+   * @param transaction the current transaction
+   * @param keys the keys to look up
+   * @param[out] results results->at(i) receives the value(s) associated with keys[i]
+   * @return true if at least one key matched
+   */
+  bool GetValues(Transaction *transaction, const std::vector<KeyType> &keys,
+                 std::vector<std::vector<ValueType>> *results);
+
+  /**
+   * Merges every bucket pair whose combined contents fit in half a bucket, then
+   * shrinks the directory as far as possible. Freed bucket pages are deleted
+   * from the buffer pool. Takes the table latch, so it can be run from a
+   * maintenance thread while the table is in use.
+   *
+   * @param transaction the current transaction
+   * @return the number of bucket pages freed
+   */
+  size_t Compact(Transaction *transaction);
+
   /**
    * Returns the global depth.  Do not touch.
    */
@@ -144,6 +185,39 @@ class ExtendibleHashTable {
    */
   HASH_TABLE_BUCKET_TYPE *FetchBucketPage(page_id_t bucket_page_id);
 
+  /**
+   * Releases the directory page obtained from FetchDirectoryPage. No-op in
+   * memory-resident mode.
+   *
+   * @param is_dirty whether the directory was modified
+   */
+  void UnpinDirectoryPage(bool is_dirty);
+
+  /**
+   * Releases a bucket page obtained from FetchBucketPage or NewBucketPage. No-op
+   * in memory-resident mode.
+   *
+   * @param bucket_page_id the page_id to release
+   * @param is_dirty whether the bucket was modified
+   */
+  void UnpinBucketPage(page_id_t bucket_page_id, bool is_dirty);
+
+  /**
+   * Allocates a new, empty bucket page. The page is returned pinned and must be
+   * released with UnpinBucketPage.
+   *
+   * @param[out] bucket_page_id the page_id of the new bucket
+   * @return a pointer to the new bucket page, nullptr if the buffer pool is full
+   */
+  HASH_TABLE_BUCKET_TYPE *NewBucketPage(page_id_t *bucket_page_id);
+
+  /**
+   * Deletes a bucket page that is no longer referenced by the directory.
+   *
+   * @param bucket_page_id the page_id to delete
+   */
+  void DeleteBucketPage(page_id_t bucket_page_id);
+
   /**
    * Performs insertion with an optional bucket splitting.
    *
@@ -158,10 +232,8 @@ class ExtendibleHashTable {
    * Optionally merges an empty bucket into it's pair.  This is called by Remove,
    * if Remove makes a bucket empty.
    *
-   * There are three conditions under which we skip the merge:
-   * 1. The bucket is no longer empty.
-   * 2. The bucket has local depth 0.
-   * 3. The bucket's local depth doesn't match its split image's local depth.
+   * Merging repeats with the merged bucket's new split image for as long as one
+   * side of the pair is empty, and the directory is shrunk after every merge.
    *
    * @param transaction a pointer to the current transaction
    * @param key the key that was removed
@@ -169,6 +241,23 @@ class ExtendibleHashTable {
    */
   void Merge(Transaction *transaction, const KeyType &key, const ValueType &value);
 
+  /**
+   * Merges the bucket at bucket_idx with its split image if either is empty or
+   * their combined size is at most max_size. The bucket on the side whose high
+   * bit is 0 is kept, the other page is deleted.
+   *
+   * There are three conditions under which we skip the merge:
+   * 1. Neither bucket is empty and the combined size exceeds max_size.
+   * 2. The bucket has local depth 0.
+   * 3. The bucket's local depth doesn't match its split image's local depth.
+   *
+   * @param dir_page a pointer to the hash table's directory page
+   * @param bucket_idx the directory index of the bucket
+   * @param max_size the largest combined size that is merged
+   * @return true if the buckets were merged
+   */
+  bool MergeBuckets(HashTableDirectoryPage *dir_page, uint32_t bucket_idx, size_t max_size);
+
 
   // member variables
   page_id_t directory_page_id_;
@@ -178,6 +267,11 @@ class ExtendibleHashTable {
   // Readers includes inserts and removes, writers are splits and merges
   ReaderWriterLatch table_latch_;
   HashFunction<KeyType> hash_fn_;
+
+  // Memory-resident mode: pages stay pinned and are reached through these pointers
+  bool pin_pages_;
+  HashTableDirectoryPage *pinned_directory_page_{nullptr};
+  std::unordered_map<page_id_t, HASH_TABLE_BUCKET_TYPE *> pinned_bucket_pages_;
 };
 
 }  // namespace bustub
@@ -26,12 +26,24 @@
 
 namespace bustub {
 
-#define HASH_TABLE_TYPE LinearProbeHashTable<KeyType, ValueType, KeyComparator>
+#define LINEAR_PROBE_HASH_TABLE_TYPE LinearProbeHashTable<KeyType, ValueType, KeyComparator>
 
 /**
  * Implementation of linear probing hash table that is backed by a buffer pool
  * manager. Non-unique keys are supported. Supports insert and delete. The
- * table dynamically grows once full.
+ * table dynamically grows once its load factor passes MAX_LOAD_FACTOR.
+ *
+ * Growing is incremental: Resize only allocates the new generation of blocks,
+ * and every following Insert/Remove rehashes up to MIGRATE_BLOCKS_PER_OP blocks
+ * of the old generation into it. While a resize is in flight both generations
+ * are probed; an entry lives in exactly one of them at any time.
+ *
+ * The header page of a generation lists its block pages. A generation with
+ * more blocks than a header page can list uses a second level: its header
+ * page lists directory pages, each of which lists MaxNumBlocks() blocks. A
+ * table that would need more blocks than that throws OUT_OF_RANGE from Insert,
+ * and an Insert that cannot allocate a new generation throws OUT_OF_MEMORY;
+ * in both cases the table is left unchanged.
  */
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class LinearProbeHashTable : public HashTable<KeyType, ValueType, KeyComparator> {
@@ -86,9 +98,74 @@ class LinearProbeHashTable : public HashTable<KeyType, ValueType, KeyComparator>
    */
   size_t GetSize();
 
+  /** Slots that may be occupied (live entries plus tombstones) before a resize is triggered */
+  static constexpr double MAX_LOAD_FACTOR = 0.75;
+
+  /** Number of old generation blocks rehashed by each Insert/Remove while a resize is in flight */
+  static constexpr size_t MIGRATE_BLOCKS_PER_OP = 2;
+
  private:
+  /**
+   * Allocates a header page, the directory pages if they are needed and enough block pages to hold num_buckets
+   * slots. If a page cannot be allocated, the pages allocated so far are deleted before the exception is thrown.
+   *
+   * @param num_buckets the minimum number of slots of the new table
+   * @return the page_id of the new header page
+   */
+  page_id_t NewTable(size_t num_buckets);
+
+  /**
+   * Returns the header page and all of its directory and block pages to the buffer pool manager.
+   *
+   * @param header_page_id the header page of the table to drop
+   */
+  void DeleteTable(page_id_t header_page_id);
+
+  /** @return true if the header page lists directory pages rather than block pages */
+  static bool HasDirectory(HashTableHeaderPage *header_page);
+
+  /** @return the page_id of the block_idx-th block of the table with the given header page */
+  page_id_t GetBlockPageId(HashTableHeaderPage *header_page, size_t block_idx);
+
+  HashTableHeaderPage *FetchHeaderPage(page_id_t header_page_id);
+
+  HASH_TABLE_BLOCK_TYPE *FetchBlockPage(page_id_t block_page_id);
+
+  /** Collects every value matching key from the table rooted at header_page_id */
+  bool GetValueFrom(page_id_t header_page_id, const KeyType &key, std::vector<ValueType> *result);
+
+  /**
+   * Inserts a key-value pair into the table rooted at header_page_id.
+   *
+   * @param[out] full set to true if the probe wrapped around without finding a free slot
+   * @return true if inserted, false if the pair already exists or the table is full
+   */
+  bool InsertInto(page_id_t header_page_id, const KeyType &key, const ValueType &value, bool *full);
+
+  /** Removes a key-value pair from the table rooted at header_page_id */
+  bool RemoveFrom(page_id_t header_page_id, const KeyType &key, const ValueType &value);
+
+  /** Starts a resize if inserting one more entry would exceed MAX_LOAD_FACTOR */
+  void MaybeGrow();
+
+  /**
+   * Rehashes at most max_blocks blocks of the old generation into the current one.
+   * The old generation is dropped once its last block has been migrated.
+   */
+  void MigrateBlocks(size_t max_blocks);
+
   // member variable
   page_id_t header_page_id_;
+  // 扩容过程中旧的哈希表, 没有扩容时为 INVALID_PAGE_ID
+  page_id_t old_header_page_id_{INVALID_PAGE_ID};
+  // 旧哈希表中下一个需要迁移的 block 下标
+  size_t migrate_block_idx_{0};
+  // 当前哈希表中被占用的插槽数量 (包括墓碑)
+  size_t num_occupied_{0};
+  // 当前哈希表中有效的键值对数量
+  size_t num_readable_{0};
+  // 旧哈希表中尚未迁移的键值对数量
+  size_t old_num_readable_{0};
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
 
@@ -0,0 +1,140 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compiled_predicate.h
+//
+// Identification: src/include/execution/compiled_predicate.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "execution/expressions/abstract_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "storage/table/tuple.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * CompiledPredicate is a boolean expression tree flattened into a program of
+ * type-specialized instructions, built once when an executor is initialized
+ * and run for every tuple.
+ *
+ * Every node gets a register holding a native value and a NULL flag. Columns
+ * are read straight from the tuple data at their offset in the schema,
+ * constants are loaded into their registers at compile time, and every
+ * comparison is an instruction instantiated for its ComparisonType and the
+ * types of its operands. Subtrees the compiler does not handle (e.g.
+ * comparisons of VARCHARs) become one instruction that evaluates them
+ * through AbstractExpression.
+ *
+ * A predicate that evaluates to NULL is false, as in SQL. A program is not
+ * safe for concurrent use, as the registers belong to it.
+ */
+class CompiledPredicate {
+ public:
+  /**
+   * Compiles a predicate over the tuples of schema, run with Evaluate().
+   * @param predicate The predicate, nullptr for one that is always true
+   */
+  void Compile(const AbstractExpression *predicate, const Schema *schema);
+
+  /** Compiles a join predicate over tuples of left_schema and right_schema, run with EvaluateJoin() */
+  void CompileJoin(const AbstractExpression *predicate, const Schema *left_schema, const Schema *right_schema);
+
+  /** Compiles a predicate over group-by and aggregate values, run with EvaluateAggregate() */
+  void CompileAggregate(const AbstractExpression *predicate);
+
+  bool Evaluate(const Tuple *tuple) { return Run(tuple, nullptr, nullptr, nullptr); }
+
+  bool EvaluateJoin(const Tuple *left_tuple, const Tuple *right_tuple) {
+    return Run(left_tuple, right_tuple, nullptr, nullptr);
+  }
+
+  bool EvaluateAggregate(const std::vector<Value> &group_bys, const std::vector<Value> &aggregates) {
+    return Run(nullptr, nullptr, &group_bys, &aggregates);
+  }
+
+  /** @return the number of instructions that fall back to evaluating an expression */
+  size_t FallbackCount() const;
+
+ private:
+  /** The ways a program can be run, each reads its input differently */
+  enum class Mode { TUPLE, JOIN, AGGREGATE };
+
+  /** A native value; integers are also kept as a double so that they compare with DECIMALs */
+  struct Register {
+    int64_t integer_;
+    double decimal_;
+    bool is_null_;
+  };
+
+  /** The inputs and registers of one run */
+  struct Frame {
+    Register *registers_;
+    const Tuple *tuples_[2];
+    const std::vector<Value> *group_bys_;
+    const std::vector<Value> *aggregates_;
+  };
+
+  struct Instruction;
+  using Operation = void (*)(const Instruction &instruction, const CompiledPredicate &program, Frame *frame);
+
+  struct Instruction {
+    Operation operation_;
+    uint32_t dst_;
+    /** The operand registers of a comparison; the tuple and the offset of a column */
+    uint32_t lhs_;
+    uint32_t rhs_;
+    /** The subtree evaluated by a fallback, or the aggregate term loaded */
+    const AbstractExpression *expr_;
+  };
+
+  /** The kinds of values a register holds, the types with the same kind compare with each other */
+  enum class Kind { INTEGER, BOOLEAN, DECIMAL, TIMESTAMP, NONE };
+
+  void Reset(const AbstractExpression *predicate, Mode mode);
+
+  /** Emits the instructions of expr. @return its register and kind, or Kind::NONE if a register cannot hold it */
+  std::pair<uint32_t, Kind> CompileNode(const AbstractExpression *expr);
+
+  /** Emits an instruction that evaluates expr through AbstractExpression */
+  std::pair<uint32_t, Kind> EmitFallback(const AbstractExpression *expr);
+
+  uint32_t NewRegister();
+
+  static Kind KindOf(TypeId type);
+
+  static void LoadValue(const Value &value, Register *reg);
+
+  static void RunFallback(const Instruction &instruction, const CompiledPredicate &program, Frame *frame);
+
+  static void RunLoadTerm(const Instruction &instruction, const CompiledPredicate &program, Frame *frame);
+
+  template <typename T>
+  static void RunLoadColumn(const Instruction &instruction, const CompiledPredicate &program, Frame *frame);
+
+  template <ComparisonType OP, Kind KIND>
+  static void RunCompare(const Instruction &instruction, const CompiledPredicate &program, Frame *frame);
+
+  bool Run(const Tuple *left_tuple, const Tuple *right_tuple, const std::vector<Value> *group_bys,
+           const std::vector<Value> *aggregates);
+
+  Mode mode_{Mode::TUPLE};
+  const Schema *schemas_[2]{nullptr, nullptr};
+  std::vector<Instruction> program_;
+  /** Initially holds the constants, every other register is written before it is read */
+  std::vector<Register> registers_;
+  /** The register of the predicate, unused when the program is empty */
+  uint32_t result_{0};
+};
+
+}  // namespace bustub
@@ -0,0 +1,197 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// data_chunk.h
+//
+// Identification: src/include/execution/data_chunk.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#include "catalog/schema.h"
+#include "storage/table/tuple.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * SelectionVector lists the rows of a DataChunk that are still alive, in
+ * increasing order. Filters shrink it instead of moving column data.
+ */
+class SelectionVector {
+ public:
+  /** Selects the rows [0, count) */
+  void SetIdentity(size_t count) {
+    rows_.resize(count);
+    for (size_t i = 0; i < count; i++) {
+      rows_[i] = static_cast<uint32_t>(i);
+    }
+  }
+
+  size_t Size() const { return rows_.size(); }
+
+  bool IsEmpty() const { return rows_.empty(); }
+
+  uint32_t operator[](size_t index) const { return rows_[index]; }
+
+  /** Resizes the selection, the caller fills Data() up to the new size */
+  void Resize(size_t count) { rows_.resize(count); }
+
+  uint32_t *Data() { return rows_.data(); }
+  const uint32_t *Data() const { return rows_.data(); }
+
+ private:
+  std::vector<uint32_t> rows_;
+};
+
+/**
+ * ColumnVector stores one column of a DataChunk as a contiguous array of the
+ * column's C++ type (int8_t for BOOLEAN and TINYINT, int16_t, int32_t,
+ * int64_t, double for DECIMAL, uint64_t for TIMESTAMP), plus a validity bitmap.
+ *
+ * VARCHAR values are (offset, length) entries into a string heap owned by the
+ * vector, read back as views. Rows that were never written are NULL.
+ */
+class ColumnVector {
+ public:
+  /** The entry of a VARCHAR row, the bytes are at heap[offset_, offset_ + length_) */
+  struct VarcharEntry {
+    uint32_t offset_;
+    uint32_t length_;
+  };
+
+  ColumnVector(TypeId type, size_t capacity);
+
+  TypeId GetType() const { return type_; }
+
+  size_t Capacity() const { return capacity_; }
+
+  /** @return the typed array of a fixed length column */
+  template <typename T>
+  T *Data() {
+    return reinterpret_cast<T *>(data_.data());
+  }
+
+  template <typename T>
+  const T *Data() const {
+    return reinterpret_cast<const T *>(data_.data());
+  }
+
+  bool IsValid(size_t row) const { return ((validity_[row / 64] >> (row % 64)) & 1) != 0; }
+
+  void SetValid(size_t row) { validity_[row / 64] |= uint64_t{1} << (row % 64); }
+
+  void SetNull(size_t row) { validity_[row / 64] &= ~(uint64_t{1} << (row % 64)); }
+
+  /** @return the validity bitmap, bit (row % 64) of word (row / 64) is set when the row is not NULL */
+  const uint64_t *Validity() const { return validity_.data(); }
+
+  /** @return true if none of the selected rows is NULL */
+  bool AllValid(const SelectionVector &sel) const;
+
+  /** @return the bytes of a non-NULL VARCHAR row, as stored in a Value (including the terminator) */
+  std::string_view GetVarchar(size_t row) const {
+    const VarcharEntry &entry = Data<VarcharEntry>()[row];
+    return std::string_view(heap_.data() + entry.offset_, entry.length_);
+  }
+
+  void SetVarchar(size_t row, const char *data, uint32_t length);
+
+  /** Makes every row NULL and drops the string heap, keeping the storage */
+  void Reset();
+
+  /**
+   * Decodes a value serialized the way Value::SerializeTo() stores it, which
+   * is how tuples store their columns.
+   */
+  void DecodeFrom(size_t row, const char *storage);
+
+  /** Slow path between rows and columns */
+  Value GetValue(size_t row) const;
+
+  void SetValue(size_t row, const Value &value);
+
+  /** Copies the rows of source listed by sel into the same rows of this vector */
+  void CopyRows(const ColumnVector &source, const SelectionVector &sel);
+
+  /** Copies the rows of source listed by sel into rows [0, sel.Size()) */
+  void Gather(const ColumnVector &source, const SelectionVector &sel);
+
+  /** @return the width of an element of the typed array of a column of the given type */
+  static size_t ElementSize(TypeId type);
+
+ private:
+  TypeId type_;
+  size_t capacity_;
+  std::vector<char> data_;
+  std::vector<uint64_t> validity_;
+  std::vector<char> heap_;
+};
+
+/**
+ * DataChunk is a columnar batch of rows that follow a schema: one typed
+ * ColumnVector per column and a SelectionVector of the rows that are alive.
+ *
+ * Producers Reset() the chunk, write rows [0, Size()) and select all of them;
+ * filters then shrink the selection, and consumers only read selected rows.
+ */
+class DataChunk {
+ public:
+  /** The number of rows a chunk holds unless asked otherwise */
+  static constexpr size_t DEFAULT_CAPACITY = 1024;
+
+  /** Allocates one column per column of schema, the schema must outlive the chunk */
+  void Initialize(const Schema *schema, size_t capacity = DEFAULT_CAPACITY);
+
+  const Schema *GetSchema() const { return schema_; }
+
+  size_t Capacity() const { return capacity_; }
+
+  /** @return the number of rows written, selected or not */
+  size_t Size() const { return size_; }
+
+  bool IsFull() const { return size_ >= capacity_; }
+
+  void SetSize(size_t size) { size_ = size; }
+
+  size_t ColumnCount() const { return columns_.size(); }
+
+  ColumnVector &GetColumn(size_t column_idx) { return columns_[column_idx]; }
+  const ColumnVector &GetColumn(size_t column_idx) const { return columns_[column_idx]; }
+
+  SelectionVector &GetSelection() { return sel_; }
+  const SelectionVector &GetSelection() const { return sel_; }
+
+  /** Empties the chunk, keeping the storage */
+  void Reset();
+
+  /** Appends a tuple that follows the schema of the chunk and selects it */
+  void AppendTuple(const Tuple &tuple);
+
+  /**
+   * Appends the raw data of a tuple that follows the schema of the chunk,
+   * decoding only the listed columns; the other columns of the row are NULL.
+   * The row is not selected.
+   */
+  void AppendRow(const char *tuple_data, const std::vector<uint32_t> &column_ids);
+
+  /** Materializes a row as a tuple of the schema of the chunk */
+  Tuple GetTuple(size_t row) const;
+
+ private:
+  const Schema *schema_{nullptr};
+  size_t capacity_{0};
+  size_t size_{0};
+  std::vector<ColumnVector> columns_;
+  SelectionVector sel_;
+};
+
+}  // namespace bustub
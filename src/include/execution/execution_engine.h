@@ -12,6 +12,7 @@
 
 #pragma once
 
+#include <utility>
 #include <vector>
 
 #include "buffer/buffer_pool_manager.h"
@@ -20,6 +21,7 @@
 #include "execution/executor_context.h"
 #include "execution/executor_factory.h"
 #include "execution/plans/abstract_plan.h"
+#include "execution/tuple_batch.h"
 #include "storage/table/tuple.h"
 #include "execution/executors/seq_scan_executor.h"
 namespace bustub {
@@ -62,16 +64,19 @@ class ExecutionEngine {
                       || (type == PlanType::SeqScan)
                       || (type == PlanType::NestedLoopJoin)
                       || (type == PlanType::HashJoin)
+                      || (type == PlanType::MergeJoin)
+                      || (type == PlanType::Sort)
                       || (type == PlanType::Aggregation)
                       || (type == PlanType::Limit)
                       || (type == PlanType::Distinct);
     try {
-      Tuple tuple;
-      RID rid;
-      // 通过调用 Next 方法不断迭代出下一个 tuple 直到为空
-      while (executor->Next(&tuple, &rid)) {
+      // 通过调用 NextBatch 方法不断取出下一批 tuple 直到为空
+      TupleBatch batch;
+      while (executor->NextBatch(&batch)) {
         if (result_set != nullptr && allow_push) {
-          result_set->push_back(tuple);
+          for (size_t i = 0; i < batch.Size(); i++) {
+            result_set->push_back(std::move(batch.TupleAt(i)));
+          }
         }
       }
     } catch (Exception &e) {
@@ -12,7 +12,11 @@
 
 #pragma once
 
+#include <utility>
+
+#include "execution/data_chunk.h"
 #include "execution/executor_context.h"
+#include "execution/tuple_batch.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
@@ -20,6 +24,11 @@ namespace bustub {
  * The AbstractExecutor implements the Volcano tuple-at-a-time iterator model.
  * This is the base class from which all executors in the BustTub execution
  * engine inherit, and defines the minimal interface that all executors support.
+ *
+ * Executors can also be pulled a batch at a time through NextBatch(), which
+ * pays the virtual call and the per-call setup once per batch instead of once
+ * per tuple. NextChunk() returns a batch in columnar form for operators that
+ * work on whole columns. A consumer uses only one of the three on an executor.
  */
 class AbstractExecutor {
  public:
@@ -46,6 +55,47 @@ class AbstractExecutor {
    */
   virtual bool Next(Tuple *tuple, RID *rid) = 0;
 
+  /**
+   * Yield the next batch of tuples from this executor.
+   *
+   * The default implementation adapts executors that only implement Next()
+   * by calling it until the batch is full.
+   *
+   * @param[out] batch Cleared, then filled with up to batch->Capacity() tuples
+   * @return `true` if at least one tuple was produced, `false` if there are no more tuples
+   */
+  virtual bool NextBatch(TupleBatch *batch) {
+    batch->Clear();
+    Tuple tuple;
+    RID rid;
+    while (!batch->IsFull() && Next(&tuple, &rid)) {
+      batch->Append(std::move(tuple), rid);
+    }
+    return !batch->IsEmpty();
+  }
+
+  /**
+   * Yield the next batch of rows from this executor in columnar form.
+   *
+   * The default implementation adapts executors without a columnar form by
+   * decoding the tuples of a NextBatch() call.
+   *
+   * @param[out] chunk Initialized with GetOutputSchema(); reset, then filled with up to chunk->Capacity() rows,
+   * of which the selected ones are the output
+   * @return `true` if at least one row was produced, `false` if there are no more rows
+   */
+  virtual bool NextChunk(DataChunk *chunk) {
+    chunk->Reset();
+    TupleBatch batch(chunk->Capacity());
+    if (!NextBatch(&batch)) {
+      return false;
+    }
+    for (size_t i = 0; i < batch.Size(); i++) {
+      chunk->AppendTuple(batch.TupleAt(i));
+    }
+    return true;
+  }
+
   /** @return The schema of the tuples that this executor produces */
   virtual const Schema *GetOutputSchema() = 0;
 
@@ -19,6 +19,7 @@
 
 #include "common/util/hash_util.h"
 #include "container/hash/hash_function.h"
+#include "execution/compiled_predicate.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/expressions/abstract_expression.h"
@@ -114,6 +115,35 @@ class SimpleAggregationHashTable {
     CombineAggregateValues(&ht_[agg_key], agg_val);
   }
 
+  /**
+   * Combines the partial aggregates of several input rows into the aggregation result.
+   * @param agg_key the key of the rows
+   * @param partial the sum, min or max over the rows for each aggregate, ignored for counts
+   * @param count the number of rows
+   */
+  void InsertCombinePartial(const AggregateKey &agg_key, const AggregateValue &partial, uint32_t count) {
+    if (ht_.count(agg_key) == 0) {
+      ht_.insert({agg_key, GenerateInitialAggregateValue()});
+    }
+    AggregateValue &result = ht_[agg_key];
+    for (uint32_t i = 0; i < agg_exprs_.size(); i++) {
+      switch (agg_types_[i]) {
+        case AggregationType::CountAggregate:
+          result.aggregates_[i] = result.aggregates_[i].Add(ValueFactory::GetIntegerValue(count));
+          break;
+        case AggregationType::SumAggregate:
+          result.aggregates_[i] = result.aggregates_[i].Add(partial.aggregates_[i]);
+          break;
+        case AggregationType::MinAggregate:
+          result.aggregates_[i] = result.aggregates_[i].Min(partial.aggregates_[i]);
+          break;
+        case AggregationType::MaxAggregate:
+          result.aggregates_[i] = result.aggregates_[i].Max(partial.aggregates_[i]);
+          break;
+      }
+    }
+  }
+
   /** An iterator over the aggregation hash table */
   class Iterator {
    public:
@@ -184,6 +214,13 @@ class AggregationExecutor : public AbstractExecutor {
    */
   bool Next(Tuple *tuple, RID *rid) override;
 
+  /**
+   * Yield the next batch of groups from the aggregation.
+   * @param[out] batch The next groups that satisfy the having clause
+   * @return `true` if a tuple was produced, `false` if there are no more tuples
+   */
+  bool NextBatch(TupleBatch *batch) override;
+
   /** @return The output schema for the aggregation */
   const Schema *GetOutputSchema() override { return plan_->OutputSchema(); };
 
@@ -192,6 +229,9 @@ class AggregationExecutor : public AbstractExecutor {
 
   Tuple GenerateOutputTuple();
 
+  /** Folds the selected rows of a chunk of the child into the aggregation hash table */
+  void AggregateChunk(const DataChunk &chunk);
+
 
 //  AggregateKey MakeKey(Tuple* tuple) {
 //      std::vector<Value> keys;
@@ -237,5 +277,7 @@ class AggregationExecutor : public AbstractExecutor {
    SimpleAggregationHashTable aht_;
   /** Simple aggregation hash table iterator */
    SimpleAggregationHashTable::Iterator aht_iterator_;
+  /** The having clause, compiled in Init() */
+  CompiledPredicate having_;
 };
 }  // namespace bustub
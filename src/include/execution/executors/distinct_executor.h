@@ -13,8 +13,11 @@
 #pragma once
 
 #include <memory>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
+#include "common/util/hash_util.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/plans/distinct_plan.h"
 #include "execution/expressions/column_value_expression.h"
@@ -49,43 +52,25 @@ class DistinctExecutor : public AbstractExecutor {
   /** @return The output schema for the distinct */
   const Schema *GetOutputSchema() override { return plan_->OutputSchema(); };
 
-  Tuple GenerateTuple() {
-      auto out_schema = this->GetOutputSchema();
-      auto columns = out_schema->GetColumns();
-      std::vector<Value> values;
-      for(uint32_t size = 0; size < columns.size(); size++){
-//          auto value = column.GetExpr()->Evaluate(&this->iter_->second, out_schema);
-          auto value = this->iter_->second.GetValue(out_schema, size);
-          values.push_back(value);
-      }
-      auto tuple = Tuple(values, this->GetOutputSchema());
-      return tuple;
-  }
+  /** @return the hash of every column of the tuple, a NULL column hashes to NULL_HASH */
+  hash_t Hash(const Tuple &tuple);
 
-  size_t Hash(Tuple tuple){
-      auto out_schema = this->GetOutputSchema();
-      auto columns = out_schema->GetColumns();
-      size_t hash_val = 0;
-      for(uint32_t size = 0; size < columns.size(); size++){
-//          auto value = column.GetExpr()->Evaluate(&tuple, out_schema);
-          auto value = tuple.GetValue(out_schema, size);
-          hash_val += this->hash_fn_(value.ToString());
-      }
-      return hash_val;
-  }
+  /** @return whether two tuples have equal values in every column, two NULLs being equal */
+  bool Equals(const Tuple &lhs, const Tuple &rhs);
 
  private:
+  /** Hashed in place of a NULL column, so (NULL, x) and (x, NULL) hash differently */
+  static constexpr hash_t NULL_HASH = 0x9e3779b97f4a7c15ULL;
+
   /** The distinct plan node to be executed */
   const DistinctPlanNode *plan_;
   /** The child executor from which tuples are obtained */
   std::unique_ptr<AbstractExecutor> child_executor_;
 
-  // 经过哈希后存放的 Tuple
-  std::unordered_map<size_t, Tuple> ht_;
-  // 哈希算法
-  std::hash<std::string> hash_fn_;
-  // 哈希表的迭代器
-  std::unordered_map<size_t, Tuple>::const_iterator iter_;
-
+  // 去重后的 Tuple, 按第一次出现的顺序输出
+  std::vector<Tuple> tuples_;
+  // 哈希值到 tuples_ 下标的映射, 哈希冲突时再逐列比较
+  std::unordered_map<hash_t, std::vector<size_t>> ht_;
+  size_t pos_{0};
 };
 }  // namespace bustub
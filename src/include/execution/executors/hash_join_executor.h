@@ -12,18 +12,53 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <exception>
+#include <functional>
 #include <memory>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
 #include <utility>
+#include <vector>
 
+#include "common/util/hash_util.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
+#include "execution/expressions/abstract_expression.h"
 #include "execution/plans/hash_join_plan.h"
+#include "storage/page/tmp_tuple_page.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
 
 /**
- * HashJoinExecutor executes a nested-loop JOIN on two tables.
+ * HashJoinExecutor executes an equi-JOIN on two tables with an in-memory hash table.
+ *
+ * The left child is the build side. Its tuples are hashed on the typed value
+ * of the join key and, when they take more than PARTITION_BYTES, radix
+ * partitioned on the top bits of the hash so that the entries and the table of
+ * each partition fit in L2. Every partition has an open-addressing table with
+ * one slot per distinct key; tuples with equal keys are chained behind it.
+ *
+ * The right child is probed a batch at a time. The tuples of a batch are
+ * grouped by partition before they are probed, and the join results are
+ * produced one at a time by Next(), so only the build side and one probe
+ * batch are ever held in memory. NULL keys match nothing.
+ *
+ * When the build side takes more than the memory budget of the plan, the join
+ * becomes a Grace hash join: both inputs are partitioned on the join key into
+ * TmpTuplePages of the buffer pool, and the pairs of partitions are then
+ * joined one at a time as above. A partition that is still over the budget is
+ * partitioned again with another hash function.
+ *
+ * With a parallelism above one, the work is split into morsels run by that
+ * many threads: the calling thread and a pool of workers started on the first
+ * parallel step and kept until the executor is destroyed. The children are still read by the calling thread; the build
+ * tuples are hashed in morsels, scattered into their partitions by chunks
+ * and the table of every partition is built by one thread. The probe side is
+ * read a round of morsels at a time, every thread probes morsels of the round
+ * into its own output buffer and Next() returns the buffers one after another.
  */
 class HashJoinExecutor : public AbstractExecutor {
  public:
@@ -37,11 +72,9 @@ class HashJoinExecutor : public AbstractExecutor {
   HashJoinExecutor(ExecutorContext *exec_ctx, const HashJoinPlanNode *plan,
                    std::unique_ptr<AbstractExecutor> &&left_child, std::unique_ptr<AbstractExecutor> &&right_child);
 
-  ~HashJoinExecutor(){
-    delete this->left_child_.release();
-    delete this->right_child_.release();
-  }
-  
+  /** Stops the worker threads and deletes the pages of the partitions that were not joined */
+  ~HashJoinExecutor() override;
+
   /** Initialize the join */
   void Init() override;
 
@@ -53,35 +86,218 @@ class HashJoinExecutor : public AbstractExecutor {
    */
   bool Next(Tuple *tuple, RID *rid) override;
 
+  /**
+   * Yield the next batch of tuples from the join.
+   * @param[out] batch The next tuples produced by the join
+   * @return `true` if a tuple was produced, `false` if there are no more tuples
+   */
+  bool NextBatch(TupleBatch *batch) override;
+
   /** @return The output schema for the join */
   const Schema *GetOutputSchema() override { return plan_->OutputSchema(); };
 
-  // 一个简单的哈希算法
-  size_t Hash(std::string data){
-    size_t hash_val = this->hash_fn_(data);
-    return hash_val;
-    // for(uint32_t i = 0; i < len; i++) {
-    //   char val = *(data + i);
-    //   hash_val += this->hash_fn_(val);
-    // }
-    // return hash_val;
+ private:
+  /** The build side of one partition should fit in L2 together with its table */
+  static constexpr size_t PARTITION_BYTES = 256 * 1024;
+  /** At most 2^MAX_RADIX_BITS partitions */
+  static constexpr uint32_t MAX_RADIX_BITS = 10;
+  static constexpr uint32_t INVALID_ENTRY = UINT32_MAX;
+  /** How far ahead of the current probe tuple its table slot is prefetched */
+  static constexpr size_t PREFETCH_DISTANCE = 8;
+  /** At most this many partitions are written at once, each keeps a page of the buffer pool pinned */
+  static constexpr size_t MAX_SPILL_FANOUT = 64;
+  /** A spilled partition over the budget is partitioned again, at most this many times */
+  static constexpr uint32_t MAX_SPILL_LEVEL = 4;
+  /** The number of tuples a thread hashes or probes at a time */
+  static constexpr size_t MORSEL_SIZE = 1024;
+  /** A parallel probe round reads this many morsels per thread, so that threads finishing early take more */
+  static constexpr size_t MORSELS_PER_THREAD = 4;
+
+  /** A build tuple, entries with equal keys are chained through next_ */
+  struct Entry {
+    hash_t hash_;
+    uint32_t next_;
+    Value key_;
+    Tuple tuple_;
+  };
+
+  /** A slot of an open-addressing table, holds the first entry of one key */
+  struct Slot {
+    hash_t hash_;
+    uint32_t head_;
+  };
+
+  /** The table of a partition, a power-of-two range of slots_ */
+  struct Partition {
+    size_t slot_begin_;
+    size_t mask_;
+  };
+
+  /** The pages of a spilled input */
+  struct SpillFile {
+    std::vector<page_id_t> pages_;
+    size_t bytes_{0};
+  };
+
+  /** A spilled input being written, its last page stays pinned until it is closed */
+  struct SpillWriter {
+    SpillFile file_;
+    TmpTuplePage *page_{nullptr};
+  };
+
+  /** A pair of spilled partitions, level_ counts how many times their tuples have been partitioned */
+  struct SpillPartition {
+    SpillFile left_;
+    SpillFile right_;
+    uint32_t level_;
+  };
+
+  /** @return the memory a build tuple takes in the hash table, including the heap buffer of a VARCHAR key */
+  static size_t EntryBytes(const Tuple &tuple, const Value &key) {
+    size_t bytes = sizeof(Entry) + 2 * sizeof(Slot) + tuple.GetLength();
+    if (key.GetTypeId() == TypeId::VARCHAR && !key.IsNull()) {
+      bytes += key.GetLength();
+    }
+    return bytes;
   }
 
- private:
-  /** The NestedLoopJoin plan node to be executed. */
+  /** Evaluates a join key, casting it to the type both keys are compared as */
+  Value EvaluateKey(const AbstractExpression *expr, const Tuple &tuple, const Schema *schema) const;
+
+  uint32_t PartitionOf(hash_t hash) const {
+    return radix_bits_ == 0 ? 0 : static_cast<uint32_t>(hash >> (64 - radix_bits_));
+  }
+
+  const Slot *SlotOf(uint32_t partition, hash_t hash) const {
+    const Partition &p = partitions_[partition];
+    return &slots_[p.slot_begin_ + (hash & p.mask_)];
+  }
+
+  /**
+   * Runs task(thread, i) for every i below task_count on the threads of the join, each thread takes the next task
+   * when it is done with one. Exceptions thrown by a task are rethrown once every thread is done.
+   */
+  void ParallelFor(size_t task_count, const std::function<void(size_t, size_t)> &task);
+
+  /** Runs the tasks of the current ParallelFor as the given thread until none is left */
+  void RunTasks(size_t thread);
+
+  /** The loop of a worker thread, waits for every ParallelFor and runs its tasks until the executor is destroyed */
+  void WorkerLoop(size_t thread);
+
+  /** Builds the hash table from the left child, or spills both children if it is over the budget */
+  void Build();
+
+  /** Evaluates and hashes the keys of entries_ and removes the entries with NULL keys */
+  void HashEntries();
+
+  /** Builds the partitions and their tables from entries_ */
+  void BuildTable();
+
+  /** Reads the next probe batch and groups it by partition, @return false when the probe side is exhausted */
+  bool FetchProbeBatch();
+
+  /** @return the number of partitions an input is spilled to */
+  size_t SpillFanout() const;
+
+  size_t SpillPartitionOf(hash_t hash, uint32_t level, size_t fanout) const {
+    return HashUtil::CombineHashes(hash, level) % fanout;
+  }
+
+  /**
+   * Partitions both inputs to disk: the tuples of entries_, those of left_batch from left_pos on and the rest of
+   * both children.
+   */
+  void SpillInputs(const TupleBatch &left_batch, size_t left_pos);
+
+  /** Partitions the tuples of a spilled partition again with the hash function of the next level */
+  void Repartition(SpillPartition *partition);
+
+  /** Queues the pairs of partitions that can produce results and deletes the others */
+  void AddPartitions(std::vector<SpillWriter> *left, std::vector<SpillWriter> *right, uint32_t level);
+
+  /** Builds the table of the next pair of spilled partitions, @return false once every pair has been joined */
+  bool LoadNextPartition();
+
+  void SpillTuple(SpillWriter *writer, const Tuple &tuple, const Value &key);
+
+  /** Unpins the last page of a writer */
+  void CloseSpill(SpillWriter *writer);
+
+  /** Reads the tuples of the last page of a spilled input into batch and deletes the page */
+  void ReadSpillPage(SpillFile *file, TupleBatch *batch);
+
+  void DropSpillFile(SpillFile *file);
+
+  /** Deletes the pages of every partition that is still on disk */
+  void DropSpills();
+
+  /** Reads the next batch of the probe side, from the right child or from the spilled partition */
+  bool ReadProbeBatch(TupleBatch *batch);
+
+  /** @return the first entry whose key equals key, or INVALID_ENTRY */
+  uint32_t Lookup(hash_t hash, const Value &key) const;
+
+  /** Reads a round of probe morsels and probes them in parallel, @return false once the join is exhausted */
+  bool ProbeRound();
+
+  /** Produces the next result of the parallel probe */
+  bool NextParallel(Tuple *tuple);
+
+  /** Advances to the next matching pair, @return false once the join is exhausted */
+  bool NextMatch(const Tuple **left_tuple, const Tuple **right_tuple);
+
+  Tuple MakeOutputTuple(const Tuple *left_tuple, const Tuple *right_tuple) const;
+
+  /** The HashJoin plan node to be executed. */
   const HashJoinPlanNode *plan_;
 
   std::unique_ptr<AbstractExecutor> left_child_;
   std::unique_ptr<AbstractExecutor> right_child_;
 
-  // 用来构建 hash 关系的容器
-  std::unordered_map<size_t, std::vector<Tuple>> ht_{};
-  // 哈希函数
-  std::hash<std::string> hash_fn_;
-  // 用来放置 join 的结果
-  std::vector<std::pair<RID, Tuple>> results;
-  // 调用 Next 方法时需要记录的 id 号
-  size_t tuple_idx;
+  // 两侧的 key 统一转换成该类型后再哈希与比较
+  TypeId key_type_{TypeId::INVALID};
+
+  // 构建侧：按分区连续存放的 entry 与各分区的开放寻址表
+  std::vector<Entry> entries_;
+  std::vector<Slot> slots_;
+  std::vector<Partition> partitions_;
+  uint32_t radix_bits_{0};
+
+  // 探测侧：当前批次、其 key 与哈希，以及按分区分组后的探测顺序
+  TupleBatch probe_batch_;
+  std::vector<Value> probe_keys_;
+  std::vector<hash_t> probe_hashes_;
+  std::vector<uint32_t> probe_order_;
+  size_t probe_pos_{0};
+  // 当前探测 tuple 的下标与其匹配链上的下一个 entry
+  size_t probe_idx_{0};
+  uint32_t chain_{INVALID_ENTRY};
+
+  // 并行模式下一轮的探测 tuple 与各线程的输出缓冲
+  std::vector<Tuple> probe_tuples_;
+  std::vector<std::vector<Tuple>> outputs_;
+  size_t output_thread_{0};
+  size_t output_pos_{0};
+
+  // 工作线程池：每次 ParallelFor 把任务交给已有的线程，round 变化表示有新的任务
+  std::vector<std::thread> workers_;
+  std::mutex pool_latch_;
+  std::condition_variable pool_cv_;
+  std::condition_variable pool_done_cv_;
+  const std::function<void(size_t, size_t)> *pool_task_{nullptr};
+  size_t pool_task_count_{0};
+  std::atomic<size_t> pool_next_{0};
+  uint64_t pool_round_{0};
+  size_t pool_busy_{0};
+  bool pool_stop_{false};
+  std::exception_ptr pool_error_;
+
+  // 构建侧超出内存预算后，两侧输入被分区写入临时页面，之后逐对连接
+  bool spilled_{false};
+  std::vector<SpillPartition> pending_;
+  // 当前分区对中探测侧尚未读取的页面
+  SpillFile probe_file_;
 };
 
 }  // namespace bustub
@@ -12,20 +12,29 @@
 
 #pragma once
 
+#include <memory>
 #include <vector>
 
 #include "common/rid.h"
+#include "execution/compiled_predicate.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/plans/index_scan_plan.h"
+#include "storage/index/index.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
 
 /**
  * IndexScanExecutor executes an index scan over a table.
+ *
+ * A comparison between the first key column and a constant is turned into the
+ * bounds of the scan: an equality on a single column key is a point lookup,
+ * which every index supports, anything else scans a key range of an ordered
+ * index. RIDs are read from the index a batch at a time, and the tuples of a
+ * batch are fetched with one fetch per heap page. Tuples are returned in key
+ * order, and the predicate is still applied to every tuple.
  */
-
 class IndexScanExecutor : public AbstractExecutor {
  public:
   /**
@@ -42,7 +51,36 @@ class IndexScanExecutor : public AbstractExecutor {
   bool Next(Tuple *tuple, RID *rid) override;
 
  private:
+  /** Number of RIDs read from the index and fetched from the table heap at a time */
+  static constexpr size_t BATCH_SIZE = 128;
+
+  /**
+   * Derives the bounds of the scan from the predicate.
+   * @param[out] low values of the leading key columns the scan starts at, empty if unbounded
+   * @param[out] high values of the leading key columns the scan stops after, empty if unbounded
+   * @return true if the predicate is an equality on a single column key
+   */
+  bool DeriveBounds(std::vector<Value> *low, std::vector<Value> *high);
+
+  /** Fetches the tuples of the next batch of RIDs, @return false once the index has no more RIDs */
+  bool FetchBatch();
+
+  /** Builds an output tuple from a tuple of the table */
+  Tuple GenerateTuple(const Tuple &tuple);
+
   /** The index scan plan node to be executed. */
   const IndexScanPlanNode *plan_;
+  IndexInfo *index_info_{nullptr};
+  TableInfo *table_info_{nullptr};
+  CompiledPredicate predicate_;
+
+  // 范围扫描使用游标; 点查询一次就拿到所有 RID, 作为唯一的一批
+  std::unique_ptr<IndexRangeCursor> cursor_;
+  std::vector<RID> point_rids_;
+
+  // 当前批次的元组, 按键的顺序排列
+  std::vector<Tuple> batch_;
+  std::vector<bool> found_;
+  size_t batch_pos_{0};
 };
 }  // namespace bustub
@@ -0,0 +1,137 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// merge_join_executor.h
+//
+// Identification: src/include/execution/executors/merge_join_executor.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "execution/executor_context.h"
+#include "execution/executors/abstract_executor.h"
+#include "execution/expressions/abstract_expression.h"
+#include "execution/external_sort.h"
+#include "execution/plans/merge_join_plan.h"
+#include "storage/page/tmp_tuple_page.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * MergeJoinExecutor executes a sort-merge JOIN on two tables.
+ *
+ * An input the plan does not mark as sorted is sorted on its key with an
+ * ExternalSort, which spills sorted runs to the buffer pool once the input
+ * takes more than its half of the memory budget. The two sorted inputs are
+ * then merged: the right tuples with the key of the current left tuple are
+ * buffered as a group and joined with every left tuple of that key. A group
+ * that takes more than the right half of the budget is written to
+ * TmpTuplePages and read back a page at a time for every left tuple, so no
+ * more than the budget of duplicates is ever held in memory. Tuples with a
+ * NULL key never match.
+ */
+class MergeJoinExecutor : public AbstractExecutor {
+ public:
+  /**
+   * Construct a new MergeJoinExecutor instance.
+   * @param exec_ctx The executor context
+   * @param plan The merge join plan to be executed
+   * @param left_child The child executor that produces tuples for the left side of join
+   * @param right_child The child executor that produces tuples for the right side of join
+   */
+  MergeJoinExecutor(ExecutorContext *exec_ctx, const MergeJoinPlanNode *plan,
+                    std::unique_ptr<AbstractExecutor> &&left_child, std::unique_ptr<AbstractExecutor> &&right_child);
+
+  /** Deletes the pages of a spilled group of duplicates */
+  ~MergeJoinExecutor() override;
+
+  /** Initialize the join, sorting the inputs that are not sorted */
+  void Init() override;
+
+  /**
+   * Yield the next tuple from the join.
+   * @param[out] tuple The next tuple produced by the join
+   * @param[out] rid The next tuple RID produced by the join
+   * @return `true` if a tuple was produced, `false` if there are no more tuples
+   */
+  bool Next(Tuple *tuple, RID *rid) override;
+
+  /**
+   * Yield the next batch of tuples from the join.
+   * @param[out] batch The next tuples produced by the join
+   * @return `true` if a tuple was produced, `false` if there are no more tuples
+   */
+  bool NextBatch(TupleBatch *batch) override;
+
+  /** @return The output schema for the join */
+  const Schema *GetOutputSchema() override { return plan_->OutputSchema(); };
+
+ private:
+  /** One side of the join, read in key order from its child or from the sort of its child */
+  struct Input {
+    AbstractExecutor *child_;
+    const AbstractExpression *key_expr_;
+    const Schema *schema_;
+    std::unique_ptr<ExternalSort> sort_;
+    // 当前的 tuple 与它的键，valid_ 为 false 表示这一侧已经读完
+    Tuple tuple_;
+    Value key_;
+    bool valid_{false};
+  };
+
+  /** Prepares an input, sorting its child unless it is already sorted */
+  void OpenInput(Input *input, AbstractExecutor *child, const AbstractExpression *key_expr, bool sorted);
+
+  /** Moves an input to its next tuple with a non-NULL key, @return false once it is exhausted */
+  bool Advance(Input *input);
+
+  /** @return <0, 0 or >0 as lhs is less than, equal to or greater than rhs */
+  static int CompareKeys(const Value &lhs, const Value &rhs);
+
+  /** Advances to the next matching pair, @return false once the join is exhausted */
+  bool NextMatch(const Tuple **left_tuple, const Tuple **right_tuple);
+
+  /** Adds a right tuple to the group, spilling the group once it is over its half of the budget */
+  void AddToGroup(Tuple tuple);
+
+  /** Writes a tuple of the group to its last page */
+  void SpillGroupTuple(const Tuple &tuple);
+
+  /** Reads the next page of a spilled group into group_ */
+  void LoadGroupPage();
+
+  /** Empties the group and deletes its pages */
+  void DropGroup();
+
+  Tuple MakeOutputTuple(const Tuple *left_tuple, const Tuple *right_tuple) const;
+
+  /** The merge join plan node to be executed */
+  const MergeJoinPlanNode *plan_;
+
+  std::unique_ptr<AbstractExecutor> left_child_;
+  std::unique_ptr<AbstractExecutor> right_child_;
+
+  Input left_;
+  Input right_;
+  // 与当前左侧 tuple 键相等的右侧 tuple，以及下一个要输出的位置
+  // 组落盘后 group_ 只保存正在读的一页，group_page_ 是下一个要读的页
+  bool in_group_{false};
+  std::vector<Tuple> group_;
+  Value group_key_;
+  size_t group_pos_{0};
+  size_t group_bytes_{0};
+  std::vector<page_id_t> group_pages_;
+  size_t group_page_{0};
+  TmpTuplePage *group_writer_{nullptr};
+};
+
+}  // namespace bustub
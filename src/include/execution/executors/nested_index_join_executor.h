@@ -18,6 +18,7 @@
 #include <utility>
 #include <vector>
 
+#include "execution/compiled_predicate.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/expressions/abstract_expression.h"
@@ -29,6 +30,15 @@ namespace bustub {
 
 /**
  * IndexJoinExecutor executes index join operations.
+ *
+ * The outer side is read a batch at a time. The keys of the batch are looked
+ * up in the inner index with one batched probe, and the matching inner tuples
+ * are fetched with one fetch per heap page, so the cost of descending the
+ * index and latching pages is shared by the whole batch instead of paid per
+ * outer tuple. Output keeps the order of the outer tuples.
+ *
+ * The key is taken from the outer operand of an equality predicate between
+ * the outer side and the (single) key column of the inner index.
  */
 class NestIndexJoinExecutor : public AbstractExecutor {
  public:
@@ -48,7 +58,25 @@ class NestIndexJoinExecutor : public AbstractExecutor {
   bool Next(Tuple *tuple, RID *rid) override;
 
  private:
+  /** Number of outer tuples probed at a time */
+  static constexpr size_t BATCH_SIZE = 256;
+
+  /** Finds the expression that computes the inner index key from an outer tuple */
+  const AbstractExpression *FindOuterKey() const;
+
+  /** Joins the next batch of outer tuples, @return false once the outer side is exhausted */
+  bool JoinBatch();
+
   /** The nested index join plan node. */
   const NestedIndexJoinPlanNode *plan_;
+  std::unique_ptr<AbstractExecutor> child_executor_;
+  TableInfo *inner_table_info_{nullptr};
+  IndexInfo *index_info_{nullptr};
+  const AbstractExpression *outer_key_{nullptr};
+  CompiledPredicate predicate_;
+
+  // 当前批次产生的结果
+  std::vector<Tuple> results_;
+  size_t result_pos_{0};
 };
 }  // namespace bustub
@@ -14,7 +14,9 @@
 
 #include <memory>
 #include <utility>
+#include <vector>
 
+#include "execution/compiled_predicate.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/plans/nested_loop_join_plan.h"
@@ -23,7 +25,15 @@
 namespace bustub {
 
 /**
- * NestedLoopJoinExecutor executes a nested-loop JOIN on two tables.
+ * NestedLoopJoinExecutor executes a block nested-loop JOIN on two tables.
+ *
+ * The outer (left) side is buffered a block of GetBlockPages() pages at a
+ * time, and the inner (right) side is scanned once per block a batch at a
+ * time. Every inner tuple is tested against the whole block in one pass,
+ * which leaves the outer tuples it matches in a selection that Next() then
+ * emits, so the output is grouped by block and inner tuple rather than by
+ * outer tuple. Any predicate can be used, this is the join for the
+ * non-equi joins a hash join cannot run.
  */
 class NestedLoopJoinExecutor : public AbstractExecutor {
  public:
@@ -38,11 +48,6 @@ class NestedLoopJoinExecutor : public AbstractExecutor {
                          std::unique_ptr<AbstractExecutor> &&left_executor,
                          std::unique_ptr<AbstractExecutor> &&right_executor);
 
-  ~NestedLoopJoinExecutor(){
-    delete this->left_executor_.release();
-    delete this->right_executor_.release();
-  }
-
   /** Initialize the join */
   void Init() override;
 
@@ -54,6 +59,13 @@ class NestedLoopJoinExecutor : public AbstractExecutor {
    */
   bool Next(Tuple *tuple, RID *rid) override;
 
+  /**
+   * Yield the next batch of tuples from the join.
+   * @param[out] batch The next tuples produced by the join
+   * @return `true` if a tuple was produced, `false` if there are no more tuples
+   */
+  bool NextBatch(TupleBatch *batch) override;
+
   /** @return The output schema for the insert */
   const Schema *GetOutputSchema() override { return plan_->OutputSchema(); };
 
@@ -63,6 +75,27 @@ class NestedLoopJoinExecutor : public AbstractExecutor {
 
   std::unique_ptr<AbstractExecutor> left_executor_;
   std::unique_ptr<AbstractExecutor> right_executor_;
+  CompiledPredicate predicate_;
+
+  /** Buffers the next block of outer tuples and restarts the inner scan, @return false once the outer side is done */
+  bool LoadOuterBlock();
+
+  /** Advances to the next matching pair, @return false once the join is exhausted */
+  bool NextMatch(const Tuple **left_tuple, const Tuple **right_tuple);
+
+  Tuple MakeOutputTuple(const Tuple *left_tuple, const Tuple *right_tuple) const;
+
+  // 外侧当前块中的 tuple，以及读取外侧时剩下的批次
+  std::vector<Tuple> outer_block_;
+  TupleBatch outer_batch_;
+  size_t outer_pos_{0};
+  bool outer_done_{false};
+  // 内侧当前批次与正在处理的内侧 tuple 之后的位置
+  TupleBatch inner_batch_;
+  size_t inner_pos_{0};
+  // 与当前内侧 tuple 匹配的外侧 tuple 下标
+  std::vector<uint32_t> matches_;
+  size_t match_pos_{0};
 };
 
 }  // namespace bustub
@@ -14,6 +14,7 @@
 
 #include <vector>
 
+#include "execution/compiled_predicate.h"
 #include "execution/executor_context.h"
 #include "execution/executors/abstract_executor.h"
 #include "execution/plans/seq_scan_plan.h"
@@ -45,21 +46,34 @@ class SeqScanExecutor : public AbstractExecutor {
    */
   bool Next(Tuple *tuple, RID *rid) override;
 
+  /**
+   * Yield the next batch of tuples from the sequential scan.
+   * @param[out] batch The tuples that satisfy the predicate, up to the capacity of the batch
+   * @return `true` if a tuple was produced, `false` if there are no more tuples
+   */
+  bool NextBatch(TupleBatch *batch) override;
+
+  /**
+   * Yield the next batch of rows from the sequential scan in columnar form.
+   * Tuples are decoded straight from the table pages into column vectors and
+   * the predicate is applied to whole columns.
+   * @param[out] chunk The rows that satisfy the predicate, all selected
+   * @return `true` if a row was produced, `false` if there are no more rows
+   */
+  bool NextChunk(DataChunk *chunk) override;
+
   /** @return The output schema for the sequential scan */
   const Schema *GetOutputSchema() override { return plan_->OutputSchema(); }
 
-  Tuple GenerateTuple(Tuple tuple) {
-    auto schema = this->exec_ctx_->GetCatalog()->GetTable(this->plan_->GetTableOid())->schema_;
-    auto out_schema = this->GetOutputSchema();
-    auto columns = out_schema->GetColumns();
+  Tuple GenerateTuple(const Tuple &tuple) {
+    const Schema *schema = &this->table_info_->schema_;
+    const Schema *out_schema = this->GetOutputSchema();
     std::vector<Value> values;
-    for(auto column: columns){
-//      printf("[Debug] column_idx: %u\n", )
-      auto value = column.GetExpr()->Evaluate(&tuple, &schema);
-      values.push_back(value);
+    values.reserve(out_schema->GetColumnCount());
+    for (const auto &column : out_schema->GetColumns()) {
+      values.push_back(column.GetExpr()->Evaluate(&tuple, schema));
     }
-    auto out_tuple = Tuple(values, this->GetOutputSchema());
-    return out_tuple;
+    return Tuple(values, out_schema);
   }
 
   ~SeqScanExecutor(){
@@ -67,9 +81,26 @@ class SeqScanExecutor : public AbstractExecutor {
   }
 
  private:
+  /**
+   * Reads the next tuple of the table that satisfies the predicate.
+   * @param[out] table_tuple The tuple as stored in the table
+   * @return `false` once the table is exhausted
+   */
+  bool NextTableTuple(Tuple *table_tuple);
+
   /** The sequential scan plan node to be executed */
   const SeqScanPlanNode *plan_;
 
+  // Init 时从 catalog 中取出一次, 之后不再重复查找
+  TableInfo *table_info_{nullptr};
+  // 逐行扫描使用的谓词, Init 时编译
+  CompiledPredicate predicate_;
+
+  // 列式扫描的状态: 当前位置, 以及谓词和输出用到的表中的列
+  RID scan_position_;
+  std::vector<uint32_t> decoded_columns_;
+  DataChunk table_chunk_;
+
   // 迭代器用于去搜索 tuple 并送入 query plan
   TableIterator* table_iterator;
 };
@@ -16,6 +16,7 @@
 #include <vector>
 
 #include "catalog/schema.h"
+#include "execution/data_chunk.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
@@ -58,6 +59,43 @@ class AbstractExpression {
    */
   virtual Value EvaluateAggregate(const std::vector<Value> &group_bys, const std::vector<Value> &aggregates) const = 0;
 
+  /**
+   * Evaluates the expression over the selected rows of a chunk.
+   *
+   * The default evaluates the rows one at a time; expressions that have a
+   * column-at-a-time form override it.
+   *
+   * @param chunk The rows, which follow chunk.GetSchema()
+   * @param[out] result Receives the value of every selected row at the same row, other rows are left untouched
+   */
+  virtual void EvaluateColumn(const DataChunk &chunk, ColumnVector *result) const {
+    const SelectionVector &sel = chunk.GetSelection();
+    for (size_t i = 0; i < sel.Size(); i++) {
+      Tuple tuple = chunk.GetTuple(sel[i]);
+      result->SetValue(sel[i], Evaluate(&tuple, chunk.GetSchema()));
+    }
+  }
+
+  /**
+   * Narrows the selection of a chunk to the rows for which this boolean
+   * expression is true; rows where it is NULL are dropped.
+   * @param chunk The rows, which follow chunk->GetSchema()
+   */
+  virtual void Select(DataChunk *chunk) const {
+    ColumnVector result(TypeId::BOOLEAN, chunk->Capacity());
+    EvaluateColumn(*chunk, &result);
+    SelectionVector &sel = chunk->GetSelection();
+    const int8_t *data = result.Data<int8_t>();
+    size_t kept = 0;
+    for (size_t i = 0; i < sel.Size(); i++) {
+      uint32_t row = sel[i];
+      if (result.IsValid(row) && data[row] != 0) {
+        sel.Data()[kept++] = row;
+      }
+    }
+    sel.Resize(kept);
+  }
+
   /** @return the child_idx'th child of this expression */
   const AbstractExpression *GetChildAt(uint32_t child_idx) const { return children_[child_idx]; }
 
@@ -48,6 +48,10 @@ class ColumnValueExpression : public AbstractExpression {
     BUSTUB_ASSERT(false, "Aggregation should only refer to group-by and aggregates.");
   }
 
+  void EvaluateColumn(const DataChunk &chunk, ColumnVector *result) const override {
+    result->CopyRows(chunk.GetColumn(col_idx_), chunk.GetSelection());
+  }
+
   uint32_t GetTupleIdx() const { return tuple_idx_; }
   uint32_t GetColIdx() const { return col_idx_; }
 
@@ -17,6 +17,9 @@
 
 #include "catalog/schema.h"
 #include "execution/expressions/abstract_expression.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "execution/vector_operations.h"
 #include "storage/table/tuple.h"
 #include "type/value_factory.h"
 
@@ -53,6 +56,54 @@ class ComparisonExpression : public AbstractExpression {
     return ValueFactory::GetBooleanValue(PerformComparison(lhs, rhs));
   }
 
+  /**
+   * Compares whole columns when the operands are columns of the chunk or
+   * constants, otherwise evaluates row by row.
+   */
+  void Select(DataChunk *chunk) const override {
+    auto left_column = dynamic_cast<const ColumnValueExpression *>(GetChildAt(0));
+    auto right_column = dynamic_cast<const ColumnValueExpression *>(GetChildAt(1));
+    auto left_constant = dynamic_cast<const ConstantValueExpression *>(GetChildAt(0));
+    auto right_constant = dynamic_cast<const ConstantValueExpression *>(GetChildAt(1));
+    SelectionVector *sel = &chunk->GetSelection();
+    bool done = false;
+    if (left_column != nullptr && right_constant != nullptr) {
+      done = VectorOperations::SelectCompareConstant(chunk->GetColumn(left_column->GetColIdx()), comp_type_,
+                                                     right_constant->GetValue(), sel);
+    } else if (left_constant != nullptr && right_column != nullptr) {
+      done = VectorOperations::SelectCompareConstant(chunk->GetColumn(right_column->GetColIdx()),
+                                                     VectorOperations::Flip(comp_type_), left_constant->GetValue(),
+                                                     sel);
+    } else if (left_column != nullptr && right_column != nullptr) {
+      done = VectorOperations::SelectCompareColumns(chunk->GetColumn(left_column->GetColIdx()), comp_type_,
+                                                    chunk->GetColumn(right_column->GetColIdx()), sel);
+    }
+    if (!done) {
+      AbstractExpression::Select(chunk);
+    }
+  }
+
+  /** @return the type of comparison this expression performs */
+  ComparisonType GetComparisonType() const { return comp_type_; }
+
+  /** @return (lhs OP rhs) on native values, for the kernels that compare without building Values */
+  template <ComparisonType OP, typename T>
+  static bool Compare(T lhs, T rhs) {
+    if constexpr (OP == ComparisonType::Equal) {
+      return lhs == rhs;
+    } else if constexpr (OP == ComparisonType::NotEqual) {
+      return lhs != rhs;
+    } else if constexpr (OP == ComparisonType::LessThan) {
+      return lhs < rhs;
+    } else if constexpr (OP == ComparisonType::LessThanOrEqual) {
+      return lhs <= rhs;
+    } else if constexpr (OP == ComparisonType::GreaterThan) {
+      return lhs > rhs;
+    } else {
+      return lhs >= rhs;
+    }
+  }
+
  private:
   CmpBool PerformComparison(const Value &lhs, const Value &rhs) const {
     switch (comp_type_) {
@@ -36,6 +36,16 @@ class ConstantValueExpression : public AbstractExpression {
     return val_;
   }
 
+  void EvaluateColumn(const DataChunk &chunk, ColumnVector *result) const override {
+    const SelectionVector &sel = chunk.GetSelection();
+    for (size_t i = 0; i < sel.Size(); i++) {
+      result->SetValue(sel[i], val_);
+    }
+  }
+
+  /** @return the constant */
+  const Value &GetValue() const { return val_; }
+
  private:
   Value val_;
 };
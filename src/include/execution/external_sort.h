@@ -0,0 +1,196 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// external_sort.h
+//
+// Identification: src/include/execution/external_sort.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "catalog/schema.h"
+#include "common/macros.h"
+#include "execution/expressions/abstract_expression.h"
+#include "storage/page/tmp_tuple_page.h"
+#include "storage/table/tuple.h"
+#include "type/value.h"
+
+namespace bustub {
+
+/**
+ * ExternalSort sorts tuples on a list of key expressions within a memory budget.
+ *
+ * Tuples are added with Add() and buffered until they take more than the
+ * budget; the buffer is then sorted and written as a sorted run to
+ * TmpTuplePages of the buffer pool. Finish() sorts what is left, and if runs
+ * were written merges them k-way with a loser tree, in several passes if
+ * there are more runs than the budget has room for pages. Next() returns the
+ * tuples in order.
+ *
+ * When the first key is a BOOLEAN, an integer or a DECIMAL, every tuple
+ * carries it normalized to an unsigned integer that orders like the key. The
+ * buffer is then sorted with an LSD radix sort on these integers, and only
+ * the tuples with equal ones are compared on the other keys; other keys are
+ * sorted with std::stable_sort. Keys are compared with the comparison of
+ * Value, NULL sorts before every other value. The sort is stable.
+ */
+class ExternalSort {
+ public:
+  /** A key to sort on, the expression is evaluated on the sorted tuples */
+  struct SortKey {
+    const AbstractExpression *expr_;
+    bool ascending_;
+  };
+
+  /**
+   * @param bpm the buffer pool the runs are written to
+   * @param schema the schema of the sorted tuples
+   * @param keys the keys to sort on, from the most to the least significant
+   * @param memory_budget the bytes the tuples buffered in memory may take
+   */
+  ExternalSort(BufferPoolManager *bpm, const Schema *schema, std::vector<SortKey> keys, size_t memory_budget);
+
+  /** Deletes the pages of the runs that were not read */
+  ~ExternalSort();
+
+  DISALLOW_COPY_AND_MOVE(ExternalSort);
+
+  /** Adds a tuple, only before Finish() */
+  void Add(const Tuple &tuple);
+
+  /** Ends the input and prepares the sorted output */
+  void Finish();
+
+  /**
+   * Yields the next tuple in order, only after Finish().
+   * @param[out] tuple the next tuple
+   * @return false once every tuple has been returned
+   */
+  bool Next(Tuple *tuple);
+
+  /** @return the number of sorted runs written to disk */
+  size_t RunCount() const { return run_count_; }
+
+ private:
+  /** At most this many runs are merged at once */
+  static constexpr size_t MAX_FAN_IN = 256;
+
+  /** Buffers smaller than this are sorted with std::stable_sort even if the first key is normalized */
+  static constexpr size_t RADIX_SORT_THRESHOLD = 64;
+
+  /** A tuple with its evaluated keys, and the first of them normalized if it can be */
+  struct Entry {
+    uint64_t prefix_;
+    std::vector<Value> keys_;
+    Tuple tuple_;
+  };
+
+  /** The normalized first key of a buffered entry while the buffer is radix sorted */
+  struct SortItem {
+    uint64_t prefix_;
+    uint32_t index_;
+  };
+
+  /** The pages of a sorted run, in the order they were written */
+  using Run = std::vector<page_id_t>;
+
+  /** Reads a run a page at a time, the tuples of the page being read are kept in memory */
+  struct RunReader {
+    /** The position of the run in the merge, equal keys are returned from the earlier run first */
+    size_t index_;
+    Run run_;
+    size_t next_page_{0};
+    std::vector<Entry> page_;
+    size_t pos_{0};
+    bool done_{false};
+  };
+
+  /** Writes a run, its last page stays pinned until it is closed */
+  struct RunWriter {
+    Run run_;
+    TmpTuplePage *page_{nullptr};
+  };
+
+  /** @return whether values of the type can be normalized */
+  static bool IsNormalizable(TypeId type);
+
+  /** @return the key as an unsigned integer that orders like it, NULL being 0 */
+  static uint64_t NormalizeKey(const Value &value);
+
+  /** @return <0, 0 or >0 as the keys of lhs from the key begin on sort before, with or after those of rhs */
+  int CompareKeys(const std::vector<Value> &lhs, const std::vector<Value> &rhs, size_t begin) const;
+
+  /** @return <0, 0 or >0 as lhs sorts before, with or after rhs */
+  int Compare(const Entry &lhs, const Entry &rhs) const;
+
+  bool Less(const Entry &lhs, const Entry &rhs) const { return Compare(lhs, rhs) < 0; }
+
+  /** Evaluates the keys of a tuple into an entry */
+  Entry MakeEntry(Tuple tuple) const;
+
+  /** Sorts the buffered tuples in memory */
+  void SortBuffer();
+
+  /** @return the memory a buffered entry takes, including the heap buffers of its VARCHAR keys */
+  static size_t EntryBytes(const Entry &entry) {
+    size_t bytes = sizeof(Entry) + entry.keys_.size() * sizeof(Value) + entry.tuple_.GetLength();
+    for (const auto &key : entry.keys_) {
+      if (key.GetTypeId() == TypeId::VARCHAR && !key.IsNull()) {
+        bytes += key.GetLength();
+      }
+    }
+    return bytes;
+  }
+
+  /** Sorts the buffered tuples and writes them as a run */
+  void SpillRun();
+
+  void WriteTuple(RunWriter *writer, const Tuple &tuple);
+
+  Run CloseRun(RunWriter *writer);
+
+  /** Moves a reader to its next tuple, @return false once its run is exhausted */
+  bool Advance(RunReader *reader);
+
+  /** Starts merging runs, the merged tuples are read with PopMerged() */
+  void StartMerge(std::vector<Run> runs);
+
+  /** @return whether the current tuple of the reader lhs is merged before that of rhs */
+  bool Beats(size_t lhs, size_t rhs) const;
+
+  /** Moves the smallest tuple of the merge into entry, @return false once every run is exhausted */
+  bool PopMerged(Entry *entry);
+
+  void DropRun(Run *run);
+
+  BufferPoolManager *bpm_;
+  const Schema *schema_;
+  std::vector<SortKey> keys_;
+  size_t memory_budget_;
+  // 第一个键能归一化时，前缀相同的 tuple 才比较其余的键
+  bool prefix_exact_;
+
+  // 内存中缓冲的 tuple，以及已经写到磁盘的有序 run
+  std::vector<Entry> buffer_;
+  size_t buffer_bytes_{0};
+  std::vector<Run> runs_;
+  size_t run_count_{0};
+
+  // 输出阶段：只有内存中的数据时直接按序读取 buffer_，否则对 readers_ 做多路归并
+  bool finished_{false};
+  size_t buffer_pos_{0};
+  std::vector<std::unique_ptr<RunReader>> readers_;
+  // 败者树：tree_[0] 是胜者，其余内部节点保存在该节点比较中落败的 reader
+  std::vector<size_t> tree_;
+};
+
+}  // namespace bustub
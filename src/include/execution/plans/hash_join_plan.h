@@ -24,18 +24,26 @@ namespace bustub {
  */
 class HashJoinPlanNode : public AbstractPlanNode {
  public:
+  /** The memory the build side may take before the join spills both inputs to disk */
+  static constexpr size_t DEFAULT_MEMORY_BUDGET = 256 * 1024 * 1024;
+
   /**
    * Construct a new HashJoinPlanNode instance.
    * @param output_schema The output schema for the JOIN
    * @param children The child plans from which tuples are obtained
    * @param left_key_expression The expression for the left JOIN key
    * @param right_key_expression The expression for the right JOIN key
+   * @param memory_budget The bytes the in-memory hash table may take
+   * @param parallelism The number of threads that build and probe the hash table
    */
   HashJoinPlanNode(const Schema *output_schema, std::vector<const AbstractPlanNode *> &&children,
-                   const AbstractExpression *left_key_expression, const AbstractExpression *right_key_expression)
+                   const AbstractExpression *left_key_expression, const AbstractExpression *right_key_expression,
+                   size_t memory_budget = DEFAULT_MEMORY_BUDGET, size_t parallelism = 1)
       : AbstractPlanNode(output_schema, std::move(children)),
         left_key_expression_{left_key_expression},
-        right_key_expression_{right_key_expression} {}
+        right_key_expression_{right_key_expression},
+        memory_budget_{memory_budget},
+        parallelism_{parallelism} {}
 
   /** @return The type of the plan node */
   PlanType GetType() const override { return PlanType::HashJoin; }
@@ -46,6 +54,12 @@ class HashJoinPlanNode : public AbstractPlanNode {
   /** @return The expression to compute the right join key */
   const AbstractExpression *RightJoinKeyExpression() const { return right_key_expression_; }
 
+  /** @return The bytes the in-memory hash table may take before the join spills to disk */
+  size_t GetMemoryBudget() const { return memory_budget_; }
+
+  /** @return The number of threads that build and probe the hash table */
+  size_t GetParallelism() const { return parallelism_; }
+
   /** @return The left plan node of the hash join */
   const AbstractPlanNode *GetLeftPlan() const {
     BUSTUB_ASSERT(GetChildren().size() == 2, "Hash joins should have exactly two children plans.");
@@ -63,6 +77,10 @@ class HashJoinPlanNode : public AbstractPlanNode {
   const AbstractExpression *left_key_expression_;
   /** The expression to compute the right JOIN key */
   const AbstractExpression *right_key_expression_;
+  /** The bytes the in-memory hash table may take */
+  size_t memory_budget_;
+  /** The number of threads that build and probe the hash table */
+  size_t parallelism_;
 };
 
 }  // namespace bustub
@@ -0,0 +1,92 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// merge_join_plan.h
+//
+// Identification: src/include/execution/plans/merge_join_plan.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "execution/plans/abstract_plan.h"
+
+namespace bustub {
+
+/**
+ * Merge join performs an equi-JOIN by merging its two inputs in the order of their join keys.
+ */
+class MergeJoinPlanNode : public AbstractPlanNode {
+ public:
+  /** The memory the inputs that are not already sorted may take while they are sorted */
+  static constexpr size_t DEFAULT_MEMORY_BUDGET = 256 * 1024 * 1024;
+
+  /**
+   * Construct a new MergeJoinPlanNode instance.
+   * @param output_schema The output schema for the JOIN
+   * @param children The child plans from which tuples are obtained
+   * @param left_key_expression The expression for the left JOIN key
+   * @param right_key_expression The expression for the right JOIN key
+   * @param memory_budget The bytes the sorts of the inputs may take, shared by both inputs
+   * @param left_sorted Whether the left child already produces its tuples in ascending key order
+   * @param right_sorted Whether the right child already produces its tuples in ascending key order
+   */
+  MergeJoinPlanNode(const Schema *output_schema, std::vector<const AbstractPlanNode *> &&children,
+                    const AbstractExpression *left_key_expression, const AbstractExpression *right_key_expression,
+                    size_t memory_budget = DEFAULT_MEMORY_BUDGET, bool left_sorted = false, bool right_sorted = false)
+      : AbstractPlanNode(output_schema, std::move(children)),
+        left_key_expression_{left_key_expression},
+        right_key_expression_{right_key_expression},
+        memory_budget_{memory_budget},
+        left_sorted_{left_sorted},
+        right_sorted_{right_sorted} {}
+
+  /** @return The type of the plan node */
+  PlanType GetType() const override { return PlanType::MergeJoin; }
+
+  /** @return The expression to compute the left join key */
+  const AbstractExpression *LeftJoinKeyExpression() const { return left_key_expression_; }
+
+  /** @return The expression to compute the right join key */
+  const AbstractExpression *RightJoinKeyExpression() const { return right_key_expression_; }
+
+  /** @return The bytes the sorts of the inputs may take before they spill to disk */
+  size_t GetMemoryBudget() const { return memory_budget_; }
+
+  /** @return Whether the left child is already sorted on the join key */
+  bool IsLeftSorted() const { return left_sorted_; }
+
+  /** @return Whether the right child is already sorted on the join key */
+  bool IsRightSorted() const { return right_sorted_; }
+
+  /** @return The left plan node of the merge join */
+  const AbstractPlanNode *GetLeftPlan() const {
+    BUSTUB_ASSERT(GetChildren().size() == 2, "Merge joins should have exactly two children plans.");
+    return GetChildAt(0);
+  }
+
+  /** @return The right plan node of the merge join */
+  const AbstractPlanNode *GetRightPlan() const {
+    BUSTUB_ASSERT(GetChildren().size() == 2, "Merge joins should have exactly two children plans.");
+    return GetChildAt(1);
+  }
+
+ private:
+  /** The expression to compute the left JOIN key */
+  const AbstractExpression *left_key_expression_;
+  /** The expression to compute the right JOIN key */
+  const AbstractExpression *right_key_expression_;
+  /** The bytes the sorts of the inputs may take */
+  size_t memory_budget_;
+  /** Whether the children are already sorted on their keys */
+  bool left_sorted_;
+  bool right_sorted_;
+};
+
+}  // namespace bustub
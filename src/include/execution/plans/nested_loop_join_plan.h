@@ -26,16 +26,21 @@ namespace bustub {
  */
 class NestedLoopJoinPlanNode : public AbstractPlanNode {
  public:
+  /** The number of pages of outer tuples the join buffers for every scan of the inner side */
+  static constexpr size_t DEFAULT_BLOCK_PAGES = 64;
+
   /**
    * Construct a new NestedLoopJoinPlanNode instance.
    * @param output The output format of this nested loop join node
    * @param children Two sequential scan children plans
    * @param predicate The predicate to join with, the tuples are joined
    * if predicate(tuple) = true or predicate = `nullptr`
+   * @param block_pages The number of pages of outer tuples joined with every scan of the inner side, a block always
+   * holds at least one tuple
    */
   NestedLoopJoinPlanNode(const Schema *output_schema, std::vector<const AbstractPlanNode *> &&children,
-                         const AbstractExpression *predicate)
-      : AbstractPlanNode(output_schema, std::move(children)), predicate_(predicate) {}
+                         const AbstractExpression *predicate, size_t block_pages = DEFAULT_BLOCK_PAGES)
+      : AbstractPlanNode(output_schema, std::move(children)), predicate_(predicate), block_pages_(block_pages) {}
 
   /** @return The type of the plan node */
   PlanType GetType() const override { return PlanType::NestedLoopJoin; }
@@ -43,6 +48,9 @@ class NestedLoopJoinPlanNode : public AbstractPlanNode {
   /** @return The predicate to be used in the nested loop join */
   const AbstractExpression *Predicate() const { return predicate_; }
 
+  /** @return The number of pages of outer tuples joined with every scan of the inner side */
+  size_t GetBlockPages() const { return block_pages_; }
+
   /** @return The left plan node of the nested loop join, by convention it should be the smaller table */
   const AbstractPlanNode *GetLeftPlan() const {
     BUSTUB_ASSERT(GetChildren().size() == 2, "Nested loop joins should have exactly two children plans.");
@@ -58,6 +66,8 @@ class NestedLoopJoinPlanNode : public AbstractPlanNode {
  private:
   /** The join predicate */
   const AbstractExpression *predicate_;
+  /** The number of pages of outer tuples joined with every scan of the inner side */
+  size_t block_pages_;
 };
 
 }  // namespace bustub
@@ -0,0 +1,68 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// sort_plan.h
+//
+// Identification: src/include/execution/plans/sort_plan.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "execution/expressions/abstract_expression.h"
+#include "execution/plans/abstract_plan.h"
+
+namespace bustub {
+
+/** The direction of an ORDER BY key */
+enum class OrderByType { ASC, DESC };
+
+/**
+ * Sort orders the tuples produced by its child executor, as ORDER BY does.
+ */
+class SortPlanNode : public AbstractPlanNode {
+ public:
+  /** The memory the sort may take before it spills sorted runs to disk */
+  static constexpr size_t DEFAULT_MEMORY_BUDGET = 256 * 1024 * 1024;
+
+  /**
+   * Construct a new SortPlanNode instance.
+   * @param output_schema The output schema, the same as that of the child
+   * @param child The child plan from which tuples are obtained
+   * @param order_bys The keys to sort on, from the most to the least significant, evaluated on the child's tuples
+   * @param memory_budget The bytes the tuples sorted in memory may take
+   */
+  SortPlanNode(const Schema *output_schema, const AbstractPlanNode *child,
+               std::vector<std::pair<OrderByType, const AbstractExpression *>> order_bys,
+               size_t memory_budget = DEFAULT_MEMORY_BUDGET)
+      : AbstractPlanNode(output_schema, {child}), order_bys_(std::move(order_bys)), memory_budget_(memory_budget) {}
+
+  /** @return The type of the plan node */
+  PlanType GetType() const override { return PlanType::Sort; }
+
+  /** @return The keys to sort on */
+  const std::vector<std::pair<OrderByType, const AbstractExpression *>> &GetOrderBy() const { return order_bys_; }
+
+  /** @return The bytes the tuples sorted in memory may take before the sort spills to disk */
+  size_t GetMemoryBudget() const { return memory_budget_; }
+
+  /** @return The child plan node */
+  const AbstractPlanNode *GetChildPlan() const {
+    BUSTUB_ASSERT(GetChildren().size() == 1, "Sort should have exactly one child plan.");
+    return GetChildAt(0);
+  }
+
+ private:
+  /** The keys to sort on */
+  std::vector<std::pair<OrderByType, const AbstractExpression *>> order_bys_;
+  /** The bytes the tuples sorted in memory may take */
+  size_t memory_budget_;
+};
+
+}  // namespace bustub
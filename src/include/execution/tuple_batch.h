@@ -0,0 +1,80 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// tuple_batch.h
+//
+// Identification: src/include/execution/tuple_batch.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "common/rid.h"
+#include "storage/table/tuple.h"
+
+namespace bustub {
+
+/**
+ * TupleBatch is a bounded array of (tuple, RID) pairs passed between executors
+ * by AbstractExecutor::NextBatch(). The storage of the batch is kept across
+ * Clear() calls, so an executor can refill the same batch without reallocating.
+ */
+class TupleBatch {
+ public:
+  /** The number of tuples a batch holds unless asked otherwise */
+  static constexpr size_t DEFAULT_CAPACITY = 1024;
+
+  /**
+   * Creates an empty batch.
+   * @param capacity the maximum number of tuples the batch holds, at least 1
+   */
+  explicit TupleBatch(size_t capacity = DEFAULT_CAPACITY) : capacity_(capacity > 0 ? capacity : 1) {
+    tuples_.reserve(capacity_);
+    rids_.reserve(capacity_);
+  }
+
+  /** @return the maximum number of tuples in the batch */
+  size_t Capacity() const { return capacity_; }
+
+  /** @return the number of tuples in the batch */
+  size_t Size() const { return tuples_.size(); }
+
+  bool IsEmpty() const { return tuples_.empty(); }
+
+  bool IsFull() const { return tuples_.size() >= capacity_; }
+
+  /** Removes all tuples, keeping the storage */
+  void Clear() {
+    tuples_.clear();
+    rids_.clear();
+  }
+
+  /** Appends a tuple, the caller checks IsFull() first */
+  void Append(const Tuple &tuple, const RID &rid) {
+    tuples_.push_back(tuple);
+    rids_.push_back(rid);
+  }
+
+  void Append(Tuple &&tuple, const RID &rid) {
+    tuples_.push_back(std::move(tuple));
+    rids_.push_back(rid);
+  }
+
+  Tuple &TupleAt(size_t index) { return tuples_[index]; }
+  const Tuple &TupleAt(size_t index) const { return tuples_[index]; }
+
+  const RID &RidAt(size_t index) const { return rids_[index]; }
+
+ private:
+  size_t capacity_;
+  std::vector<Tuple> tuples_;
+  std::vector<RID> rids_;
+};
+
+}  // namespace bustub
@@ -0,0 +1,44 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// vector_operations.h
+//
+// Identification: src/include/execution/vector_operations.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include "execution/data_chunk.h"
+#include "type/value.h"
+
+namespace bustub {
+
+enum class ComparisonType;
+
+/**
+ * VectorOperations holds the column-at-a-time kernels used by expressions
+ * evaluated over a DataChunk. Every kernel works on the typed arrays of the
+ * columns and narrows a selection vector, NULL never satisfies a comparison.
+ *
+ * Kernels return false, leaving their output untouched, for types they do not
+ * handle; the caller then falls back to evaluating Values row by row.
+ */
+class VectorOperations {
+ public:
+  /** Keeps the rows of sel for which (column op constant) holds */
+  static bool SelectCompareConstant(const ColumnVector &column, ComparisonType op, const Value &constant,
+                                    SelectionVector *sel);
+
+  /** Keeps the rows of sel for which (lhs op rhs) holds */
+  static bool SelectCompareColumns(const ColumnVector &lhs, ComparisonType op, const ColumnVector &rhs,
+                                   SelectionVector *sel);
+
+  /** @return the comparison that holds for (rhs op' lhs) exactly when (lhs op rhs) holds */
+  static ComparisonType Flip(ComparisonType op);
+};
+
+}  // namespace bustub
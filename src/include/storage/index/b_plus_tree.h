@@ -10,10 +10,14 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <atomic>
+#include <deque>
 #include <queue>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "common/rwlatch.h"
 #include "concurrency/transaction.h"
 #include "storage/index/index_iterator.h"
 #include "storage/page/b_plus_tree_internal_page.h"
@@ -23,6 +27,19 @@ namespace bustub {
 
 #define BPLUSTREE_TYPE BPlusTree<KeyType, ValueType, KeyComparator>
 
+/**
+ * Latching protocol used by Insert and Remove.
+ *
+ * PESSIMISTIC: write latches are crabbed down from the root, and ancestors are
+ * released as soon as a child is safe (cannot split or merge).
+ * OPTIMISTIC: descend with read latches and write-latch only the leaf. If the
+ * leaf turns out to be unsafe, restart pessimistically.
+ * OLC: writers behave as in OPTIMISTIC. Readers take no latches; they record
+ * each node's version before reading it and restart from the root if it
+ * changed (optimistic lock coupling).
+ */
+enum class BPlusTreeLatchMode { PESSIMISTIC, OPTIMISTIC, OLC };
+
 /**
  * Main class providing the API for the Interactive B+ Tree.
  *
@@ -40,7 +57,9 @@ class BPlusTree {
 
  public:
   explicit BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                     int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE);
+                     int leaf_max_size = LEAF_PAGE_SIZE, int internal_max_size = INTERNAL_PAGE_SIZE,
+                     BPlusTreeLatchMode latch_mode = BPlusTreeLatchMode::OPTIMISTIC,
+                     page_id_t header_page_id = HEADER_PAGE_ID);
 
   // Returns true if this B+ tree has no keys and values.
   bool IsEmpty() const;
@@ -54,6 +73,10 @@ class BPlusTree {
   // return the value associated with a given key
   bool GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction = nullptr);
 
+  // append the values of every key in [low, high] in key order, lock-free in OLC mode
+  void GetRange(const KeyType &low, const KeyType &high, std::vector<ValueType> *result,
+                Transaction *transaction = nullptr);
+
   // index iterator
   INDEXITERATOR_TYPE Begin();
   INDEXITERATOR_TYPE Begin(const KeyType &key);
@@ -71,31 +94,125 @@ class BPlusTree {
     out.close();
   }
 
+  /**
+   * Builds the tree bottom-up from key & value pairs. Leaves are filled left to
+   * right to fill_factor of their capacity, then each internal level is built
+   * above them. Every page is allocated, filled and written exactly once, and at
+   * most one page per level is pinned at a time. Unsorted input is sorted first;
+   * for duplicate keys the first value wins.
+   *
+   * @param entries the key & value pairs to load
+   * @param fill_factor fraction of each node to fill, clamped to [min_size, max_size];
+   *        a level with too few items for that gets fewer, fuller nodes
+   * @return false if the tree is not empty
+   */
+  bool BulkLoad(std::vector<std::pair<KeyType, ValueType>> entries, double fill_factor = 1.0);
+
   // read data from file and insert one by one
   void InsertFromFile(const std::string &file_name, Transaction *transaction = nullptr);
 
+  // read data from file and bulk load it into an empty tree
+  void BulkLoadFromFile(const std::string &file_name, double fill_factor = 1.0);
+
   // read data from file and remove one by one
   void RemoveFromFile(const std::string &file_name, Transaction *transaction = nullptr);
-  // expose for test purpose
+  // expose for test purpose. The returned leaf is pinned but not latched.
   Page *FindLeafPage(const KeyType &key, bool leftMost = false);
 
  private:
+  // Lets an iterator that backs off from a latched leaf re-descend past the last key it finished.
+  typename INDEXITERATOR_TYPE::SeekFunction MakeSeekFunction();
+
+  enum class Operation { FIND, INSERT, DELETE };
+
+  /**
+   * Latches held by one operation: the root id latch and the pages latched
+   * along the path, top-down. Pages merged away are deleted on release.
+   */
+  struct LatchContext {
+    bool root_locked_{false};
+    bool root_exclusive_{false};
+    // page and whether it is write-latched
+    std::deque<std::pair<Page *, bool>> pages_;
+    std::vector<page_id_t> deleted_pages_;
+  };
+
+  // The right-most node of one level during a bulk load
+  struct BulkLoadLevel {
+    Page *page_{nullptr};
+    // entries (leaf level) or children (internal levels) to distribute
+    int64_t items_{0};
+    int64_t nodes_{0};
+    int64_t next_node_{0};
+    // entries or children the open node still takes
+    int64_t remaining_{0};
+  };
+
+  // Opens the next node of a level, first opening a new parent if the current
+  // one is full. The node is linked into its parent under first_key.
+  void OpenBulkLoadNode(std::vector<BulkLoadLevel> *levels, size_t level, const KeyType &first_key);
+
+  Page *FetchTreePage(page_id_t page_id);
+
+  Page *NewTreePage(page_id_t *page_id);
+
+  // key is the key being inserted or removed, a leaf is only safe for an insert if it fits
+  bool IsSafe(BPlusTreePage *node, Operation op, const KeyType &key);
+
+  // Lock-free descent for OLC mode. On success the leaf for key is pinned and its version recorded, page_id is
+  // INVALID_PAGE_ID if the tree is empty. Returns false if a version check failed and nothing is pinned.
+  bool OlcDescend(const KeyType &key, page_id_t *page_id, BPlusTreePage **node, uint32_t *version);
+
+  // Lock-free point lookup for OLC mode. Returns false if the lookup has to be restarted.
+  bool OlcLookup(const KeyType &key, ValueType *value, bool *found);
+
+  // Lock-free range scan for OLC mode, following the leaf chain. Returns false if the scan has to be
+  // restarted, the values it appended are then stale.
+  bool OlcScan(const KeyType &low, const KeyType &high, std::vector<ValueType> *result);
+
+  // Page latches used by Insert and Remove. Releasing a write latch ends the
+  // version section of a page modified under it (see BPlusTreePage::BeginWrite),
+  // so latching a page that ends up unchanged does not restart OLC readers.
+  void LatchPage(Page *page, bool write);
+
+  void UnlatchPage(Page *page, bool write);
+
+  /**
+   * Descends to the leaf for key. FIND read-crabs and keeps only the leaf. INSERT
+   * and DELETE write-crab and keep every ancestor that may still be modified.
+   * With optimistic set, internal pages are read-crabbed and only the leaf is
+   * write-latched. Returns nullptr if the tree is empty.
+   */
+  Page *FindLeafPageLatched(const KeyType &key, Operation op, LatchContext *ctx, bool optimistic = false,
+                            bool left_most = false);
+
+  void ReleaseAncestors(LatchContext *ctx);
+
+  // Releases every latch and pin held by ctx. Write-latched pages are unpinned
+  // with the given dirty flag. Pages in deleted_pages_ are then deleted.
+  void ReleaseAll(LatchContext *ctx, bool dirty);
+
+  // Attempts Insert/Remove with an optimistic descent. Returns false if the
+  // leaf was unsafe and the operation has to be restarted pessimistically.
+  bool OptimisticInsert(const KeyType &key, const ValueType &value, bool *inserted);
+
+  bool OptimisticRemove(const KeyType &key);
+
   void StartNewTree(const KeyType &key, const ValueType &value);
 
-  bool InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction = nullptr);
+  bool InsertIntoLeaf(const KeyType &key, const ValueType &value, LatchContext *ctx);
 
-  void InsertIntoParent(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node,
-                        Transaction *transaction = nullptr);
+  void InsertIntoParent(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node);
 
   template <typename N>
   N *Split(N *node);
 
   template <typename N>
-  bool CoalesceOrRedistribute(N *node, Transaction *transaction = nullptr);
+  bool CoalesceOrRedistribute(N *node, LatchContext *ctx);
 
   template <typename N>
   bool Coalesce(N **neighbor_node, N **node, BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> **parent,
-                int index, Transaction *transaction = nullptr);
+                int index, LatchContext *ctx);
 
   template <typename N>
   void Redistribute(N *neighbor_node, N *node, int index);
@@ -111,11 +228,17 @@ class BPlusTree {
 
   // member variable
   std::string index_name_;
-  page_id_t root_page_id_;
+  // written under root_latch_, read without it by OLC readers
+  std::atomic<page_id_t> root_page_id_;
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
   int leaf_max_size_;
   int internal_max_size_;
+  BPlusTreeLatchMode latch_mode_;
+  // page holding the <index_name, root_page_id> record, INVALID_PAGE_ID to keep none
+  page_id_t header_page_id_;
+  // protects root_page_id_
+  ReaderWriterLatch root_latch_;
 };
 
 }  // namespace bustub
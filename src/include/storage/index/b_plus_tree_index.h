@@ -14,6 +14,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "storage/index/b_plus_tree.h"
@@ -23,10 +24,37 @@ namespace bustub {
 
 #define BPLUSTREE_INDEX_TYPE BPlusTreeIndex<KeyType, ValueType, KeyComparator>
 
+/**
+ * The key type of the tree behind a BPlusTreeIndex on GenericKey<KeySize>: the
+ * normalized index key followed by the RID, big-endian, in RID_SIZE more bytes.
+ */
+template <typename KeyType>
+struct BPlusTreeEntryKey;
+
+template <size_t KeySize>
+struct BPlusTreeEntryKey<GenericKey<KeySize>> {
+  static constexpr size_t RID_SIZE = sizeof(int64_t);
+  using Key = GenericKey<KeySize + RID_SIZE>;
+  using Comparator = GenericComparator<KeySize + RID_SIZE>;
+  static_assert(RID_SIZE == Comparator::SUFFIX_SIZE, "the comparator must read the whole RID as the key suffix");
+};
+
+/**
+ * B+ tree index that allows duplicate keys. The tree itself keeps unique keys,
+ * so every entry is stored under (key, rid): equal keys are ordered by RID,
+ * removing an entry removes only that RID, and a point lookup scans the range
+ * of entries that share the key.
+ */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeIndex : public Index {
+  using EntryKey = typename BPlusTreeEntryKey<KeyType>::Key;
+  using EntryComparator = typename BPlusTreeEntryKey<KeyType>::Comparator;
+  using EntryIterator = IndexIterator<EntryKey, ValueType, EntryComparator>;
+
  public:
-  BPlusTreeIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager);
+  BPlusTreeIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager,
+                 BPlusTreeLatchMode latch_mode = BPlusTreeLatchMode::OPTIMISTIC,
+                 page_id_t header_page_id = HEADER_PAGE_ID);
 
   void InsertEntry(const Tuple &key, RID rid, Transaction *transaction) override;
 
@@ -34,17 +62,41 @@ class BPlusTreeIndex : public Index {
 
   void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
 
-  INDEXITERATOR_TYPE GetBeginIterator();
+  // Probes the keys in key order, so consecutive descents share the pages near the root
+  void ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *results,
+                Transaction *transaction) override;
+
+  bool SupportsRangeScan() const override { return true; }
+
+  void ScanRange(const Tuple *low, const Tuple *high, std::vector<RID> *result, Transaction *transaction) override;
 
-  INDEXITERATOR_TYPE GetBeginIterator(const KeyType &key);
+  std::unique_ptr<IndexRangeCursor> OpenRangeCursor(const std::vector<Value> &low, const std::vector<Value> &high,
+                                                    Transaction *transaction) override;
 
-  INDEXITERATOR_TYPE GetEndIterator();
+  // Builds an empty index bottom-up from (key tuple, rid) pairs, see BPlusTree::BulkLoad
+  bool BulkLoad(const std::vector<std::pair<Tuple, RID>> &entries, double fill_factor = 1.0);
+
+  EntryIterator GetBeginIterator();
+
+  // an iterator at the first entry whose key is not less than key
+  EntryIterator GetBeginIterator(const KeyType &key);
+
+  EntryIterator GetEndIterator();
 
  protected:
+  // Appends the RID to the index key; upper pads with the largest RID suffix instead
+  EntryKey MakeEntryKey(const KeyType &key, RID rid) const;
+  EntryKey MakeBoundKey(const KeyType &key, bool upper) const;
+
+  // Appends the RIDs of every entry whose key equals key
+  void ScanEqual(const KeyType &key, std::vector<RID> *result);
+
   // comparator for key
   KeyComparator comparator_;
+  // comparator for (key, rid) entries in the tree
+  EntryComparator entry_comparator_;
   // container
-  BPlusTree<KeyType, ValueType, KeyComparator> container_;
+  BPlusTree<EntryKey, ValueType, EntryComparator> container_;
 };
 
 }  // namespace bustub
@@ -28,8 +28,11 @@ namespace bustub {
 template <typename KeyType, typename ValueType, typename KeyComparator>
 class ExtendibleHashTableIndex : public Index {
  public:
+  /**
+   * @param pin_pages keep the whole table pinned in the buffer pool (memory-resident mode)
+   */
   ExtendibleHashTableIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager,
-                           const HashFunction<KeyType> &hash_fn);
+                           const HashFunction<KeyType> &hash_fn, bool pin_pages = false);
 
   ~ExtendibleHashTableIndex() override = default;
 
@@ -39,6 +42,15 @@ class ExtendibleHashTableIndex : public Index {
 
   void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) override;
 
+  void ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *results,
+                Transaction *transaction) override;
+
+  /**
+   * Merges sparse buckets and shrinks the directory of the underlying table.
+   * @return the number of bucket pages freed
+   */
+  size_t Compact(Transaction *transaction);
+
  protected:
   // comparator for key
   KeyComparator comparator_;
@@ -12,7 +12,11 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
 
 #include "storage/table/tuple.h"
 #include "type/value.h"
@@ -25,48 +29,73 @@ namespace bustub {
  * This key type uses an fixed length array to hold data for indexing
  * purposes, the actual size of which is specified and instantiated
  * with a template argument.
+ *
+ * Keys are stored normalized, so that the byte order of two keys is the order
+ * of their values and comparing keys is a single memcmp. The columns of the key
+ * schema are encoded one after another:
+ *  - integers and booleans big-endian with the sign bit flipped
+ *  - decimals big-endian with the sign bit flipped, all bits for negative values
+ *  - timestamps big-endian
+ *  - varchars as their bytes with 0x00 escaped as 0x00 0xFF, terminated by 0x00 0x00
+ * The rest of the key is zero. An encoding longer than KeySize is truncated, and
+ * a NULL varchar is encoded as the empty string.
  */
 template <size_t KeySize>
 class GenericKey {
  public:
-  inline void SetFromKey(const Tuple &tuple) {
+  inline void SetFromKey(const Tuple &tuple, const Schema *key_schema) {
     // intialize to 0
     memset(data_, 0, KeySize);
-//    printf("[Debug] ");
-//    for(uint32_t i = 0; i < tuple.GetLength(); i++) {
-//      printf("%c", *(tuple.GetData() + i));
-//    }
-//    printf("\n");
-//    printf("[Debug] KeySize: %lu\n", KeySize);
-    memcpy(data_, tuple.GetData(), tuple.GetLength());
+    size_t offset = 0;
+    for (uint32_t i = 0; i < key_schema->GetColumnCount(); i++) {
+      EncodeValue(tuple.GetValue(key_schema, i), &offset);
+    }
+  }
+
+  /**
+   * Sets the key to the smallest key whose leading columns hold values, or to
+   * the largest such key if upper. Range scans use these keys as bounds.
+   */
+  inline void SetFromPrefix(const std::vector<Value> &values, bool upper) {
+    memset(data_, upper ? 0xFF : 0, KeySize);
+    size_t offset = 0;
+    for (const auto &value : values) {
+      EncodeValue(value, &offset);
+    }
   }
 
   // NOTE: for test purpose only
+  // encodes the key as a BIGINT column, or as an INTEGER column if it does not fit
   inline void SetFromInteger(int64_t key) {
     memset(data_, 0, KeySize);
-    memcpy(data_, &key, sizeof(int64_t));
+    size_t offset = 0;
+    if constexpr (KeySize < sizeof(int64_t)) {
+      EncodeValue(Value(TypeId::INTEGER, static_cast<int32_t>(key)), &offset);
+    } else {
+      EncodeValue(Value(TypeId::BIGINT, key), &offset);
+    }
   }
 
   inline Value ToValue(Schema *schema, uint32_t column_idx) const {
-    const char *data_ptr;
-    const auto &col = schema->GetColumn(column_idx);
-    const TypeId column_type = col.GetType();
-    const bool is_inlined = col.IsInlined();
-    if (is_inlined) {
-      data_ptr = (data_ + col.GetOffset());
-    } else {
-      int32_t offset = *reinterpret_cast<int32_t *>(const_cast<char *>(data_ + col.GetOffset()));
-      data_ptr = (data_ + offset);
+    size_t offset = 0;
+    for (uint32_t i = 0; i < column_idx; i++) {
+      SkipValue(schema->GetColumn(i).GetType(), &offset);
     }
-    return Value::DeserializeFrom(data_ptr, column_type);
+    return DecodeValue(schema->GetColumn(column_idx).GetType(), offset);
   }
 
   // NOTE: for test purpose only
-  // interpret the first 8 bytes as int64_t from data vector
-  inline int64_t ToString() const { return *reinterpret_cast<int64_t *>(const_cast<char *>(data_)); }
+  // interpret the key as the integer SetFromInteger() encodes
+  inline int64_t ToString() const {
+    if constexpr (KeySize < sizeof(int64_t)) {
+      return DecodeValue(TypeId::INTEGER, 0).template GetAs<int32_t>();
+    } else {
+      return DecodeValue(TypeId::BIGINT, 0).template GetAs<int64_t>();
+    }
+  }
 
   // NOTE: for test purpose only
-  // interpret the first 8 bytes as int64_t from data vector
+  // interpret the key as the integer SetFromInteger() encodes
   friend std::ostream &operator<<(std::ostream &os, const GenericKey &key) {
     os << key.ToString();
     return os;
@@ -74,15 +103,133 @@ class GenericKey {
 
   // actual location of data, extends past the end.
   char data_[KeySize];
+
+ private:
+  static constexpr uint64_t SIGN_BIT = static_cast<uint64_t>(1) << 63;
+
+  // 写入 len 个字节, 超出 KeySize 的部分被截断, offset 仍然前进
+  inline void Append(const char *bytes, size_t len, size_t *offset) {
+    if (*offset < KeySize) {
+      memcpy(data_ + *offset, bytes, std::min(len, KeySize - *offset));
+    }
+    *offset += len;
+  }
+
+  inline char ByteAt(size_t offset) const { return offset < KeySize ? data_[offset] : 0; }
+
+  inline void EncodeValue(const Value &value, size_t *offset) {
+    const TypeId type = value.GetTypeId();
+    if (type == TypeId::VARCHAR) {
+      if (!value.IsNull()) {
+        const char *str = value.GetData();
+        const uint32_t len = value.GetLength() - 1;
+        const char escaped[2] = {0, static_cast<char>(0xFF)};
+        for (uint32_t i = 0; i < len; i++) {
+          if (str[i] == 0) {
+            Append(escaped, 2, offset);
+          } else {
+            Append(str + i, 1, offset);
+          }
+        }
+      }
+      const char terminator[2] = {0, 0};
+      Append(terminator, 2, offset);
+      return;
+    }
+    // 定长类型先按原来的小端格式序列化, 再翻转符号位并转成大端
+    char bytes[sizeof(uint64_t)];
+    const size_t size = Type::GetTypeSize(type);
+    value.SerializeTo(bytes);
+    if (type == TypeId::DECIMAL) {
+      uint64_t bits;
+      memcpy(&bits, bytes, sizeof(bits));
+      // -0.0 与 0.0 相等, 编码也必须相同
+      bits = value.GetAs<double>() == 0 ? 0 : bits;
+      bits = (bits & SIGN_BIT) != 0 ? ~bits : bits ^ SIGN_BIT;
+      memcpy(bytes, &bits, sizeof(bits));
+    } else if (type != TypeId::TIMESTAMP) {
+      bytes[size - 1] ^= static_cast<char>(0x80);
+    }
+    char encoded[sizeof(uint64_t)];
+    for (size_t i = 0; i < size; i++) {
+      encoded[i] = bytes[size - 1 - i];
+    }
+    Append(encoded, size, offset);
+  }
+
+  inline Value DecodeValue(TypeId type, size_t offset) const {
+    if (type == TypeId::VARCHAR) {
+      std::string str;
+      while (offset < KeySize) {
+        char c = data_[offset++];
+        if (c != 0) {
+          str.push_back(c);
+          continue;
+        }
+        if (ByteAt(offset) == 0) {
+          break;
+        }
+        // 0x00 0xFF 是转义后的 0x00
+        str.push_back(0);
+        offset++;
+      }
+      return Value(TypeId::VARCHAR, str);
+    }
+    char bytes[sizeof(uint64_t)];
+    const size_t size = Type::GetTypeSize(type);
+    for (size_t i = 0; i < size; i++) {
+      bytes[i] = ByteAt(offset + size - 1 - i);
+    }
+    if (type == TypeId::DECIMAL) {
+      uint64_t bits;
+      memcpy(&bits, bytes, sizeof(bits));
+      bits = (bits & SIGN_BIT) != 0 ? bits ^ SIGN_BIT : ~bits;
+      memcpy(bytes, &bits, sizeof(bits));
+    } else if (type != TypeId::TIMESTAMP) {
+      bytes[size - 1] ^= static_cast<char>(0x80);
+    }
+    return Value::DeserializeFrom(bytes, type);
+  }
+
+  inline void SkipValue(TypeId type, size_t *offset) const {
+    if (type != TypeId::VARCHAR) {
+      *offset += Type::GetTypeSize(type);
+      return;
+    }
+    while (*offset < KeySize) {
+      char c = data_[(*offset)++];
+      if (c == 0) {
+        // 终止符 0x00 0x00 或者转义的 0x00 0xFF, 都是两个字节
+        bool terminated = ByteAt(*offset) == 0;
+        (*offset)++;
+        if (terminated) {
+          return;
+        }
+      }
+    }
+  }
 };
 
 /**
  * Function object returns true if lhs < rhs, used for trees
+ *
+ * Keys are normalized by GenericKey, so they are compared with a single memcmp.
+ * Tree pages use IntegerKey() to search keys made of a single integer column,
+ * optionally followed by a suffix, without calling the comparator at all.
  */
 template <size_t KeySize>
 class GenericComparator {
  public:
   inline int operator()(const GenericKey<KeySize> &lhs, const GenericKey<KeySize> &rhs) const {
+    const int cmp = memcmp(lhs.data_, rhs.data_, KeySize);
+    return static_cast<int>(cmp > 0) - static_cast<int>(cmp < 0);
+  }
+
+  /**
+   * Compares two keys column by column through Value. Agrees with operator() on
+   * every key that is not NULL or truncated, kept as the reference ordering.
+   */
+  inline int CompareColumns(const GenericKey<KeySize> &lhs, const GenericKey<KeySize> &rhs) const {
     uint32_t column_count = key_schema_->GetColumnCount();
 
     for (uint32_t i = 0; i < column_count; i++) {
@@ -100,13 +247,98 @@ class GenericComparator {
     return 0;
   }
 
-  GenericComparator(const GenericComparator &other) : key_schema_{other.key_schema_} {}
+  /**
+   * Returns the shortest key s with lhs < s <= rhs, used as the separator when a
+   * B+ tree leaf splits: rhs cut right after the first byte that differs from
+   * lhs, the rest zero. The separator is only meant to be compared, its columns
+   * need not decode to values of either key.
+   */
+  inline GenericKey<KeySize> ShortestSeparator(const GenericKey<KeySize> &lhs, const GenericKey<KeySize> &rhs) const {
+    size_t common = 0;
+    while (common < KeySize && lhs.data_[common] == rhs.data_[common]) {
+      common++;
+    }
+    GenericKey<KeySize> separator;
+    memset(separator.data_, 0, KeySize);
+    memcpy(separator.data_, rhs.data_, std::min(common + 1, KeySize));
+    return separator;
+  }
+
+  /** The bytes after the columns that also order keys when the comparator has a suffix */
+  static constexpr size_t SUFFIX_SIZE = 8;
+
+  /** A key on the integer fast path decoded to a single unsigned integer that orders like the key */
+  using IntegerKeyType = unsigned __int128;
 
-  // constructor
-  explicit GenericComparator(Schema *key_schema) : key_schema_(key_schema) {}
+  /** @return true if the key is a single integer column and its suffix, so IntegerKey() orders keys */
+  inline bool HasIntegerFastPath() const { return integer_type_ != TypeId::INVALID; }
+
+  /**
+   * @return the key as an unsigned integer, only meaningful if HasIntegerFastPath(): the encoded integer column in
+   *         the high 64 bits and the suffix, if there is one, in the low 64 bits
+   */
+  inline IntegerKeyType IntegerKey(const GenericKey<KeySize> &key) const {
+    uint64_t column;
+    switch (integer_type_) {
+      case TypeId::TINYINT:
+        column = LoadBigEndian<sizeof(int8_t)>(key.data_);
+        break;
+      case TypeId::SMALLINT:
+        column = LoadBigEndian<sizeof(int16_t)>(key.data_);
+        break;
+      case TypeId::INTEGER:
+        column = LoadBigEndian<sizeof(int32_t)>(key.data_);
+        break;
+      default:
+        column = LoadBigEndian<sizeof(int64_t)>(key.data_);
+        break;
+    }
+    uint64_t suffix = has_suffix_ ? LoadBigEndian<SUFFIX_SIZE>(key.data_ + KeySize - SUFFIX_SIZE) : 0;
+    return static_cast<IntegerKeyType>(column) << 64 | suffix;
+  }
+
+  GenericComparator(const GenericComparator &other)
+      : key_schema_{other.key_schema_}, has_suffix_{other.has_suffix_}, integer_type_{other.integer_type_} {}
+
+  /**
+   * @param key_schema the columns encoded at the front of the key
+   * @param has_suffix true if the last SUFFIX_SIZE bytes of the key also order keys, as the RIDs of the (key, rid)
+   *        entries of a BPlusTreeIndex do
+   */
+  explicit GenericComparator(Schema *key_schema, bool has_suffix = false)
+      : key_schema_(key_schema), has_suffix_(has_suffix) {
+    if (key_schema_->GetColumnCount() != 1) {
+      return;
+    }
+    const TypeId type = key_schema_->GetColumn(0).GetType();
+    const bool is_integer = type == TypeId::TINYINT || type == TypeId::SMALLINT || type == TypeId::INTEGER ||
+                            type == TypeId::BIGINT;
+    if (is_integer && Type::GetTypeSize(type) + (has_suffix ? SUFFIX_SIZE : 0) <= KeySize) {
+      integer_type_ = type;
+    }
+  }
 
  private:
+  // 键中的整数是翻转了符号位的大端格式, 当作无符号的大端整数读出即可保持顺序
+  template <size_t Size>
+  static inline uint64_t LoadBigEndian(const char *data) {
+    // 键放不下的整数类型不会启用快速路径
+    if constexpr (Size <= KeySize) {
+      unsigned char bytes[Size];
+      memcpy(bytes, data, Size);
+      uint64_t value = 0;
+      for (size_t i = 0; i < Size; i++) {
+        value = value << 8 | bytes[i];
+      }
+      return value;
+    }
+    return 0;
+  }
+
   Schema *key_schema_;
+  bool has_suffix_{false};
+  // type of the single integer key column, INVALID if the key takes the generic path
+  TypeId integer_type_{TypeId::INVALID};
 };
 
 }  // namespace bustub
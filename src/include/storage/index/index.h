@@ -18,6 +18,7 @@
 #include <vector>
 
 #include "catalog/schema.h"
+#include "common/exception.h"
 #include "storage/table/tuple.h"
 #include "type/value.h"
 
@@ -96,6 +97,30 @@ class IndexMetadata {
   Schema *key_schema_;
 };
 
+/////////////////////////////////////////////////////////////////////
+// IndexRangeCursor class definition
+/////////////////////////////////////////////////////////////////////
+
+/**
+ * class IndexRangeCursor - Streams the RIDs of an index range scan in key order
+ *
+ * The cursor holds no latch or pin between batches, each batch resumes the scan
+ * right after the last key the previous batch returned. The index must not be
+ * dropped while a cursor is open.
+ */
+class IndexRangeCursor {
+ public:
+  virtual ~IndexRangeCursor() = default;
+
+  /**
+   * Appends the RIDs of the next keys in the range.
+   * @param[out] result The collection the RIDs are appended to
+   * @param max_size The largest number of RIDs to append
+   * @return false if the range was already exhausted and nothing was appended
+   */
+  virtual bool NextBatch(std::vector<RID> *result, size_t max_size) = 0;
+};
+
 /////////////////////////////////////////////////////////////////////
 // Index class definition
 /////////////////////////////////////////////////////////////////////
@@ -175,6 +200,76 @@ class Index {
    */
   virtual void ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) = 0;
 
+  /**
+   * Search the index for a batch of keys.
+   *
+   * The default implementation calls ScanKey once per key; indexes that can
+   * share work across keys (e.g. one directory/bucket fetch per batch) override it.
+   *
+   * @param keys The index keys
+   * @param results results->at(i) is populated with the RIDs matching keys[i]
+   * @param transaction The transaction context
+   */
+  virtual void ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *results,
+                        Transaction *transaction) {
+    results->clear();
+    results->resize(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+      ScanKey(keys[i], &(*results)[i], transaction);
+    }
+  }
+
+  ///////////////////////////////////////////////////////////////////
+  // Range Scan
+  ///////////////////////////////////////////////////////////////////
+
+  /** @return true if the index keeps keys ordered and implements ScanRange */
+  virtual bool SupportsRangeScan() const { return false; }
+
+  /**
+   * Locate a search value against the values a key column of type can hold.
+   * Values outside that range cannot be cast to the column type.
+   * @return -1 if value is below the smallest value of type, 1 if above the largest, 0 otherwise
+   */
+  static int CompareToKeyRange(const Value &value, TypeId type) {
+    auto is_numeric = [](TypeId id) {
+      return id == TypeId::TINYINT || id == TypeId::SMALLINT || id == TypeId::INTEGER || id == TypeId::BIGINT ||
+             id == TypeId::DECIMAL;
+    };
+    if (value.IsNull() || !is_numeric(value.GetTypeId()) || !is_numeric(type) || value.GetTypeId() == type) {
+      return 0;
+    }
+    if (value.CompareLessThan(Type::GetMinValue(type)) == CmpBool::CmpTrue) {
+      return -1;
+    }
+    return value.CompareGreaterThan(Type::GetMaxValue(type)) == CmpBool::CmpTrue ? 1 : 0;
+  }
+
+  /**
+   * Collect the RIDs of every key in [low, high], in key order.
+   * @param low The lower bound, or nullptr to start at the smallest key
+   * @param high The upper bound, or nullptr to run to the largest key
+   * @param result The collection of RIDs that is populated with results of the scan
+   * @param transaction The transaction context
+   */
+  virtual void ScanRange(const Tuple *low, const Tuple *high, std::vector<RID> *result, Transaction *transaction) {
+    throw Exception(ExceptionType::NOT_IMPLEMENTED, "Index::ScanRange: index is not ordered");
+  }
+
+  /**
+   * Open a cursor over every key whose leading columns lie in [low, high]. A
+   * bound value outside the range of its column type clamps the bound instead
+   * of failing; the range is empty if no key can lie within it.
+   * @param low Values of the leading key columns the range starts at, empty to start at the smallest key
+   * @param high Values of the leading key columns the range stops after, empty to run to the largest key
+   * @param transaction The transaction context
+   * @return a cursor streaming the RIDs of the range in key order
+   */
+  virtual std::unique_ptr<IndexRangeCursor> OpenRangeCursor(const std::vector<Value> &low,
+                                                            const std::vector<Value> &high, Transaction *transaction) {
+    throw Exception(ExceptionType::NOT_IMPLEMENTED, "Index::OpenRangeCursor: index is not ordered");
+  }
+
  private:
   /** The Index structure owns its metadata */
   std::unique_ptr<IndexMetadata> metadata_;
@@ -13,31 +13,84 @@
  * For range scan of b+ tree
  */
 #pragma once
+#include <functional>
+
+#include "buffer/buffer_pool_manager.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
 
 namespace bustub {
 
 #define INDEXITERATOR_TYPE IndexIterator<KeyType, ValueType, KeyComparator>
 
+/**
+ * Forward iterator over the leaf chain of a B+ tree.
+ *
+ * The iterator holds exactly one leaf pinned and read-latched. When it enters a
+ * leaf, it hints the buffer pool to read the next leaf ahead without pinning
+ * it. It moves on by latch coupling: the next leaf is read-latched before the
+ * current one is released, so merges and redistributions cannot move entries
+ * past it. A writer may hold the next leaf while waiting for the current one
+ * (siblings are latched right to left), so the iterator only tries the latch.
+ * If that fails it releases the current leaf and seeks past its last key from
+ * the root. Do not modify the tree from the thread that owns a live iterator.
+ */
 INDEX_TEMPLATE_ARGUMENTS
 class IndexIterator {
+  using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
+
  public:
-  // you may define your own constructor based on your member variables
+  // Finds the leaf holding the first entry greater than a key. Returns it pinned and
+  // read-latched with the entry's index, or nullptr if the tree is empty.
+  using SeekFunction = std::function<Page *(const KeyType &key, int *index)>;
+
+  // an end iterator
   IndexIterator();
+  /**
+   * @param buffer_pool_manager the tree's buffer pool manager
+   * @param page a leaf that is already pinned and read-latched, ownership moves to the iterator
+   * @param index position of the first entry in the leaf
+   * @param seek used to reposition when the next leaf cannot be latched
+   */
+  IndexIterator(BufferPoolManager *buffer_pool_manager, Page *page, int index, SeekFunction seek);
   ~IndexIterator();
 
+  IndexIterator(IndexIterator &&other) noexcept;
+  IndexIterator &operator=(IndexIterator &&other) noexcept;
+  IndexIterator(const IndexIterator &) = delete;
+  IndexIterator &operator=(const IndexIterator &) = delete;
+
   bool IsEnd();
 
   const MappingType &operator*();
 
   IndexIterator &operator++();
 
-  bool operator==(const IndexIterator &itr) const { throw std::runtime_error("unimplemented"); }
+  bool operator==(const IndexIterator &itr) const {
+    if (page_ == nullptr || itr.page_ == nullptr) {
+      return page_ == itr.page_;
+    }
+    return page_->GetPageId() == itr.page_->GetPageId() && index_ == itr.index_;
+  }
 
-  bool operator!=(const IndexIterator &itr) const { throw std::runtime_error("unimplemented"); }
+  bool operator!=(const IndexIterator &itr) const { return !(*this == itr); }
 
  private:
-  // add your own private member variables here
+  // Moves to the next non-empty leaf while the current position is past the end of the leaf
+  void SkipExhaustedLeaves();
+
+  // Hints the buffer pool to read the current leaf's successor
+  void PrefetchNextLeaf();
+
+  // Unlatches and unpins the current leaf
+  void Release();
+
+  BufferPoolManager *buffer_pool_manager_{nullptr};
+  Page *page_{nullptr};
+  LeafPage *leaf_{nullptr};
+  int index_{0};
+  // the entry last returned by operator*, leaves store keys compressed
+  MappingType item_;
+  SeekFunction seek_;
 };
 
 }  // namespace bustub
@@ -0,0 +1,264 @@
+//===----------------------------------------------------------------------===//
+//
+//                         CMU-DB Project (15-445/645)
+//                         ***DO NO SHARE PUBLICLY***
+//
+// Identification: src/include/page/b_plus_tree_entry_array.h
+//
+// Copyright (c) 2018, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace bustub {
+
+/**
+ * Compressed storage of the key & value entries of a B+ tree page.
+ *
+ * Keys are compressed in two ways. The bytes every key of the page starts with
+ * are stored once as the page prefix (prefix compression), and the trailing
+ * zero bytes no key of the page uses are not stored at all (suffix truncation,
+ * which pays off for the shortened separator keys of internal pages and for
+ * keys shorter than the key type). All entries keep the same width, so they are
+ * still addressed by index:
+ *
+ *  ---------------------------------------------------------------------------------------
+ * | PREFIX (prefix_len) | KEY(1)[prefix_len, key_len) + VALUE(1) | ... | KEY(n) + VALUE(n) |
+ *  ---------------------------------------------------------------------------------------
+ *
+ * This object is the 4 byte descriptor kept in the page header, the page passes
+ * in its entry area. Adding a key that does not match the layout widens the
+ * layout and re-encodes the page, removing keys never narrows it; Rebuild()
+ * computes the tightest layout when entries are moved in bulk.
+ *
+ * Readers using optimistic lock coupling read pages that may be modified
+ * concurrently, so accessors clamp the layout and never address bytes outside
+ * the entry area.
+ */
+template <typename KeyType, typename ValueType>
+class BPlusTreeEntryArray {
+ public:
+  using Entry = std::pair<KeyType, ValueType>;
+
+  static constexpr int KEY_SIZE = sizeof(KeyType);
+  static constexpr int VALUE_SIZE = sizeof(ValueType);
+
+  /** @return the number of entries that fit in data_bytes whatever keys they hold */
+  static constexpr int UncompressedCapacity(int data_bytes) { return data_bytes / (KEY_SIZE + VALUE_SIZE); }
+
+  void Init() {
+    prefix_len_ = 0;
+    key_len_ = 0;
+  }
+
+  int GetPrefixLength() const { return Clamp().first; }
+  int GetKeyLength() const { return Clamp().second; }
+
+  /** @return the number of entries that fit in data_bytes with the current layout */
+  int Capacity(int data_bytes) const {
+    auto [prefix_len, key_len] = Clamp();
+    return CapacityOf(prefix_len, key_len, data_bytes);
+  }
+
+  KeyType KeyAt(const char *data, int index) const {
+    auto [prefix_len, key_len] = Clamp();
+    KeyType key;
+    char *bytes = reinterpret_cast<char *>(&key);
+    memcpy(bytes, data, prefix_len);
+    memcpy(bytes + prefix_len, data + EntryOffset(prefix_len, key_len, index), key_len - prefix_len);
+    memset(bytes + key_len, 0, KEY_SIZE - key_len);
+    return key;
+  }
+
+  ValueType ValueAt(const char *data, int index) const {
+    auto [prefix_len, key_len] = Clamp();
+    ValueType value;
+    memcpy(&value, data + EntryOffset(prefix_len, key_len, index) + key_len - prefix_len, VALUE_SIZE);
+    return value;
+  }
+
+  void SetValueAt(char *data, int index, const ValueType &value) {
+    memcpy(data + EntryOffset(prefix_len_, key_len_, index) + key_len_ - prefix_len_, &value, VALUE_SIZE);
+  }
+
+  /** Overwrites the key at index. The caller checks CanReplaceKey() first. */
+  void SetKeyAt(char *data, int size, int index, const KeyType &key) {
+    Widen(data, size, key);
+    memcpy(data + EntryOffset(prefix_len_, key_len_, index), Bytes(key) + prefix_len_, key_len_ - prefix_len_);
+  }
+
+  /** @return true if one more entry holding key fits in data_bytes */
+  bool HasRoomFor(const char *data, int size, int data_bytes, const KeyType &key) const {
+    auto [prefix_len, key_len] = WidenedLayout(data, size, key);
+    return size + 1 <= CapacityOf(prefix_len, key_len, data_bytes);
+  }
+
+  /** @return true if one of the entries can be given key without overflowing data_bytes */
+  bool CanReplaceKey(const char *data, int size, int data_bytes, const KeyType &key) const {
+    auto [prefix_len, key_len] = WidenedLayout(data, size, key);
+    return size <= CapacityOf(prefix_len, key_len, data_bytes);
+  }
+
+  /** Inserts an entry before index. The caller checks HasRoomFor() first. */
+  void Insert(char *data, int size, int index, const KeyType &key, const ValueType &value) {
+    Widen(data, size, key);
+    int stride = key_len_ - prefix_len_ + VALUE_SIZE;
+    char *slot = data + EntryOffset(prefix_len_, key_len_, index);
+    memmove(slot + stride, slot, static_cast<size_t>(size - index) * stride);
+    memcpy(slot, Bytes(key) + prefix_len_, key_len_ - prefix_len_);
+    memcpy(slot + key_len_ - prefix_len_, &value, VALUE_SIZE);
+  }
+
+  void Remove(char *data, int size, int index) {
+    int stride = key_len_ - prefix_len_ + VALUE_SIZE;
+    char *slot = data + EntryOffset(prefix_len_, key_len_, index);
+    memmove(slot, slot + stride, static_cast<size_t>(size - index - 1) * stride);
+  }
+
+  /** Appends the entries [begin, end) to entries */
+  void Decode(const char *data, int begin, int end, std::vector<Entry> *entries) const {
+    for (int i = begin; i < end; i++) {
+      entries->emplace_back(KeyAt(data, i), ValueAt(data, i));
+    }
+  }
+
+  /** Re-encodes the page with exactly the given entries, using the tightest layout for them */
+  void Rebuild(char *data, const Entry *entries, int count) {
+    auto [prefix_len, key_len] = LayoutOf(entries, count);
+    prefix_len_ = prefix_len;
+    key_len_ = key_len;
+    if (count == 0) {
+      return;
+    }
+    memcpy(data, Bytes(entries[0].first), prefix_len);
+    for (int i = 0; i < count; i++) {
+      char *slot = data + EntryOffset(prefix_len, key_len, i);
+      memcpy(slot, Bytes(entries[i].first) + prefix_len, key_len - prefix_len);
+      memcpy(slot + key_len - prefix_len, &entries[i].second, VALUE_SIZE);
+    }
+  }
+
+  /**
+   * @return true if the entries of two pages plus an optional extra key fit in
+   * one page of data_bytes
+   */
+  static bool FitsTogether(const BPlusTreeEntryArray &left, const char *left_data, int left_size,
+                           const BPlusTreeEntryArray &right, const char *right_data, int right_size,
+                           const KeyType *extra_key, int data_bytes) {
+    int count = left_size + right_size + (extra_key != nullptr ? 1 : 0);
+    if (count <= UncompressedCapacity(data_bytes)) {
+      return true;
+    }
+    // 合并后的前缀是各个非空页面前缀的公共部分, 有效长度取最长者
+    const char *prefix = nullptr;
+    int prefix_len = KEY_SIZE;
+    int key_len = 0;
+    auto merge_layout = [&](const char *bytes, int bytes_prefix_len, int bytes_key_len) {
+      if (prefix == nullptr) {
+        prefix = bytes;
+        prefix_len = bytes_prefix_len;
+      } else {
+        prefix_len = CommonPrefix(prefix, bytes, std::min(prefix_len, bytes_prefix_len));
+      }
+      key_len = std::max(key_len, bytes_key_len);
+    };
+    if (left_size > 0) {
+      merge_layout(left_data, left.prefix_len_, left.key_len_);
+    }
+    if (right_size > 0) {
+      merge_layout(right_data, right.prefix_len_, right.key_len_);
+    }
+    if (extra_key != nullptr) {
+      int extra_len = SignificantLength(*extra_key);
+      merge_layout(Bytes(*extra_key), extra_len, extra_len);
+    }
+    return count <= CapacityOf(std::min(prefix_len, key_len), key_len, data_bytes);
+  }
+
+ private:
+  static const char *Bytes(const KeyType &key) { return reinterpret_cast<const char *>(&key); }
+
+  static int CapacityOf(int prefix_len, int key_len, int data_bytes) {
+    return (data_bytes - prefix_len) / (key_len - prefix_len + VALUE_SIZE);
+  }
+
+  static size_t EntryOffset(int prefix_len, int key_len, int index) {
+    return prefix_len + static_cast<size_t>(index) * (key_len - prefix_len + VALUE_SIZE);
+  }
+
+  static int CommonPrefix(const char *lhs, const char *rhs, int limit) {
+    int length = 0;
+    while (length < limit && lhs[length] == rhs[length]) {
+      length++;
+    }
+    return length;
+  }
+
+  // 最后一个非零字节之后的部分不需要存储
+  static int SignificantLength(const KeyType &key) {
+    const char *bytes = Bytes(key);
+    int length = KEY_SIZE;
+    while (length > 0 && bytes[length - 1] == 0) {
+      length--;
+    }
+    return length;
+  }
+
+  // 并发读者可能读到写了一半的布局, 因此把它限制在合法范围内
+  std::pair<int, int> Clamp() const {
+    int prefix_len = std::min<int>(prefix_len_, KEY_SIZE);
+    int key_len = std::clamp<int>(key_len_, prefix_len, KEY_SIZE);
+    return {prefix_len, key_len};
+  }
+
+  std::pair<int, int> WidenedLayout(const char *data, int size, const KeyType &key) const {
+    int key_len = SignificantLength(key);
+    if (size == 0) {
+      return {key_len, key_len};
+    }
+    return {CommonPrefix(data, Bytes(key), prefix_len_), std::max<int>(key_len_, key_len)};
+  }
+
+  static std::pair<int, int> LayoutOf(const Entry *entries, int count) {
+    if (count == 0) {
+      return {0, 0};
+    }
+    int prefix_len = KEY_SIZE;
+    int key_len = SignificantLength(entries[0].first);
+    for (int i = 1; i < count; i++) {
+      prefix_len = CommonPrefix(Bytes(entries[0].first), Bytes(entries[i].first), prefix_len);
+      key_len = std::max(key_len, SignificantLength(entries[i].first));
+    }
+    return {std::min(prefix_len, key_len), key_len};
+  }
+
+  // 改变布局时先解码所有项, 再按新的布局重新编码
+  void Widen(char *data, int size, const KeyType &key) {
+    auto [prefix_len, key_len] = WidenedLayout(data, size, key);
+    if (prefix_len == prefix_len_ && key_len == key_len_) {
+      return;
+    }
+    std::vector<Entry> entries;
+    entries.reserve(size);
+    Decode(data, 0, size, &entries);
+    prefix_len_ = prefix_len;
+    key_len_ = key_len;
+    memcpy(data, Bytes(key), prefix_len);
+    for (int i = 0; i < size; i++) {
+      char *slot = data + EntryOffset(prefix_len, key_len, i);
+      memcpy(slot, Bytes(entries[i].first) + prefix_len, key_len - prefix_len);
+      memcpy(slot + key_len - prefix_len, &entries[i].second, VALUE_SIZE);
+    }
+  }
+
+  uint16_t prefix_len_;
+  uint16_t key_len_;
+};
+
+}  // namespace bustub
@@ -12,12 +12,14 @@
 
 #include <queue>
 
+#include "storage/page/b_plus_tree_entry_array.h"
 #include "storage/page/b_plus_tree_page.h"
 
 namespace bustub {
 
 #define B_PLUS_TREE_INTERNAL_PAGE_TYPE BPlusTreeInternalPage<KeyType, ValueType, KeyComparator>
-#define INTERNAL_PAGE_HEADER_SIZE 24
+#define INTERNAL_PAGE_HEADER_SIZE 32
+// number of entries that fit in an internal page without compression
 #define INTERNAL_PAGE_SIZE ((PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / (sizeof(MappingType)))
 /**
  * Store n indexed keys and n+1 child pointers (page_id) within internal page.
@@ -27,14 +29,24 @@ namespace bustub {
  * the first key always remains invalid. That is to say, any search/lookup
  * should ignore the first key.
  *
- * Internal page format (keys are stored in increasing order):
- *  --------------------------------------------------------------------------
- * | HEADER | KEY(1)+PAGE_ID(1) | KEY(2)+PAGE_ID(2) | ... | KEY(n)+PAGE_ID(n) |
- *  --------------------------------------------------------------------------
+ * Internal page format (keys are stored in increasing order, prefix compressed
+ * and with their trailing zero bytes truncated, see BPlusTreeEntryArray):
+ *  -----------------------------------------------------------------------------------
+ * | HEADER | PREFIX | KEY(1)+PAGE_ID(1) | KEY(2)+PAGE_ID(2) | ... | KEY(n)+PAGE_ID(n) |
+ *  -----------------------------------------------------------------------------------
+ *
+ * The header is the common B+ tree page header followed by PrefixLen (2) and
+ * KeyLen (2), 32 bytes in total. Separators pushed up from the leaves are
+ * shortened by the tree, so the truncation is what raises the fanout here.
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeInternalPage : public BPlusTreePage {
  public:
+  // Largest max size of an internal page. Splitting a page that holds at most
+  // this many entries leaves both halves room for one more key, whatever its layout.
+  static constexpr int MAX_ENTRIES =
+      2 * BPlusTreeEntryArray<KeyType, ValueType>::UncompressedCapacity(PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) - 2;
+
   // must call initialize method after "create" a new node
   void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int max_size = INTERNAL_PAGE_SIZE);
 
@@ -46,6 +58,8 @@ class BPlusTreeInternalPage : public BPlusTreePage {
   ValueType Lookup(const KeyType &key, const KeyComparator &comparator) const;
   void PopulateNewRoot(const ValueType &old_value, const KeyType &new_key, const ValueType &new_value);
   int InsertNodeAfter(const ValueType &old_value, const KeyType &new_key, const ValueType &new_value);
+  // append a child at the end without adopting it, used by bulk loading
+  void AppendNode(const KeyType &new_key, const ValueType &new_value);
   void Remove(int index);
   ValueType RemoveAndReturnOnlyChild();
 
@@ -57,10 +71,24 @@ class BPlusTreeInternalPage : public BPlusTreePage {
   void MoveLastToFrontOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
                          BufferPoolManager *buffer_pool_manager);
 
+  // compression aware sizing
+  bool HasRoomFor(const KeyType &key) const;
+  // true if one more entry fits whatever its key, so a child split cannot split this page
+  bool HasRoomForAnyKey() const;
+  bool CanReplaceKey(const KeyType &key) const;
+  bool CanMergeWith(const BPlusTreeInternalPage *other, const KeyType &middle_key) const;
+  int GetMinSize() const;
+
  private:
-  void CopyNFrom(MappingType *items, int size, BufferPoolManager *buffer_pool_manager);
+  static constexpr int DATA_BYTES = PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE;
+
+  ValueType IntegerLookup(const KeyType &key, const KeyComparator &comparator) const;
+  // entries a reader may look at, bounded even if the page is being modified concurrently
+  int ReadableSize() const;
+  void CopyNFrom(const MappingType *items, int size, BufferPoolManager *buffer_pool_manager);
   void CopyLastFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager);
   void CopyFirstFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager);
-  MappingType array_[0];
+  BPlusTreeEntryArray<KeyType, ValueType> entries_;
+  char data_[0];
 };
 }  // namespace bustub
@@ -13,12 +13,14 @@
 #include <utility>
 #include <vector>
 
+#include "storage/page/b_plus_tree_entry_array.h"
 #include "storage/page/b_plus_tree_page.h"
 
 namespace bustub {
 
 #define B_PLUS_TREE_LEAF_PAGE_TYPE BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>
-#define LEAF_PAGE_HEADER_SIZE 28
+#define LEAF_PAGE_HEADER_SIZE 36
+// number of entries that fit in a leaf page without compression
 #define LEAF_PAGE_SIZE ((PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / sizeof(MappingType))
 
 /**
@@ -26,22 +28,32 @@ namespace bustub {
  * see include/common/rid.h for detailed implementation) together within leaf
  * page. Only support unique key.
  *
- * Leaf page format (keys are stored in order):
+ * Leaf page format (keys are stored in order, prefix compressed, see
+ * BPlusTreeEntryArray):
  *  ----------------------------------------------------------------------
- * | HEADER | KEY(1) + RID(1) | KEY(2) + RID(2) | ... | KEY(n) + RID(n)
+ * | HEADER | PREFIX | KEY(1) + RID(1) | KEY(2) + RID(2) | ... | KEY(n) + RID(n)
  *  ----------------------------------------------------------------------
  *
- *  Header format (size in byte, 28 bytes in total):
+ *  Header format (size in byte, 36 bytes in total):
  *  ---------------------------------------------------------------------
  * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) |
  *  ---------------------------------------------------------------------
- *  -----------------------------------------------
- * | ParentPageId (4) | PageId (4) | NextPageId (4)
- *  -----------------------------------------------
+ *  ------------------------------------------------------------------------------------------
+ * | ParentPageId (4) | PageId (4) | Version (4) | NextPageId (4) | PrefixLen (2) | KeyLen (2)
+ *  ------------------------------------------------------------------------------------------
+ *
+ * How many entries fit depends on how well the keys compress. Max size only
+ * bounds the entry count; a page is also full once the next key does not fit,
+ * see HasRoomFor().
  */
 INDEX_TEMPLATE_ARGUMENTS
 class BPlusTreeLeafPage : public BPlusTreePage {
  public:
+  // Largest max size of a leaf page. Splitting a page that holds at most this
+  // many entries leaves both halves room for one more key, whatever its layout.
+  static constexpr int MAX_ENTRIES =
+      2 * BPlusTreeEntryArray<KeyType, ValueType>::UncompressedCapacity(PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) - 2;
+
   // After creating a new leaf page from buffer pool, must call initialize
   // method to set default values
   void Init(page_id_t page_id, page_id_t parent_id = INVALID_PAGE_ID, int max_size = LEAF_PAGE_SIZE);
@@ -50,7 +62,16 @@ class BPlusTreeLeafPage : public BPlusTreePage {
   void SetNextPageId(page_id_t next_page_id);
   KeyType KeyAt(int index) const;
   int KeyIndex(const KeyType &key, const KeyComparator &comparator) const;
-  const MappingType &GetItem(int index);
+  MappingType GetItem(int index) const;
+  // entries a reader may look at, bounded even if the page is being modified concurrently
+  int ReadableSize() const;
+
+  // compression aware sizing
+  bool HasRoomFor(const KeyType &key) const;
+  bool CanMergeWith(const BPlusTreeLeafPage *other) const;
+  int GetMinSize() const;
+  int GetPrefixLength() const;
+  int GetKeyLength() const;
 
   // insert and delete methods
   int Insert(const KeyType &key, const ValueType &value, const KeyComparator &comparator);
@@ -64,10 +85,14 @@ class BPlusTreeLeafPage : public BPlusTreePage {
   void MoveLastToFrontOf(BPlusTreeLeafPage *recipient);
 
  private:
-  void CopyNFrom(MappingType *items, int size);
+  static constexpr int DATA_BYTES = PAGE_SIZE - LEAF_PAGE_HEADER_SIZE;
+
+  int IntegerLowerBound(const KeyType &key, const KeyComparator &comparator) const;
+  void CopyNFrom(const MappingType *items, int size);
   void CopyLastFrom(const MappingType &item);
   void CopyFirstFrom(const MappingType &item);
   page_id_t next_page_id_;
-  MappingType array_[0];
+  BPlusTreeEntryArray<KeyType, ValueType> entries_;
+  char data_[0];
 };
 }  // namespace bustub
@@ -10,6 +10,7 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <atomic>
 #include <cassert>
 #include <climits>
 #include <cstdlib>
@@ -33,12 +34,18 @@ enum class IndexPageType { INVALID_INDEX_PAGE = 0, LEAF_PAGE, INTERNAL_PAGE };
  * It actually serves as a header part for each B+ tree page and
  * contains information shared by both leaf page and internal page.
  *
- * Header format (size in byte, 24 bytes in total):
+ * Header format (size in byte, 28 bytes in total):
  * ----------------------------------------------------------------------------
  * | PageType (4) | LSN (4) | CurrentSize (4) | MaxSize (4) |
  * ----------------------------------------------------------------------------
- * | ParentPageId (4) | PageId(4) |
+ * | ParentPageId (4) | PageId(4) | Version (4) |
  * ----------------------------------------------------------------------------
+ *
+ * Version is used for optimistic lock coupling. A writer holding the write
+ * latch makes it odd right before its first change to the page and even again
+ * when it releases the latch, so only sections that modify the page advance
+ * it. A reader that saw the same even version before and after reading the
+ * page knows the page did not change in between.
  */
 class BPlusTreePage {
  public:
@@ -62,14 +69,24 @@ class BPlusTreePage {
 
   void SetLSN(lsn_t lsn = INVALID_LSN);
 
+  uint32_t GetVersion() const;
+  static bool IsVersionLocked(uint32_t version) { return (version & 1) != 0; }
+  // true if the page is unchanged since GetVersion() returned version
+  bool ValidateVersion(uint32_t version) const;
+  // Called under the write latch before each change, only the first one of a latched section bumps the version
+  void BeginWrite();
+  // Called when the write latch is released, ends the section if BeginWrite() was called
+  void EndWrite();
+
  private:
   // member variable, attributes that both internal and leaf page share
-  IndexPageType page_type_ __attribute__((__unused__));
-  lsn_t lsn_ __attribute__((__unused__));
-  int size_ __attribute__((__unused__));
-  int max_size_ __attribute__((__unused__));
-  page_id_t parent_page_id_ __attribute__((__unused__));
-  page_id_t page_id_ __attribute__((__unused__));
+  IndexPageType page_type_;
+  lsn_t lsn_;
+  int size_;
+  int max_size_;
+  page_id_t parent_page_id_;
+  page_id_t page_id_;
+  std::atomic<uint32_t> version_;
 };
 
 }  // namespace bustub
@@ -122,6 +122,19 @@ class TablePage : public Page {
    */
   bool GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, LockManager *lock_manager);
 
+  /**
+   * Read a tuple in place, without copying it out of the page.
+   * @param rid rid of the tuple to read
+   * @param[out] data the serialized tuple, valid while the page stays latched and pinned
+   * @param txn transaction performing the read
+   * @param lock_manager the lock manager
+   * @return true if the read is successful (i.e. the tuple exists)
+   */
+  bool GetTupleData(const RID &rid, const char **data, Transaction *txn, LockManager *lock_manager);
+
+  /** @return the number of slots in this page, including the slots of deleted tuples */
+  uint32_t GetSlotCount() { return GetTupleCount(); }
+
   /** @return the rid of the first tuple in this page */
 
   /**
@@ -1,15 +1,13 @@
 #pragma once
 
+#include <cstring>
+
 #include "storage/page/page.h"
 #include "storage/table/tmp_tuple.h"
 #include "storage/table/tuple.h"
 
 namespace bustub {
 
-// To pass the test cases for this class, you must follow the existing TmpTuplePage format and implement the
-// existing functions exactly as they are! It may be helpful to look at TablePage.
-// Remember that this task is optional, you get full credit if you finish the next task.
-
 /**
  * TmpTuplePage format:
  *
@@ -17,17 +15,68 @@ namespace bustub {
  * | PageId (4) | LSN (4) | FreeSpace (4) | (free space) | TupleSize2 | TupleData2 | TupleSize1 | TupleData1 |
  *
  * We choose this format because DeserializeExpression expects to read Size followed by Data.
+ *
+ * FreeSpace is the offset of the most recently inserted tuple; tuples grow from the end of the page towards the
+ * header, so the tuples of a page are read from FreeSpace up to the end of the page. A TmpTuplePage holds tuples
+ * spilled by an operator for as long as it runs; it is never logged.
  */
 class TmpTuplePage : public Page {
  public:
-  void Init(page_id_t page_id, uint32_t page_size) {}
+  /**
+   * Initialize the TmpTuplePage header.
+   * @param page_id the page ID of this page
+   * @param page_size the size of this page, every tuple is stored below it
+   */
+  void Init(page_id_t page_id, uint32_t page_size) {
+    memcpy(GetData(), &page_id, sizeof(page_id_t));
+    SetLSN(INVALID_LSN);
+    SetFreeSpacePointer(page_size);
+  }
 
-  page_id_t GetTablePageId() { return INVALID_PAGE_ID; }
+  /** @return the page ID of this page */
+  page_id_t GetTablePageId() { return *reinterpret_cast<page_id_t *>(GetData()); }
 
-  bool Insert(const Tuple &tuple, TmpTuple *out) { return false; }
+  /** @return the offset of the most recently inserted tuple, the end of the page if there is none */
+  uint32_t GetFreeSpacePointer() { return *reinterpret_cast<uint32_t *>(GetData() + OFFSET_FREE_SPACE); }
+
+  /**
+   * Insert a tuple into the page.
+   * @param tuple tuple to insert
+   * @param[out] out the page and offset of the inserted tuple
+   * @return true if the insert is successful, false if the page has no room for the tuple
+   */
+  bool Insert(const Tuple &tuple, TmpTuple *out) {
+    uint32_t free_space = GetFreeSpacePointer();
+    uint32_t size = sizeof(uint32_t) + tuple.GetLength();
+    if (free_space < SIZE_HEADER + size) {
+      return false;
+    }
+    free_space -= size;
+    tuple.SerializeTo(GetData() + free_space);
+    SetFreeSpacePointer(free_space);
+    *out = TmpTuple(GetTablePageId(), free_space);
+    return true;
+  }
+
+  /**
+   * Read the tuple stored at an offset of this page.
+   * @param offset the offset of the tuple, as returned by Insert()
+   * @param[out] tuple the tuple, a deep copy of the stored data
+   * @return the offset of the tuple inserted before it
+   */
+  uint32_t Get(uint32_t offset, Tuple *tuple) {
+    tuple->DeserializeFrom(GetData() + offset);
+    return offset + sizeof(uint32_t) + *reinterpret_cast<uint32_t *>(GetData() + offset);
+  }
 
  private:
+  void SetFreeSpacePointer(uint32_t free_space) {
+    memcpy(GetData() + OFFSET_FREE_SPACE, &free_space, sizeof(uint32_t));
+  }
+
   static_assert(sizeof(page_id_t) == 4);
+  static constexpr size_t OFFSET_FREE_SPACE = 8;
+  static constexpr size_t SIZE_HEADER = 12;
 };
 
 }  // namespace bustub
@@ -12,6 +12,9 @@
 
 #pragma once
 
+#include <functional>
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
 #include "recovery/log_manager.h"
 #include "storage/page/table_page.h"
@@ -99,6 +102,28 @@ class TableHeap {
    */
   bool GetTuple(const RID &rid, Tuple *tuple, Transaction *txn);
 
+  /**
+   * Read a batch of tuples from the table, fetching every page of the batch once.
+   * @param rids rids of the tuples to read, in any order
+   * @param[out] tuples tuples->at(i) receives the tuple at rids[i]
+   * @param[out] found found->at(i) is true if the tuple at rids[i] exists
+   * @param txn transaction performing the read
+   */
+  void GetTuples(const std::vector<RID> &rids, std::vector<Tuple> *tuples, std::vector<bool> *found,
+                 Transaction *txn);
+
+  /**
+   * Visit the tuples of the table in place, one page at a time, starting at *position.
+   * @param[in,out] position the rid to start at (slots of deleted tuples are skipped), set to where
+   * the next call should continue; its page id is INVALID_PAGE_ID once the table is exhausted
+   * @param max_count the maximum number of tuples to visit
+   * @param visit called with the serialized tuple, which is valid only during the call, and its rid
+   * @param txn transaction performing the read
+   * @return the number of tuples visited
+   */
+  size_t ScanTuples(RID *position, size_t max_count, const std::function<void(const char *, const RID &)> &visit,
+                    Transaction *txn);
+
   /** @return the begin iterator of this table */
   TableIterator Begin(Transaction *txn);
 
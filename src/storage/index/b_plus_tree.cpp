@@ -9,7 +9,11 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <string>
+#include <thread>  // NOLINT
+#include <type_traits>
+#include <utility>
 
 #include "common/exception.h"
 #include "common/rid.h"
@@ -19,19 +23,23 @@
 namespace bustub {
 INDEX_TEMPLATE_ARGUMENTS
 BPLUSTREE_TYPE::BPlusTree(std::string name, BufferPoolManager *buffer_pool_manager, const KeyComparator &comparator,
-                          int leaf_max_size, int internal_max_size)
+                          int leaf_max_size, int internal_max_size, BPlusTreeLatchMode latch_mode,
+                          page_id_t header_page_id)
     : index_name_(std::move(name)),
       root_page_id_(INVALID_PAGE_ID),
       buffer_pool_manager_(buffer_pool_manager),
       comparator_(comparator),
-      leaf_max_size_(leaf_max_size),
-      internal_max_size_(internal_max_size) {}
+      // 页面放不下新键时会提前分裂, max_size 只需要保证分裂后的两半都还能放下任意一个键
+      leaf_max_size_(std::min<int>(leaf_max_size, LeafPage::MAX_ENTRIES)),
+      internal_max_size_(std::min<int>(internal_max_size, InternalPage::MAX_ENTRIES)),
+      latch_mode_(latch_mode),
+      header_page_id_(header_page_id) {}
 
 /*
  * Helper function to decide whether current b+tree is empty
  */
 INDEX_TEMPLATE_ARGUMENTS
-bool BPLUSTREE_TYPE::IsEmpty() const { return true; }
+bool BPLUSTREE_TYPE::IsEmpty() const { return root_page_id_ == INVALID_PAGE_ID; }
 /*****************************************************************************
  * SEARCH
  *****************************************************************************/
@@ -42,7 +50,158 @@ bool BPLUSTREE_TYPE::IsEmpty() const { return true; }
  */
 INDEX_TEMPLATE_ARGUMENTS
 bool BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result, Transaction *transaction) {
-  return false;
+  if (latch_mode_ == BPlusTreeLatchMode::OLC) {
+    ValueType value;
+    bool found;
+    while (!OlcLookup(key, &value, &found)) {
+      std::this_thread::yield();
+    }
+    if (found) {
+      result->push_back(value);
+    }
+    return found;
+  }
+  LatchContext ctx;
+  Page *page = FindLeafPageLatched(key, Operation::FIND, &ctx);
+  if (page == nullptr) {
+    return false;
+  }
+  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  ValueType value;
+  bool found = leaf->Lookup(key, &value, comparator_);
+  if (found) {
+    result->push_back(value);
+  }
+  ReleaseAll(&ctx, false);
+  return found;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::OlcDescend(const KeyType &key, page_id_t *page_id, BPlusTreePage **node, uint32_t *version) {
+  *page_id = root_page_id_;
+  if (*page_id == INVALID_PAGE_ID) {
+    return true;
+  }
+  *node = reinterpret_cast<BPlusTreePage *>(FetchTreePage(*page_id)->GetData());
+  *version = (*node)->GetVersion();
+  // 读到版本号之后再确认它仍然是根节点, 之后根节点的分裂或合并都会修改它的版本号
+  if (BPlusTreePage::IsVersionLocked(*version) || root_page_id_ != *page_id) {
+    buffer_pool_manager_->UnpinPage(*page_id, false);
+    return false;
+  }
+
+  while (!(*node)->IsLeafPage()) {
+    page_id_t child_id = reinterpret_cast<InternalPage *>(*node)->Lookup(key, comparator_);
+    // 先验证读到的孩子指针有效, 再去获取孩子
+    if (!(*node)->ValidateVersion(*version)) {
+      buffer_pool_manager_->UnpinPage(*page_id, false);
+      return false;
+    }
+    auto child = reinterpret_cast<BPlusTreePage *>(FetchTreePage(child_id)->GetData());
+    uint32_t child_version = child->GetVersion();
+    // 父节点没有变化说明读取孩子版本号时孩子仍然挂在树上
+    bool valid = !BPlusTreePage::IsVersionLocked(child_version) && (*node)->ValidateVersion(*version);
+    buffer_pool_manager_->UnpinPage(*page_id, false);
+    if (!valid) {
+      buffer_pool_manager_->UnpinPage(child_id, false);
+      return false;
+    }
+    *page_id = child_id;
+    *node = child;
+    *version = child_version;
+  }
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::OlcLookup(const KeyType &key, ValueType *value, bool *found) {
+  page_id_t page_id;
+  BPlusTreePage *node;
+  uint32_t version;
+  if (!OlcDescend(key, &page_id, &node, &version)) {
+    return false;
+  }
+  if (page_id == INVALID_PAGE_ID) {
+    *found = false;
+    return true;
+  }
+  *found = reinterpret_cast<LeafPage *>(node)->Lookup(key, value, comparator_);
+  bool valid = node->ValidateVersion(version);
+  buffer_pool_manager_->UnpinPage(page_id, false);
+  return valid;
+}
+
+/*
+ * Append the values of every key in [low, high] to result, in key order.
+ * This method is used for equality probes on trees whose keys carry a suffix
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::GetRange(const KeyType &low, const KeyType &high, std::vector<ValueType> *result,
+                              Transaction *transaction) {
+  if (latch_mode_ == BPlusTreeLatchMode::OLC) {
+    size_t size = result->size();
+    while (!OlcScan(low, high, result)) {
+      result->erase(result->begin() + size, result->end());
+      std::this_thread::yield();
+    }
+    return;
+  }
+  for (auto iter = Begin(low); !iter.IsEnd(); ++iter) {
+    const auto &[key, value] = *iter;
+    if (comparator_(key, high) > 0) {
+      break;
+    }
+    result->push_back(value);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::OlcScan(const KeyType &low, const KeyType &high, std::vector<ValueType> *result) {
+  page_id_t page_id;
+  BPlusTreePage *node;
+  uint32_t version;
+  if (!OlcDescend(low, &page_id, &node, &version)) {
+    return false;
+  }
+  if (page_id == INVALID_PAGE_ID) {
+    return true;
+  }
+  int index = reinterpret_cast<LeafPage *>(node)->KeyIndex(low, comparator_);
+  while (true) {
+    auto leaf = reinterpret_cast<LeafPage *>(node);
+    bool done = false;
+    for (int size = leaf->ReadableSize(); index < size; index++) {
+      auto item = leaf->GetItem(index);
+      if (comparator_(item.first, high) > 0) {
+        done = true;
+        break;
+      }
+      result->push_back(item.second);
+    }
+    page_id_t next_id = leaf->GetNextPageId();
+    // 读到的项和右兄弟指针都要在版本号不变时才有效
+    if (!node->ValidateVersion(version)) {
+      buffer_pool_manager_->UnpinPage(page_id, false);
+      return false;
+    }
+    if (done || next_id == INVALID_PAGE_ID) {
+      buffer_pool_manager_->UnpinPage(page_id, false);
+      return true;
+    }
+    auto next = reinterpret_cast<BPlusTreePage *>(FetchTreePage(next_id)->GetData());
+    uint32_t next_version = next->GetVersion();
+    // 与下降时一样, 当前叶子没有变化说明读取版本号时右兄弟仍然挂在树上
+    bool valid = !BPlusTreePage::IsVersionLocked(next_version) && node->ValidateVersion(version);
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    if (!valid) {
+      buffer_pool_manager_->UnpinPage(next_id, false);
+      return false;
+    }
+    page_id = next_id;
+    node = next;
+    version = next_version;
+    index = 0;
+  }
 }
 
 /*****************************************************************************
@@ -56,7 +215,57 @@ bool BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
  * keys return false, otherwise return true.
  */
 INDEX_TEMPLATE_ARGUMENTS
-bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transaction *transaction) { return false; }
+bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transaction *transaction) {
+  if (latch_mode_ != BPlusTreeLatchMode::PESSIMISTIC) {
+    bool inserted;
+    if (OptimisticInsert(key, value, &inserted)) {
+      return inserted;
+    }
+  }
+  while (true) {
+    root_latch_.WLock();
+    if (root_page_id_ == INVALID_PAGE_ID) {
+      StartNewTree(key, value);
+      root_latch_.WUnlock();
+      return true;
+    }
+    root_latch_.WUnlock();
+
+    // 树在两次加锁之间可能被删空, 此时重新尝试建树
+    LatchContext ctx;
+    if (FindLeafPageLatched(key, Operation::INSERT, &ctx) != nullptr) {
+      return InsertIntoLeaf(key, value, &ctx);
+    }
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::OptimisticInsert(const KeyType &key, const ValueType &value, bool *inserted) {
+  LatchContext ctx;
+  Page *page = FindLeafPageLatched(key, Operation::INSERT, &ctx, true);
+  if (page == nullptr) {
+    // 空树需要修改根节点, 交给悲观路径
+    return false;
+  }
+  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  ValueType existing;
+  if (leaf->Lookup(key, &existing, comparator_)) {
+    ReleaseAll(&ctx, false);
+    *inserted = false;
+    return true;
+  }
+  if (!IsSafe(leaf, Operation::INSERT, key)) {
+    // 叶子会分裂, 需要从根节点开始悲观地重新加锁
+    ReleaseAll(&ctx, false);
+    return false;
+  }
+  leaf->BeginWrite();
+  leaf->Insert(key, value, comparator_);
+  ReleaseAll(&ctx, true);
+  *inserted = true;
+  return true;
+}
+
 /*
  * Insert constant key & value pair into an empty tree
  * User needs to first ask for new page from buffer pool manager(NOTICE: throw
@@ -64,7 +273,16 @@ bool BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transact
  * tree's root page id and insert entry directly into leaf page.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {}
+void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {
+  page_id_t root_page_id;
+  Page *page = NewTreePage(&root_page_id);
+  auto root = reinterpret_cast<LeafPage *>(page->GetData());
+  root->Init(root_page_id, INVALID_PAGE_ID, leaf_max_size_);
+  root->Insert(key, value, comparator_);
+  root_page_id_ = root_page_id;
+  UpdateRootPageId(1);
+  buffer_pool_manager_->UnpinPage(root_page_id, true);
+}
 
 /*
  * Insert constant key & value pair into leaf page
@@ -75,8 +293,35 @@ void BPLUSTREE_TYPE::StartNewTree(const KeyType &key, const ValueType &value) {}
  * keys return false, otherwise return true.
  */
 INDEX_TEMPLATE_ARGUMENTS
-bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value, Transaction *transaction) {
-  return false;
+bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value, LatchContext *ctx) {
+  auto leaf = reinterpret_cast<LeafPage *>(ctx->pages_.back().first->GetData());
+  ValueType existing;
+  if (leaf->Lookup(key, &existing, comparator_)) {
+    ReleaseAll(ctx, false);
+    return false;
+  }
+  leaf->BeginWrite();
+  if (!leaf->HasRoomFor(key)) {
+    // 压缩后的布局放不下新键, 先分裂再插入到对应的一半; 新叶子在挂到父节点之前写完, OLC 读者看不到中间状态
+    LeafPage *new_leaf = Split(leaf);
+    LeafPage *target = comparator_(key, new_leaf->KeyAt(0)) < 0 ? leaf : new_leaf;
+    target->Insert(key, value, comparator_);
+    InsertIntoParent(leaf, comparator_.ShortestSeparator(leaf->KeyAt(leaf->GetSize() - 1), new_leaf->KeyAt(0)),
+                     new_leaf);
+    buffer_pool_manager_->UnpinPage(new_leaf->GetPageId(), true);
+    ReleaseAll(ctx, true);
+    return true;
+  }
+  leaf->Insert(key, value, comparator_);
+  if (leaf->GetSize() >= leaf->GetMaxSize()) {
+    LeafPage *new_leaf = Split(leaf);
+    // 分隔键只需要区分左右两个叶子, 取最短的那个以节省内部页的空间
+    InsertIntoParent(leaf, comparator_.ShortestSeparator(leaf->KeyAt(leaf->GetSize() - 1), new_leaf->KeyAt(0)),
+                     new_leaf);
+    buffer_pool_manager_->UnpinPage(new_leaf->GetPageId(), true);
+  }
+  ReleaseAll(ctx, true);
+  return true;
 }
 
 /*
@@ -89,7 +334,21 @@ bool BPLUSTREE_TYPE::InsertIntoLeaf(const KeyType &key, const ValueType &value,
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
 N *BPLUSTREE_TYPE::Split(N *node) {
-  return nullptr;
+  page_id_t new_page_id;
+  Page *new_page = NewTreePage(&new_page_id);
+  auto new_node = reinterpret_cast<N *>(new_page->GetData());
+  node->BeginWrite();
+  if constexpr (std::is_same_v<N, LeafPage>) {
+    new_node->Init(new_page_id, node->GetParentPageId(), leaf_max_size_);
+    node->MoveHalfTo(new_node);
+    // 新的叶子插入到叶子链表中
+    new_node->SetNextPageId(node->GetNextPageId());
+    node->SetNextPageId(new_page_id);
+  } else {
+    new_node->Init(new_page_id, node->GetParentPageId(), internal_max_size_);
+    node->MoveHalfTo(new_node, buffer_pool_manager_);
+  }
+  return new_node;
 }
 
 /*
@@ -102,8 +361,166 @@ N *BPLUSTREE_TYPE::Split(N *node) {
  * recursively if necessary.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node,
-                                      Transaction *transaction) {}
+void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &key, BPlusTreePage *new_node) {
+  if (old_node->IsRootPage()) {
+    // 根节点分裂, 此时一定持有 root_latch_ 的写锁
+    page_id_t root_page_id;
+    Page *root_page = NewTreePage(&root_page_id);
+    auto root = reinterpret_cast<InternalPage *>(root_page->GetData());
+    root->Init(root_page_id, INVALID_PAGE_ID, internal_max_size_);
+    root->PopulateNewRoot(old_node->GetPageId(), key, new_node->GetPageId());
+    old_node->SetParentPageId(root_page_id);
+    new_node->SetParentPageId(root_page_id);
+    root_page_id_ = root_page_id;
+    UpdateRootPageId(0);
+    buffer_pool_manager_->UnpinPage(root_page_id, true);
+    return;
+  }
+
+  // 父节点不安全, 因此仍在本次操作的加锁路径中
+  page_id_t parent_page_id = old_node->GetParentPageId();
+  auto parent = reinterpret_cast<InternalPage *>(FetchTreePage(parent_page_id)->GetData());
+  parent->BeginWrite();
+  if (!parent->HasRoomFor(key)) {
+    // 压缩后的布局放不下新的分隔键, 先分裂父节点, old_node 会被其中一半收养;
+    // 新的父节点在挂到上层之前写完, OLC 读者看不到中间状态
+    InternalPage *new_parent = Split(parent);
+    InternalPage *target = parent->ValueIndex(old_node->GetPageId()) >= 0 ? parent : new_parent;
+    target->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
+    new_node->SetParentPageId(target->GetPageId());
+    InsertIntoParent(parent, new_parent->KeyAt(0), new_parent);
+    buffer_pool_manager_->UnpinPage(new_parent->GetPageId(), true);
+    buffer_pool_manager_->UnpinPage(parent_page_id, true);
+    return;
+  }
+  parent->InsertNodeAfter(old_node->GetPageId(), key, new_node->GetPageId());
+  new_node->SetParentPageId(parent_page_id);
+  if (parent->GetSize() > parent->GetMaxSize()) {
+    InternalPage *new_parent = Split(parent);
+    InsertIntoParent(parent, new_parent->KeyAt(0), new_parent);
+    buffer_pool_manager_->UnpinPage(new_parent->GetPageId(), true);
+  }
+  buffer_pool_manager_->UnpinPage(parent_page_id, true);
+}
+
+/*****************************************************************************
+ * BULK LOADING
+ *****************************************************************************/
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::BulkLoad(std::vector<std::pair<KeyType, ValueType>> entries, double fill_factor) {
+  auto less = [this](const std::pair<KeyType, ValueType> &a, const std::pair<KeyType, ValueType> &b) {
+    return comparator_(a.first, b.first) < 0;
+  };
+  auto equal = [this](const std::pair<KeyType, ValueType> &a, const std::pair<KeyType, ValueType> &b) {
+    return comparator_(a.first, b.first) == 0;
+  };
+  if (!std::is_sorted(entries.begin(), entries.end(), less)) {
+    std::stable_sort(entries.begin(), entries.end(), less);
+  }
+  entries.erase(std::unique(entries.begin(), entries.end(), equal), entries.end());
+
+  root_latch_.WLock();
+  if (root_page_id_ != INVALID_PAGE_ID) {
+    root_latch_.WUnlock();
+    return false;
+  }
+  if (entries.empty()) {
+    root_latch_.WUnlock();
+    return true;
+  }
+
+  // 叶子最多容纳 max_size - 1 项, 内部节点最多容纳 max_size 个孩子. 每个节点的项数是预先规划的,
+  // 因此只使用不压缩也一定能放下的项数
+  int leaf_max_size = std::min<int>(leaf_max_size_, LEAF_PAGE_SIZE);
+  int internal_max_size = std::min<int>(
+      internal_max_size_, (PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / sizeof(std::pair<KeyType, page_id_t>) - 1);
+  int leaf_min_size = std::max(1, leaf_max_size / 2);
+  int internal_min_size = std::max(2, (internal_max_size + 1) / 2);
+  int leaf_capacity = std::clamp(static_cast<int>(fill_factor * (leaf_max_size - 1)), leaf_min_size, leaf_max_size - 1);
+  int internal_capacity =
+      std::clamp(static_cast<int>(fill_factor * internal_max_size), internal_min_size, internal_max_size);
+
+  // 预先计算每一层的节点个数, 这样每个节点在创建时就知道自己的父节点和应当容纳的项数.
+  // 节点个数先按 ceil(items / capacity) 计算, 项数在节点之间平均分配; 如果平均后低于 min_size
+  // (例如 items 只比 capacity 多一点), 就减少到 floor(items / min_size) 个节点, 此时每个节点
+  // 的项数在 [min_size, 2 * min_size - 1] 之内, 不会超过节点的最大容量
+  std::vector<BulkLoadLevel> levels;
+  int64_t items = static_cast<int64_t>(entries.size());
+  int capacity = leaf_capacity;
+  int min_size = leaf_min_size;
+  do {
+    BulkLoadLevel level;
+    level.items_ = items;
+    level.nodes_ = (items + capacity - 1) / capacity;
+    if (level.nodes_ > 1 && items / level.nodes_ < min_size) {
+      level.nodes_ = std::max<int64_t>(1, items / min_size);
+    }
+    levels.push_back(level);
+    items = level.nodes_;
+    capacity = internal_capacity;
+    min_size = internal_min_size;
+  } while (items > 1);
+
+  for (size_t i = 0; i < entries.size(); i++) {
+    const auto &[key, value] = entries[i];
+    BulkLoadLevel &leaves = levels[0];
+    if (leaves.remaining_ == 0) {
+      Page *prev = leaves.page_;
+      OpenBulkLoadNode(&levels, 0, i == 0 ? key : comparator_.ShortestSeparator(entries[i - 1].first, key));
+      if (prev != nullptr) {
+        // 下一个叶子已经分配好, 前一个叶子写完之后不会再被访问
+        reinterpret_cast<LeafPage *>(prev->GetData())->SetNextPageId(leaves.page_->GetPageId());
+        buffer_pool_manager_->UnpinPage(prev->GetPageId(), true);
+      }
+    }
+    reinterpret_cast<LeafPage *>(leaves.page_->GetData())->Insert(key, value, comparator_);
+    leaves.remaining_--;
+  }
+
+  root_page_id_ = levels.back().page_->GetPageId();
+  for (const auto &level : levels) {
+    buffer_pool_manager_->UnpinPage(level.page_->GetPageId(), true);
+  }
+  UpdateRootPageId(1);
+  root_latch_.WUnlock();
+  return true;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::OpenBulkLoadNode(std::vector<BulkLoadLevel> *levels, size_t level, const KeyType &first_key) {
+  page_id_t parent_page_id = INVALID_PAGE_ID;
+  InternalPage *parent = nullptr;
+  if (level + 1 < levels->size()) {
+    BulkLoadLevel &parent_level = (*levels)[level + 1];
+    if (parent_level.remaining_ == 0) {
+      Page *prev = parent_level.page_;
+      OpenBulkLoadNode(levels, level + 1, first_key);
+      if (prev != nullptr) {
+        buffer_pool_manager_->UnpinPage(prev->GetPageId(), true);
+      }
+    }
+    parent_page_id = parent_level.page_->GetPageId();
+    parent = reinterpret_cast<InternalPage *>(parent_level.page_->GetData());
+    parent_level.remaining_--;
+  }
+
+  page_id_t page_id;
+  Page *page = NewTreePage(&page_id);
+  if (level == 0) {
+    reinterpret_cast<LeafPage *>(page->GetData())->Init(page_id, parent_page_id, leaf_max_size_);
+  } else {
+    reinterpret_cast<InternalPage *>(page->GetData())->Init(page_id, parent_page_id, internal_max_size_);
+  }
+  if (parent != nullptr) {
+    parent->AppendNode(first_key, page_id);
+  }
+
+  // 项数在同一层的节点之间平均分配
+  BulkLoadLevel &current = (*levels)[level];
+  current.page_ = page;
+  current.remaining_ = current.items_ / current.nodes_ + (current.next_node_ < current.items_ % current.nodes_ ? 1 : 0);
+  current.next_node_++;
+}
 
 /*****************************************************************************
  * REMOVE
@@ -116,7 +533,52 @@ void BPLUSTREE_TYPE::InsertIntoParent(BPlusTreePage *old_node, const KeyType &ke
  * necessary.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {}
+void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
+  if (latch_mode_ != BPlusTreeLatchMode::PESSIMISTIC && OptimisticRemove(key)) {
+    return;
+  }
+  LatchContext ctx;
+  Page *page = FindLeafPageLatched(key, Operation::DELETE, &ctx);
+  if (page == nullptr) {
+    return;
+  }
+  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  ValueType existing;
+  if (!leaf->Lookup(key, &existing, comparator_)) {
+    ReleaseAll(&ctx, false);
+    return;
+  }
+  leaf->BeginWrite();
+  leaf->RemoveAndDeleteRecord(key, comparator_);
+  if (CoalesceOrRedistribute(leaf, &ctx)) {
+    ctx.deleted_pages_.push_back(leaf->GetPageId());
+  }
+  ReleaseAll(&ctx, true);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::OptimisticRemove(const KeyType &key) {
+  LatchContext ctx;
+  Page *page = FindLeafPageLatched(key, Operation::DELETE, &ctx, true);
+  if (page == nullptr) {
+    return true;
+  }
+  auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+  ValueType existing;
+  if (!leaf->Lookup(key, &existing, comparator_)) {
+    ReleaseAll(&ctx, false);
+    return true;
+  }
+  if (!IsSafe(leaf, Operation::DELETE, key)) {
+    // 叶子会合并或重新分配, 需要从根节点开始悲观地重新加锁
+    ReleaseAll(&ctx, false);
+    return false;
+  }
+  leaf->BeginWrite();
+  leaf->RemoveAndDeleteRecord(key, comparator_);
+  ReleaseAll(&ctx, true);
+  return true;
+}
 
 /*
  * User needs to first find the sibling of input page. If sibling's size + input
@@ -127,8 +589,54 @@ void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {}
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, Transaction *transaction) {
-  return false;
+bool BPLUSTREE_TYPE::CoalesceOrRedistribute(N *node, LatchContext *ctx) {
+  if (node->IsRootPage()) {
+    return AdjustRoot(node);
+  }
+  if (node->GetSize() >= node->GetMinSize()) {
+    return false;
+  }
+
+  // 父节点不安全, 因此仍在本次操作的加锁路径中
+  page_id_t parent_page_id = node->GetParentPageId();
+  auto parent = reinterpret_cast<InternalPage *>(FetchTreePage(parent_page_id)->GetData());
+  if (parent->GetSize() < 2) {
+    // 父节点因为放不下新的分隔键而没能重新分配, 只剩一个孩子, 此时没有兄弟可以合并
+    buffer_pool_manager_->UnpinPage(parent_page_id, false);
+    return false;
+  }
+  int index = parent->ValueIndex(node->GetPageId());
+  // 优先选择左兄弟, 最左侧的孩子选择右兄弟
+  int sibling_index = index == 0 ? 1 : index - 1;
+  Page *sibling_page = FetchTreePage(parent->ValueAt(sibling_index));
+  LatchPage(sibling_page, true);
+  ctx->pages_.emplace_back(sibling_page, true);
+  auto sibling = reinterpret_cast<N *>(sibling_page->GetData());
+
+  // 合并后的页面既不能达到分裂的条件, 压缩后也要放得下
+  bool fits;
+  if constexpr (std::is_same_v<N, LeafPage>) {
+    fits = sibling->CanMergeWith(node);
+  } else {
+    fits = sibling->CanMergeWith(node, parent->KeyAt(std::max(index, sibling_index)));
+  }
+  if (!fits) {
+    Redistribute(sibling, node, index);
+    buffer_pool_manager_->UnpinPage(parent_page_id, true);
+    return false;
+  }
+
+  page_id_t node_page_id = node->GetPageId();
+  if (Coalesce(&sibling, &node, &parent, index, ctx)) {
+    ctx->deleted_pages_.push_back(parent_page_id);
+  }
+  buffer_pool_manager_->UnpinPage(parent_page_id, true);
+  // Coalesce 之后 node 指向被合并掉的右侧节点
+  if (node->GetPageId() != node_page_id) {
+    ctx->deleted_pages_.push_back(node->GetPageId());
+    return false;
+  }
+  return true;
 }
 
 /*
@@ -147,8 +655,22 @@ INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
 bool BPLUSTREE_TYPE::Coalesce(N **neighbor_node, N **node,
                               BPlusTreeInternalPage<KeyType, page_id_t, KeyComparator> **parent, int index,
-                              Transaction *transaction) {
-  return false;
+                              LatchContext *ctx) {
+  // 总是把右侧节点合并到左侧节点
+  if (index == 0) {
+    std::swap(*neighbor_node, *node);
+  }
+  int right_index = (*parent)->ValueIndex((*node)->GetPageId());
+  (*node)->BeginWrite();
+  (*neighbor_node)->BeginWrite();
+  (*parent)->BeginWrite();
+  if constexpr (std::is_same_v<N, LeafPage>) {
+    (*node)->MoveAllTo(*neighbor_node);
+  } else {
+    (*node)->MoveAllTo(*neighbor_node, (*parent)->KeyAt(right_index), buffer_pool_manager_);
+  }
+  (*parent)->Remove(right_index);
+  return CoalesceOrRedistribute(*parent, ctx);
 }
 
 /*
@@ -162,7 +684,43 @@ bool BPLUSTREE_TYPE::Coalesce(N **neighbor_node, N **node,
  */
 INDEX_TEMPLATE_ARGUMENTS
 template <typename N>
-void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {}
+void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {
+  page_id_t parent_page_id = node->GetParentPageId();
+  auto parent = reinterpret_cast<InternalPage *>(FetchTreePage(parent_page_id)->GetData());
+  // 先算出新的分隔键: 移动之后右侧页面的第一个键, 叶子取能区分左右两侧的最短键
+  int last = neighbor_node->GetSize() - 1;
+  KeyType separator;
+  if constexpr (std::is_same_v<N, LeafPage>) {
+    separator = index == 0 ? comparator_.ShortestSeparator(neighbor_node->KeyAt(0), neighbor_node->KeyAt(1))
+                           : comparator_.ShortestSeparator(neighbor_node->KeyAt(last - 1), neighbor_node->KeyAt(last));
+  } else {
+    separator = index == 0 ? neighbor_node->KeyAt(1) : neighbor_node->KeyAt(last);
+  }
+  if (!parent->CanReplaceKey(separator)) {
+    // 父节点放不下更长的分隔键, 保持 node 不满, 树仍然是正确的
+    buffer_pool_manager_->UnpinPage(parent_page_id, false);
+    return;
+  }
+  neighbor_node->BeginWrite();
+  node->BeginWrite();
+  parent->BeginWrite();
+  if (index == 0) {
+    if constexpr (std::is_same_v<N, LeafPage>) {
+      neighbor_node->MoveFirstToEndOf(node);
+    } else {
+      neighbor_node->MoveFirstToEndOf(node, parent->KeyAt(1), buffer_pool_manager_);
+    }
+    parent->SetKeyAt(1, separator);
+  } else {
+    if constexpr (std::is_same_v<N, LeafPage>) {
+      neighbor_node->MoveLastToFrontOf(node);
+    } else {
+      neighbor_node->MoveLastToFrontOf(node, parent->KeyAt(index), buffer_pool_manager_);
+    }
+    parent->SetKeyAt(index, separator);
+  }
+  buffer_pool_manager_->UnpinPage(parent_page_id, true);
+}
 /*
  * Update root page if necessary
  * NOTE: size of root page can be less than min size and this method is only
@@ -174,7 +732,27 @@ void BPLUSTREE_TYPE::Redistribute(N *neighbor_node, N *node, int index) {}
  * happend
  */
 INDEX_TEMPLATE_ARGUMENTS
-bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) { return false; }
+bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) {
+  if (old_root_node->IsLeafPage()) {
+    if (old_root_node->GetSize() > 0) {
+      return false;
+    }
+    root_page_id_ = INVALID_PAGE_ID;
+    UpdateRootPageId(0);
+    return true;
+  }
+  if (old_root_node->GetSize() > 1) {
+    return false;
+  }
+  // 根节点只剩下一个孩子, 孩子成为新的根节点
+  old_root_node->BeginWrite();
+  root_page_id_ = reinterpret_cast<InternalPage *>(old_root_node)->RemoveAndReturnOnlyChild();
+  UpdateRootPageId(0);
+  auto new_root = reinterpret_cast<BPlusTreePage *>(FetchTreePage(root_page_id_)->GetData());
+  new_root->SetParentPageId(INVALID_PAGE_ID);
+  buffer_pool_manager_->UnpinPage(root_page_id_, true);
+  return true;
+}
 
 /*****************************************************************************
  * INDEX ITERATOR
@@ -185,7 +763,16 @@ bool BPLUSTREE_TYPE::AdjustRoot(BPlusTreePage *old_root_node) { return false; }
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin() { return INDEXITERATOR_TYPE(); }
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin() {
+  LatchContext ctx;
+  Page *page = FindLeafPageLatched(KeyType(), Operation::FIND, &ctx, false, true);
+  if (page == nullptr) {
+    return INDEXITERATOR_TYPE();
+  }
+  // 叶子的读锁和 Pin 交给迭代器
+  ctx.pages_.clear();
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, page, 0, MakeSeekFunction());
+}
 
 /*
  * Input parameter is low key, find the leaf page that contains the input key
@@ -193,7 +780,35 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin() { return INDEXITERATOR_TYPE(); }
  * @return : index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) { return INDEXITERATOR_TYPE(); }
+INDEXITERATOR_TYPE BPLUSTREE_TYPE::Begin(const KeyType &key) {
+  LatchContext ctx;
+  Page *page = FindLeafPageLatched(key, Operation::FIND, &ctx);
+  if (page == nullptr) {
+    return INDEXITERATOR_TYPE();
+  }
+  ctx.pages_.clear();
+  int index = reinterpret_cast<LeafPage *>(page->GetData())->KeyIndex(key, comparator_);
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, page, index, MakeSeekFunction());
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+typename INDEXITERATOR_TYPE::SeekFunction BPLUSTREE_TYPE::MakeSeekFunction() {
+  return [this](const KeyType &key, int *index) {
+    LatchContext ctx;
+    Page *page = FindLeafPageLatched(key, Operation::FIND, &ctx);
+    if (page == nullptr) {
+      return page;
+    }
+    ctx.pages_.clear();
+    // 定位到第一个大于 key 的项, 树中的键是唯一的
+    auto leaf = reinterpret_cast<LeafPage *>(page->GetData());
+    *index = leaf->KeyIndex(key, comparator_);
+    if (*index < leaf->GetSize() && comparator_(leaf->KeyAt(*index), key) == 0) {
+      (*index)++;
+    }
+    return page;
+  };
+}
 
 /*
  * Input parameter is void, construct an index iterator representing the end
@@ -212,7 +827,154 @@ INDEXITERATOR_TYPE BPLUSTREE_TYPE::End() { return INDEXITERATOR_TYPE(); }
  */
 INDEX_TEMPLATE_ARGUMENTS
 Page *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, bool leftMost) {
-  throw Exception(ExceptionType::NOT_IMPLEMENTED, "Implement this for test");
+  LatchContext ctx;
+  Page *page = FindLeafPageLatched(key, Operation::FIND, &ctx, false, leftMost);
+  if (page != nullptr) {
+    // 只保留 Pin, 释放读锁
+    page->RUnlatch();
+  }
+  return page;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FetchTreePage(page_id_t page_id) {
+  Page *page = buffer_pool_manager_->FetchPage(page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "BPlusTree: cannot fetch page, all frames are pinned");
+  }
+  return page;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::NewTreePage(page_id_t *page_id) {
+  Page *page = buffer_pool_manager_->NewPage(page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "BPlusTree: cannot allocate page, all frames are pinned");
+  }
+  return page;
+}
+
+/*
+ * A node is safe if the operation cannot propagate a split or merge to its parent
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_TYPE::IsSafe(BPlusTreePage *node, Operation op, const KeyType &key) {
+  auto leaf = reinterpret_cast<LeafPage *>(node);
+  auto internal = reinterpret_cast<InternalPage *>(node);
+  switch (op) {
+    case Operation::FIND:
+      return true;
+    case Operation::INSERT:
+      // 叶子在 size 达到 max_size 时分裂, 内部页在超过 max_size 时分裂; 放不下新键时也会分裂.
+      // 内部页还不知道孩子分裂后要插入的分隔键, 因此要求能放下任意一个键
+      if (node->IsLeafPage()) {
+        return leaf->GetSize() + 1 < leaf->GetMaxSize() && leaf->HasRoomFor(key);
+      }
+      return internal->GetSize() < internal->GetMaxSize() && internal->HasRoomForAnyKey();
+    case Operation::DELETE:
+      if (node->IsRootPage()) {
+        return node->IsLeafPage() ? node->GetSize() > 1 : node->GetSize() > 2;
+      }
+      return node->IsLeafPage() ? leaf->GetSize() > leaf->GetMinSize() : internal->GetSize() > internal->GetMinSize();
+  }
+  return false;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::LatchPage(Page *page, bool write) {
+  if (write) {
+    page->WLatch();
+  } else {
+    page->RLatch();
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::UnlatchPage(Page *page, bool write) {
+  if (write) {
+    reinterpret_cast<BPlusTreePage *>(page->GetData())->EndWrite();
+    page->WUnlatch();
+  } else {
+    page->RUnlatch();
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+Page *BPLUSTREE_TYPE::FindLeafPageLatched(const KeyType &key, Operation op, LatchContext *ctx, bool optimistic,
+                                          bool left_most) {
+  bool exclusive = op != Operation::FIND && !optimistic;
+  if (exclusive) {
+    root_latch_.WLock();
+  } else {
+    root_latch_.RLock();
+  }
+  ctx->root_locked_ = true;
+  ctx->root_exclusive_ = exclusive;
+  if (root_page_id_ == INVALID_PAGE_ID) {
+    ReleaseAll(ctx, false);
+    return nullptr;
+  }
+
+  page_id_t page_id = root_page_id_;
+  while (true) {
+    Page *page = FetchTreePage(page_id);
+    // 页面类型在页面的生命周期内不会改变, 并且父节点的锁保证它不会被删除, 因此可以在加锁前读取
+    auto node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+    bool write = exclusive || (op != Operation::FIND && node->IsLeafPage());
+    LatchPage(page, write);
+    ctx->pages_.emplace_back(page, write);
+    // 读锁和乐观模式下总是释放祖先, 写锁只有在孩子安全时才释放
+    if (!exclusive || IsSafe(node, op, key)) {
+      ReleaseAncestors(ctx);
+    }
+    if (node->IsLeafPage()) {
+      return page;
+    }
+    auto internal = reinterpret_cast<InternalPage *>(node);
+    page_id = left_most ? internal->ValueAt(0) : internal->Lookup(key, comparator_);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ReleaseAncestors(LatchContext *ctx) {
+  if (ctx->root_locked_) {
+    if (ctx->root_exclusive_) {
+      root_latch_.WUnlock();
+    } else {
+      root_latch_.RUnlock();
+    }
+    ctx->root_locked_ = false;
+  }
+  // 祖先在修改之前就被释放, 因此不会是脏页
+  while (ctx->pages_.size() > 1) {
+    auto [page, write] = ctx->pages_.front();
+    ctx->pages_.pop_front();
+    UnlatchPage(page, write);
+    buffer_pool_manager_->UnpinPage(page->GetPageId(), false);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::ReleaseAll(LatchContext *ctx, bool dirty) {
+  if (ctx->root_locked_) {
+    if (ctx->root_exclusive_) {
+      root_latch_.WUnlock();
+    } else {
+      root_latch_.RUnlock();
+    }
+    ctx->root_locked_ = false;
+  }
+  for (auto [page, write] : ctx->pages_) {
+    page_id_t page_id = page->GetPageId();
+    UnlatchPage(page, write);
+    buffer_pool_manager_->UnpinPage(page_id, dirty && write);
+  }
+  ctx->pages_.clear();
+  // 所有的 Pin 都释放之后才能删除被合并掉的页面
+  for (page_id_t page_id : ctx->deleted_pages_) {
+    buffer_pool_manager_->DeletePage(page_id);
+  }
+  ctx->deleted_pages_.clear();
 }
 
 /*
@@ -225,15 +987,19 @@ Page *BPLUSTREE_TYPE::FindLeafPage(const KeyType &key, bool leftMost) {
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
-  HeaderPage *header_page = static_cast<HeaderPage *>(buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
-  if (insert_record != 0) {
-    // create a new record<index_name + root_page_id> in header_page
-    header_page->InsertRecord(index_name_, root_page_id_);
-  } else {
-    // update root_page_id in header_page
-    header_page->UpdateRecord(index_name_, root_page_id_);
+  if (header_page_id_ == INVALID_PAGE_ID) {
+    return;
+  }
+  HeaderPage *header_page = static_cast<HeaderPage *>(buffer_pool_manager_->FetchPage(header_page_id_));
+  // 需要时先新建 <index_name, root_page_id> 记录; 记录已经存在(树被清空后重建根节点)时改为更新
+  bool recorded = insert_record != 0 && header_page->InsertRecord(index_name_, root_page_id_);
+  if (!recorded) {
+    recorded = header_page->UpdateRecord(index_name_, root_page_id_);
+  }
+  buffer_pool_manager_->UnpinPage(header_page_id_, true);
+  if (!recorded) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "B+ tree cannot record its root page id in the header page");
   }
-  buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
 }
 
 /*
@@ -253,6 +1019,23 @@ void BPLUSTREE_TYPE::InsertFromFile(const std::string &file_name, Transaction *t
     Insert(index_key, rid, transaction);
   }
 }
+
+/*
+ * This method is used for test only
+ * Read data from file and bulk load it into an empty tree
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_TYPE::BulkLoadFromFile(const std::string &file_name, double fill_factor) {
+  int64_t key;
+  std::vector<std::pair<KeyType, ValueType>> entries;
+  std::ifstream input(file_name);
+  while (input >> key) {
+    KeyType index_key;
+    index_key.SetFromInteger(key);
+    entries.emplace_back(index_key, RID(key));
+  }
+  BulkLoad(std::move(entries), fill_factor);
+}
 /*
  * This method is used for test only
  * Read data from file and remove one by one
@@ -399,4 +1182,13 @@ template class BPlusTree<GenericKey<16>, RID, GenericComparator<16>>;
 template class BPlusTree<GenericKey<32>, RID, GenericComparator<32>>;
 template class BPlusTree<GenericKey<64>, RID, GenericComparator<64>>;
 
+// (key, rid) entries of a BPlusTreeIndex, see BPlusTreeEntryKey
+template class BPlusTree<GenericKey<12>, RID, GenericComparator<12>>;
+
+template class BPlusTree<GenericKey<24>, RID, GenericComparator<24>>;
+
+template class BPlusTree<GenericKey<40>, RID, GenericComparator<40>>;
+
+template class BPlusTree<GenericKey<72>, RID, GenericComparator<72>>;
+
 }  // namespace bustub
@@ -11,51 +11,233 @@
 
 #include "storage/index/b_plus_tree_index.h"
 
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
 namespace bustub {
+
+namespace {
+
+/**
+ * Range cursor over a B+ tree. Every batch descends the tree again from the
+ * last key returned, so no leaf stays latched between batches.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+class BPlusTreeRangeCursor : public IndexRangeCursor {
+ public:
+  BPlusTreeRangeCursor(BPlusTree<KeyType, ValueType, KeyComparator> *tree, const KeyComparator &comparator,
+                       const KeyType &low, const KeyType &high, bool empty)
+      : tree_(tree), comparator_(comparator), next_key_(low), high_key_(high), exhausted_(empty) {}
+
+  bool NextBatch(std::vector<RID> *result, size_t max_size) override {
+    if (exhausted_) {
+      return false;
+    }
+    size_t count = 0;
+    auto iter = tree_->Begin(next_key_);
+    // 树中的键带有 RID, 是唯一的, 上一批返回的最后一项需要跳过
+    if (started_ && !iter.IsEnd() && comparator_((*iter).first, next_key_) == 0) {
+      ++iter;
+    }
+    for (; !iter.IsEnd() && count < max_size; ++iter) {
+      const auto &[key, rid] = *iter;
+      if (comparator_(key, high_key_) > 0) {
+        break;
+      }
+      result->push_back(rid);
+      next_key_ = key;
+      count++;
+    }
+    started_ = true;
+    exhausted_ = count < max_size;
+    return count > 0;
+  }
+
+ private:
+  BPlusTree<KeyType, ValueType, KeyComparator> *tree_;
+  KeyComparator comparator_;
+  KeyType next_key_;
+  KeyType high_key_;
+  bool started_{false};
+  bool exhausted_{false};
+};
+
+}  // namespace
 /*
  * Constructor
  */
 INDEX_TEMPLATE_ARGUMENTS
-BPLUSTREE_INDEX_TYPE::BPlusTreeIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager)
+BPLUSTREE_INDEX_TYPE::BPlusTreeIndex(std::unique_ptr<IndexMetadata> &&metadata, BufferPoolManager *buffer_pool_manager,
+                                     BPlusTreeLatchMode latch_mode, page_id_t header_page_id)
     : Index(std::move(metadata)),
       comparator_(GetMetadata()->GetKeySchema()),
-      container_(GetMetadata()->GetName(), buffer_pool_manager, comparator_) {}
+      entry_comparator_(GetMetadata()->GetKeySchema(), true),
+      // 页面压缩后能放下的项数取决于键, 因此 max_size 取上限, 放不下时页面会提前分裂
+      container_(GetMetadata()->GetName(), buffer_pool_manager, entry_comparator_,
+                 BPlusTreeLeafPage<EntryKey, ValueType, EntryComparator>::MAX_ENTRIES,
+                 BPlusTreeInternalPage<EntryKey, page_id_t, EntryComparator>::MAX_ENTRIES, latch_mode,
+                 header_page_id) {}
+
+INDEX_TEMPLATE_ARGUMENTS
+typename BPLUSTREE_INDEX_TYPE::EntryKey BPLUSTREE_INDEX_TYPE::MakeEntryKey(const KeyType &key, RID rid) const {
+  EntryKey entry_key;
+  memcpy(entry_key.data_, key.data_, sizeof(key.data_));
+  // RID 按有符号整数的顺序写成大端, 与键一样可以直接按字节比较
+  auto bits = static_cast<uint64_t>(rid.Get()) ^ (static_cast<uint64_t>(1) << 63);
+  for (size_t i = 0; i < BPlusTreeEntryKey<KeyType>::RID_SIZE; i++) {
+    entry_key.data_[sizeof(key.data_) + i] =
+        static_cast<char>(bits >> (8 * (BPlusTreeEntryKey<KeyType>::RID_SIZE - 1 - i)));
+  }
+  return entry_key;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+typename BPLUSTREE_INDEX_TYPE::EntryKey BPLUSTREE_INDEX_TYPE::MakeBoundKey(const KeyType &key, bool upper) const {
+  EntryKey entry_key;
+  memcpy(entry_key.data_, key.data_, sizeof(key.data_));
+  memset(entry_key.data_ + sizeof(key.data_), upper ? 0xFF : 0, BPlusTreeEntryKey<KeyType>::RID_SIZE);
+  return entry_key;
+}
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::InsertEntry(const Tuple &key, RID rid, Transaction *transaction) {
   // construct insert index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, GetKeySchema());
 
-  container_.Insert(index_key, rid, transaction);
+  container_.Insert(MakeEntryKey(index_key, rid), rid, transaction);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::DeleteEntry(const Tuple &key, RID rid, Transaction *transaction) {
   // construct delete index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, GetKeySchema());
+
+  // 只删除这个 RID 对应的项, 相同键的其他项不受影响
+  container_.Remove(MakeEntryKey(index_key, rid), transaction);
+}
 
-  container_.Remove(index_key, transaction);
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::ScanEqual(const KeyType &key, std::vector<RID> *result) {
+  // 该键的所有项在 (key, 最小 RID) 与 (key, 最大 RID) 之间, OLC 模式下这次范围探测不加锁
+  container_.GetRange(MakeBoundKey(key, false), MakeBoundKey(key, true), result);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_INDEX_TYPE::ScanKey(const Tuple &key, std::vector<RID> *result, Transaction *transaction) {
   // construct scan index key
   KeyType index_key;
-  index_key.SetFromKey(key);
+  index_key.SetFromKey(key, GetKeySchema());
+
+  ScanEqual(index_key, result);
+}
 
-  container_.GetValue(index_key, result, transaction);
+INDEX_TEMPLATE_ARGUMENTS
+void BPLUSTREE_INDEX_TYPE::ScanKeys(const std::vector<Tuple> &keys, std::vector<std::vector<RID>> *results,
+                                    Transaction *transaction) {
+  std::vector<KeyType> index_keys(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    index_keys[i].SetFromKey(keys[i], GetKeySchema());
+  }
+  // 按键排序后再查找, 相邻两次下降路径上的页面大多还在缓冲池中
+  std::vector<size_t> order(keys.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(),
+            [&](size_t lhs, size_t rhs) { return comparator_(index_keys[lhs], index_keys[rhs]) < 0; });
+  results->clear();
+  results->resize(keys.size());
+  for (size_t pos = 0; pos < order.size(); pos++) {
+    size_t i = order[pos];
+    // 批次中重复的键只查找一次
+    if (pos > 0 && comparator_(index_keys[order[pos - 1]], index_keys[i]) == 0) {
+      (*results)[i] = (*results)[order[pos - 1]];
+      continue;
+    }
+    ScanEqual(index_keys[i], &(*results)[i]);
+  }
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE BPLUSTREE_INDEX_TYPE::GetBeginIterator() { return container_.Begin(); }
+void BPLUSTREE_INDEX_TYPE::ScanRange(const Tuple *low, const Tuple *high, std::vector<RID> *result,
+                                    Transaction *transaction) {
+  KeyType low_key;
+  if (low != nullptr) {
+    low_key.SetFromKey(*low, GetKeySchema());
+  }
+  // 上界补上最大的 RID, 与上界相等的所有项都在范围内
+  EntryKey high_entry_key{};
+  if (high != nullptr) {
+    KeyType high_key;
+    high_key.SetFromKey(*high, GetKeySchema());
+    high_entry_key = MakeBoundKey(high_key, true);
+  }
+  for (auto iter = low != nullptr ? container_.Begin(MakeBoundKey(low_key, false)) : container_.Begin();
+       !iter.IsEnd(); ++iter) {
+    const auto &[entry_key, rid] = *iter;
+    if (high != nullptr && entry_comparator_(entry_key, high_entry_key) > 0) {
+      break;
+    }
+    result->push_back(rid);
+  }
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE BPLUSTREE_INDEX_TYPE::GetBeginIterator(const KeyType &key) { return container_.Begin(key); }
+std::unique_ptr<IndexRangeCursor> BPLUSTREE_INDEX_TYPE::OpenRangeCursor(const std::vector<Value> &low,
+                                                                        const std::vector<Value> &high,
+                                                                        Transaction *transaction) {
+  // 边界只给出前几列的值, 先转换成键的列类型, 再补成该前缀下最小/最大的键.
+  // 超出列类型范围的值无法转换, 边界截断到它之前的前缀: 下界低于最小值或上界高于最大值时
+  // 这一列不再限制范围; 反方向越界时范围落在该前缀的所有键之外, 第一列就越界则范围为空
+  bool empty = false;
+  auto clamp = [this, &empty](const std::vector<Value> &values, bool upper, KeyType *key) {
+    std::vector<Value> key_values;
+    bool pad_upper = upper;
+    for (uint32_t i = 0; i < values.size(); i++) {
+      TypeId type = GetKeySchema()->GetColumn(i).GetType();
+      int side = Index::CompareToKeyRange(values[i], type);
+      if (side != 0) {
+        if ((side > 0) != upper) {
+          empty = empty || i == 0;
+          pad_upper = !upper;
+        }
+        break;
+      }
+      key_values.push_back(values[i].CastAs(type));
+    }
+    key->SetFromPrefix(key_values, pad_upper);
+  };
+  KeyType low_key;
+  KeyType high_key;
+  clamp(low, false, &low_key);
+  clamp(high, true, &high_key);
+  return std::make_unique<BPlusTreeRangeCursor<EntryKey, ValueType, EntryComparator>>(
+      &container_, entry_comparator_, MakeBoundKey(low_key, false), MakeBoundKey(high_key, true), empty);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool BPLUSTREE_INDEX_TYPE::BulkLoad(const std::vector<std::pair<Tuple, RID>> &entries, double fill_factor) {
+  std::vector<std::pair<EntryKey, ValueType>> index_entries;
+  index_entries.reserve(entries.size());
+  for (const auto &[key, rid] : entries) {
+    KeyType index_key;
+    index_key.SetFromKey(key, GetKeySchema());
+    index_entries.emplace_back(MakeEntryKey(index_key, rid), rid);
+  }
+  return container_.BulkLoad(std::move(index_entries), fill_factor);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+typename BPLUSTREE_INDEX_TYPE::EntryIterator BPLUSTREE_INDEX_TYPE::GetBeginIterator() { return container_.Begin(); }
+
+INDEX_TEMPLATE_ARGUMENTS
+typename BPLUSTREE_INDEX_TYPE::EntryIterator BPLUSTREE_INDEX_TYPE::GetBeginIterator(const KeyType &key) {
+  return container_.Begin(MakeBoundKey(key, false));
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE BPLUSTREE_INDEX_TYPE::GetEndIterator() { return container_.End(); }
+typename BPLUSTREE_INDEX_TYPE::EntryIterator BPLUSTREE_INDEX_TYPE::GetEndIterator() { return container_.End(); }
 
 template class BPlusTreeIndex<GenericKey<4>, RID, GenericComparator<4>>;
 template class BPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>>;
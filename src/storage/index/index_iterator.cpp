@@ -2,7 +2,9 @@
  * index_iterator.cpp
  */
 #include <cassert>
+#include <utility>
 
+#include "common/exception.h"
 #include "storage/index/index_iterator.h"
 
 namespace bustub {
@@ -15,16 +17,118 @@ INDEX_TEMPLATE_ARGUMENTS
 INDEXITERATOR_TYPE::IndexIterator() = default;
 
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::~IndexIterator() = default;
+INDEXITERATOR_TYPE::IndexIterator(BufferPoolManager *buffer_pool_manager, Page *page, int index, SeekFunction seek)
+    : buffer_pool_manager_(buffer_pool_manager),
+      page_(page),
+      leaf_(reinterpret_cast<LeafPage *>(page->GetData())),
+      index_(index),
+      seek_(std::move(seek)) {
+  PrefetchNextLeaf();
+  SkipExhaustedLeaves();
+}
 
 INDEX_TEMPLATE_ARGUMENTS
-bool INDEXITERATOR_TYPE::IsEnd() { throw std::runtime_error("unimplemented"); }
+INDEXITERATOR_TYPE::~IndexIterator() { Release(); }
 
 INDEX_TEMPLATE_ARGUMENTS
-const MappingType &INDEXITERATOR_TYPE::operator*() { throw std::runtime_error("unimplemented"); }
+INDEXITERATOR_TYPE::IndexIterator(IndexIterator &&other) noexcept
+    : buffer_pool_manager_(other.buffer_pool_manager_),
+      page_(std::exchange(other.page_, nullptr)),
+      leaf_(std::exchange(other.leaf_, nullptr)),
+      index_(other.index_),
+      seek_(std::move(other.seek_)) {}
 
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE &INDEXITERATOR_TYPE::operator++() { throw std::runtime_error("unimplemented"); }
+INDEXITERATOR_TYPE &INDEXITERATOR_TYPE::operator=(IndexIterator &&other) noexcept {
+  if (this != &other) {
+    Release();
+    buffer_pool_manager_ = other.buffer_pool_manager_;
+    page_ = std::exchange(other.page_, nullptr);
+    leaf_ = std::exchange(other.leaf_, nullptr);
+    index_ = other.index_;
+    seek_ = std::move(other.seek_);
+  }
+  return *this;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool INDEXITERATOR_TYPE::IsEnd() { return page_ == nullptr; }
+
+INDEX_TEMPLATE_ARGUMENTS
+const MappingType &INDEXITERATOR_TYPE::operator*() {
+  if (page_ == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_RANGE, "IndexIterator: dereferencing end iterator");
+  }
+  // 叶子中的键是压缩存储的, 解码到迭代器自己的缓冲里再返回引用
+  item_ = leaf_->GetItem(index_);
+  return item_;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+INDEXITERATOR_TYPE &INDEXITERATOR_TYPE::operator++() {
+  if (page_ != nullptr) {
+    index_++;
+    SkipExhaustedLeaves();
+  }
+  return *this;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::SkipExhaustedLeaves() {
+  while (page_ != nullptr && index_ >= leaf_->GetSize()) {
+    page_id_t next_page_id = leaf_->GetNextPageId();
+    if (next_page_id == INVALID_PAGE_ID) {
+      Release();
+      return;
+    }
+    Page *next = buffer_pool_manager_->FetchPage(next_page_id);
+    if (next == nullptr) {
+      throw Exception(ExceptionType::OUT_OF_MEMORY, "IndexIterator: cannot fetch next leaf, all frames are pinned");
+    }
+    if (next->TryRLatch()) {
+      // 锁耦合: 先锁住下一个叶子再释放当前叶子, 期间的合并和重新分配无法越过迭代器
+      Release();
+      page_ = next;
+      leaf_ = reinterpret_cast<LeafPage *>(next->GetData());
+      index_ = 0;
+      PrefetchNextLeaf();
+      continue;
+    }
+    // 下一个叶子被写者持有, 写者可能正在等待当前叶子 (兄弟节点从右向左加锁), 不能阻塞等待.
+    // 释放当前叶子, 从根节点重新定位到当前叶子最后一个键之后; 只有空树的根叶子会是空的
+    buffer_pool_manager_->UnpinPage(next_page_id, false);
+    if (leaf_->GetSize() == 0) {
+      Release();
+      return;
+    }
+    KeyType last_key = leaf_->KeyAt(leaf_->GetSize() - 1);
+    Release();
+    page_ = seek_(last_key, &index_);
+    if (page_ == nullptr) {
+      return;
+    }
+    leaf_ = reinterpret_cast<LeafPage *>(page_->GetData());
+    PrefetchNextLeaf();
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::PrefetchNextLeaf() {
+  page_id_t next_page_id = leaf_->GetNextPageId();
+  if (next_page_id != INVALID_PAGE_ID) {
+    buffer_pool_manager_->PrefetchPage(next_page_id);
+  }
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+void INDEXITERATOR_TYPE::Release() {
+  if (page_ != nullptr) {
+    page_->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_->GetPageId(), false);
+    page_ = nullptr;
+    leaf_ = nullptr;
+  }
+}
 
 template class IndexIterator<GenericKey<4>, RID, GenericComparator<4>>;
 
@@ -36,4 +140,13 @@ template class IndexIterator<GenericKey<32>, RID, GenericComparator<32>>;
 
 template class IndexIterator<GenericKey<64>, RID, GenericComparator<64>>;
 
+// (key, rid) entries of a BPlusTreeIndex, see BPlusTreeEntryKey
+template class IndexIterator<GenericKey<12>, RID, GenericComparator<12>>;
+
+template class IndexIterator<GenericKey<24>, RID, GenericComparator<24>>;
+
+template class IndexIterator<GenericKey<40>, RID, GenericComparator<40>>;
+
+template class IndexIterator<GenericKey<72>, RID, GenericComparator<72>>;
+
 }  // namespace bustub
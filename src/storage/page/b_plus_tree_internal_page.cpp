@@ -9,13 +9,27 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
+#include <vector>
 
 #include "common/exception.h"
 #include "storage/page/b_plus_tree_internal_page.h"
 
 namespace bustub {
+namespace {
+// 子节点被移动到新的内部页后, 需要更新它的父节点指针
+void SetChildParent(BufferPoolManager *buffer_pool_manager, page_id_t child_page_id, page_id_t parent_page_id) {
+  Page *page = buffer_pool_manager->FetchPage(child_page_id);
+  if (page == nullptr) {
+    throw Exception(ExceptionType::OUT_OF_MEMORY, "BPlusTreeInternalPage: cannot fetch child page");
+  }
+  reinterpret_cast<BPlusTreePage *>(page->GetData())->SetParentPageId(parent_page_id);
+  buffer_pool_manager->UnpinPage(child_page_id, true);
+}
+}  // namespace
+
 /*****************************************************************************
  * HELPER METHODS AND UTILITIES
  *****************************************************************************/
@@ -25,34 +39,92 @@ namespace bustub {
  * max page size
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, int max_size) {}
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, int max_size) {
+  SetPageType(IndexPageType::INTERNAL_PAGE);
+  SetSize(0);
+  SetPageId(page_id);
+  SetParentPageId(parent_id);
+  SetMaxSize(max_size);
+  entries_.Init();
+}
 /*
  * Helper method to get/set the key associated with input "index"(a.k.a
  * array offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-KeyType B_PLUS_TREE_INTERNAL_PAGE_TYPE::KeyAt(int index) const {
-  // replace with your own code
-  KeyType key{};
-  return key;
-}
+KeyType B_PLUS_TREE_INTERNAL_PAGE_TYPE::KeyAt(int index) const { return entries_.KeyAt(data_, index); }
 
+/*
+ * The caller makes sure the key fits, see CanReplaceKey()
+ */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) {}
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::SetKeyAt(int index, const KeyType &key) {
+  entries_.SetKeyAt(data_, GetSize(), index, key);
+}
 
 /*
  * Helper method to find and return array index(or offset), so that its value
  * equals to input "value"
  */
 INDEX_TEMPLATE_ARGUMENTS
-int B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueIndex(const ValueType &value) const { return 0; }
+int B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueIndex(const ValueType &value) const {
+  for (int i = 0; i < GetSize(); i++) {
+    if (entries_.ValueAt(data_, i) == value) {
+      return i;
+    }
+  }
+  return -1;
+}
 
 /*
  * Helper method to get the value associated with input "index"(a.k.a array
  * offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const { return 0; }
+ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const { return entries_.ValueAt(data_, index); }
+
+/*
+ * An internal page is full once the next key does not fit with the compressed
+ * layout, even if it holds fewer than max size entries
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::HasRoomFor(const KeyType &key) const {
+  return entries_.HasRoomFor(data_, GetSize(), DATA_BYTES, key);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::HasRoomForAnyKey() const {
+  return GetSize() + 1 <= BPlusTreeEntryArray<KeyType, ValueType>::UncompressedCapacity(DATA_BYTES);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::CanReplaceKey(const KeyType &key) const {
+  return entries_.CanReplaceKey(data_, GetSize(), DATA_BYTES, key);
+}
+
+/*
+ * Merging moves the separator from the parent down as the first key of the
+ * right page, so it has to fit as well
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_INTERNAL_PAGE_TYPE::CanMergeWith(const BPlusTreeInternalPage *other, const KeyType &middle_key) const {
+  return GetSize() + other->GetSize() <= GetMaxSize() &&
+         BPlusTreeEntryArray<KeyType, ValueType>::FitsTogether(entries_, data_, GetSize(), other->entries_,
+                                                               other->data_, other->GetSize(), &middle_key,
+                                                               DATA_BYTES);
+}
+
+/*
+ * Half of what the page can hold with its current layout, a page of keys that
+ * do not compress is not expected to hold max size / 2 entries
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_INTERNAL_PAGE_TYPE::GetMinSize() const {
+  return (std::min(GetMaxSize(), entries_.Capacity(DATA_BYTES)) + 1) / 2;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_INTERNAL_PAGE_TYPE::ReadableSize() const { return std::min(GetSize(), entries_.Capacity(DATA_BYTES)); }
 
 /*****************************************************************************
  * LOOKUP
@@ -64,7 +136,43 @@ ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::ValueAt(int index) const { return 0; }
  */
 INDEX_TEMPLATE_ARGUMENTS
 ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key, const KeyComparator &comparator) const {
-  return INVALID_PAGE_ID;
+  if (comparator.HasIntegerFastPath()) {
+    return IntegerLookup(key, comparator);
+  }
+  // 二分查找最后一个不大于 key 的分隔键, 第一个键无效因此从 1 开始
+  int left = 1;
+  int right = ReadableSize();
+  while (left < right) {
+    int mid = left + (right - left) / 2;
+    if (comparator(KeyAt(mid), key) <= 0) {
+      left = mid + 1;
+    } else {
+      right = mid;
+    }
+  }
+  return ValueAt(left - 1);
+}
+
+/*
+ * Lookup for single integer keys: branchless binary search over the decoded
+ * integers, so the loop compiles to conditional moves instead of mispredicted jumps
+ */
+INDEX_TEMPLATE_ARGUMENTS
+ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::IntegerLookup(const KeyType &key, const KeyComparator &comparator) const {
+  // 在 [1, size) 中找最后一个不大于 key 的分隔键, 找不到时落到第 0 个孩子
+  int size = ReadableSize() - 1;
+  if (size <= 0) {
+    return ValueAt(0);
+  }
+  const auto target = comparator.IntegerKey(key);
+  int base = 1;
+  while (size > 1) {
+    int half = size / 2;
+    base = comparator.IntegerKey(KeyAt(base + half)) <= target ? base + half : base;
+    size -= half;
+  }
+  // base 之前的键都不大于 key; base 本身不大于 key 时它就是目标, 否则取前一个
+  return ValueAt(comparator.IntegerKey(KeyAt(base)) <= target ? base : base - 1);
 }
 
 /*****************************************************************************
@@ -78,7 +186,22 @@ ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::Lookup(const KeyType &key, const KeyCo
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::PopulateNewRoot(const ValueType &old_value, const KeyType &new_key,
-                                                     const ValueType &new_value) {}
+                                                     const ValueType &new_value) {
+  // 第一个键无效, 用 new_key 填充它, 这样不会破坏页面的公共前缀
+  MappingType items[2] = {MappingType(new_key, old_value), MappingType(new_key, new_value)};
+  entries_.Rebuild(data_, items, 2);
+  SetSize(2);
+}
+/*
+ * Append new_key & new_value pair at the end of the page. The child's parent
+ * page id is left untouched, the caller is responsible for it.
+ */
+INDEX_TEMPLATE_ARGUMENTS
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::AppendNode(const KeyType &new_key, const ValueType &new_value) {
+  entries_.Insert(data_, GetSize(), GetSize(), new_key, new_value);
+  IncreaseSize(1);
+}
+
 /*
  * Insert new_key & new_value pair right after the pair with its value ==
  * old_value
@@ -87,7 +210,11 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::PopulateNewRoot(const ValueType &old_value,
 INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertNodeAfter(const ValueType &old_value, const KeyType &new_key,
                                                     const ValueType &new_value) {
-  return 0;
+  int size = GetSize();
+  int index = ValueIndex(old_value) + 1;
+  entries_.Insert(data_, size, index, new_key, new_value);
+  IncreaseSize(1);
+  return size + 1;
 }
 
 /*****************************************************************************
@@ -98,14 +225,35 @@ int B_PLUS_TREE_INTERNAL_PAGE_TYPE::InsertNodeAfter(const ValueType &old_value,
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveHalfTo(BPlusTreeInternalPage *recipient,
-                                                BufferPoolManager *buffer_pool_manager) {}
+                                                BufferPoolManager *buffer_pool_manager) {
+  // 后一半移动到新页, 新页的第一个键即为需要插入父节点的分隔键
+  int size = GetSize();
+  int start = size / 2;
+  std::vector<MappingType> items;
+  items.reserve(size);
+  entries_.Decode(data_, 0, size, &items);
+  recipient->CopyNFrom(items.data() + start, size - start, buffer_pool_manager);
+  entries_.Rebuild(data_, items.data(), start);
+  SetSize(start);
+}
 
 /* Copy entries into me, starting from {items} and copy {size} entries.
  * Since it is an internal page, for all entries (pages) moved, their parents page now changes to me.
  * So I need to 'adopt' them by changing their parent page id, which needs to be persisted with BufferPoolManger
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyNFrom(MappingType *items, int size, BufferPoolManager *buffer_pool_manager) {}
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyNFrom(const MappingType *items, int size,
+                                               BufferPoolManager *buffer_pool_manager) {
+  std::vector<MappingType> merged;
+  merged.reserve(GetSize() + size);
+  entries_.Decode(data_, 0, GetSize(), &merged);
+  merged.insert(merged.end(), items, items + size);
+  entries_.Rebuild(data_, merged.data(), static_cast<int>(merged.size()));
+  for (int i = 0; i < size; i++) {
+    SetChildParent(buffer_pool_manager, items[i].second, GetPageId());
+  }
+  IncreaseSize(size);
+}
 
 /*****************************************************************************
  * REMOVE
@@ -116,14 +264,21 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyNFrom(MappingType *items, int size, Buf
  * NOTE: store key&value pair continuously after deletion
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Remove(int index) {}
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::Remove(int index) {
+  entries_.Remove(data_, GetSize(), index);
+  IncreaseSize(-1);
+}
 
 /*
  * Remove the only key & value pair in internal page and return the value
  * NOTE: only call this method within AdjustRoot()(in b_plus_tree.cpp)
  */
 INDEX_TEMPLATE_ARGUMENTS
-ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::RemoveAndReturnOnlyChild() { return INVALID_PAGE_ID; }
+ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::RemoveAndReturnOnlyChild() {
+  ValueType child = ValueAt(0);
+  SetSize(0);
+  return child;
+}
 /*****************************************************************************
  * MERGE
  *****************************************************************************/
@@ -136,7 +291,15 @@ ValueType B_PLUS_TREE_INTERNAL_PAGE_TYPE::RemoveAndReturnOnlyChild() { return IN
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveAllTo(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
-                                               BufferPoolManager *buffer_pool_manager) {}
+                                               BufferPoolManager *buffer_pool_manager) {
+  // 父节点中的分隔键下移, 作为第一个孩子的键
+  std::vector<MappingType> items;
+  items.reserve(GetSize());
+  entries_.Decode(data_, 0, GetSize(), &items);
+  items[0].first = middle_key;
+  recipient->CopyNFrom(items.data(), GetSize(), buffer_pool_manager);
+  SetSize(0);
+}
 
 /*****************************************************************************
  * REDISTRIBUTE
@@ -151,14 +314,21 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveAllTo(BPlusTreeInternalPage *recipient,
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
-                                                      BufferPoolManager *buffer_pool_manager) {}
+                                                      BufferPoolManager *buffer_pool_manager) {
+  recipient->CopyLastFrom(MappingType(middle_key, ValueAt(0)), buffer_pool_manager);
+  Remove(0);
+}
 
 /* Append an entry at the end.
  * Since it is an internal page, the moved entry(page)'s parent needs to be updated.
  * So I need to 'adopt' it by changing its parent page id, which needs to be persisted with BufferPoolManger
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyLastFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager) {}
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyLastFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager) {
+  entries_.Insert(data_, GetSize(), GetSize(), pair.first, pair.second);
+  SetChildParent(buffer_pool_manager, pair.second, GetPageId());
+  IncreaseSize(1);
+}
 
 /*
  * Remove the last key & value pair from this page to head of "recipient" page.
@@ -169,14 +339,22 @@ void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyLastFrom(const MappingType &pair, Buffe
  */
 INDEX_TEMPLATE_ARGUMENTS
 void B_PLUS_TREE_INTERNAL_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeInternalPage *recipient, const KeyType &middle_key,
-                                                       BufferPoolManager *buffer_pool_manager) {}
+                                                       BufferPoolManager *buffer_pool_manager) {
+  recipient->SetKeyAt(0, middle_key);
+  recipient->CopyFirstFrom(MappingType(KeyAt(GetSize() - 1), ValueAt(GetSize() - 1)), buffer_pool_manager);
+  IncreaseSize(-1);
+}
 
 /* Append an entry at the beginning.
  * Since it is an internal page, the moved entry(page)'s parent needs to be updated.
  * So I need to 'adopt' it by changing its parent page id, which needs to be persisted with BufferPoolManger
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyFirstFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager) {}
+void B_PLUS_TREE_INTERNAL_PAGE_TYPE::CopyFirstFrom(const MappingType &pair, BufferPoolManager *buffer_pool_manager) {
+  entries_.Insert(data_, GetSize(), 0, pair.first, pair.second);
+  SetChildParent(buffer_pool_manager, pair.second, GetPageId());
+  IncreaseSize(1);
+}
 
 // valuetype for internalNode should be page id_t
 template class BPlusTreeInternalPage<GenericKey<4>, page_id_t, GenericComparator<4>>;
@@ -184,4 +362,9 @@ template class BPlusTreeInternalPage<GenericKey<8>, page_id_t, GenericComparator
 template class BPlusTreeInternalPage<GenericKey<16>, page_id_t, GenericComparator<16>>;
 template class BPlusTreeInternalPage<GenericKey<32>, page_id_t, GenericComparator<32>>;
 template class BPlusTreeInternalPage<GenericKey<64>, page_id_t, GenericComparator<64>>;
+// (key, rid) entries of a BPlusTreeIndex, see BPlusTreeEntryKey
+template class BPlusTreeInternalPage<GenericKey<12>, page_id_t, GenericComparator<12>>;
+template class BPlusTreeInternalPage<GenericKey<24>, page_id_t, GenericComparator<24>>;
+template class BPlusTreeInternalPage<GenericKey<40>, page_id_t, GenericComparator<40>>;
+template class BPlusTreeInternalPage<GenericKey<72>, page_id_t, GenericComparator<72>>;
 }  // namespace bustub
@@ -9,7 +9,9 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <sstream>
+#include <vector>
 
 #include "common/exception.h"
 #include "common/rid.h"
@@ -27,45 +29,119 @@ namespace bustub {
  * next page id and set max size
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, int max_size) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::Init(page_id_t page_id, page_id_t parent_id, int max_size) {
+  SetPageType(IndexPageType::LEAF_PAGE);
+  SetSize(0);
+  SetPageId(page_id);
+  SetParentPageId(parent_id);
+  SetNextPageId(INVALID_PAGE_ID);
+  SetMaxSize(max_size);
+  entries_.Init();
+}
 
 /**
  * Helper methods to set/get next page id
  */
 INDEX_TEMPLATE_ARGUMENTS
-page_id_t B_PLUS_TREE_LEAF_PAGE_TYPE::GetNextPageId() const { return INVALID_PAGE_ID; }
+page_id_t B_PLUS_TREE_LEAF_PAGE_TYPE::GetNextPageId() const { return next_page_id_; }
 
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::SetNextPageId(page_id_t next_page_id) { next_page_id_ = next_page_id; }
 
 /**
  * Helper method to find the first index i so that array[i].first >= key
  * NOTE: This method is only used when generating index iterator
  */
 INDEX_TEMPLATE_ARGUMENTS
-int B_PLUS_TREE_LEAF_PAGE_TYPE::KeyIndex(const KeyType &key, const KeyComparator &comparator) const { return 0; }
+int B_PLUS_TREE_LEAF_PAGE_TYPE::KeyIndex(const KeyType &key, const KeyComparator &comparator) const {
+  if (comparator.HasIntegerFastPath()) {
+    return IntegerLowerBound(key, comparator);
+  }
+  // 二分查找第一个不小于 key 的位置
+  int left = 0;
+  int right = ReadableSize();
+  while (left < right) {
+    int mid = left + (right - left) / 2;
+    if (comparator(KeyAt(mid), key) < 0) {
+      left = mid + 1;
+    } else {
+      right = mid;
+    }
+  }
+  return left;
+}
+
+/*
+ * KeyIndex for single integer keys: branchless binary search over the decoded
+ * integers, so the loop compiles to conditional moves instead of mispredicted jumps
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_LEAF_PAGE_TYPE::IntegerLowerBound(const KeyType &key, const KeyComparator &comparator) const {
+  int size = ReadableSize();
+  if (size == 0) {
+    return 0;
+  }
+  const auto target = comparator.IntegerKey(key);
+  int base = 0;
+  // 每轮把区间缩小一半, 用条件选择代替分支
+  while (size > 1) {
+    int half = size / 2;
+    base = comparator.IntegerKey(KeyAt(base + half)) < target ? base + half : base;
+    size -= half;
+  }
+  return base + static_cast<int>(comparator.IntegerKey(KeyAt(base)) < target);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_LEAF_PAGE_TYPE::ReadableSize() const { return std::min(GetSize(), entries_.Capacity(DATA_BYTES)); }
 
 /*
  * Helper method to find and return the key associated with input "index"(a.k.a
  * array offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-KeyType B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const {
-  // replace with your own code
-  KeyType key{};
-  return key;
-}
+KeyType B_PLUS_TREE_LEAF_PAGE_TYPE::KeyAt(int index) const { return entries_.KeyAt(data_, index); }
 
 /*
  * Helper method to find and return the key & value pair associated with input
  * "index"(a.k.a array offset)
  */
 INDEX_TEMPLATE_ARGUMENTS
-const MappingType &B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) {
-  // replace with your own code
-  return array_[0];
+MappingType B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) const {
+  return MappingType(entries_.KeyAt(data_, index), entries_.ValueAt(data_, index));
+}
+
+/*
+ * A leaf is full once the next key does not fit with the compressed layout,
+ * even if it holds fewer than max size entries
+ */
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::HasRoomFor(const KeyType &key) const {
+  return entries_.HasRoomFor(data_, GetSize(), DATA_BYTES, key);
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+bool B_PLUS_TREE_LEAF_PAGE_TYPE::CanMergeWith(const BPlusTreeLeafPage *other) const {
+  return GetSize() + other->GetSize() < GetMaxSize() &&
+         BPlusTreeEntryArray<KeyType, ValueType>::FitsTogether(entries_, data_, GetSize(), other->entries_,
+                                                               other->data_, other->GetSize(), nullptr, DATA_BYTES);
 }
 
+/*
+ * Half of what the page can hold with its current layout, a leaf of keys that
+ * do not compress is not expected to hold max size / 2 entries
+ */
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_LEAF_PAGE_TYPE::GetMinSize() const {
+  return std::min(GetMaxSize(), entries_.Capacity(DATA_BYTES)) / 2;
+}
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_LEAF_PAGE_TYPE::GetPrefixLength() const { return entries_.GetPrefixLength(); }
+
+INDEX_TEMPLATE_ARGUMENTS
+int B_PLUS_TREE_LEAF_PAGE_TYPE::GetKeyLength() const { return entries_.GetKeyLength(); }
+
 /*****************************************************************************
  * INSERTION
  *****************************************************************************/
@@ -75,7 +151,15 @@ const MappingType &B_PLUS_TREE_LEAF_PAGE_TYPE::GetItem(int index) {
  */
 INDEX_TEMPLATE_ARGUMENTS
 int B_PLUS_TREE_LEAF_PAGE_TYPE::Insert(const KeyType &key, const ValueType &value, const KeyComparator &comparator) {
-  return 0;
+  int size = GetSize();
+  int index = KeyIndex(key, comparator);
+  if (index < size && comparator(KeyAt(index), key) == 0) {
+    // 只支持唯一键, 重复的键不插入
+    return size;
+  }
+  entries_.Insert(data_, size, index, key, value);
+  IncreaseSize(1);
+  return size + 1;
 }
 
 /*****************************************************************************
@@ -85,13 +169,30 @@ int B_PLUS_TREE_LEAF_PAGE_TYPE::Insert(const KeyType &key, const ValueType &valu
  * Remove half of key & value pairs from this page to "recipient" page
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveHalfTo(BPlusTreeLeafPage *recipient) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveHalfTo(BPlusTreeLeafPage *recipient) {
+  // 分裂后两半各自重新计算最紧凑的布局
+  int size = GetSize();
+  int start = size / 2;
+  std::vector<MappingType> items;
+  items.reserve(size);
+  entries_.Decode(data_, 0, size, &items);
+  recipient->CopyNFrom(items.data() + start, size - start);
+  entries_.Rebuild(data_, items.data(), start);
+  SetSize(start);
+}
 
 /*
  * Copy starting from items, and copy {size} number of elements into me.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyNFrom(MappingType *items, int size) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyNFrom(const MappingType *items, int size) {
+  std::vector<MappingType> merged;
+  merged.reserve(GetSize() + size);
+  entries_.Decode(data_, 0, GetSize(), &merged);
+  merged.insert(merged.end(), items, items + size);
+  entries_.Rebuild(data_, merged.data(), static_cast<int>(merged.size()));
+  IncreaseSize(size);
+}
 
 /*****************************************************************************
  * LOOKUP
@@ -103,6 +204,11 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyNFrom(MappingType *items, int size) {}
  */
 INDEX_TEMPLATE_ARGUMENTS
 bool B_PLUS_TREE_LEAF_PAGE_TYPE::Lookup(const KeyType &key, ValueType *value, const KeyComparator &comparator) const {
+  int index = KeyIndex(key, comparator);
+  if (index < ReadableSize() && comparator(KeyAt(index), key) == 0) {
+    *value = entries_.ValueAt(data_, index);
+    return true;
+  }
   return false;
 }
 
@@ -116,7 +222,16 @@ bool B_PLUS_TREE_LEAF_PAGE_TYPE::Lookup(const KeyType &key, ValueType *value, co
  * @return   page size after deletion
  */
 INDEX_TEMPLATE_ARGUMENTS
-int B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAndDeleteRecord(const KeyType &key, const KeyComparator &comparator) { return 0; }
+int B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAndDeleteRecord(const KeyType &key, const KeyComparator &comparator) {
+  int size = GetSize();
+  int index = KeyIndex(key, comparator);
+  if (index < size && comparator(KeyAt(index), key) == 0) {
+    entries_.Remove(data_, size, index);
+    IncreaseSize(-1);
+    return size - 1;
+  }
+  return size;
+}
 
 /*****************************************************************************
  * MERGE
@@ -126,7 +241,14 @@ int B_PLUS_TREE_LEAF_PAGE_TYPE::RemoveAndDeleteRecord(const KeyType &key, const
  * to update the next_page id in the sibling page
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveAllTo(BPlusTreeLeafPage *recipient) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveAllTo(BPlusTreeLeafPage *recipient) {
+  std::vector<MappingType> items;
+  items.reserve(GetSize());
+  entries_.Decode(data_, 0, GetSize(), &items);
+  recipient->CopyNFrom(items.data(), GetSize());
+  recipient->SetNextPageId(GetNextPageId());
+  SetSize(0);
+}
 
 /*****************************************************************************
  * REDISTRIBUTE
@@ -135,29 +257,47 @@ void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveAllTo(BPlusTreeLeafPage *recipient) {}
  * Remove the first key & value pair from this page to "recipient" page.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeLeafPage *recipient) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveFirstToEndOf(BPlusTreeLeafPage *recipient) {
+  recipient->CopyLastFrom(GetItem(0));
+  entries_.Remove(data_, GetSize(), 0);
+  IncreaseSize(-1);
+}
 
 /*
  * Copy the item into the end of my item list. (Append item to my array)
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyLastFrom(const MappingType &item) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyLastFrom(const MappingType &item) {
+  entries_.Insert(data_, GetSize(), GetSize(), item.first, item.second);
+  IncreaseSize(1);
+}
 
 /*
  * Remove the last key & value pair from this page to "recipient" page.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeLeafPage *recipient) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::MoveLastToFrontOf(BPlusTreeLeafPage *recipient) {
+  recipient->CopyFirstFrom(GetItem(GetSize() - 1));
+  IncreaseSize(-1);
+}
 
 /*
  * Insert item at the front of my items. Move items accordingly.
  */
 INDEX_TEMPLATE_ARGUMENTS
-void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyFirstFrom(const MappingType &item) {}
+void B_PLUS_TREE_LEAF_PAGE_TYPE::CopyFirstFrom(const MappingType &item) {
+  entries_.Insert(data_, GetSize(), 0, item.first, item.second);
+  IncreaseSize(1);
+}
 
 template class BPlusTreeLeafPage<GenericKey<4>, RID, GenericComparator<4>>;
 template class BPlusTreeLeafPage<GenericKey<8>, RID, GenericComparator<8>>;
 template class BPlusTreeLeafPage<GenericKey<16>, RID, GenericComparator<16>>;
 template class BPlusTreeLeafPage<GenericKey<32>, RID, GenericComparator<32>>;
 template class BPlusTreeLeafPage<GenericKey<64>, RID, GenericComparator<64>>;
+// (key, rid) entries of a BPlusTreeIndex, see BPlusTreeEntryKey
+template class BPlusTreeLeafPage<GenericKey<12>, RID, GenericComparator<12>>;
+template class BPlusTreeLeafPage<GenericKey<24>, RID, GenericComparator<24>>;
+template class BPlusTreeLeafPage<GenericKey<40>, RID, GenericComparator<40>>;
+template class BPlusTreeLeafPage<GenericKey<72>, RID, GenericComparator<72>>;
 }  // namespace bustub
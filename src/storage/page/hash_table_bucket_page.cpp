@@ -63,29 +63,19 @@ bool HASH_TABLE_BUCKET_TYPE::Insert(KeyType key, ValueType value, KeyComparator
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
 bool HASH_TABLE_BUCKET_TYPE::Remove(KeyType key, ValueType value, KeyComparator cmp) {
-  size_t count = 0;
   size_t size = this->Size();
   for(size_t bucket_idx = 0; bucket_idx < size; bucket_idx++){
-    if(!this->IsOccupied(bucket_idx)) {
-      break;
-    }else if(cmp(this->array_[bucket_idx].first, key) == 0 && this->array_[bucket_idx].second == value && this->IsReadable(bucket_idx)) {
-      count++;
-      if(size == 1) {
-        this->SetNonReadable(0);
-        this->SetNonOccupied(0);
-      }else{
-        // 不考虑效率，将后面的元素进行前移
-        for(size_t x = bucket_idx; x < size - 1; x++) {
-          this->array_[x] = this->array_[x+1];
-          this->SetOccupied(x);
-          this->SetReadable(x);
-          this->SetNonOccupied(x+1);
-          this->SetNonReadable(x+1);
-        }
+    if(cmp(this->array_[bucket_idx].first, key) == 0 && this->array_[bucket_idx].second == value && this->IsReadable(bucket_idx)) {
+      // 不考虑效率，将后面的元素进行前移, 并清除最后一个插槽
+      for(size_t x = bucket_idx; x + 1 < size; x++) {
+        this->array_[x] = this->array_[x+1];
       }
+      this->SetNonOccupied(size - 1);
+      this->SetNonReadable(size - 1);
+      return true;
     }
   }
-  return count > 0;
+  return false;
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
@@ -101,13 +91,14 @@ ValueType HASH_TABLE_BUCKET_TYPE::ValueAt(uint32_t bucket_idx) const {
 template <typename KeyType, typename ValueType, typename KeyComparator>
 void HASH_TABLE_BUCKET_TYPE::RemoveAt(uint32_t bucket_idx) {
   size_t size = this->Size();
-  for(size_t x = bucket_idx; x < size - 1; x++) {
+  if(bucket_idx >= size) {
+    return;
+  }
+  for(size_t x = bucket_idx; x + 1 < size; x++) {
     this->array_[x] = this->array_[x+1];
-    this->SetOccupied(x);
-    this->SetReadable(x);
-    this->SetNonOccupied(x+1);
-    this->SetNonReadable(x+1);
   }
+  this->SetNonOccupied(size - 1);
+  this->SetNonReadable(size - 1);
 }
 
 template <typename KeyType, typename ValueType, typename KeyComparator>
@@ -50,9 +50,21 @@ void HashTableDirectoryPage::SetBucketPageId(uint32_t bucket_idx, page_id_t buck
   this->bucket_page_ids_[bucket_idx] = bucket_page_id;
 }
 
-uint32_t HashTableDirectoryPage::Size() { return 0; }
+uint32_t HashTableDirectoryPage::Size() { return 1U << this->global_depth_; }
 
-bool HashTableDirectoryPage::CanShrink() { return false; }
+bool HashTableDirectoryPage::CanShrink() {
+  if(this->global_depth_ == 0) {
+    return false;
+  }
+  // 所有 bucket 的 local depth 都小于 global depth 时, 后一半插槽与前一半完全相同
+  uint32_t size = this->Size();
+  for(uint32_t i = 0; i < size; i++) {
+    if(this->local_depths_[i] >= this->global_depth_) {
+      return false;
+    }
+  }
+  return true;
+}
 
 uint32_t HashTableDirectoryPage::GetLocalDepth(uint32_t bucket_idx) { 
   return (uint32_t)this->local_depths_[bucket_idx];
@@ -79,7 +91,14 @@ void HashTableDirectoryPage::DecrLocalDepth(uint32_t bucket_idx) {
   this->local_depths_[bucket_idx] -= 1;
 }
 
-uint32_t HashTableDirectoryPage::GetLocalHighBit(uint32_t bucket_idx) { return 0; }
+uint32_t HashTableDirectoryPage::GetLocalHighBit(uint32_t bucket_idx) {
+  uint32_t local_depth = this->GetLocalDepth(bucket_idx);
+  return local_depth == 0 ? 0 : 1U << (local_depth - 1);
+}
+
+uint32_t HashTableDirectoryPage::GetSplitImageIndex(uint32_t bucket_idx) {
+  return bucket_idx ^ this->GetLocalHighBit(bucket_idx);
+}
 
 /**
  * VerifyIntegrity - Use this for debugging but **DO NOT CHANGE**
@@ -10,7 +10,10 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
 #include <cassert>
+#include <numeric>
+#include <vector>
 
 #include "common/logger.h"
 #include "storage/table/table_heap.h"
@@ -170,6 +173,68 @@ bool TableHeap::GetTuple(const RID &rid, Tuple *tuple, Transaction *txn) {
   return res;
 }
 
+void TableHeap::GetTuples(const std::vector<RID> &rids, std::vector<Tuple> *tuples, std::vector<bool> *found,
+                          Transaction *txn) {
+  tuples->assign(rids.size(), Tuple());
+  found->assign(rids.size(), false);
+  // 按照页号排序后同一页上的元组相邻, 每个页面只需要获取一次
+  std::vector<size_t> order(rids.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&rids](size_t lhs, size_t rhs) {
+    return rids[lhs].GetPageId() != rids[rhs].GetPageId() ? rids[lhs].GetPageId() < rids[rhs].GetPageId()
+                                                          : rids[lhs].GetSlotNum() < rids[rhs].GetSlotNum();
+  });
+  for (size_t begin = 0; begin < order.size();) {
+    page_id_t page_id = rids[order[begin]].GetPageId();
+    size_t end = begin;
+    while (end < order.size() && rids[order[end]].GetPageId() == page_id) {
+      end++;
+    }
+    auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    if (page == nullptr) {
+      txn->SetState(TransactionState::ABORTED);
+      return;
+    }
+    page->RLatch();
+    for (size_t i = begin; i < end; i++) {
+      (*found)[order[i]] = page->GetTuple(rids[order[i]], &(*tuples)[order[i]], txn, lock_manager_);
+    }
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    begin = end;
+  }
+}
+
+size_t TableHeap::ScanTuples(RID *position, size_t max_count,
+                             const std::function<void(const char *, const RID &)> &visit, Transaction *txn) {
+  size_t count = 0;
+  while (position->GetPageId() != INVALID_PAGE_ID && count < max_count) {
+    page_id_t page_id = position->GetPageId();
+    auto page = static_cast<TablePage *>(buffer_pool_manager_->FetchPage(page_id));
+    if (page == nullptr) {
+      txn->SetState(TransactionState::ABORTED);
+      return count;
+    }
+    // 每个页面只获取并加锁一次, 元组直接在页面上解码
+    page->RLatch();
+    uint32_t slot = position->GetSlotNum();
+    uint32_t slot_count = page->GetSlotCount();
+    for (; slot < slot_count && count < max_count; slot++) {
+      RID rid(page_id, slot);
+      const char *data;
+      if (page->GetTupleData(rid, &data, txn, lock_manager_)) {
+        visit(data, rid);
+        count++;
+      }
+    }
+    page_id_t next_page_id = page->GetNextPageId();
+    page->RUnlatch();
+    buffer_pool_manager_->UnpinPage(page_id, false);
+    *position = slot < slot_count ? RID(page_id, slot) : RID(next_page_id, 0);
+  }
+  return count;
+}
+
 TableIterator TableHeap::Begin(Transaction *txn) {
   // Start an iterator from the first page.
   // TODO(Wuwen): Hacky fix for now. Removing empty pages is a better way to handle this.
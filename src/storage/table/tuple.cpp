@@ -25,9 +25,11 @@ Tuple::Tuple(std::vector<Value> values, const Schema *schema) : allocated_(true)
   assert(values.size() == schema->GetColumnCount());
 
   // 1. Calculate the size of the tuple.
+  // A NULL varlen is serialized as its length field alone, its length is BUSTUB_VALUE_NULL rather than 0.
+  auto varlen_size = [](const Value &value) { return value.IsNull() ? 0 : value.GetLength(); };
   uint32_t tuple_size = schema->GetLength();
   for (auto &i : schema->GetUnlinedColumns()) {
-    tuple_size += (values[i].GetLength() + sizeof(uint32_t));
+    tuple_size += (varlen_size(values[i]) + sizeof(uint32_t));
   }
 
   // 2. Allocate memory.
@@ -46,7 +48,7 @@ Tuple::Tuple(std::vector<Value> values, const Schema *schema) : allocated_(true)
       *reinterpret_cast<uint32_t *>(data_ + col.GetOffset()) = offset;
       // Serialize varchar value, in place (size+data).
       values[i].SerializeTo(data_ + offset);
-      offset += (values[i].GetLength() + sizeof(uint32_t));
+      offset += (varlen_size(values[i]) + sizeof(uint32_t));
     } else {
       values[i].SerializeTo(data_ + col.GetOffset());
     }
@@ -87,6 +89,30 @@ Tuple &Tuple::operator=(const Tuple &other) {
   return *this;
 }
 
+Tuple::Tuple(Tuple &&other) noexcept
+    : allocated_(other.allocated_), rid_(other.rid_), size_(other.size_), data_(other.data_) {
+  other.allocated_ = false;
+  other.size_ = 0;
+  other.data_ = nullptr;
+}
+
+Tuple &Tuple::operator=(Tuple &&other) noexcept {
+  if (this == &other) {
+    return *this;
+  }
+  if (allocated_) {
+    delete[] data_;
+  }
+  allocated_ = other.allocated_;
+  rid_ = other.rid_;
+  size_ = other.size_;
+  data_ = other.data_;
+  other.allocated_ = false;
+  other.size_ = 0;
+  other.data_ = nullptr;
+  return *this;
+}
+
 Value Tuple::GetValue(const Schema *schema, const uint32_t column_idx) const {
   assert(schema);
   assert(data_);
@@ -99,8 +125,11 @@ Value Tuple::GetValue(const Schema *schema, const uint32_t column_idx) const {
 Tuple Tuple::KeyFromTuple(const Schema &schema, const Schema &key_schema, const std::vector<uint32_t> &key_attrs) {
   std::vector<Value> values;
   values.reserve(key_attrs.size());
-  for (auto idx : key_attrs) {
-    values.emplace_back(this->GetValue(&schema, idx));
+  for (uint32_t i = 0; i < key_attrs.size(); i++) {
+    Value value = this->GetValue(&schema, key_attrs[i]);
+    // 键的列类型可能与表中的列不同, 例如用 BIGINT 索引 INTEGER 列
+    TypeId key_type = key_schema.GetColumn(i).GetType();
+    values.emplace_back(value.GetTypeId() == key_type ? value : value.CastAs(key_type));
   }
   return Tuple(values, &key_schema);
 }
@@ -11,9 +11,11 @@
 //===----------------------------------------------------------------------===//
 
 #include "buffer/buffer_pool_manager_instance.h"
+#include <chrono>  // NOLINT
 #include <cstdio>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
 #include "buffer/buffer_pool_manager.h"
 #include "gtest/gtest.h"
 
@@ -139,4 +141,52 @@ TEST(BufferPoolManagerInstanceTest, SampleTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, PrefetchTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 4;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  page_id_t page_id;
+  auto *page = bpm->NewPage(&page_id);
+  snprintf(page->GetData(), PAGE_SIZE, "Hello");
+  EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+
+  // 预取提示在后台把页面读进空闲的帧, 但不会 Pin 住它
+  auto find_frame = [&](page_id_t target) -> Page * {
+    for (size_t i = 0; i < buffer_pool_size; i++) {
+      if (bpm->GetPages()[i].GetPageId() == target) {
+        return &bpm->GetPages()[i];
+      }
+    }
+    return nullptr;
+  };
+  bpm->PrefetchPage(page_id);
+  Page *frame = nullptr;
+  for (int i = 0; i < 1000 && frame == nullptr; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    frame = find_frame(page_id);
+  }
+  ASSERT_NE(nullptr, frame);
+  EXPECT_EQ(0, frame->GetPinCount());
+  EXPECT_EQ(frame, bpm->FetchPage(page_id));
+  EXPECT_EQ(0, strcmp(frame->GetData(), "Hello"));
+  EXPECT_TRUE(bpm->UnpinPage(page_id, false));
+
+  // 预取进来的页面没有被 Pin, 缓冲池仍然可以全部用于新页面
+  bpm->PrefetchPage(page_id);
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  for (size_t i = 0; i < buffer_pool_size; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+
+  delete bpm;
+  delete disk_manager;
+}
+
 }  // namespace bustub
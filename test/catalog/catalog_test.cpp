@@ -688,4 +688,74 @@ TEST(CatalogTest, DISABLED_IndexInteraction3) {
   remove("catalog_test.log");
 }
 
+// Every index type should be populated from the table heap, and only the B+ tree should answer range scans
+TEST(CatalogTest, CreateIndexTypes) {
+  auto disk_manager = std::make_unique<DiskManager>("catalog_test.db");
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(64, disk_manager.get());
+  auto catalog = std::make_unique<Catalog>(bpm.get(), nullptr, nullptr);
+  auto txn = std::make_unique<Transaction>(0);
+
+  const std::string table_name{"foobar"};
+  std::vector<Column> columns{{"A", TypeId::BIGINT}};
+  Schema table_schema{columns};
+  auto *table_info = catalog->CreateTable(txn.get(), table_name, table_schema);
+  ASSERT_NE(Catalog::NULL_TABLE_INFO, table_info);
+
+  // Insert the keys in descending order so the B+ tree has to sort them before loading
+  const int64_t num_keys = 500;
+  for (int64_t i = num_keys - 1; i >= 0; i--) {
+    Tuple tuple{std::vector<Value>{ValueFactory::GetBigIntValue(i)}, &table_schema};
+    RID rid{};
+    ASSERT_TRUE(table_info->table_->InsertTuple(tuple, &rid, txn.get()));
+  }
+
+  std::vector<Column> key_columns{{"A", TypeId::BIGINT}};
+  std::vector<uint32_t> key_attrs{0};
+  Schema key_schema{key_columns};
+  auto make_key = [&](int64_t v) {
+    Tuple tuple{std::vector<Value>{ValueFactory::GetBigIntValue(v)}, &table_schema};
+    return tuple.KeyFromTuple(table_schema, key_schema, key_attrs);
+  };
+
+  const std::vector<std::pair<std::string, IndexType>> index_types{{"ext_hash", IndexType::EXTENDIBLE_HASH},
+                                                                   {"btree", IndexType::BPLUS_TREE},
+                                                                   {"linear_hash", IndexType::LINEAR_PROBE_HASH}};
+  for (const auto &[index_name, index_type] : index_types) {
+    auto *index_info = catalog->CreateIndex<BigintKeyType, BigintValueType, BigintComparatorType>(
+        txn.get(), index_name, table_name, table_schema, key_schema, key_attrs, BIGINT_SIZE, BigintHashFunctionType{},
+        index_type);
+    ASSERT_NE(Catalog::NULL_INDEX_INFO, index_info);
+    EXPECT_EQ(index_type, index_info->index_type_);
+    auto *index = index_info->index_.get();
+
+    // Every key in the table should be found, and point at a tuple holding that key
+    for (int64_t i = 0; i < num_keys; i++) {
+      std::vector<RID> results{};
+      index->ScanKey(make_key(i), &results, txn.get());
+      ASSERT_EQ(1, results.size()) << index_name << " key " << i;
+      Tuple tuple{};
+      ASSERT_TRUE(table_info->table_->GetTuple(results[0], &tuple, txn.get()));
+      EXPECT_EQ(i, tuple.GetValue(&table_schema, 0).GetAs<int64_t>());
+    }
+
+    EXPECT_EQ(index_type == IndexType::BPLUS_TREE, index->SupportsRangeScan());
+  }
+
+  // Range scans on the B+ tree come back in key order
+  auto *btree = catalog->GetIndex("btree", table_name)->index_.get();
+  const Tuple low = make_key(100);
+  const Tuple high = make_key(199);
+  std::vector<RID> results{};
+  btree->ScanRange(&low, &high, &results, txn.get());
+  ASSERT_EQ(100, results.size());
+  for (size_t i = 0; i < results.size(); i++) {
+    Tuple tuple{};
+    ASSERT_TRUE(table_info->table_->GetTuple(results[i], &tuple, txn.get()));
+    EXPECT_EQ(static_cast<int64_t>(100 + i), tuple.GetValue(&table_schema, 0).GetAs<int64_t>());
+  }
+
+  remove("catalog_test.db");
+  remove("catalog_test.log");
+}
+
 }  // namespace bustub
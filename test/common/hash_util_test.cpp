@@ -0,0 +1,155 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// hash_util_test.cpp
+//
+// Identification: test/common/hash_util_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "common/util/hash_util.h"
+#include "gtest/gtest.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+// The byte-at-a-time hash HashUtil used before, kept for the benchmark below.
+static hash_t LegacyHashBytes(const char *bytes, size_t length) {
+  hash_t hash = length;
+  for (size_t i = 0; i < length; ++i) {
+    hash = ((hash << 5) ^ (hash >> 27)) ^ bytes[i];
+  }
+  return hash;
+}
+
+// Checks that the given bits of the hash spread n sequential keys evenly over 2^bits buckets.
+static void CheckDistribution(const std::vector<hash_t> &hashes, uint32_t shift, uint32_t bits) {
+  std::vector<uint32_t> buckets(1U << bits, 0);
+  for (hash_t hash : hashes) {
+    buckets[(hash >> shift) & ((1U << bits) - 1)]++;
+  }
+  double expected = static_cast<double>(hashes.size()) / buckets.size();
+  double chi_square = 0;
+  for (uint32_t count : buckets) {
+    chi_square += (count - expected) * (count - expected) / expected;
+  }
+  // for a uniform hash chi_square ~ N(k, 2k) with k = #buckets
+  double k = buckets.size();
+  EXPECT_LT(chi_square, k + 6 * std::sqrt(2 * k)) << "shift " << shift;
+  EXPECT_LT(*std::max_element(buckets.begin(), buckets.end()), 2 * expected) << "shift " << shift;
+}
+
+// NOLINTNEXTLINE
+TEST(HashUtilTest, SequentialIntegerDistributionTest) {
+  const int num_keys = 1 << 20;
+  std::vector<hash_t> hashes;
+  hashes.reserve(num_keys);
+  for (int i = 0; i < num_keys; i++) {
+    Value val = ValueFactory::GetIntegerValue(i);
+    hashes.push_back(HashUtil::HashValue(&val));
+  }
+
+  // no full collisions
+  std::unordered_set<hash_t> unique(hashes.begin(), hashes.end());
+  EXPECT_EQ(num_keys, unique.size());
+
+  // low bits are used by the extendible hash directory, high bits by partitioning
+  CheckDistribution(hashes, 0, 12);
+  CheckDistribution(hashes, 20, 12);
+  CheckDistribution(hashes, 52, 12);
+}
+
+// NOLINTNEXTLINE
+TEST(HashUtilTest, HashValueConsistencyTest) {
+  // integer types of different widths hash the same when they hold the same value
+  Value tiny = ValueFactory::GetTinyIntValue(42);
+  Value small = ValueFactory::GetSmallIntValue(42);
+  Value integer = ValueFactory::GetIntegerValue(42);
+  Value big = ValueFactory::GetBigIntValue(42);
+  EXPECT_EQ(HashUtil::HashValue(&integer), HashUtil::HashValue(&tiny));
+  EXPECT_EQ(HashUtil::HashValue(&integer), HashUtil::HashValue(&small));
+  EXPECT_EQ(HashUtil::HashValue(&integer), HashUtil::HashValue(&big));
+
+  Value str1 = ValueFactory::GetVarcharValue("hello world");
+  Value str2 = ValueFactory::GetVarcharValue("hello world");
+  Value str3 = ValueFactory::GetVarcharValue("hello worle");
+  EXPECT_EQ(HashUtil::HashValue(&str1), HashUtil::HashValue(&str2));
+  EXPECT_NE(HashUtil::HashValue(&str1), HashUtil::HashValue(&str3));
+
+  // every length bucket of HashBytes, each byte must matter
+  std::string data(200, 'x');
+  for (size_t len = 0; len <= data.size(); len++) {
+    hash_t hash = HashUtil::HashBytes(data.data(), len);
+    for (size_t pos = 0; pos < len; pos++) {
+      std::string copy = data.substr(0, len);
+      copy[pos] = 'y';
+      EXPECT_NE(hash, HashUtil::HashBytes(copy.data(), len)) << "len " << len << " pos " << pos;
+    }
+  }
+
+  EXPECT_NE(HashUtil::CombineHashes(1, 2), HashUtil::CombineHashes(2, 1));
+
+  // Hash<T> sign extends like HashValue, so a negative number hashes the same at every width
+  int8_t neg_tiny = -7;
+  int32_t neg_integer = -7;
+  Value neg_value = ValueFactory::GetBigIntValue(-7);
+  EXPECT_EQ(HashUtil::Hash(&neg_tiny), HashUtil::Hash(&neg_integer));
+  EXPECT_EQ(HashUtil::Hash(&neg_integer), HashUtil::HashValue(&neg_value));
+
+  // 0.0 = -0.0, so they must hash the same
+  Value zero = ValueFactory::GetDecimalValue(0.0);
+  Value neg_zero = ValueFactory::GetDecimalValue(-0.0);
+  EXPECT_EQ(HashUtil::HashValue(&zero), HashUtil::HashValue(&neg_zero));
+}
+
+// Hashing throughput, run with --gtest_also_run_disabled_tests.
+// NOLINTNEXTLINE
+TEST(HashUtilTest, DISABLED_BenchmarkTest) {
+  using clock = std::chrono::steady_clock;
+  const size_t total_bytes = 1 << 28;
+  for (size_t len : {4, 8, 16, 32, 64, 256, 4096}) {
+    std::string data(len, 'a');
+    for (size_t i = 0; i < len; i++) {
+      data[i] = static_cast<char>(i * 31);
+    }
+    size_t iters = total_bytes / len;
+    hash_t sink = 0;
+    auto start = clock::now();
+    for (size_t i = 0; i < iters; i++) {
+      data[0] = static_cast<char>(i);
+      sink ^= LegacyHashBytes(data.data(), len);
+    }
+    auto mid = clock::now();
+    for (size_t i = 0; i < iters; i++) {
+      data[0] = static_cast<char>(i);
+      sink ^= HashUtil::HashBytes(data.data(), len);
+    }
+    auto end = clock::now();
+    double legacy = total_bytes / std::chrono::duration<double>(mid - start).count() / (1 << 20);
+    double current = total_bytes / std::chrono::duration<double>(end - mid).count() / (1 << 20);
+    printf("len %5zu  legacy %9.1f MB/s  HashBytes %9.1f MB/s  (%zu)\n", len, legacy, current, sink & 1);
+  }
+
+  const uint64_t num_ints = 1 << 26;
+  hash_t sink = 0;
+  auto start = clock::now();
+  for (uint64_t i = 0; i < num_ints; i++) {
+    sink ^= HashUtil::HashInt(i);
+  }
+  auto end = clock::now();
+  printf("HashInt %.1f Mkeys/s (%zu)\n", num_ints / std::chrono::duration<double>(end - start).count() / 1e6,
+         sink & 1);
+}
+
+}  // namespace bustub
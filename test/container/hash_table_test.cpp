@@ -10,7 +10,10 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <chrono>  // NOLINT
+#include <cstdio>
 #include <thread>  // NOLINT
+#include <unordered_map>
 #include <vector>
 
 #include "buffer/buffer_pool_manager_instance.h"
@@ -152,4 +155,273 @@ TEST(HASH_TABLE_TEST, ADVANCED_TEST) {
 
 }
 
+// NOLINTNEXTLINE
+TEST(HashTableTest, BatchGetValueTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  for (int i = 0; i < 2000; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+  }
+  EXPECT_TRUE(ht.Insert(nullptr, 7, 70));
+
+  // 批量查询, 包括重复的 key 和不存在的 key
+  std::vector<int> keys;
+  for (int i = 3000; i >= -100; i -= 7) {
+    keys.push_back(i);
+  }
+  keys.push_back(7);
+  keys.push_back(7);
+
+  std::vector<std::vector<int>> results;
+  EXPECT_TRUE(ht.GetValues(nullptr, keys, &results));
+  ASSERT_EQ(keys.size(), results.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    std::vector<int> expected;
+    ht.GetValue(nullptr, keys[i], &expected);
+    EXPECT_EQ(expected, results[i]) << "Mismatch for key " << keys[i];
+  }
+  EXPECT_EQ(2, results.back().size());
+
+  std::vector<int> missing{-1, -2, 5000};
+  EXPECT_FALSE(ht.GetValues(nullptr, missing, &results));
+  ASSERT_EQ(3, results.size());
+  for (const auto &res : results) {
+    EXPECT_TRUE(res.empty());
+  }
+
+  ht.VerifyIntegrity();
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, PinnedModeTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(100, disk_manager);
+  page_id_t directory_page_id;
+  uint32_t global_depth;
+  {
+    ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>(), true);
+
+    // 插入足够多的数据触发分裂, 分裂出来的 bucket 同样常驻内存
+    for (int i = 0; i < 5000; i++) {
+      EXPECT_TRUE(ht.Insert(nullptr, i, i));
+    }
+    EXPECT_FALSE(ht.Insert(nullptr, 42, 42));
+    for (int i = 0; i < 5000; i++) {
+      std::vector<int> res;
+      ht.GetValue(nullptr, i, &res);
+      ASSERT_EQ(1, res.size()) << "Failed to keep " << i;
+      EXPECT_EQ(i, res[0]);
+    }
+    for (int i = 0; i < 5000; i += 2) {
+      EXPECT_TRUE(ht.Remove(nullptr, i, i));
+    }
+    for (int i = 0; i < 5000; i++) {
+      std::vector<int> res;
+      EXPECT_EQ(i % 2 == 1, ht.GetValue(nullptr, i, &res));
+    }
+    ht.VerifyIntegrity();
+    global_depth = ht.GetGlobalDepth();
+    EXPECT_GT(global_depth, 0);
+
+    // 常驻的页面可以通过正常的刷盘路径持久化
+    HashTableDirectoryPage *dir_page = ht.GetDirPage();
+    directory_page_id = dir_page->GetPageId();
+    bpm->FlushAllPages();
+    char data[PAGE_SIZE];
+    disk_manager->ReadPage(directory_page_id, data);
+    EXPECT_EQ(global_depth, reinterpret_cast<HashTableDirectoryPage *>(data)->GetGlobalDepth());
+  }
+
+  // 析构后所有的 Pin 都被释放, 缓冲池可以重新分配全部的帧
+  std::vector<page_id_t> page_ids(100);
+  for (auto &page_id : page_ids) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// A memory-resident table reports an exhausted buffer pool instead of failing inserts silently
+// NOLINTNEXTLINE
+TEST(HashTableTest, PinnedModeExhaustedPoolTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(4, disk_manager);
+  {
+    ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>(), true);
+    // 4 个帧最多容纳目录和 3 个 bucket, 之后的分裂没有空闲帧
+    bool thrown = false;
+    int inserted = 0;
+    for (int i = 0; i < 5000 && !thrown; i++) {
+      try {
+        EXPECT_TRUE(ht.Insert(nullptr, i, i));
+        inserted++;
+      } catch (Exception &e) {
+        EXPECT_EQ(ExceptionType::OUT_OF_MEMORY, e.GetType());
+        thrown = true;
+      }
+    }
+    EXPECT_TRUE(thrown);
+    // 抛出异常后表锁已释放, 已插入的数据仍然可读
+    for (int i = 0; i < inserted; i++) {
+      std::vector<int> res;
+      EXPECT_TRUE(ht.GetValue(nullptr, i, &res));
+    }
+    ht.VerifyIntegrity();
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, MergeShrinkTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(100, disk_manager);
+  {
+    ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>(), true);
+    for (int i = 0; i < 5000; i++) {
+      EXPECT_TRUE(ht.Insert(nullptr, i, i));
+    }
+    EXPECT_GT(ht.GetGlobalDepth(), 2);
+
+    // 删除全部数据后, 空 bucket 递归合并, directory 收缩回深度 0
+    for (int i = 0; i < 5000; i++) {
+      EXPECT_TRUE(ht.Remove(nullptr, i, i));
+      if (i % 500 == 0) {
+        ht.VerifyIntegrity();
+      }
+    }
+    ht.VerifyIntegrity();
+    EXPECT_EQ(0, ht.GetGlobalDepth());
+
+    // 被合并掉的 bucket 页已经释放, 只剩 directory 和一个 bucket 被 Pin 住
+    std::vector<page_id_t> page_ids(98);
+    for (auto &page_id : page_ids) {
+      EXPECT_NE(nullptr, bpm->NewPage(&page_id));
+    }
+    for (auto page_id : page_ids) {
+      bpm->UnpinPage(page_id, false);
+    }
+
+    for (int i = 0; i < 100; i++) {
+      EXPECT_TRUE(ht.Insert(nullptr, i, i));
+    }
+    std::vector<int> res;
+    EXPECT_TRUE(ht.GetValue(nullptr, 99, &res));
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, CompactTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+
+  for (int i = 0; i < 10000; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+  }
+  uint32_t global_depth = ht.GetGlobalDepth();
+
+  // 只保留 1/20 的数据, 每个 bucket 都不为空, Remove 不会触发合并
+  for (int i = 0; i < 10000; i++) {
+    if (i % 20 != 0) {
+      EXPECT_TRUE(ht.Remove(nullptr, i, i));
+    }
+  }
+  EXPECT_EQ(global_depth, ht.GetGlobalDepth());
+
+  // 在后台线程中压缩, 同时进行查询
+  size_t freed = 0;
+  std::thread compactor([&] { freed = ht.Compact(nullptr); });
+  for (int i = 0; i < 10000; i += 20) {
+    std::vector<int> res;
+    EXPECT_TRUE(ht.GetValue(nullptr, i, &res));
+  }
+  compactor.join();
+
+  EXPECT_GT(freed, 0);
+  EXPECT_LT(ht.GetGlobalDepth(), global_depth);
+  ht.VerifyIntegrity();
+  for (int i = 0; i < 10000; i++) {
+    std::vector<int> res;
+    EXPECT_EQ(i % 20 == 0, ht.GetValue(nullptr, i, &res)) << "Mismatch for key " << i;
+  }
+  EXPECT_EQ(0, ht.Compact(nullptr));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(HashTableTest, DISABLED_BenchmarkTest) {
+  const int num_keys = 20000;
+  const int num_rounds = 20;
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(200, disk_manager);
+
+  auto bench = [&](const char *label, auto &&lookup) {
+    auto start = std::chrono::steady_clock::now();
+    size_t found = 0;
+    for (int round = 0; round < num_rounds; round++) {
+      for (int i = 0; i < num_keys; i++) {
+        found += lookup(i);
+      }
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    printf("%-16s %8.1f ns/lookup (found %zu)\n", label, elapsed / (num_keys * num_rounds), found);
+  };
+
+  {
+    ExtendibleHashTable<int, int, IntComparator> ht("buffered", bpm, IntComparator(), HashFunction<int>());
+    for (int i = 0; i < num_keys; i++) {
+      ht.Insert(nullptr, i, i);
+    }
+    bench("buffered", [&](int key) {
+      std::vector<int> res;
+      return static_cast<size_t>(ht.GetValue(nullptr, key, &res));
+    });
+  }
+  {
+    ExtendibleHashTable<int, int, IntComparator> ht("pinned", bpm, IntComparator(), HashFunction<int>(), true);
+    for (int i = 0; i < num_keys; i++) {
+      ht.Insert(nullptr, i, i);
+    }
+    bench("pinned", [&](int key) {
+      std::vector<int> res;
+      return static_cast<size_t>(ht.GetValue(nullptr, key, &res));
+    });
+  }
+  {
+    std::unordered_map<int, int> map;
+    for (int i = 0; i < num_keys; i++) {
+      map.emplace(i, i);
+    }
+    bench("unordered_map", [&](int key) { return map.count(key); });
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
 }  // namespace bustub
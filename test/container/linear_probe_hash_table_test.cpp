@@ -0,0 +1,261 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// linear_probe_hash_table_test.cpp
+//
+// Identification: test/container/linear_probe_hash_table_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "common/logger.h"
+#include "container/hash/extendible_hash_table.h"
+#include "container/hash/linear_probe_hash_table.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(LinearProbeHashTableTest, SampleTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 1000, HashFunction<int>());
+
+  // insert a few values
+  for (int i = 0; i < 5; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    EXPECT_EQ(1, res.size()) << "Failed to insert " << i << std::endl;
+    EXPECT_EQ(i, res[0]);
+  }
+
+  // insert one more value for each key
+  for (int i = 0; i < 5; i++) {
+    if (i == 0) {
+      // duplicate values for the same key are not allowed
+      EXPECT_FALSE(ht.Insert(nullptr, i, 2 * i));
+    } else {
+      EXPECT_TRUE(ht.Insert(nullptr, i, 2 * i));
+    }
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    if (i == 0) {
+      EXPECT_EQ(1, res.size());
+      EXPECT_EQ(i, res[0]);
+    } else {
+      EXPECT_EQ(2, res.size());
+    }
+  }
+
+  // look for a key that does not exist
+  std::vector<int> res;
+  ht.GetValue(nullptr, 20, &res);
+  EXPECT_EQ(0, res.size());
+
+  // delete some values
+  for (int i = 0; i < 5; i++) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i));
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    if (i == 0) {
+      EXPECT_EQ(0, res.size());
+    } else {
+      EXPECT_EQ(1, res.size());
+      EXPECT_EQ(2 * i, res[0]);
+    }
+  }
+  EXPECT_FALSE(ht.Remove(nullptr, 0, 0));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// NOLINTNEXTLINE
+TEST(LinearProbeHashTableTest, IncrementalResizeTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 10, HashFunction<int>());
+  size_t initial_size = ht.GetSize();
+
+  // 插入大量数据触发多次扩容, 扩容过程中的每一步都应当能读到所有数据
+  const int num_keys = 10000;
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_TRUE(ht.Insert(nullptr, i, i));
+    if (i % 97 == 0) {
+      for (int j = 0; j <= i; j += 13) {
+        std::vector<int> res;
+        ht.GetValue(nullptr, j, &res);
+        ASSERT_EQ(1, res.size()) << "Failed to keep " << j << " after inserting " << i;
+      }
+    }
+  }
+  EXPECT_GT(ht.GetSize(), initial_size);
+  EXPECT_LE(num_keys, ht.GetSize());
+
+  for (int i = 0; i < num_keys; i++) {
+    EXPECT_FALSE(ht.Insert(nullptr, i, i));
+  }
+
+  for (int i = 0; i < num_keys; i += 2) {
+    EXPECT_TRUE(ht.Remove(nullptr, i, i));
+  }
+  for (int i = 0; i < num_keys; i++) {
+    std::vector<int> res;
+    ht.GetValue(nullptr, i, &res);
+    EXPECT_EQ(i % 2, res.size()) << "Unexpected result for " << i;
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// A table with more blocks than a header page can list keeps them in directory pages
+// NOLINTNEXTLINE
+TEST(LinearProbeHashTableTest, DirectoryPagesTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  size_t slots_per_block = 4 * PAGE_SIZE / (4 * sizeof(std::pair<int, int>) + 1);
+  size_t num_buckets = (HashTableHeaderPage::MaxNumBlocks() + 100) * slots_per_block;
+  {
+    LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), num_buckets, HashFunction<int>());
+    EXPECT_LE(num_buckets, ht.GetSize());
+
+    const int num_keys = 20000;
+    for (int i = 0; i < num_keys; i++) {
+      EXPECT_TRUE(ht.Insert(nullptr, i, i));
+    }
+    for (int i = 0; i < num_keys; i += 2) {
+      EXPECT_TRUE(ht.Remove(nullptr, i, i));
+    }
+    for (int i = 0; i < num_keys; i++) {
+      std::vector<int> res;
+      ht.GetValue(nullptr, i, &res);
+      EXPECT_EQ(i % 2, res.size()) << "Unexpected result for " << i;
+    }
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// An insert that cannot allocate the next generation throws and leaves the table usable
+// NOLINTNEXTLINE
+TEST(LinearProbeHashTableTest, ExhaustedPoolResizeTest) {
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(5, disk_manager);
+  {
+    LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), 10, HashFunction<int>());
+    size_t size = ht.GetSize();
+    // 插入到下一次插入就会触发扩容为止
+    int num_keys = static_cast<int>(LinearProbeHashTable<int, int, IntComparator>::MAX_LOAD_FACTOR * size);
+    for (int i = 0; i < num_keys; i++) {
+      EXPECT_TRUE(ht.Insert(nullptr, i, i));
+    }
+
+    // 只留下一个空闲帧, 新一代的头页能分配而 block 不能
+    std::vector<page_id_t> pinned(4);
+    for (auto &page_id : pinned) {
+      ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    }
+    bool thrown = false;
+    try {
+      ht.Insert(nullptr, num_keys, num_keys);
+    } catch (Exception &e) {
+      EXPECT_EQ(ExceptionType::OUT_OF_MEMORY, e.GetType());
+      thrown = true;
+    }
+    EXPECT_TRUE(thrown);
+    EXPECT_EQ(size, ht.GetSize());
+    for (auto page_id : pinned) {
+      bpm->UnpinPage(page_id, false);
+    }
+
+    // 抛出异常后表锁已释放, 扩容可以重新开始
+    EXPECT_TRUE(ht.Insert(nullptr, num_keys, num_keys));
+    EXPECT_LT(size, ht.GetSize());
+    for (int i = 0; i <= num_keys; i++) {
+      std::vector<int> res;
+      ht.GetValue(nullptr, i, &res);
+      EXPECT_EQ(1, res.size()) << "Failed to keep " << i;
+    }
+  }
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+// Throughput comparison against the extendible hash table.
+// Run with --gtest_also_run_disabled_tests.
+// NOLINTNEXTLINE
+TEST(LinearProbeHashTableTest, DISABLED_BenchmarkTest) {
+  const int num_keys = 50000;
+  const double load_factors[] = {0.25, 0.5, 0.7};
+  using clock = std::chrono::steady_clock;
+  auto ops_per_sec = [](clock::time_point start, clock::time_point end, int ops) {
+    return ops / std::chrono::duration<double>(end - start).count();
+  };
+
+  for (double load_factor : load_factors) {
+    auto *disk_manager = new DiskManager("test.db");
+    auto *bpm = new BufferPoolManagerInstance(1000, disk_manager);
+    LinearProbeHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(),
+                                                     static_cast<size_t>(num_keys / load_factor), HashFunction<int>());
+    auto start = clock::now();
+    for (int i = 0; i < num_keys; i++) {
+      ht.Insert(nullptr, i, i);
+    }
+    auto mid = clock::now();
+    std::vector<int> res;
+    for (int i = 0; i < num_keys; i++) {
+      res.clear();
+      ht.GetValue(nullptr, i, &res);
+    }
+    auto end = clock::now();
+    printf("linear probe  lf=%.2f insert %12.0f ops/s  lookup %12.0f ops/s\n", load_factor,
+           ops_per_sec(start, mid, num_keys), ops_per_sec(mid, end, num_keys));
+    disk_manager->ShutDown();
+    remove("test.db");
+    delete disk_manager;
+    delete bpm;
+  }
+
+  auto *disk_manager = new DiskManager("test.db");
+  auto *bpm = new BufferPoolManagerInstance(1000, disk_manager);
+  ExtendibleHashTable<int, int, IntComparator> ht("blah", bpm, IntComparator(), HashFunction<int>());
+  auto start = clock::now();
+  for (int i = 0; i < num_keys; i++) {
+    ht.Insert(nullptr, i, i);
+  }
+  auto mid = clock::now();
+  std::vector<int> res;
+  for (int i = 0; i < num_keys; i++) {
+    res.clear();
+    ht.GetValue(nullptr, i, &res);
+  }
+  auto end = clock::now();
+  printf("extendible             insert %12.0f ops/s  lookup %12.0f ops/s\n", ops_per_sec(start, mid, num_keys),
+         ops_per_sec(mid, end, num_keys));
+  disk_manager->ShutDown();
+  remove("test.db");
+  delete disk_manager;
+  delete bpm;
+}
+
+}  // namespace bustub
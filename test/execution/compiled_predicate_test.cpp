@@ -0,0 +1,271 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compiled_predicate_test.cpp
+//
+// Identification: test/execution/compiled_predicate_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "execution/compiled_predicate.h"
+#include "execution/expressions/aggregate_value_expression.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "gtest/gtest.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+const std::vector<ComparisonType> COMPARISON_TYPES{ComparisonType::Equal,         ComparisonType::NotEqual,
+                                                   ComparisonType::LessThan,      ComparisonType::LessThanOrEqual,
+                                                   ComparisonType::GreaterThan,   ComparisonType::GreaterThanOrEqual};
+
+/** Owns the nodes of the expression trees of a test */
+class ExpressionPool {
+ public:
+  const AbstractExpression *Column(uint32_t tuple_idx, uint32_t col_idx, TypeId type) {
+    return Add(std::make_unique<ColumnValueExpression>(tuple_idx, col_idx, type));
+  }
+
+  const AbstractExpression *Constant(const Value &value) {
+    return Add(std::make_unique<ConstantValueExpression>(value));
+  }
+
+  const AbstractExpression *Compare(const AbstractExpression *lhs, const AbstractExpression *rhs,
+                                    ComparisonType comp_type) {
+    return Add(std::make_unique<ComparisonExpression>(lhs, rhs, comp_type));
+  }
+
+  const AbstractExpression *Term(bool is_group_by, uint32_t idx, TypeId type) {
+    return Add(std::make_unique<AggregateValueExpression>(is_group_by, idx, type));
+  }
+
+ private:
+  const AbstractExpression *Add(std::unique_ptr<AbstractExpression> &&expr) {
+    exprs_.push_back(std::move(expr));
+    return exprs_.back().get();
+  }
+
+  std::vector<std::unique_ptr<AbstractExpression>> exprs_;
+};
+
+/** A random value of the type from a small domain, NULL one time in eight, for VARCHAR columns too */
+Value RandomValue(TypeId type, std::mt19937 *rng) {
+  int32_t value = static_cast<int32_t>((*rng)() % 9) - 4;
+  if ((*rng)() % 8 == 0) {
+    return ValueFactory::GetNullValueByType(type);
+  }
+  switch (type) {
+    case TypeId::BOOLEAN:
+      return ValueFactory::GetBooleanValue(value > 0);
+    case TypeId::TINYINT:
+      return ValueFactory::GetTinyIntValue(static_cast<int8_t>(value));
+    case TypeId::SMALLINT:
+      return ValueFactory::GetSmallIntValue(static_cast<int16_t>(value));
+    case TypeId::INTEGER:
+      return ValueFactory::GetIntegerValue(value);
+    case TypeId::BIGINT:
+      return ValueFactory::GetBigIntValue(value);
+    case TypeId::DECIMAL:
+      return ValueFactory::GetDecimalValue(value / 2.0);
+    default:
+      return ValueFactory::GetVarcharValue(std::string(value + 4, 'x'));
+  }
+}
+
+std::vector<Tuple> RandomTuples(const Schema &schema, size_t count, std::mt19937 *rng) {
+  std::vector<Tuple> tuples;
+  for (size_t i = 0; i < count; i++) {
+    std::vector<Value> values;
+    for (const auto &column : schema.GetColumns()) {
+      values.push_back(RandomValue(column.GetType(), rng));
+    }
+    tuples.emplace_back(values, &schema);
+    // NULLs of every type, VARCHAR included, must read back as NULL or the predicates see the wrong input
+    for (uint32_t i = 0; i < values.size(); i++) {
+      EXPECT_EQ(values[i].IsNull(), tuples.back().GetValue(&schema, i).IsNull());
+    }
+  }
+  return tuples;
+}
+
+/** @return true if Values of the two types can be compared, Value asserts otherwise */
+bool IsComparable(TypeId lhs, TypeId rhs) {
+  auto numeric = [](TypeId type) { return type != TypeId::BOOLEAN && type != TypeId::VARCHAR; };
+  return lhs == rhs || (numeric(lhs) && numeric(rhs));
+}
+
+/** The interpreted predicate, a NULL result is false */
+bool IsTrue(const Value &value) { return !value.IsNull() && value.GetAs<bool>(); }
+
+/** (...((col_0 < 0) = (col_1 < 0)) = ...) = (col_{depth-1} < 0), a predicate of the given depth */
+const AbstractExpression *NestedPredicate(ExpressionPool *pool, const Schema &schema, uint32_t depth) {
+  const AbstractExpression *zero = pool->Constant(ValueFactory::GetIntegerValue(0));
+  auto leaf = [&](uint32_t col_idx) {
+    return pool->Compare(pool->Column(0, col_idx, schema.GetColumn(col_idx).GetType()), zero,
+                         ComparisonType::LessThan);
+  };
+  const AbstractExpression *predicate = leaf(0);
+  for (uint32_t level = 1; level < depth; level++) {
+    predicate = pool->Compare(predicate, leaf(level), ComparisonType::Equal);
+  }
+  return predicate;
+}
+
+}  // namespace
+
+// Every comparison of every pair of columns and constants agrees with the interpreted expression
+TEST(CompiledPredicateTest, TupleTest) {
+  Schema schema({Column("a", TypeId::INTEGER), Column("b", TypeId::BIGINT), Column("c", TypeId::DECIMAL),
+                 Column("d", TypeId::SMALLINT), Column("e", TypeId::TINYINT), Column("f", TypeId::BOOLEAN),
+                 Column("g", TypeId::VARCHAR, 8)});
+  std::mt19937 rng(2021);
+  auto tuples = RandomTuples(schema, 200, &rng);
+  ExpressionPool pool;
+  std::vector<const AbstractExpression *> operands;
+  for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+    operands.push_back(pool.Column(0, i, schema.GetColumn(i).GetType()));
+  }
+  operands.push_back(pool.Constant(ValueFactory::GetIntegerValue(1)));
+  operands.push_back(pool.Constant(ValueFactory::GetDecimalValue(-0.5)));
+  operands.push_back(pool.Constant(ValueFactory::GetNullValueByType(TypeId::BIGINT)));
+  operands.push_back(pool.Constant(ValueFactory::GetBooleanValue(true)));
+
+  size_t compared = 0;
+  for (auto comp_type : COMPARISON_TYPES) {
+    for (const auto *lhs : operands) {
+      for (const auto *rhs : operands) {
+        if (!IsComparable(lhs->GetReturnType(), rhs->GetReturnType())) {
+          continue;
+        }
+        const AbstractExpression *predicate = pool.Compare(lhs, rhs, comp_type);
+        CompiledPredicate compiled;
+        compiled.Compile(predicate, &schema);
+        for (const auto &tuple : tuples) {
+          ASSERT_EQ(IsTrue(predicate->Evaluate(&tuple, &schema)), compiled.Evaluate(&tuple));
+        }
+        compared++;
+      }
+    }
+  }
+  EXPECT_EQ(6 * (8 * 8 + 2 * 2 + 1), compared);
+
+  // 只有 VARCHAR 的比较退回到解释执行
+  CompiledPredicate compiled;
+  const AbstractExpression *xx = pool.Constant(ValueFactory::GetVarcharValue("xx"));
+  compiled.Compile(pool.Compare(operands[6], xx, ComparisonType::Equal), &schema);
+  EXPECT_EQ(1, compiled.FallbackCount());
+  compiled.Compile(NestedPredicate(&pool, schema, 5), &schema);
+  EXPECT_EQ(0, compiled.FallbackCount());
+  compiled.Compile(nullptr, &schema);
+  EXPECT_TRUE(compiled.Evaluate(&tuples[0]));
+}
+
+TEST(CompiledPredicateTest, NestedTest) {
+  Schema schema({Column("a", TypeId::INTEGER), Column("b", TypeId::BIGINT), Column("c", TypeId::DECIMAL),
+                 Column("d", TypeId::SMALLINT), Column("e", TypeId::INTEGER)});
+  std::mt19937 rng(2021);
+  auto tuples = RandomTuples(schema, 500, &rng);
+  ExpressionPool pool;
+  for (uint32_t depth = 1; depth <= 5; depth++) {
+    const AbstractExpression *predicate = NestedPredicate(&pool, schema, depth);
+    CompiledPredicate compiled;
+    compiled.Compile(predicate, &schema);
+    for (const auto &tuple : tuples) {
+      ASSERT_EQ(IsTrue(predicate->Evaluate(&tuple, &schema)), compiled.Evaluate(&tuple));
+    }
+  }
+}
+
+TEST(CompiledPredicateTest, JoinAndAggregateTest) {
+  Schema left_schema({Column("a", TypeId::INTEGER), Column("b", TypeId::VARCHAR, 8)});
+  Schema right_schema({Column("c", TypeId::DECIMAL), Column("d", TypeId::BIGINT)});
+  std::mt19937 rng(2021);
+  auto left_tuples = RandomTuples(left_schema, 40, &rng);
+  auto right_tuples = RandomTuples(right_schema, 40, &rng);
+  ExpressionPool pool;
+  for (auto comp_type : COMPARISON_TYPES) {
+    // a op c, a op d, d op a
+    for (const auto &[lhs, rhs] : std::vector<std::pair<const AbstractExpression *, const AbstractExpression *>>{
+             {pool.Column(0, 0, TypeId::INTEGER), pool.Column(1, 0, TypeId::DECIMAL)},
+             {pool.Column(0, 0, TypeId::INTEGER), pool.Column(1, 1, TypeId::BIGINT)},
+             {pool.Column(1, 1, TypeId::BIGINT), pool.Column(0, 0, TypeId::INTEGER)}}) {
+      const AbstractExpression *predicate = pool.Compare(lhs, rhs, comp_type);
+      CompiledPredicate compiled;
+      compiled.CompileJoin(predicate, &left_schema, &right_schema);
+      for (const auto &left : left_tuples) {
+        for (const auto &right : right_tuples) {
+          ASSERT_EQ(IsTrue(predicate->EvaluateJoin(&left, &left_schema, &right, &right_schema)),
+                    compiled.EvaluateJoin(&left, &right));
+        }
+      }
+    }
+
+    // HAVING clauses: a group-by term against an aggregate, and an aggregate against a constant
+    for (const auto &[lhs, rhs] : std::vector<std::pair<const AbstractExpression *, const AbstractExpression *>>{
+             {pool.Term(true, 0, TypeId::INTEGER), pool.Term(false, 1, TypeId::BIGINT)},
+             {pool.Term(false, 0, TypeId::INTEGER), pool.Constant(ValueFactory::GetIntegerValue(2))}}) {
+      const AbstractExpression *predicate = pool.Compare(lhs, rhs, comp_type);
+      CompiledPredicate compiled;
+      compiled.CompileAggregate(predicate);
+      for (int i = 0; i < 100; i++) {
+        std::vector<Value> group_bys{RandomValue(TypeId::INTEGER, &rng)};
+        std::vector<Value> aggregates{RandomValue(TypeId::INTEGER, &rng), RandomValue(TypeId::BIGINT, &rng)};
+        ASSERT_EQ(IsTrue(predicate->EvaluateAggregate(group_bys, aggregates)),
+                  compiled.EvaluateAggregate(group_bys, aggregates));
+      }
+    }
+  }
+}
+
+// Predicates of depth 1 to 5, interpreted versus compiled
+TEST(CompiledPredicateTest, DISABLED_BenchmarkTest) {
+  Schema schema({Column("a", TypeId::INTEGER), Column("b", TypeId::BIGINT), Column("c", TypeId::DECIMAL),
+                 Column("d", TypeId::INTEGER), Column("e", TypeId::BIGINT)});
+  std::mt19937 rng(2021);
+  auto tuples = RandomTuples(schema, 1 << 16, &rng);
+  const size_t repeat = 16;
+  ExpressionPool pool;
+  for (uint32_t depth = 1; depth <= 5; depth++) {
+    const AbstractExpression *predicate = NestedPredicate(&pool, schema, depth);
+    auto start = std::chrono::steady_clock::now();
+    size_t interpreted_count = 0;
+    for (size_t r = 0; r < repeat; r++) {
+      for (const auto &tuple : tuples) {
+        interpreted_count += static_cast<size_t>(IsTrue(predicate->Evaluate(&tuple, &schema)));
+      }
+    }
+    auto interpreted_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    CompiledPredicate compiled;
+    compiled.Compile(predicate, &schema);
+    size_t compiled_count = 0;
+    for (size_t r = 0; r < repeat; r++) {
+      for (const auto &tuple : tuples) {
+        compiled_count += static_cast<size_t>(compiled.Evaluate(&tuple));
+      }
+    }
+    auto compiled_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    EXPECT_EQ(interpreted_count, compiled_count);
+
+    double rows = static_cast<double>(repeat * tuples.size());
+    printf("depth %u: interpreted %6.2f ns/tuple, compiled %5.2f ns/tuple\n", depth, interpreted_ns / rows,
+           compiled_ns / rows);
+  }
+}
+
+}  // namespace bustub
@@ -0,0 +1,346 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// data_chunk_test.cpp
+//
+// Identification: test/execution/data_chunk_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "execution/data_chunk.h"
+#include "execution/expressions/column_value_expression.h"
+#include "execution/expressions/comparison_expression.h"
+#include "execution/expressions/constant_value_expression.h"
+#include "execution/vector_operations.h"
+#include "gtest/gtest.h"
+#include "type/value_factory.h"
+
+namespace bustub {
+
+namespace {
+
+const std::vector<ComparisonType> COMPARISON_TYPES{ComparisonType::Equal,         ComparisonType::NotEqual,
+                                                   ComparisonType::LessThan,      ComparisonType::LessThanOrEqual,
+                                                   ComparisonType::GreaterThan,   ComparisonType::GreaterThanOrEqual};
+
+/** A random value of the column type from a small domain, NULL one time in eight */
+Value RandomValue(TypeId type, std::mt19937 *rng) {
+  std::uniform_int_distribution<int32_t> dist(-20, 20);
+  if ((*rng)() % 8 == 0) {
+    return ValueFactory::GetNullValueByType(type);
+  }
+  switch (type) {
+    case TypeId::SMALLINT:
+      return ValueFactory::GetSmallIntValue(static_cast<int16_t>(dist(*rng)));
+    case TypeId::INTEGER:
+      return ValueFactory::GetIntegerValue(dist(*rng));
+    case TypeId::BIGINT:
+      return ValueFactory::GetBigIntValue(dist(*rng) * 1000000000000LL);
+    case TypeId::DECIMAL:
+      return ValueFactory::GetDecimalValue(dist(*rng) / 4.0);
+    default:
+      return ValueFactory::GetVarcharValue(std::string(static_cast<size_t>(dist(*rng) + 20) % 6, 'x'));
+  }
+}
+
+/** Fills a chunk with random tuples, returning the tuples */
+std::vector<Tuple> FillChunk(const Schema *schema, size_t count, std::mt19937 *rng, DataChunk *chunk) {
+  chunk->Initialize(schema, count);
+  std::vector<Tuple> tuples;
+  for (size_t i = 0; i < count; i++) {
+    std::vector<Value> values;
+    for (const auto &column : schema->GetColumns()) {
+      values.push_back(RandomValue(column.GetType(), rng));
+    }
+    tuples.emplace_back(values, schema);
+    chunk->AppendTuple(tuples.back());
+  }
+  return tuples;
+}
+
+/** The rows a boolean expression selects when evaluated one tuple at a time */
+std::vector<uint32_t> SelectByRow(const AbstractExpression &expr, const std::vector<Tuple> &tuples,
+                                  const Schema *schema) {
+  std::vector<uint32_t> rows;
+  for (uint32_t i = 0; i < tuples.size(); i++) {
+    Value result = expr.Evaluate(&tuples[i], schema);
+    if (!result.IsNull() && result.GetAs<bool>()) {
+      rows.push_back(i);
+    }
+  }
+  return rows;
+}
+
+std::vector<uint32_t> SelectByColumn(const AbstractExpression &expr, DataChunk *chunk) {
+  chunk->GetSelection().SetIdentity(chunk->Size());
+  expr.Select(chunk);
+  const SelectionVector &sel = chunk->GetSelection();
+  return std::vector<uint32_t>(sel.Data(), sel.Data() + sel.Size());
+}
+
+}  // namespace
+
+TEST(DataChunkTest, RoundTripTest) {
+  Schema schema({Column("a", TypeId::INTEGER), Column("b", TypeId::VARCHAR, 8), Column("c", TypeId::BIGINT),
+                 Column("d", TypeId::DECIMAL), Column("e", TypeId::SMALLINT)});
+  std::mt19937 rng(2021);
+  DataChunk chunk;
+  auto tuples = FillChunk(&schema, 300, &rng, &chunk);
+  ASSERT_EQ(tuples.size(), chunk.Size());
+  ASSERT_EQ(tuples.size(), chunk.GetSelection().Size());
+  for (size_t row = 0; row < tuples.size(); row++) {
+    EXPECT_EQ(tuples[row].ToString(&schema), chunk.GetTuple(row).ToString(&schema));
+    for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+      EXPECT_EQ(tuples[row].GetValue(&schema, i).IsNull(), !chunk.GetColumn(i).IsValid(row));
+    }
+  }
+
+  // Gather compacts the selected rows, Reset makes every row NULL again
+  SelectionVector sel;
+  sel.SetIdentity(0);
+  for (uint32_t row = 1; row < tuples.size(); row += 3) {
+    sel.Resize(sel.Size() + 1);
+    sel.Data()[sel.Size() - 1] = row;
+  }
+  DataChunk gathered;
+  gathered.Initialize(&schema, tuples.size());
+  for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+    gathered.GetColumn(i).Gather(chunk.GetColumn(i), sel);
+  }
+  for (size_t i = 0; i < sel.Size(); i++) {
+    EXPECT_EQ(tuples[sel[i]].ToString(&schema), gathered.GetTuple(i).ToString(&schema));
+  }
+  chunk.Reset();
+  EXPECT_EQ(0, chunk.Size());
+  EXPECT_FALSE(chunk.GetColumn(0).IsValid(0));
+}
+
+// Column-at-a-time comparisons select exactly the rows row-at-a-time evaluation selects
+TEST(DataChunkTest, SelectTest) {
+  Schema schema({Column("a", TypeId::INTEGER), Column("b", TypeId::BIGINT), Column("c", TypeId::DECIMAL),
+                 Column("d", TypeId::SMALLINT), Column("e", TypeId::INTEGER), Column("f", TypeId::VARCHAR, 8)});
+  std::mt19937 rng(2021);
+  DataChunk chunk;
+  auto tuples = FillChunk(&schema, 500, &rng, &chunk);
+
+  std::vector<ColumnValueExpression> columns;
+  for (uint32_t i = 0; i < schema.GetColumnCount(); i++) {
+    columns.emplace_back(0, i, schema.GetColumn(i).GetType());
+  }
+  std::vector<ConstantValueExpression> constants{
+      ConstantValueExpression(ValueFactory::GetIntegerValue(3)),
+      ConstantValueExpression(ValueFactory::GetBigIntValue(-5000000000000LL)),
+      ConstantValueExpression(ValueFactory::GetDecimalValue(1.25)),
+      ConstantValueExpression(ValueFactory::GetNullValueByType(TypeId::INTEGER)),
+      ConstantValueExpression(ValueFactory::GetVarcharValue("xx"))};
+
+  for (auto comp_type : COMPARISON_TYPES) {
+    for (const auto &column : columns) {
+      for (const auto &constant : constants) {
+        if ((column.GetReturnType() == TypeId::VARCHAR) != (constant.GetReturnType() == TypeId::VARCHAR)) {
+          continue;
+        }
+        ComparisonExpression column_constant(&column, &constant, comp_type);
+        EXPECT_EQ(SelectByRow(column_constant, tuples, &schema), SelectByColumn(column_constant, &chunk));
+        ComparisonExpression constant_column(&constant, &column, comp_type);
+        EXPECT_EQ(SelectByRow(constant_column, tuples, &schema), SelectByColumn(constant_column, &chunk));
+      }
+    }
+    for (uint32_t lhs = 0; lhs + 1 < columns.size(); lhs++) {
+      for (uint32_t rhs = 0; rhs + 1 < columns.size(); rhs++) {
+        ComparisonExpression column_column(&columns[lhs], &columns[rhs], comp_type);
+        EXPECT_EQ(SelectByRow(column_column, tuples, &schema), SelectByColumn(column_column, &chunk));
+      }
+    }
+  }
+}
+
+// Kernels on a selection that is no longer dense, and on TIMESTAMP columns, agree with the scalar comparison
+TEST(DataChunkTest, SparseSelectTest) {
+  Schema schema({Column("a", TypeId::INTEGER), Column("b", TypeId::BIGINT), Column("c", TypeId::DECIMAL)});
+  std::mt19937 rng(2021);
+  DataChunk chunk;
+  auto tuples = FillChunk(&schema, 700, &rng, &chunk);
+  ColumnValueExpression col_a(0, 0, TypeId::INTEGER);
+  ColumnValueExpression col_b(0, 1, TypeId::BIGINT);
+  ColumnValueExpression col_c(0, 2, TypeId::DECIMAL);
+  ConstantValueExpression zero(ValueFactory::GetIntegerValue(0));
+  ComparisonExpression a_ne_0(&col_a, &zero, ComparisonType::NotEqual);
+  for (auto comp_type : COMPARISON_TYPES) {
+    ComparisonExpression b_c(&col_b, &col_c, comp_type);
+    ComparisonExpression c_0(&col_c, &zero, comp_type);
+    for (const auto *second : {&b_c, &c_0}) {
+      std::vector<uint32_t> expected;
+      for (uint32_t row : SelectByRow(a_ne_0, tuples, &schema)) {
+        Value result = second->Evaluate(&tuples[row], &schema);
+        if (!result.IsNull() && result.GetAs<bool>()) {
+          expected.push_back(row);
+        }
+      }
+      SelectByColumn(a_ne_0, &chunk);
+      second->Select(&chunk);
+      const SelectionVector &sel = chunk.GetSelection();
+      EXPECT_EQ(expected, std::vector<uint32_t>(sel.Data(), sel.Data() + sel.Size()));
+    }
+  }
+
+  // TIMESTAMP Values cannot be built here, so the columns are filled directly
+  const size_t count = 300;
+  ColumnVector lhs(TypeId::TIMESTAMP, count);
+  ColumnVector rhs(TypeId::TIMESTAMP, count);
+  for (size_t row = 0; row < count; row++) {
+    // 覆盖最高位为 1 的值, 检查按无符号数比较
+    lhs.Data<uint64_t>()[row] = (rng() % 4) << 62 | rng() % 4;
+    rhs.Data<uint64_t>()[row] = (rng() % 4) << 62 | rng() % 4;
+    lhs.SetValid(row);
+    if (row % 7 != 0) {
+      rhs.SetValid(row);
+    }
+  }
+  for (auto comp_type : COMPARISON_TYPES) {
+    for (size_t first_row : {0, 1}) {
+      std::vector<uint32_t> expected;
+      SelectionVector sel;
+      sel.SetIdentity(count);
+      for (size_t row = first_row; row < count; row++) {
+        uint64_t left = lhs.Data<uint64_t>()[row];
+        uint64_t right = rhs.Data<uint64_t>()[row];
+        bool holds = (comp_type == ComparisonType::Equal && left == right) ||
+                     (comp_type == ComparisonType::NotEqual && left != right) ||
+                     (comp_type == ComparisonType::LessThan && left < right) ||
+                     (comp_type == ComparisonType::LessThanOrEqual && left <= right) ||
+                     (comp_type == ComparisonType::GreaterThan && left > right) ||
+                     (comp_type == ComparisonType::GreaterThanOrEqual && left >= right);
+        if (holds && rhs.IsValid(row)) {
+          expected.push_back(row);
+        }
+        sel.Data()[row - first_row] = row;
+      }
+      sel.Resize(count - first_row);
+      ASSERT_TRUE(VectorOperations::SelectCompareColumns(lhs, comp_type, rhs, &sel));
+      EXPECT_EQ(expected, std::vector<uint32_t>(sel.Data(), sel.Data() + sel.Size()));
+    }
+  }
+}
+
+// col < constant at 50% selectivity: Value evaluation, the scalar kernel (sparse selection) and the SIMD kernel,
+// over chunks that stay in the cache
+TEST(DataChunkTest, DISABLED_ComparisonBenchmarkTest) {
+  const size_t num_chunks = 16;
+  const size_t repeat = 64;
+  std::mt19937 rng(2021);
+  for (TypeId type : {TypeId::INTEGER, TypeId::BIGINT, TypeId::DECIMAL}) {
+    Schema schema({Column("a", type)});
+    std::vector<Tuple> tuples;
+    std::vector<DataChunk> chunks(num_chunks);
+    for (auto &chunk : chunks) {
+      chunk.Initialize(&schema);
+      for (size_t i = 0; i < DataChunk::DEFAULT_CAPACITY; i++) {
+        tuples.emplace_back(std::vector<Value>{ValueFactory::GetIntegerValue(rng() % 1000).CastAs(type)}, &schema);
+        chunk.AppendTuple(tuples.back());
+      }
+    }
+    ColumnValueExpression col_a(0, 0, type);
+    ConstantValueExpression const500(ValueFactory::GetIntegerValue(500));
+    ComparisonExpression predicate(&col_a, &const500, ComparisonType::LessThan);
+
+    auto start = std::chrono::steady_clock::now();
+    size_t row_count = 0;
+    for (size_t r = 0; r < repeat; r++) {
+      for (const auto &tuple : tuples) {
+        row_count += static_cast<size_t>(predicate.Evaluate(&tuple, &schema).GetAs<bool>());
+      }
+    }
+    auto row_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    // 不含第 0 行的选择向量不是稠密的, 走标量的内核
+    SelectionVector sparse;
+    sparse.SetIdentity(DataChunk::DEFAULT_CAPACITY - 1);
+    for (size_t i = 0; i < sparse.Size(); i++) {
+      sparse.Data()[i]++;
+    }
+    size_t kernel_count[2] = {0, 0};
+    double kernel_ns[2];
+    for (size_t dense = 0; dense < 2; dense++) {
+      start = std::chrono::steady_clock::now();
+      for (size_t r = 0; r < repeat; r++) {
+        for (auto &chunk : chunks) {
+          SelectionVector &sel = chunk.GetSelection();
+          if (dense == 1) {
+            sel.SetIdentity(chunk.Size());
+          } else {
+            sel = sparse;
+          }
+          predicate.Select(&chunk);
+          kernel_count[dense] += sel.Size();
+        }
+      }
+      kernel_ns[dense] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+    EXPECT_GE(row_count, kernel_count[0]);
+    EXPECT_EQ(row_count, kernel_count[1]);
+
+    printf("%-8s < constant: Value %6.2f ns/row, scalar kernel %5.2f ns/row, SIMD kernel %5.2f ns/row\n",
+           Type::TypeIdToString(type).c_str(), row_ns / (repeat * tuples.size()),
+           kernel_ns[0] / (repeat * tuples.size()), kernel_ns[1] / (repeat * tuples.size()));
+  }
+}
+
+// SELECT SUM(b) FROM t WHERE a < 500, one Value at a time versus one column at a time
+TEST(DataChunkTest, DISABLED_BenchmarkTest) {
+  Schema schema({Column("a", TypeId::INTEGER), Column("b", TypeId::INTEGER)});
+  const size_t num_rows = 1 << 20;
+  std::mt19937 rng(2021);
+  std::uniform_int_distribution<int32_t> dist(0, 999);
+  std::vector<Tuple> tuples;
+  std::vector<DataChunk> chunks((num_rows + DataChunk::DEFAULT_CAPACITY - 1) / DataChunk::DEFAULT_CAPACITY);
+  for (size_t i = 0; i < num_rows; i++) {
+    tuples.emplace_back(std::vector<Value>{ValueFactory::GetIntegerValue(dist(rng)), ValueFactory::GetIntegerValue(1)},
+                        &schema);
+    DataChunk &chunk = chunks[i / DataChunk::DEFAULT_CAPACITY];
+    if (i % DataChunk::DEFAULT_CAPACITY == 0) {
+      chunk.Initialize(&schema);
+    }
+    chunk.AppendTuple(tuples.back());
+  }
+  ColumnValueExpression col_a(0, 0, TypeId::INTEGER);
+  ConstantValueExpression const500(ValueFactory::GetIntegerValue(500));
+  ComparisonExpression predicate(&col_a, &const500, ComparisonType::LessThan);
+
+  auto start = std::chrono::steady_clock::now();
+  Value row_sum = ValueFactory::GetIntegerValue(0);
+  for (const auto &tuple : tuples) {
+    if (predicate.Evaluate(&tuple, &schema).GetAs<bool>()) {
+      row_sum = row_sum.Add(tuple.GetValue(&schema, 1));
+    }
+  }
+  auto row_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+  start = std::chrono::steady_clock::now();
+  int64_t column_sum = 0;
+  for (auto &chunk : chunks) {
+    chunk.GetSelection().SetIdentity(chunk.Size());
+    predicate.Select(&chunk);
+    const SelectionVector &sel = chunk.GetSelection();
+    const int32_t *data = chunk.GetColumn(1).Data<int32_t>();
+    for (size_t i = 0; i < sel.Size(); i++) {
+      column_sum += data[sel[i]];
+    }
+  }
+  auto column_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  EXPECT_EQ(row_sum.GetAs<int32_t>(), column_sum);
+
+  printf("filter + sum over %zu rows: row at a time %6.2f ns/row, column at a time %5.2f ns/row\n", num_rows,
+         row_ns / num_rows, column_ns / num_rows);
+}
+
+}  // namespace bustub
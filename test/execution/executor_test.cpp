@@ -10,9 +10,12 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <algorithm>
+#include <chrono>  // NOLINT
 #include <memory>
 #include <numeric>
 #include <string>
+#include <thread>  // NOLINT
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -21,6 +24,7 @@
 #include "concurrency/transaction_manager.h"
 #include "execution/execution_engine.h"
 #include "execution/executor_context.h"
+#include "execution/executor_factory.h"
 #include "execution/executors/aggregation_executor.h"
 #include "execution/executors/insert_executor.h"
 #include "execution/executors/nested_loop_join_executor.h"
@@ -31,8 +35,12 @@
 #include "execution/plans/delete_plan.h"
 #include "execution/plans/distinct_plan.h"
 #include "execution/plans/hash_join_plan.h"
+#include "execution/plans/index_scan_plan.h"
 #include "execution/plans/limit_plan.h"
+#include "execution/plans/merge_join_plan.h"
+#include "execution/plans/nested_index_join_plan.h"
 #include "execution/plans/seq_scan_plan.h"
+#include "execution/plans/sort_plan.h"
 #include "execution/plans/update_plan.h"
 #include "executor_test_util.h"  // NOLINT
 #include "gtest/gtest.h"
@@ -386,6 +394,113 @@ TEST_F(ExecutorTest, SimpleDeleteTest) {
   ASSERT_TRUE(rids.empty());
 }
 
+// SELECT col_a, col_b FROM test_1 WHERE <predicate on col_a>, answered by an index on col_a
+TEST_F(ExecutorTest, SimpleIndexScanTest) {
+  auto table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  auto &schema = table_info->schema_;
+  auto key_schema = ParseCreateStatement("a bigint");
+  auto *btree_info = GetExecutorContext()->GetCatalog()->CreateIndex<KeyType, ValueType, ComparatorType>(
+      GetTxn(), "btree_index", "test_1", schema, *key_schema, {0}, 8, HashFunctionType{}, IndexType::BPLUS_TREE);
+  auto *hash_info = GetExecutorContext()->GetCatalog()->CreateIndex<KeyType, ValueType, ComparatorType>(
+      GetTxn(), "hash_index", "test_1", schema, *key_schema, {0}, 8, HashFunctionType{});
+
+  auto col_a = MakeColumnValueExpression(schema, 0, "colA");
+  auto col_b = MakeColumnValueExpression(schema, 0, "colB");
+  auto out_schema = MakeOutputSchema({{"colA", col_a}, {"colB", col_b}});
+  auto run = [&](const AbstractExpression *predicate, index_oid_t index_oid) {
+    IndexScanPlanNode plan{out_schema, predicate, index_oid};
+    std::vector<Tuple> result_set;
+    GetExecutionEngine()->Execute(&plan, &result_set, GetTxn(), GetExecutorContext());
+    std::vector<int32_t> col_a_values;
+    for (const auto &tuple : result_set) {
+      col_a_values.push_back(tuple.GetValue(out_schema, out_schema->GetColIdx("colA")).GetAs<int32_t>());
+      EXPECT_LT(tuple.GetValue(out_schema, out_schema->GetColIdx("colB")).GetAs<int32_t>(), 10);
+    }
+    return col_a_values;
+  };
+  auto expect_range = [](const std::vector<int32_t> &col_a_values, int32_t low, int32_t high) {
+    std::vector<int32_t> expected(high - low);
+    std::iota(expected.begin(), expected.end(), low);
+    EXPECT_EQ(expected, col_a_values);
+  };
+
+  auto const500 = MakeConstantValueExpression(ValueFactory::GetIntegerValue(500));
+  // col_a = 500, on both indexes
+  auto equal = MakeComparisonExpression(col_a, const500, ComparisonType::Equal);
+  expect_range(run(equal, btree_info->index_oid_), 500, 501);
+  expect_range(run(equal, hash_info->index_oid_), 500, 501);
+  // col_a < 500, tuples come back in key order
+  auto less = MakeComparisonExpression(col_a, const500, ComparisonType::LessThan);
+  expect_range(run(less, btree_info->index_oid_), 0, 500);
+  // col_a >= 500
+  auto greater_equal = MakeComparisonExpression(col_a, const500, ComparisonType::GreaterThanOrEqual);
+  expect_range(run(greater_equal, btree_info->index_oid_), 500, TEST1_SIZE);
+  // 500 < col_a, the constant on the left
+  auto flipped = MakeComparisonExpression(const500, col_a, ComparisonType::LessThan);
+  expect_range(run(flipped, btree_info->index_oid_), 501, TEST1_SIZE);
+  // No predicate scans the whole index
+  expect_range(run(nullptr, btree_info->index_oid_), 0, TEST1_SIZE);
+  // A range predicate cannot be answered by a hash index
+  EXPECT_THROW(run(less, hash_info->index_oid_), Exception);
+}
+
+// SELECT col_a, col_b FROM test_1 WHERE <predicate on col_b>, col_b holds only 10 distinct values
+TEST_F(ExecutorTest, NonUniqueIndexScanTest) {
+  auto table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  auto &schema = table_info->schema_;
+  auto key_schema = ParseCreateStatement("b integer");
+  auto *btree_info = GetExecutorContext()->GetCatalog()->CreateIndex<KeyType, ValueType, ComparatorType>(
+      GetTxn(), "btree_index", "test_1", schema, *key_schema, {1}, 8, HashFunctionType{}, IndexType::BPLUS_TREE);
+
+  auto col_a = MakeColumnValueExpression(schema, 0, "colA");
+  auto col_b = MakeColumnValueExpression(schema, 0, "colB");
+  auto out_schema = MakeOutputSchema({{"colA", col_a}, {"colB", col_b}});
+  // 返回 col_a 排序后的结果, 与顺序扫描的结果比较
+  auto run = [&](const AbstractPlanNode *plan) {
+    std::vector<Tuple> result_set;
+    GetExecutionEngine()->Execute(plan, &result_set, GetTxn(), GetExecutorContext());
+    std::vector<int32_t> col_a_values;
+    for (const auto &tuple : result_set) {
+      col_a_values.push_back(tuple.GetValue(out_schema, out_schema->GetColIdx("colA")).GetAs<int32_t>());
+    }
+    std::sort(col_a_values.begin(), col_a_values.end());
+    return col_a_values;
+  };
+
+  auto const3 = MakeConstantValueExpression(ValueFactory::GetIntegerValue(3));
+  for (auto type : {ComparisonType::Equal, ComparisonType::LessThan, ComparisonType::GreaterThanOrEqual}) {
+    auto predicate = MakeComparisonExpression(col_b, const3, type);
+    SeqScanPlanNode seq_scan_plan{out_schema, predicate, table_info->oid_};
+    IndexScanPlanNode index_scan_plan{out_schema, predicate, btree_info->index_oid_};
+    auto expected = run(&seq_scan_plan);
+    EXPECT_FALSE(expected.empty());
+    EXPECT_EQ(expected, run(&index_scan_plan));
+  }
+  IndexScanPlanNode full_scan_plan{out_schema, nullptr, btree_info->index_oid_};
+  EXPECT_EQ(run(&full_scan_plan).size(), TEST1_SIZE);
+
+  // 超出 INTEGER 范围的 BIGINT 常量不能转换成键, 边界被截断或者范围为空
+  for (int64_t bound : {int64_t{10000000000}, int64_t{-10000000000}}) {
+    auto constant = MakeConstantValueExpression(ValueFactory::GetBigIntValue(bound));
+    for (auto type : {ComparisonType::Equal, ComparisonType::LessThan, ComparisonType::GreaterThanOrEqual}) {
+      auto predicate = MakeComparisonExpression(col_b, constant, type);
+      SeqScanPlanNode seq_scan_plan{out_schema, predicate, table_info->oid_};
+      IndexScanPlanNode index_scan_plan{out_schema, predicate, btree_info->index_oid_};
+      EXPECT_EQ(run(&seq_scan_plan), run(&index_scan_plan));
+    }
+  }
+
+  // 删除一项只会删除对应 RID 的那一项, 相同键的其他项仍然可以查到
+  std::vector<RID> rids;
+  Tuple key({ValueFactory::GetIntegerValue(3)}, key_schema.get());
+  btree_info->index_->ScanKey(key, &rids, GetTxn());
+  ASSERT_GT(rids.size(), 1);
+  btree_info->index_->DeleteEntry(key, rids[0], GetTxn());
+  std::vector<RID> remaining;
+  btree_info->index_->ScanKey(key, &remaining, GetTxn());
+  EXPECT_EQ(remaining, std::vector<RID>(rids.begin() + 1, rids.end()));
+}
+
 // SELECT test_1.col_a, test_1.col_b, test_2.col1, test_2.col3 FROM test_1 JOIN test_2 ON test_1.col_a = test_2.col1;
 TEST_F(ExecutorTest, SimpleNestedLoopJoinTest) {
   const Schema *out_schema1;
@@ -438,6 +553,51 @@ TEST_F(ExecutorTest, SimpleNestedLoopJoinTest) {
   ASSERT_EQ(result_set.size(), 100);
 }
 
+// SELECT test_1.colA, test_3.colA FROM test_1 JOIN test_3 ON test_1.colB < test_3.colA;
+// A non-equi join, the outer side is buffered a tuple at a time, one page at a time and as a single block
+TEST_F(ExecutorTest, BlockNestedLoopJoinTest) {
+  auto *outer_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  auto *outer_schema = MakeOutputSchema({{"colA", MakeColumnValueExpression(outer_info->schema_, 0, "colA")},
+                                         {"colB", MakeColumnValueExpression(outer_info->schema_, 0, "colB")}});
+  SeqScanPlanNode outer_plan{outer_schema, nullptr, outer_info->oid_};
+  auto *inner_info = GetExecutorContext()->GetCatalog()->GetTable("test_3");
+  auto *inner_schema = MakeOutputSchema({{"colA", MakeColumnValueExpression(inner_info->schema_, 0, "colA")}});
+  SeqScanPlanNode inner_plan{inner_schema, nullptr, inner_info->oid_};
+
+  auto *outer_col_a = MakeColumnValueExpression(*outer_schema, 0, "colA");
+  auto *outer_col_b = MakeColumnValueExpression(*outer_schema, 0, "colB");
+  auto *inner_col_a = MakeColumnValueExpression(*inner_schema, 1, "colA");
+  auto *out_schema = MakeOutputSchema({{"outer_colA", outer_col_a}, {"inner_colA", inner_col_a}});
+  auto *predicate = MakeComparisonExpression(outer_col_b, inner_col_a, ComparisonType::LessThan);
+
+  // The expected pairs, test_3.colA goes from 0 to TEST3_SIZE - 1
+  std::vector<Tuple> outer_set;
+  GetExecutionEngine()->Execute(&outer_plan, &outer_set, GetTxn(), GetExecutorContext());
+  std::vector<std::pair<int32_t, int32_t>> expected;
+  for (const auto &outer : outer_set) {
+    auto outer_a = outer.GetValue(outer_schema, 0).GetAs<int32_t>();
+    auto outer_b = outer.GetValue(outer_schema, 1).GetAs<int32_t>();
+    for (auto inner_a = outer_b + 1; inner_a < static_cast<int32_t>(TEST3_SIZE); inner_a++) {
+      expected.emplace_back(outer_a, inner_a);
+    }
+  }
+  std::sort(expected.begin(), expected.end());
+
+  // A block of no pages still holds one outer tuple
+  for (size_t block_pages : {size_t{0}, size_t{1}, NestedLoopJoinPlanNode::DEFAULT_BLOCK_PAGES}) {
+    NestedLoopJoinPlanNode join_plan{out_schema, {&outer_plan, &inner_plan}, predicate, block_pages};
+    std::vector<Tuple> result_set;
+    GetExecutionEngine()->Execute(&join_plan, &result_set, GetTxn(), GetExecutorContext());
+    std::vector<std::pair<int32_t, int32_t>> result;
+    for (const auto &tuple : result_set) {
+      result.emplace_back(tuple.GetValue(out_schema, 0).GetAs<int32_t>(),
+                          tuple.GetValue(out_schema, 1).GetAs<int32_t>());
+    }
+    std::sort(result.begin(), result.end());
+    ASSERT_EQ(expected, result);
+  }
+}
+
 // SELECT test_4.colA, test_4.colB, test_6.colA, test_6.colB FROM test_4 JOIN test_6 ON test_4.colA = test_6.colA;
 TEST_F(ExecutorTest, SimpleHashJoinTest) {
   // Construct sequential scan of table test_4
@@ -506,6 +666,467 @@ TEST_F(ExecutorTest, SimpleHashJoinTest) {
   }
 }
 
+// SELECT l.colA, r.colA FROM test_1 l JOIN test_1 r ON l.colB = r.colB;
+// Both sides repeat every key about a hundred times.
+// The join runs in memory and spilled to disk, on one and four threads.
+TEST_F(ExecutorTest, HashJoinDuplicateKeysTest) {
+  auto *table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  auto &schema = table_info->schema_;
+  auto *scan_schema = MakeOutputSchema(
+      {{"colA", MakeColumnValueExpression(schema, 0, "colA")}, {"colB", MakeColumnValueExpression(schema, 0, "colB")}});
+  SeqScanPlanNode left_plan{scan_schema, nullptr, table_info->oid_};
+  SeqScanPlanNode right_plan{scan_schema, nullptr, table_info->oid_};
+
+  auto *left_col_b = MakeColumnValueExpression(*scan_schema, 0, "colB");
+  auto *right_col_b = MakeColumnValueExpression(*scan_schema, 1, "colB");
+  auto *out_schema = MakeOutputSchema({{"left_colA", MakeColumnValueExpression(*scan_schema, 0, "colA")},
+                                       {"right_colA", MakeColumnValueExpression(*scan_schema, 1, "colA")}});
+  // The expected pairs, found with a nested loop
+  std::vector<Tuple> scan_set;
+  GetExecutionEngine()->Execute(&left_plan, &scan_set, GetTxn(), GetExecutorContext());
+  std::vector<std::pair<int32_t, int32_t>> expected;
+  for (const auto &left : scan_set) {
+    for (const auto &right : scan_set) {
+      if (left.GetValue(scan_schema, 1).GetAs<int32_t>() == right.GetValue(scan_schema, 1).GetAs<int32_t>()) {
+        expected.emplace_back(left.GetValue(scan_schema, 0).GetAs<int32_t>(),
+                              right.GetValue(scan_schema, 0).GetAs<int32_t>());
+      }
+    }
+  }
+
+  std::sort(expected.begin(), expected.end());
+
+  // With a budget of 16KB the join spills, and a partition of several keys is over the budget and partitioned again
+  for (auto [memory_budget, parallelism] : std::vector<std::pair<size_t, size_t>>{
+           {HashJoinPlanNode::DEFAULT_MEMORY_BUDGET, 1}, {16 * 1024, 1}, {HashJoinPlanNode::DEFAULT_MEMORY_BUDGET, 4},
+           {16 * 1024, 4}}) {
+    HashJoinPlanNode join_plan{out_schema, {&left_plan, &right_plan}, left_col_b, right_col_b, memory_budget,
+                               parallelism};
+    std::vector<Tuple> result_set;
+    GetExecutionEngine()->Execute(&join_plan, &result_set, GetTxn(), GetExecutorContext());
+    std::vector<std::pair<int32_t, int32_t>> result;
+    for (const auto &tuple : result_set) {
+      result.emplace_back(tuple.GetValue(out_schema, 0).GetAs<int32_t>(),
+                          tuple.GetValue(out_schema, 1).GetAs<int32_t>());
+    }
+    std::sort(result.begin(), result.end());
+    ASSERT_EQ(expected, result);
+  }
+}
+
+// SELECT big.a, test_1.colA FROM big JOIN test_1 ON big.b = test_1.colA;
+// The build side is large enough to be radix partitioned, and its BIGINT keys are probed with INTEGERs
+TEST_F(ExecutorTest, PartitionedHashJoinTest) {
+  constexpr int64_t big_size = 8000;
+  constexpr int64_t distinct_keys = 2000;
+  auto big_schema = ParseCreateStatement("a bigint,b bigint");
+  auto *big_info = GetExecutorContext()->GetCatalog()->CreateTable(GetTxn(), "big", *big_schema);
+  for (int64_t i = 0; i < big_size; i++) {
+    Tuple tuple{{ValueFactory::GetBigIntValue(i), ValueFactory::GetBigIntValue(i % distinct_keys)},
+                &big_info->schema_};
+    RID rid;
+    ASSERT_TRUE(big_info->table_->InsertTuple(tuple, &rid, GetTxn()));
+  }
+  auto *big_col_a = MakeColumnValueExpression(big_info->schema_, 0, "a");
+  auto *big_col_b = MakeColumnValueExpression(big_info->schema_, 0, "b");
+  auto *left_schema = MakeOutputSchema({{"colA", big_col_a}, {"colB", big_col_b}});
+  SeqScanPlanNode left_plan{left_schema, nullptr, big_info->oid_};
+
+  auto *test1_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  auto *right_schema = MakeOutputSchema({{"colA", MakeColumnValueExpression(test1_info->schema_, 0, "colA")}});
+  SeqScanPlanNode right_plan{right_schema, nullptr, test1_info->oid_};
+
+  auto *left_key = MakeColumnValueExpression(*left_schema, 0, "colB");
+  auto *right_key = MakeColumnValueExpression(*right_schema, 1, "colA");
+  auto *out_schema = MakeOutputSchema({{"big_colA", MakeColumnValueExpression(*left_schema, 0, "colA")},
+                                       {"big_colB", MakeColumnValueExpression(*left_schema, 0, "colB")},
+                                       {"test1_colA", right_key}});
+  // The join is also run spilled to partitions of the buffer pool that are each partitioned again, and on 4 threads
+  for (auto [memory_budget, parallelism] :
+       std::vector<std::pair<size_t, size_t>>{{HashJoinPlanNode::DEFAULT_MEMORY_BUDGET, 1},
+                                              {64 * 1024, 1},
+                                              {HashJoinPlanNode::DEFAULT_MEMORY_BUDGET, 4}}) {
+    HashJoinPlanNode join_plan{out_schema, {&left_plan, &right_plan}, left_key, right_key, memory_budget, parallelism};
+    std::vector<Tuple> result_set;
+    GetExecutionEngine()->Execute(&join_plan, &result_set, GetTxn(), GetExecutorContext());
+    // Every tuple of test_1 matches big_size / distinct_keys tuples of big
+    ASSERT_EQ(result_set.size(), TEST1_SIZE * (big_size / distinct_keys));
+    std::unordered_set<int64_t> big_rows;
+    for (const auto &tuple : result_set) {
+      auto big_col_a_value = tuple.GetValue(out_schema, 0).GetAs<int64_t>();
+      ASSERT_EQ(tuple.GetValue(out_schema, 1).GetAs<int64_t>(), tuple.GetValue(out_schema, 2).GetAs<int32_t>());
+      ASSERT_EQ(big_col_a_value % distinct_keys, tuple.GetValue(out_schema, 2).GetAs<int32_t>());
+      ASSERT_TRUE(big_rows.insert(big_col_a_value).second);
+    }
+  }
+}
+
+// SELECT l.id, r.id FROM names l JOIN names r ON l.name = r.name;
+// The VARCHAR keys are counted against the memory budget along with the tuples holding them
+TEST_F(ExecutorTest, HashJoinVarcharKeysTest) {
+  constexpr int32_t names_size = 1000;
+  constexpr int32_t distinct_names = 250;
+  auto names_schema = ParseCreateStatement("id integer,name varchar(64)");
+  auto *names_info = GetExecutorContext()->GetCatalog()->CreateTable(GetTxn(), "names", *names_schema);
+  for (int32_t i = 0; i < names_size; i++) {
+    std::string name = "a_join_key_long_enough_to_matter_" + std::to_string(i % distinct_names);
+    Tuple tuple{{ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(name)}, &names_info->schema_};
+    RID rid;
+    ASSERT_TRUE(names_info->table_->InsertTuple(tuple, &rid, GetTxn()));
+  }
+  auto *scan_schema = MakeOutputSchema({{"id", MakeColumnValueExpression(names_info->schema_, 0, "id")},
+                                        {"name", MakeColumnValueExpression(names_info->schema_, 0, "name")}});
+  SeqScanPlanNode left_plan{scan_schema, nullptr, names_info->oid_};
+  SeqScanPlanNode right_plan{scan_schema, nullptr, names_info->oid_};
+
+  auto *left_name = MakeColumnValueExpression(*scan_schema, 0, "name");
+  auto *right_name = MakeColumnValueExpression(*scan_schema, 1, "name");
+  auto *out_schema = MakeOutputSchema({{"left_id", MakeColumnValueExpression(*scan_schema, 0, "id")},
+                                       {"right_id", MakeColumnValueExpression(*scan_schema, 1, "id")}});
+  for (auto [memory_budget, parallelism] : std::vector<std::pair<size_t, size_t>>{
+           {HashJoinPlanNode::DEFAULT_MEMORY_BUDGET, 1}, {16 * 1024, 1}, {HashJoinPlanNode::DEFAULT_MEMORY_BUDGET, 4},
+           {16 * 1024, 4}}) {
+    HashJoinPlanNode join_plan{out_schema, {&left_plan, &right_plan}, left_name, right_name, memory_budget,
+                               parallelism};
+    std::vector<Tuple> result_set;
+    GetExecutionEngine()->Execute(&join_plan, &result_set, GetTxn(), GetExecutorContext());
+    // Every name is shared by names_size / distinct_names rows
+    ASSERT_EQ(result_set.size(), static_cast<size_t>(names_size * (names_size / distinct_names)));
+    for (const auto &tuple : result_set) {
+      ASSERT_EQ(tuple.GetValue(out_schema, 0).GetAs<int32_t>() % distinct_names,
+                tuple.GetValue(out_schema, 1).GetAs<int32_t>() % distinct_names);
+    }
+  }
+}
+
+// SELECT l.colA, r.colA FROM test_1 l JOIN test_1 r ON l.colB = r.colB;
+// Both sides repeat every key about a hundred times, and are sorted in memory and in runs spilled to disk
+TEST_F(ExecutorTest, MergeJoinDuplicateKeysTest) {
+  auto *table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  auto &schema = table_info->schema_;
+  auto *scan_schema = MakeOutputSchema(
+      {{"colA", MakeColumnValueExpression(schema, 0, "colA")}, {"colB", MakeColumnValueExpression(schema, 0, "colB")}});
+  SeqScanPlanNode left_plan{scan_schema, nullptr, table_info->oid_};
+  SeqScanPlanNode right_plan{scan_schema, nullptr, table_info->oid_};
+
+  auto *left_col_b = MakeColumnValueExpression(*scan_schema, 0, "colB");
+  auto *right_col_b = MakeColumnValueExpression(*scan_schema, 1, "colB");
+  auto *out_schema = MakeOutputSchema({{"left_colA", MakeColumnValueExpression(*scan_schema, 0, "colA")},
+                                       {"left_colB", left_col_b},
+                                       {"right_colA", MakeColumnValueExpression(*scan_schema, 1, "colA")}});
+  // The expected pairs, found with a nested loop
+  std::vector<Tuple> scan_set;
+  GetExecutionEngine()->Execute(&left_plan, &scan_set, GetTxn(), GetExecutorContext());
+  std::vector<std::pair<int32_t, int32_t>> expected;
+  for (const auto &left : scan_set) {
+    for (const auto &right : scan_set) {
+      if (left.GetValue(scan_schema, 1).GetAs<int32_t>() == right.GetValue(scan_schema, 1).GetAs<int32_t>()) {
+        expected.emplace_back(left.GetValue(scan_schema, 0).GetAs<int32_t>(),
+                              right.GetValue(scan_schema, 0).GetAs<int32_t>());
+      }
+    }
+  }
+  std::sort(expected.begin(), expected.end());
+
+  // With a budget of 4KB each input is sorted into many runs that are merged two at a time, and every group of
+  // duplicate right tuples is over its 2KB and spilled to pages that are read back for each left tuple of the key
+  for (size_t memory_budget : {MergeJoinPlanNode::DEFAULT_MEMORY_BUDGET, static_cast<size_t>(4 * 1024)}) {
+    MergeJoinPlanNode join_plan{out_schema, {&left_plan, &right_plan}, left_col_b, right_col_b, memory_budget};
+    std::vector<Tuple> result_set;
+    GetExecutionEngine()->Execute(&join_plan, &result_set, GetTxn(), GetExecutorContext());
+    std::vector<std::pair<int32_t, int32_t>> result;
+    int32_t last_key = 0;
+    for (const auto &tuple : result_set) {
+      // The output comes in the order of the join key
+      auto key = tuple.GetValue(out_schema, 1).GetAs<int32_t>();
+      ASSERT_LE(last_key, key);
+      last_key = key;
+      result.emplace_back(tuple.GetValue(out_schema, 0).GetAs<int32_t>(),
+                          tuple.GetValue(out_schema, 2).GetAs<int32_t>());
+    }
+    std::sort(result.begin(), result.end());
+    ASSERT_EQ(expected, result);
+  }
+}
+
+// SELECT test_1.colA, test_3.colA FROM test_1 JOIN test_3 ON test_1.colA = test_3.colA;
+// Both scans already produce colA in ascending order, so neither input is sorted
+TEST_F(ExecutorTest, MergeJoinSortedInputsTest) {
+  auto *test1_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  auto *test3_info = GetExecutorContext()->GetCatalog()->GetTable("test_3");
+  auto *left_schema = MakeOutputSchema({{"colA", MakeColumnValueExpression(test1_info->schema_, 0, "colA")}});
+  auto *right_schema = MakeOutputSchema({{"colA", MakeColumnValueExpression(test3_info->schema_, 0, "colA")}});
+  SeqScanPlanNode left_plan{left_schema, nullptr, test1_info->oid_};
+  SeqScanPlanNode right_plan{right_schema, nullptr, test3_info->oid_};
+
+  auto *left_key = MakeColumnValueExpression(*left_schema, 0, "colA");
+  auto *right_key = MakeColumnValueExpression(*right_schema, 1, "colA");
+  auto *out_schema = MakeOutputSchema({{"test1_colA", left_key}, {"test3_colA", right_key}});
+  MergeJoinPlanNode join_plan{out_schema,  {&left_plan, &right_plan}, left_key, right_key,
+                              MergeJoinPlanNode::DEFAULT_MEMORY_BUDGET, true, true};
+  std::vector<Tuple> result_set;
+  GetExecutionEngine()->Execute(&join_plan, &result_set, GetTxn(), GetExecutorContext());
+
+  ASSERT_EQ(result_set.size(), std::min<size_t>(TEST1_SIZE, TEST3_SIZE));
+  for (size_t i = 0; i < result_set.size(); i++) {
+    ASSERT_EQ(result_set[i].GetValue(out_schema, 0).GetAs<int32_t>(), static_cast<int32_t>(i));
+    ASSERT_EQ(result_set[i].GetValue(out_schema, 1).GetAs<int32_t>(), static_cast<int32_t>(i));
+  }
+}
+
+// Joins a fact table with a dimension table on one and several threads
+TEST_F(ExecutorTest, DISABLED_HashJoinBenchmarkTest) {
+  constexpr int64_t fact_size = 50000;
+  constexpr int64_t dim_size = 5000;
+  auto schema = ParseCreateStatement("a bigint,b bigint");
+  auto *fact_info = GetExecutorContext()->GetCatalog()->CreateTable(GetTxn(), "fact", *schema);
+  auto *dim_info = GetExecutorContext()->GetCatalog()->CreateTable(GetTxn(), "dim", *schema);
+  RID rid;
+  for (int64_t i = 0; i < fact_size; i++) {
+    Tuple tuple{{ValueFactory::GetBigIntValue(i), ValueFactory::GetBigIntValue(i * 7919 % dim_size)},
+                &fact_info->schema_};
+    fact_info->table_->InsertTuple(tuple, &rid, GetTxn());
+  }
+  for (int64_t i = 0; i < dim_size; i++) {
+    Tuple tuple{{ValueFactory::GetBigIntValue(i), ValueFactory::GetBigIntValue(i)}, &dim_info->schema_};
+    dim_info->table_->InsertTuple(tuple, &rid, GetTxn());
+  }
+  auto *dim_schema = MakeOutputSchema({{"a", MakeColumnValueExpression(dim_info->schema_, 0, "a")}});
+  SeqScanPlanNode dim_plan{dim_schema, nullptr, dim_info->oid_};
+  auto *fact_schema = MakeOutputSchema({{"a", MakeColumnValueExpression(fact_info->schema_, 0, "a")},
+                                        {"b", MakeColumnValueExpression(fact_info->schema_, 0, "b")}});
+  SeqScanPlanNode fact_plan{fact_schema, nullptr, fact_info->oid_};
+  auto *dim_key = MakeColumnValueExpression(*dim_schema, 0, "a");
+  auto *fact_key = MakeColumnValueExpression(*fact_schema, 1, "b");
+  auto *out_schema =
+      MakeOutputSchema({{"fact_a", MakeColumnValueExpression(*fact_schema, 1, "a")}, {"dim_a", dim_key}});
+
+  // @return the number of tuples produced by a plan and the nanoseconds taken
+  auto drain = [&](const AbstractPlanNode *plan) {
+    auto executor = ExecutorFactory::CreateExecutor(GetExecutorContext(), plan);
+    auto start = std::chrono::steady_clock::now();
+    executor->Init();
+    size_t count = 0;
+    TupleBatch batch;
+    while (executor->NextBatch(&batch)) {
+      count += batch.Size();
+    }
+    auto ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return std::make_pair(count, ns);
+  };
+  // Reading the inputs through the small buffer pool of the test is most of the time, it is measured on its own
+  double scan_ns = drain(&dim_plan).second + drain(&fact_plan).second;
+  printf("scanning the inputs: %6.1f ns/probe tuple, %u hardware threads\n", scan_ns / fact_size,
+         std::thread::hardware_concurrency());
+  for (size_t parallelism : {1, 2, 4, 8}) {
+    HashJoinPlanNode join_plan{out_schema,
+                               {&dim_plan, &fact_plan},
+                               dim_key,
+                               fact_key,
+                               HashJoinPlanNode::DEFAULT_MEMORY_BUDGET,
+                               parallelism};
+    auto [count, join_ns] = drain(&join_plan);
+    ASSERT_EQ(count, fact_size);
+    printf("%zu threads: %6.1f ns/probe tuple, %6.1f without the scans\n", parallelism, join_ns / fact_size,
+           (join_ns - scan_ns) / fact_size);
+  }
+}
+
+// SELECT test_1.colA, test_1.colB, test_6.colA, test_6.colB FROM test_1 JOIN test_6 ON test_1.colA = test_6.colA;
+// test_6 is probed through an index on colA
+TEST_F(ExecutorTest, SimpleNestedIndexJoinTest) {
+  auto *outer_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  auto *col_a = MakeColumnValueExpression(outer_info->schema_, 0, "colA");
+  auto *col_b = MakeColumnValueExpression(outer_info->schema_, 0, "colB");
+  const Schema *outer_schema = MakeOutputSchema({{"colA", col_a}, {"colB", col_b}});
+  SeqScanPlanNode scan_plan{outer_schema, nullptr, outer_info->oid_};
+
+  auto *inner_info = GetExecutorContext()->GetCatalog()->GetTable("test_6");
+  const Schema *inner_schema = &inner_info->schema_;
+  auto key_schema = ParseCreateStatement("a bigint");
+  GetExecutorContext()->GetCatalog()->CreateIndex<KeyType, ValueType, ComparatorType>(
+      GetTxn(), "btree_index", "test_6", *inner_schema, *key_schema, {0}, 8, HashFunctionType{},
+      IndexType::BPLUS_TREE);
+  GetExecutorContext()->GetCatalog()->CreateIndex<KeyType, ValueType, ComparatorType>(
+      GetTxn(), "hash_index", "test_6", *inner_schema, *key_schema, {0}, 8, HashFunctionType{});
+
+  // Columns from test_1 have a tuple index of 0, columns from test_6 a tuple index of 1
+  auto *outer_col_a = MakeColumnValueExpression(*outer_schema, 0, "colA");
+  auto *outer_col_b = MakeColumnValueExpression(*outer_schema, 0, "colB");
+  auto *inner_col_a = MakeColumnValueExpression(*inner_schema, 1, "colA");
+  auto *inner_col_b = MakeColumnValueExpression(*inner_schema, 1, "colB");
+  const Schema *out_schema = MakeOutputSchema({{"outer_colA", outer_col_a},
+                                               {"outer_colB", outer_col_b},
+                                               {"inner_colA", inner_col_a},
+                                               {"inner_colB", inner_col_b}});
+  auto *predicate = MakeComparisonExpression(outer_col_a, inner_col_a, ComparisonType::Equal);
+
+  // test_1 spans several outer batches, each test_1.colA below TEST6_SIZE matches one tuple of test_6
+  for (const auto &index_name : {"btree_index", "hash_index"}) {
+    NestedIndexJoinPlanNode join_plan{out_schema,   {&scan_plan}, predicate, inner_info->oid_, index_name,
+                                      outer_schema, inner_schema};
+    std::vector<Tuple> result_set;
+    GetExecutionEngine()->Execute(&join_plan, &result_set, GetTxn(), GetExecutorContext());
+    ASSERT_EQ(result_set.size(), TEST6_SIZE);
+    for (size_t i = 0; i < result_set.size(); i++) {
+      const auto &tuple = result_set[i];
+      // The output keeps the order of the outer tuples
+      ASSERT_EQ(tuple.GetValue(out_schema, out_schema->GetColIdx("outer_colA")).GetAs<int32_t>(), i);
+      ASSERT_EQ(tuple.GetValue(out_schema, out_schema->GetColIdx("inner_colA")).GetAs<int64_t>(), i);
+      ASSERT_EQ(tuple.GetValue(out_schema, out_schema->GetColIdx("inner_colB")).GetAs<int32_t>(), i);
+    }
+  }
+}
+
+// SELECT wide.a, test_1.colA FROM wide JOIN test_1 ON wide.a = test_1.colA;
+// The BIGINT outer keys probe an INTEGER index, keys outside the INTEGER range match nothing
+TEST_F(ExecutorTest, NestedIndexJoinOutOfRangeKeysTest) {
+  auto wide_schema = ParseCreateStatement("a bigint");
+  auto *wide_info = GetExecutorContext()->GetCatalog()->CreateTable(GetTxn(), "wide", *wide_schema);
+  const std::vector<int64_t> outer_keys{-(int64_t{1} << 40), 5, int64_t{1} << 40, 7, INT64_MAX};
+  for (auto key : outer_keys) {
+    RID rid;
+    ASSERT_TRUE(wide_info->table_->InsertTuple(Tuple{{ValueFactory::GetBigIntValue(key)}, &wide_info->schema_}, &rid,
+                                               GetTxn()));
+  }
+  auto *wide_col_a = MakeColumnValueExpression(wide_info->schema_, 0, "a");
+  const Schema *outer_schema = MakeOutputSchema({{"a", wide_col_a}});
+  SeqScanPlanNode scan_plan{outer_schema, nullptr, wide_info->oid_};
+
+  auto *inner_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  const Schema *inner_schema = &inner_info->schema_;
+  auto key_schema = ParseCreateStatement("a integer");
+  GetExecutorContext()->GetCatalog()->CreateIndex<KeyType, ValueType, ComparatorType>(
+      GetTxn(), "btree_index", "test_1", *inner_schema, *key_schema, {0}, 8, HashFunctionType{},
+      IndexType::BPLUS_TREE);
+  GetExecutorContext()->GetCatalog()->CreateIndex<KeyType, ValueType, ComparatorType>(
+      GetTxn(), "hash_index", "test_1", *inner_schema, *key_schema, {0}, 8, HashFunctionType{});
+
+  auto *outer_col_a = MakeColumnValueExpression(*outer_schema, 0, "a");
+  auto *inner_col_a = MakeColumnValueExpression(*inner_schema, 1, "colA");
+  const Schema *out_schema = MakeOutputSchema({{"outer_a", outer_col_a}, {"inner_colA", inner_col_a}});
+  auto *predicate = MakeComparisonExpression(outer_col_a, inner_col_a, ComparisonType::Equal);
+
+  for (const auto &index_name : {"btree_index", "hash_index"}) {
+    NestedIndexJoinPlanNode join_plan{out_schema,   {&scan_plan}, predicate, inner_info->oid_, index_name,
+                                      outer_schema, inner_schema};
+    std::vector<Tuple> result_set;
+    GetExecutionEngine()->Execute(&join_plan, &result_set, GetTxn(), GetExecutorContext());
+    ASSERT_EQ(result_set.size(), 2);
+    ASSERT_EQ(result_set[0].GetValue(out_schema, 0).GetAs<int64_t>(), 5);
+    ASSERT_EQ(result_set[0].GetValue(out_schema, 1).GetAs<int32_t>(), 5);
+    ASSERT_EQ(result_set[1].GetValue(out_schema, 0).GetAs<int64_t>(), 7);
+    ASSERT_EQ(result_set[1].GetValue(out_schema, 1).GetAs<int32_t>(), 7);
+  }
+}
+
+// Pulling tuples a batch at a time must produce what pulling them one at a time produces
+TEST_F(ExecutorTest, BatchInterfaceTest) {
+  auto *table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  auto &schema = table_info->schema_;
+  auto *col_a = MakeColumnValueExpression(schema, 0, "colA");
+  auto *col_b = MakeColumnValueExpression(schema, 0, "colB");
+  auto *scan_schema = MakeOutputSchema({{"colA", col_a}, {"colB", col_b}});
+  auto *predicate = MakeComparisonExpression(col_a, MakeConstantValueExpression(ValueFactory::GetIntegerValue(500)),
+                                             ComparisonType::LessThan);
+  SeqScanPlanNode scan_plan{scan_schema, predicate, table_info->oid_};
+  LimitPlanNode limit_plan{scan_schema, &scan_plan, 37};
+
+  auto *scan_col_b = MakeColumnValueExpression(*scan_schema, 0, "colB");
+  const AbstractExpression *count_a = MakeAggregateValueExpression(false, 0);
+  auto *agg_schema = MakeOutputSchema({{"countA", count_a}, {"colB", MakeAggregateValueExpression(true, 0)}});
+  AggregationPlanNode agg_plan{agg_schema,
+                               &scan_plan,
+                               nullptr,
+                               {scan_col_b},
+                               {MakeColumnValueExpression(*scan_schema, 0, "colA")},
+                               {AggregationType::CountAggregate}};
+  // Distinct has no native batch implementation, it goes through the adapter
+  DistinctPlanNode distinct_plan{scan_schema, &scan_plan};
+
+  auto run_next = [&](const AbstractPlanNode *plan) {
+    auto executor = ExecutorFactory::CreateExecutor(GetExecutorContext(), plan);
+    executor->Init();
+    std::vector<std::string> result;
+    Tuple tuple;
+    RID rid;
+    while (executor->Next(&tuple, &rid)) {
+      result.push_back(tuple.ToString(plan->OutputSchema()));
+    }
+    return result;
+  };
+  auto run_batch = [&](const AbstractPlanNode *plan, size_t capacity) {
+    auto executor = ExecutorFactory::CreateExecutor(GetExecutorContext(), plan);
+    executor->Init();
+    std::vector<std::string> result;
+    TupleBatch batch(capacity);
+    while (executor->NextBatch(&batch)) {
+      EXPECT_LE(batch.Size(), capacity);
+      for (size_t i = 0; i < batch.Size(); i++) {
+        result.push_back(batch.TupleAt(i).ToString(plan->OutputSchema()));
+      }
+    }
+    return result;
+  };
+
+  for (const AbstractPlanNode *plan : {static_cast<const AbstractPlanNode *>(&scan_plan),
+                                       static_cast<const AbstractPlanNode *>(&limit_plan),
+                                       static_cast<const AbstractPlanNode *>(&agg_plan),
+                                       static_cast<const AbstractPlanNode *>(&distinct_plan)}) {
+    auto expected = run_next(plan);
+    ASSERT_FALSE(expected.empty());
+    EXPECT_EQ(expected, run_batch(plan, 7));
+    EXPECT_EQ(expected, run_batch(plan, TupleBatch::DEFAULT_CAPACITY));
+  }
+  EXPECT_EQ(500, run_next(&scan_plan).size());
+  EXPECT_EQ(37, run_batch(&limit_plan, 7).size());
+}
+
+// The columnar scan selects and projects the same rows as the row at a time scan
+TEST_F(ExecutorTest, ChunkInterfaceTest) {
+  auto *table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  auto &schema = table_info->schema_;
+  auto *col_a = MakeColumnValueExpression(schema, 0, "colA");
+  auto *col_b = MakeColumnValueExpression(schema, 0, "colB");
+  auto *const_5 = MakeConstantValueExpression(ValueFactory::GetIntegerValue(5));
+  // colB > 5 is computed by the expression instead of copied from the table
+  auto *b_gt_5 = MakeComparisonExpression(col_b, const_5, ComparisonType::GreaterThan);
+  auto *scan_schema = MakeOutputSchema({{"colB", col_b}, {"colA", col_a}, {"b_gt_5", b_gt_5}});
+  std::vector<const AbstractExpression *> predicates{
+      nullptr, MakeComparisonExpression(col_a, MakeConstantValueExpression(ValueFactory::GetIntegerValue(700)),
+                                        ComparisonType::GreaterThanOrEqual),
+      MakeComparisonExpression(const_5, col_b, ComparisonType::NotEqual),
+      MakeComparisonExpression(col_a, col_b, ComparisonType::LessThanOrEqual)};
+
+  for (const auto *predicate : predicates) {
+    SeqScanPlanNode scan_plan{scan_schema, predicate, table_info->oid_};
+    auto executor = ExecutorFactory::CreateExecutor(GetExecutorContext(), &scan_plan);
+    executor->Init();
+    std::vector<std::string> expected;
+    Tuple tuple;
+    RID rid;
+    while (executor->Next(&tuple, &rid)) {
+      expected.push_back(tuple.ToString(scan_schema));
+    }
+    ASSERT_FALSE(expected.empty());
+
+    for (size_t capacity : {size_t{64}, DataChunk::DEFAULT_CAPACITY}) {
+      executor->Init();
+      std::vector<std::string> result;
+      DataChunk chunk;
+      chunk.Initialize(scan_schema, capacity);
+      while (executor->NextChunk(&chunk)) {
+        const SelectionVector &sel = chunk.GetSelection();
+        ASSERT_FALSE(sel.IsEmpty());
+        for (size_t i = 0; i < sel.Size(); i++) {
+          result.push_back(chunk.GetTuple(sel[i]).ToString(scan_schema));
+        }
+      }
+      EXPECT_EQ(expected, result);
+    }
+  }
+}
+
 // SELECT COUNT(col_a), SUM(col_a), min(col_a), max(col_a) from test_1;
 TEST_F(ExecutorTest, SimpleAggregationTest) {
   const Schema *scan_schema;
@@ -609,6 +1230,43 @@ TEST_F(ExecutorTest, SimpleGroupByAggregation) {
   }
 }
 
+// SELECT colA, colB FROM test_1 ORDER BY colB, colA DESC;
+// Sorted in memory and in runs spilled to disk
+TEST_F(ExecutorTest, SimpleSortTest) {
+  auto *table_info = GetExecutorContext()->GetCatalog()->GetTable("test_1");
+  auto &schema = table_info->schema_;
+  auto *col_a = MakeColumnValueExpression(schema, 0, "colA");
+  auto *col_b = MakeColumnValueExpression(schema, 0, "colB");
+  auto *out_schema = MakeOutputSchema({{"colA", col_a}, {"colB", col_b}});
+  SeqScanPlanNode scan_plan{out_schema, nullptr, table_info->oid_};
+
+  std::vector<Tuple> scan_set;
+  GetExecutionEngine()->Execute(&scan_plan, &scan_set, GetTxn(), GetExecutorContext());
+  std::vector<std::pair<int32_t, int32_t>> expected;
+  for (const auto &tuple : scan_set) {
+    expected.emplace_back(tuple.GetValue(out_schema, 1).GetAs<int32_t>(),
+                          -tuple.GetValue(out_schema, 0).GetAs<int32_t>());
+  }
+  std::sort(expected.begin(), expected.end());
+
+  auto *sort_col_a = MakeColumnValueExpression(*out_schema, 0, "colA");
+  auto *sort_col_b = MakeColumnValueExpression(*out_schema, 0, "colB");
+  for (size_t memory_budget : {SortPlanNode::DEFAULT_MEMORY_BUDGET, static_cast<size_t>(4 * 1024)}) {
+    SortPlanNode sort_plan{out_schema,
+                           &scan_plan,
+                           {{OrderByType::ASC, sort_col_b}, {OrderByType::DESC, sort_col_a}},
+                           memory_budget};
+    std::vector<Tuple> result_set;
+    GetExecutionEngine()->Execute(&sort_plan, &result_set, GetTxn(), GetExecutorContext());
+    std::vector<std::pair<int32_t, int32_t>> result;
+    for (const auto &tuple : result_set) {
+      result.emplace_back(tuple.GetValue(out_schema, 1).GetAs<int32_t>(),
+                          -tuple.GetValue(out_schema, 0).GetAs<int32_t>());
+    }
+    ASSERT_EQ(expected, result);
+  }
+}
+
 // SELECT colA, colB FROM test_3 LIMIT 10
 TEST_F(ExecutorTest, SimpleLimitTest) {
   auto *table_info = GetExecutorContext()->GetCatalog()->GetTable("test_3");
@@ -674,4 +1332,30 @@ TEST_F(ExecutorTest, SimpleDistinctTest) {
   ASSERT_TRUE(std::equal(results.cbegin(), results.cend(), expected.cbegin()));
 }
 
+// SELECT DISTINCT a, b, c FROM t; where (NULL, 1) and (1, NULL) are distinct rows, and 0.0 and -0.0 are equal
+TEST_F(ExecutorTest, DistinctNullAndZeroTest) {
+  auto table_schema = ParseCreateStatement("a integer,b integer,c double");
+  auto *table_info = GetExecutorContext()->GetCatalog()->CreateTable(GetTxn(), "t", *table_schema);
+  Value null_integer = ValueFactory::GetNullValueByType(TypeId::INTEGER);
+  std::vector<std::vector<Value>> rows{
+      {null_integer, ValueFactory::GetIntegerValue(1), ValueFactory::GetDecimalValue(0.0)},
+      {ValueFactory::GetIntegerValue(1), null_integer, ValueFactory::GetDecimalValue(-0.0)},
+      {null_integer, ValueFactory::GetIntegerValue(1), ValueFactory::GetDecimalValue(-0.0)},
+      {ValueFactory::GetIntegerValue(1), null_integer, ValueFactory::GetDecimalValue(0.0)}};
+  for (const auto &row : rows) {
+    RID rid;
+    ASSERT_TRUE(table_info->table_->InsertTuple(Tuple{row, &table_info->schema_}, &rid, GetTxn()));
+  }
+  auto *out_schema = MakeOutputSchema({{"a", MakeColumnValueExpression(table_info->schema_, 0, "a")},
+                                       {"b", MakeColumnValueExpression(table_info->schema_, 0, "b")},
+                                       {"c", MakeColumnValueExpression(table_info->schema_, 0, "c")}});
+  SeqScanPlanNode scan_plan{out_schema, nullptr, table_info->oid_};
+  DistinctPlanNode distinct_plan{out_schema, &scan_plan};
+  std::vector<Tuple> result_set;
+  GetExecutionEngine()->Execute(&distinct_plan, &result_set, GetTxn(), GetExecutorContext());
+  ASSERT_EQ(result_set.size(), 2);
+  ASSERT_TRUE(result_set[0].GetValue(out_schema, 0).IsNull());
+  ASSERT_TRUE(result_set[1].GetValue(out_schema, 1).IsNull());
+}
+
 }  // namespace bustub
@@ -0,0 +1,218 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_compression_test.cpp
+//
+// Identification: test/storage/b_plus_tree_compression_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "gtest/gtest.h"
+#include "storage/index/b_plus_tree.h"
+#include "storage/page/header_page.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+namespace {
+
+using CompositeTree = BPlusTree<GenericKey<64>, RID, GenericComparator<64>>;
+using CompositeLeaf = BPlusTreeLeafPage<GenericKey<64>, RID, GenericComparator<64>>;
+using CompositeInternal = BPlusTreeInternalPage<GenericKey<64>, page_id_t, GenericComparator<64>>;
+
+/** A (customer, order) key, both columns share a long prefix with their neighbours */
+GenericKey<64> MakeCompositeKey(const Schema *key_schema, int customer, int order, int pad) {
+  char customer_name[32];
+  char order_name[32];
+  snprintf(customer_name, sizeof(customer_name), "customer#%06d", customer);
+  snprintf(order_name, sizeof(order_name), "order#%0*d", 5 + pad, order);
+  Tuple tuple({Value(TypeId::VARCHAR, customer_name), Value(TypeId::VARCHAR, order_name)}, key_schema);
+  GenericKey<64> key;
+  key.SetFromKey(tuple, key_schema);
+  return key;
+}
+
+struct TreeShape {
+  int height_{0};
+  int leaves_{0};
+  int leaf_entries_{0};
+  int internal_pages_{0};
+  int internal_entries_{0};
+};
+
+void WalkTree(BufferPoolManager *bpm, page_id_t page_id, int depth, TreeShape *shape) {
+  Page *page = bpm->FetchPage(page_id);
+  auto node = reinterpret_cast<BPlusTreePage *>(page->GetData());
+  shape->height_ = std::max(shape->height_, depth + 1);
+  if (node->IsLeafPage()) {
+    shape->leaves_++;
+    shape->leaf_entries_ += node->GetSize();
+  } else {
+    auto internal = reinterpret_cast<CompositeInternal *>(node);
+    shape->internal_pages_++;
+    shape->internal_entries_ += internal->GetSize();
+    for (int i = 0; i < internal->GetSize(); i++) {
+      WalkTree(bpm, internal->ValueAt(i), depth + 1, shape);
+    }
+  }
+  bpm->UnpinPage(page_id, false);
+}
+
+TreeShape GetTreeShape(BufferPoolManager *bpm, const std::string &name) {
+  auto header_page = reinterpret_cast<HeaderPage *>(bpm->FetchPage(HEADER_PAGE_ID)->GetData());
+  page_id_t root_page_id;
+  TreeShape shape;
+  if (header_page->GetRootId(name, &root_page_id)) {
+    WalkTree(bpm, root_page_id, 0, &shape);
+  }
+  bpm->UnpinPage(HEADER_PAGE_ID, false);
+  return shape;
+}
+
+}  // namespace
+
+// Composite VARCHAR keys of varying length, so pages widen their layout, split early and merge by size
+TEST(BPlusTreeCompressionTest, CompositeVarcharTest) {
+  auto key_schema = ParseCreateStatement("a varchar(16),b varchar(16)");
+  GenericComparator<64> comparator(key_schema.get());
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  page_id_t page_id;
+  bpm->NewPage(&page_id);
+  CompositeTree tree("foo_pk", bpm, comparator, CompositeLeaf::MAX_ENTRIES, CompositeInternal::MAX_ENTRIES);
+
+  std::mt19937 rng(2021);
+  std::vector<GenericKey<64>> keys;
+  for (int customer = 0; customer < 60; customer++) {
+    for (int order = 0; order < 100; order++) {
+      keys.push_back(MakeCompositeKey(key_schema.get(), customer * 7919 % 100000, order, (customer + order) % 4));
+    }
+  }
+  std::vector<int> order(keys.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::shuffle(order.begin(), order.end(), rng);
+  for (int i : order) {
+    EXPECT_TRUE(tree.Insert(keys[i], RID(0, i)));
+  }
+  EXPECT_FALSE(tree.Insert(keys[order[0]], RID(0, 0)));
+
+  std::vector<RID> rids;
+  for (size_t i = 0; i < keys.size(); i++) {
+    rids.clear();
+    ASSERT_TRUE(tree.GetValue(keys[i], &rids));
+    ASSERT_EQ(1, rids.size());
+    EXPECT_EQ(i, rids[0].GetSlotNum());
+  }
+
+  std::vector<int> sorted(keys.size());
+  std::iota(sorted.begin(), sorted.end(), 0);
+  std::sort(sorted.begin(), sorted.end(), [&](int lhs, int rhs) { return comparator(keys[lhs], keys[rhs]) < 0; });
+  size_t position = 0;
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+    ASSERT_LT(position, sorted.size());
+    EXPECT_EQ(0, comparator((*iterator).first, keys[sorted[position]]));
+    EXPECT_EQ(sorted[position], (*iterator).second.GetSlotNum());
+    position++;
+  }
+  EXPECT_EQ(keys.size(), position);
+
+  // Remove every other key in a random order, then the rest
+  for (size_t i = 0; i < order.size(); i += 2) {
+    tree.Remove(keys[order[i]]);
+  }
+  for (size_t i = 0; i < order.size(); i++) {
+    rids.clear();
+    EXPECT_EQ(i % 2 == 1, tree.GetValue(keys[order[i]], &rids));
+  }
+  position = 0;
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+    position++;
+  }
+  EXPECT_EQ(order.size() / 2, position);
+  for (size_t i = 1; i < order.size(); i += 2) {
+    tree.Remove(keys[order[i]]);
+  }
+  EXPECT_TRUE(tree.IsEmpty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete bpm;
+  delete disk_manager;
+  remove("test.db");
+  remove("test.log");
+}
+
+// Fanout and point lookup latency with pages capped at the uncompressed capacity versus compressed pages
+TEST(BPlusTreeCompressionTest, DISABLED_BenchmarkTest) {
+  auto key_schema = ParseCreateStatement("a varchar(16),b varchar(16)");
+  GenericComparator<64> comparator(key_schema.get());
+
+  std::mt19937 rng(2021);
+  std::vector<GenericKey<64>> keys;
+  for (int customer = 0; customer < 1000; customer++) {
+    for (int order = 0; order < 100; order++) {
+      keys.push_back(MakeCompositeKey(key_schema.get(), customer, order, 0));
+    }
+  }
+  std::shuffle(keys.begin(), keys.end(), rng);
+  const int num_lookups = 20000;
+  std::vector<GenericKey<64>> probes;
+  std::uniform_int_distribution<size_t> pick(0, keys.size() - 1);
+  for (int i = 0; i < num_lookups; i++) {
+    probes.push_back(keys[pick(rng)]);
+  }
+
+  struct Config {
+    const char *name_;
+    int leaf_max_size_;
+    int internal_max_size_;
+  };
+  const int leaf_capacity = (PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / sizeof(std::pair<GenericKey<64>, RID>);
+  const int internal_capacity = (PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / sizeof(std::pair<GenericKey<64>, page_id_t>);
+  const std::vector<Config> configs{{"uncompressed capacity", leaf_capacity, internal_capacity - 1},
+                                    {"compressed", CompositeLeaf::MAX_ENTRIES, CompositeInternal::MAX_ENTRIES}};
+  for (const auto &config : configs) {
+    DiskManager *disk_manager = new DiskManager("test.db");
+    BufferPoolManager *bpm = new BufferPoolManagerInstance(4096, disk_manager);
+    page_id_t page_id;
+    bpm->NewPage(&page_id);
+    bpm->UnpinPage(HEADER_PAGE_ID, true);
+    CompositeTree tree("foo_pk", bpm, comparator, config.leaf_max_size_, config.internal_max_size_);
+    for (size_t i = 0; i < keys.size(); i++) {
+      tree.Insert(keys[i], RID(0, i));
+    }
+    TreeShape shape = GetTreeShape(bpm, "foo_pk");
+
+    std::vector<RID> rids;
+    auto start = std::chrono::steady_clock::now();
+    for (const auto &probe : probes) {
+      rids.clear();
+      tree.GetValue(probe, &rids);
+    }
+    auto lookup_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    printf("%-22s: height %d, %5d leaves, %6.1f entries/leaf, %4d internal pages, fanout %6.1f, %7.1f ns/lookup\n",
+           config.name_, shape.height_, shape.leaves_, static_cast<double>(shape.leaf_entries_) / shape.leaves_,
+           shape.internal_pages_, static_cast<double>(shape.internal_entries_) / shape.internal_pages_,
+           lookup_ns / num_lookups);
+
+    delete bpm;
+    delete disk_manager;
+    remove("test.db");
+    remove("test.log");
+  }
+}
+
+}  // namespace bustub
@@ -100,7 +100,7 @@ void DeleteHelperSplit(BPlusTree<GenericKey<8>, RID, GenericComparator<8>> *tree
   delete transaction;
 }
 
-TEST(BPlusTreeConcurrentTest, DISABLED_InsertTest1) {
+TEST(BPlusTreeConcurrentTest, InsertTest1) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -152,7 +152,7 @@ TEST(BPlusTreeConcurrentTest, DISABLED_InsertTest1) {
   remove("test.log");
 }
 
-TEST(BPlusTreeConcurrentTest, DISABLED_InsertTest2) {
+TEST(BPlusTreeConcurrentTest, InsertTest2) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -203,7 +203,7 @@ TEST(BPlusTreeConcurrentTest, DISABLED_InsertTest2) {
   remove("test.log");
 }
 
-TEST(BPlusTreeConcurrentTest, DISABLED_DeleteTest1) {
+TEST(BPlusTreeConcurrentTest, DeleteTest1) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -245,7 +245,7 @@ TEST(BPlusTreeConcurrentTest, DISABLED_DeleteTest1) {
   remove("test.log");
 }
 
-TEST(BPlusTreeConcurrentTest, DISABLED_DeleteTest2) {
+TEST(BPlusTreeConcurrentTest, DeleteTest2) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -288,7 +288,7 @@ TEST(BPlusTreeConcurrentTest, DISABLED_DeleteTest2) {
   remove("test.log");
 }
 
-TEST(BPlusTreeConcurrentTest, DISABLED_MixTest) {
+TEST(BPlusTreeConcurrentTest, MixTest) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -333,4 +333,298 @@ TEST(BPlusTreeConcurrentTest, DISABLED_MixTest) {
   remove("test.log");
 }
 
+// helper function to look up every key and count the hits
+int64_t LookupHelper(BPlusTree<GenericKey<8>, RID, GenericComparator<8>> *tree, const std::vector<int64_t> &keys) {
+  GenericKey<8> index_key;
+  std::vector<RID> rids;
+  int64_t found = 0;
+  for (auto key : keys) {
+    rids.clear();
+    index_key.SetFromInteger(key);
+    if (tree->GetValue(index_key, &rids)) {
+      EXPECT_EQ(rids.size(), 1);
+      EXPECT_EQ(rids[0].GetSlotNum(), key & 0xFFFFFFFF);
+      found++;
+    }
+  }
+  return found;
+}
+
+TEST(BPlusTreeConcurrentTest, LatchModeTest) {
+  for (auto mode : {BPlusTreeLatchMode::PESSIMISTIC, BPlusTreeLatchMode::OPTIMISTIC, BPlusTreeLatchMode::OLC}) {
+    auto key_schema = ParseCreateStatement("a bigint");
+    GenericComparator<8> comparator(key_schema.get());
+
+    DiskManager *disk_manager = new DiskManager("test.db");
+    BufferPoolManager *bpm = new BufferPoolManagerInstance(256, disk_manager);
+    // 很小的节点, 让分裂和合并频繁地传播到根节点
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 4, 4, mode);
+
+    page_id_t page_id;
+    auto header_page = bpm->NewPage(&page_id);
+    (void)header_page;
+
+    const int64_t total = 2000;
+    const int num_threads = 8;
+    std::vector<int64_t> keys;
+    for (int64_t key = 1; key <= total; key++) {
+      keys.push_back(key);
+    }
+    LaunchParallelTest(num_threads, InsertHelperSplit, &tree, keys, num_threads);
+    EXPECT_EQ(LookupHelper(&tree, keys), total);
+
+    // 并发地删除偶数, 同时读取奇数
+    std::vector<int64_t> even_keys;
+    std::vector<int64_t> odd_keys;
+    for (auto key : keys) {
+      (key % 2 == 0 ? even_keys : odd_keys).push_back(key);
+    }
+    std::thread reader([&] {
+      for (int i = 0; i < 4; i++) {
+        EXPECT_EQ(LookupHelper(&tree, odd_keys), static_cast<int64_t>(odd_keys.size()));
+      }
+    });
+    LaunchParallelTest(num_threads, DeleteHelperSplit, &tree, even_keys, num_threads);
+    reader.join();
+    EXPECT_EQ(LookupHelper(&tree, even_keys), 0);
+    EXPECT_EQ(LookupHelper(&tree, odd_keys), static_cast<int64_t>(odd_keys.size()));
+
+    // 全部删除后树为空, 并且可以重新插入
+    LaunchParallelTest(num_threads, DeleteHelperSplit, &tree, odd_keys, num_threads);
+    EXPECT_TRUE(tree.IsEmpty());
+    InsertHelper(&tree, odd_keys);
+    EXPECT_EQ(LookupHelper(&tree, odd_keys), static_cast<int64_t>(odd_keys.size()));
+
+    bpm->UnpinPage(HEADER_PAGE_ID, true);
+    delete disk_manager;
+    delete bpm;
+    remove("test.db");
+    remove("test.log");
+  }
+}
+
+TEST(BPlusTreeConcurrentTest, ScanWhileWriteTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(256, disk_manager);
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 4, 4);
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  // 4 的倍数在扫描期间一直存在, 其余的键被并发地插入和删除
+  const int64_t total = 2000;
+  std::vector<int64_t> stable_keys;
+  std::vector<int64_t> churn_keys;
+  for (int64_t key = 0; key < total; key++) {
+    (key % 4 == 0 ? stable_keys : churn_keys).push_back(key);
+  }
+  InsertHelper(&tree, stable_keys);
+
+  std::thread writer([&] {
+    for (int round = 0; round < 3; round++) {
+      InsertHelper(&tree, churn_keys);
+      DeleteHelper(&tree, churn_keys);
+    }
+  });
+  // 扫描不是快照, 但迭代器在叶子之间使用锁耦合, 一直存在的键既不会被跳过也不会重复
+  auto scan = [&] {
+    int64_t prev = -1;
+    size_t stable_seen = 0;
+    for (auto iter = tree.Begin(); !iter.IsEnd(); ++iter) {
+      int64_t key = (*iter).second.GetSlotNum();
+      EXPECT_GT(key, prev);
+      prev = key;
+      stable_seen += key % 4 == 0 ? 1 : 0;
+    }
+    return stable_seen;
+  };
+  for (int round = 0; round < 5; round++) {
+    EXPECT_EQ(scan(), stable_keys.size());
+  }
+  writer.join();
+  EXPECT_EQ(scan(), stable_keys.size());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+TEST(BPlusTreeConcurrentTest, RangeWhileWriteTest) {
+  for (auto mode : {BPlusTreeLatchMode::PESSIMISTIC, BPlusTreeLatchMode::OPTIMISTIC, BPlusTreeLatchMode::OLC}) {
+    auto key_schema = ParseCreateStatement("a bigint");
+    GenericComparator<8> comparator(key_schema.get());
+
+    DiskManager *disk_manager = new DiskManager("test.db");
+    BufferPoolManager *bpm = new BufferPoolManagerInstance(256, disk_manager);
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 4, 4, mode);
+    page_id_t page_id;
+    auto header_page = bpm->NewPage(&page_id);
+    (void)header_page;
+
+    // 偶数一直存在, 奇数被并发地插入和删除, 让范围经过的叶子不断分裂与合并
+    const int64_t total = 2000;
+    std::vector<int64_t> stable_keys;
+    std::vector<int64_t> churn_keys;
+    for (int64_t key = 0; key < total; key++) {
+      (key % 2 == 0 ? stable_keys : churn_keys).push_back(key);
+    }
+    InsertHelper(&tree, stable_keys);
+
+    std::thread writer([&] {
+      for (int round = 0; round < 3; round++) {
+        InsertHelper(&tree, churn_keys);
+        DeleteHelper(&tree, churn_keys);
+      }
+    });
+    // 每次探测 [low, low + 99], 结果有序且包含范围内的所有偶数
+    auto probe = [&](int64_t low) {
+      GenericKey<8> low_key;
+      GenericKey<8> high_key;
+      low_key.SetFromInteger(low);
+      high_key.SetFromInteger(low + 99);
+      std::vector<RID> rids;
+      tree.GetRange(low_key, high_key, &rids);
+      int64_t prev = low - 1;
+      size_t stable_seen = 0;
+      for (const auto &rid : rids) {
+        int64_t key = rid.GetSlotNum();
+        EXPECT_GT(key, prev);
+        EXPECT_LE(key, low + 99);
+        prev = key;
+        stable_seen += key % 2 == 0 ? 1 : 0;
+      }
+      EXPECT_EQ(stable_seen, 50);
+    };
+    for (int round = 0; round < 5; round++) {
+      for (int64_t low = 0; low + 100 <= total; low += 100) {
+        probe(low);
+      }
+    }
+    writer.join();
+    probe(total - 100);
+
+    bpm->UnpinPage(HEADER_PAGE_ID, true);
+    delete disk_manager;
+    delete bpm;
+    remove("test.db");
+    remove("test.log");
+  }
+}
+
+// Throughput of latch crabbing with and without optimistic descent. Each thread
+// owns a disjoint key range and runs a 50/50 mix of inserts and point lookups.
+TEST(BPlusTreeConcurrentTest, DISABLED_BenchmarkTest) {
+  const int64_t ops_per_thread = 4000;
+  for (auto mode : {BPlusTreeLatchMode::PESSIMISTIC, BPlusTreeLatchMode::OPTIMISTIC}) {
+    for (int num_threads : {1, 2, 4, 8, 16, 32}) {
+      auto key_schema = ParseCreateStatement("a bigint");
+      GenericComparator<8> comparator(key_schema.get());
+
+      DiskManager *disk_manager = new DiskManager("test.db");
+      BufferPoolManager *bpm = new BufferPoolManagerInstance(4096, disk_manager);
+      BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree(
+          "foo_pk", bpm, comparator, (PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / sizeof(std::pair<GenericKey<8>, RID>),
+          (PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / sizeof(std::pair<GenericKey<8>, page_id_t>), mode);
+      page_id_t page_id;
+      auto header_page = bpm->NewPage(&page_id);
+      (void)header_page;
+
+      auto worker = [&](uint64_t thread_itr) {
+        GenericKey<8> index_key;
+        RID rid;
+        std::vector<RID> rids;
+        for (int64_t i = 0; i < ops_per_thread; i++) {
+          int64_t key = static_cast<int64_t>(thread_itr) * ops_per_thread + i;
+          index_key.SetFromInteger(key);
+          if (i % 2 == 0) {
+            rid.Set(static_cast<int32_t>(key >> 32), key & 0xFFFFFFFF);
+            tree.Insert(index_key, rid);
+          } else {
+            rids.clear();
+            tree.GetValue(index_key, &rids);
+          }
+        }
+      };
+
+      auto start = std::chrono::steady_clock::now();
+      LaunchParallelTest(num_threads, worker);
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      printf("%-11s threads=%2d  %10.0f ops/s\n", mode == BPlusTreeLatchMode::OPTIMISTIC ? "optimistic" : "pessimistic",
+             num_threads, static_cast<double>(ops_per_thread) * num_threads / elapsed.count());
+
+      bpm->UnpinPage(HEADER_PAGE_ID, true);
+      delete disk_manager;
+      delete bpm;
+      remove("test.db");
+      remove("test.log");
+    }
+  }
+}
+
+// Read-heavy throughput: 95% point lookups of preloaded keys, 5% inserts of new
+// keys. Compares latch crabbing against lock-free OLC readers.
+TEST(BPlusTreeConcurrentTest, DISABLED_ReadHeavyBenchmarkTest) {
+  const int64_t preload = 20000;
+  const int64_t ops_per_thread = 4000;
+  const char *mode_names[] = {"pessimistic", "optimistic", "olc"};
+  for (auto mode : {BPlusTreeLatchMode::PESSIMISTIC, BPlusTreeLatchMode::OPTIMISTIC, BPlusTreeLatchMode::OLC}) {
+    for (int num_threads : {1, 2, 4, 8, 16, 32}) {
+      auto key_schema = ParseCreateStatement("a bigint");
+      GenericComparator<8> comparator(key_schema.get());
+
+      DiskManager *disk_manager = new DiskManager("test.db");
+      BufferPoolManager *bpm = new BufferPoolManagerInstance(4096, disk_manager);
+      BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree(
+          "foo_pk", bpm, comparator, (PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / sizeof(std::pair<GenericKey<8>, RID>),
+          (PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / sizeof(std::pair<GenericKey<8>, page_id_t>), mode);
+      page_id_t page_id;
+      auto header_page = bpm->NewPage(&page_id);
+      (void)header_page;
+
+      std::vector<int64_t> keys;
+      for (int64_t key = 0; key < preload; key++) {
+        keys.push_back(key);
+      }
+      InsertHelper(&tree, keys);
+
+      auto worker = [&](uint64_t thread_itr) {
+        GenericKey<8> index_key;
+        RID rid;
+        std::vector<RID> rids;
+        uint64_t seed = thread_itr * 0x9E3779B97F4A7C15ULL + 1;
+        for (int64_t i = 0; i < ops_per_thread; i++) {
+          seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+          if (i % 20 == 0) {
+            int64_t key = preload + static_cast<int64_t>(thread_itr) * ops_per_thread + i;
+            index_key.SetFromInteger(key);
+            rid.Set(static_cast<int32_t>(key >> 32), key & 0xFFFFFFFF);
+            tree.Insert(index_key, rid);
+          } else {
+            index_key.SetFromInteger(static_cast<int64_t>((seed >> 33) % preload));
+            rids.clear();
+            tree.GetValue(index_key, &rids);
+          }
+        }
+      };
+
+      auto start = std::chrono::steady_clock::now();
+      LaunchParallelTest(num_threads, worker);
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+      printf("%-11s threads=%2d  %10.0f ops/s\n", mode_names[static_cast<int>(mode)], num_threads,
+             static_cast<double>(ops_per_thread) * num_threads / elapsed.count());
+
+      bpm->UnpinPage(HEADER_PAGE_ID, true);
+      delete disk_manager;
+      delete bpm;
+      remove("test.db");
+      remove("test.log");
+    }
+  }
+}
+
 }  // namespace bustub
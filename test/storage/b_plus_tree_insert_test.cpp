@@ -11,16 +11,24 @@
 //===----------------------------------------------------------------------===//
 
 #include <algorithm>
+#include <chrono>  // NOLINT
 #include <cstdio>
+#include <functional>
+#include <random>
+#include <utility>
+#include <vector>
 
 #include "buffer/buffer_pool_manager_instance.h"
 #include "gtest/gtest.h"
 #include "storage/index/b_plus_tree.h"
+#include "storage/index/b_plus_tree_index.h"
+#include "storage/page/header_page.h"
 #include "test_util.h"  // NOLINT
+#include "type/value_factory.h"
 
 namespace bustub {
 
-TEST(BPlusTreeTests, DISABLED_InsertTest1) {
+TEST(BPlusTreeTests, InsertTest1) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -78,7 +86,7 @@ TEST(BPlusTreeTests, DISABLED_InsertTest1) {
   remove("test.log");
 }
 
-TEST(BPlusTreeTests, DISABLED_InsertTest2) {
+TEST(BPlusTreeTests, InsertTest2) {
   // create KeyComparator and index schema
   auto key_schema = ParseCreateStatement("a bigint");
   GenericComparator<8> comparator(key_schema.get());
@@ -145,4 +153,215 @@ TEST(BPlusTreeTests, DISABLED_InsertTest2) {
   remove("test.db");
   remove("test.log");
 }
+
+TEST(BPlusTreeTests, BulkLoadTest) {
+  for (double fill_factor : {1.0, 0.5}) {
+    auto key_schema = ParseCreateStatement("a bigint");
+    GenericComparator<8> comparator(key_schema.get());
+
+    DiskManager *disk_manager = new DiskManager("test.db");
+    BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 5, 5);
+    GenericKey<8> index_key;
+    RID rid;
+
+    page_id_t page_id;
+    auto header_page = bpm->NewPage(&page_id);
+    (void)header_page;
+
+    // 乱序输入, 并且包含一个重复的键
+    const int64_t total = 1000;
+    std::vector<std::pair<GenericKey<8>, RID>> entries;
+    for (int64_t key = 1; key <= total; key++) {
+      index_key.SetFromInteger(key);
+      rid.Set(static_cast<int32_t>(key >> 32), key & 0xFFFFFFFF);
+      entries.emplace_back(index_key, rid);
+    }
+    std::shuffle(entries.begin(), entries.end(), std::mt19937(0));
+    index_key.SetFromInteger(1);
+    entries.emplace_back(index_key, RID(-1, 0));
+
+    int writes_before = disk_manager->GetNumWrites();
+    EXPECT_TRUE(tree.BulkLoad(entries, fill_factor));
+    // 每个页面只写一次: 写入次数等于新分配的页面数
+    page_id_t next_page_id;
+    bpm->NewPage(&next_page_id);
+    bpm->UnpinPage(next_page_id, false);
+    EXPECT_EQ(disk_manager->GetNumWrites() - writes_before, next_page_id - 1);
+    EXPECT_FALSE(tree.BulkLoad(entries, fill_factor));
+
+    std::vector<RID> rids;
+    for (int64_t key = 1; key <= total; key++) {
+      rids.clear();
+      index_key.SetFromInteger(key);
+      EXPECT_TRUE(tree.GetValue(index_key, &rids));
+      ASSERT_EQ(rids.size(), 1);
+      EXPECT_EQ(rids[0].GetSlotNum(), key);
+    }
+
+    // 批量加载的树仍然可以正常插入和删除
+    for (int64_t key = total + 1; key <= total * 2; key++) {
+      index_key.SetFromInteger(key);
+      rid.Set(0, key);
+      EXPECT_TRUE(tree.Insert(index_key, rid));
+    }
+    for (int64_t key = 1; key <= total * 2; key += 2) {
+      index_key.SetFromInteger(key);
+      tree.Remove(index_key);
+    }
+    for (int64_t key = 1; key <= total * 2; key++) {
+      rids.clear();
+      index_key.SetFromInteger(key);
+      EXPECT_EQ(tree.GetValue(index_key, &rids), key % 2 == 0);
+    }
+
+    bpm->UnpinPage(HEADER_PAGE_ID, true);
+    delete disk_manager;
+    delete bpm;
+    remove("test.db");
+    remove("test.log");
+  }
+}
+
+TEST(BPlusTreeTests, BulkLoadNodeSizeTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  using InternalPage = BPlusTreeInternalPage<GenericKey<8>, page_id_t, GenericComparator<8>>;
+
+  // 项数只比节点容量多一点时最容易出现不足半满的节点
+  for (double fill_factor : {1.0, 0.5}) {
+    for (int64_t total = 1; total <= 500; total += 7) {
+      DiskManager *disk_manager = new DiskManager("test.db");
+      BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+      page_id_t page_id;
+      auto header_page = reinterpret_cast<HeaderPage *>(bpm->NewPage(&page_id)->GetData());
+      BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 20, 6);
+
+      std::vector<std::pair<GenericKey<8>, RID>> entries;
+      GenericKey<8> index_key;
+      for (int64_t key = 0; key < total; key++) {
+        index_key.SetFromInteger(key);
+        entries.emplace_back(index_key, RID(0, key));
+      }
+      ASSERT_TRUE(tree.BulkLoad(entries, fill_factor));
+
+      // 除根节点外, 每个节点的大小都在 [min_size, max_size] 之内
+      int64_t leaf_entries = 0;
+      std::function<void(page_id_t)> check = [&](page_id_t id) {
+        auto node = reinterpret_cast<BPlusTreePage *>(bpm->FetchPage(id)->GetData());
+        if (!node->IsRootPage()) {
+          EXPECT_GE(node->GetSize(), node->GetMinSize()) << "total " << total << " fill factor " << fill_factor;
+        }
+        if (node->IsLeafPage()) {
+          EXPECT_LT(node->GetSize(), node->GetMaxSize());
+          leaf_entries += node->GetSize();
+        } else {
+          EXPECT_LE(node->GetSize(), node->GetMaxSize());
+          auto internal = reinterpret_cast<InternalPage *>(node);
+          for (int i = 0; i < internal->GetSize(); i++) {
+            check(internal->ValueAt(i));
+          }
+        }
+        bpm->UnpinPage(id, false);
+      };
+      page_id_t root_page_id;
+      ASSERT_TRUE(header_page->GetRootId("foo_pk", &root_page_id));
+      check(root_page_id);
+      EXPECT_EQ(leaf_entries, total);
+
+      bpm->UnpinPage(HEADER_PAGE_ID, true);
+      delete disk_manager;
+      delete bpm;
+      remove("test.db");
+      remove("test.log");
+    }
+  }
+}
+
+TEST(BPlusTreeTests, ScanRangeTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  DiskManager *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+
+  auto metadata = std::make_unique<IndexMetadata>("foo_pk", "foo", key_schema.get(), std::vector<uint32_t>{0});
+  BPlusTreeIndex<GenericKey<8>, RID, GenericComparator<8>> index(std::move(metadata), bpm);
+  auto make_key = [&](int64_t key) { return Tuple({ValueFactory::GetBigIntValue(key)}, key_schema.get()); };
+  // 只插入偶数, 范围的边界可以落在不存在的键上
+  for (int64_t key = 0; key < 1000; key += 2) {
+    index.InsertEntry(make_key(key), RID(0, key), nullptr);
+  }
+  EXPECT_TRUE(index.SupportsRangeScan());
+
+  auto scan = [&](const Tuple *low, const Tuple *high) {
+    std::vector<RID> rids;
+    index.ScanRange(low, high, &rids, nullptr);
+    std::vector<int64_t> keys;
+    for (const auto &rid : rids) {
+      keys.push_back(rid.GetSlotNum());
+    }
+    return keys;
+  };
+  Tuple low = make_key(101);
+  Tuple high = make_key(120);
+  EXPECT_EQ(scan(&low, &high), (std::vector<int64_t>{102, 104, 106, 108, 110, 112, 114, 116, 118, 120}));
+  low = make_key(990);
+  EXPECT_EQ(scan(&low, nullptr), (std::vector<int64_t>{990, 992, 994, 996, 998}));
+  high = make_key(4);
+  EXPECT_EQ(scan(nullptr, &high), (std::vector<int64_t>{0, 2, 4}));
+  EXPECT_EQ(scan(nullptr, nullptr).size(), 500);
+  low = make_key(2000);
+  EXPECT_TRUE(scan(&low, nullptr).empty());
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
+// Index build time: one insert per key versus a bottom-up bulk load of the same
+// shuffled keys.
+TEST(BPlusTreeTests, DISABLED_BulkLoadBenchmarkTest) {
+  const int64_t total = 200000;
+  for (bool bulk : {false, true}) {
+    auto key_schema = ParseCreateStatement("a bigint");
+    GenericComparator<8> comparator(key_schema.get());
+
+    DiskManager *disk_manager = new DiskManager("test.db");
+    BufferPoolManager *bpm = new BufferPoolManagerInstance(256, disk_manager);
+    BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator);
+    page_id_t page_id;
+    auto header_page = bpm->NewPage(&page_id);
+    (void)header_page;
+
+    GenericKey<8> index_key;
+    std::vector<std::pair<GenericKey<8>, RID>> entries;
+    for (int64_t key = 0; key < total; key++) {
+      index_key.SetFromInteger(key);
+      entries.emplace_back(index_key, RID(0, key));
+    }
+    std::shuffle(entries.begin(), entries.end(), std::mt19937(0));
+
+    auto start = std::chrono::steady_clock::now();
+    if (bulk) {
+      tree.BulkLoad(std::move(entries));
+    } else {
+      for (const auto &[key, value] : entries) {
+        tree.Insert(key, value);
+      }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    printf("%-7s %lld keys  %8.3f s  %d page writes\n", bulk ? "bulk" : "insert", static_cast<long long>(total),
+           elapsed.count(), disk_manager->GetNumWrites());
+
+    bpm->UnpinPage(HEADER_PAGE_ID, true);
+    delete disk_manager;
+    delete bpm;
+    remove("test.db");
+    remove("test.log");
+  }
+}
 }  // namespace bustub
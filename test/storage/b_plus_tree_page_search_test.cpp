@@ -0,0 +1,261 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// b_plus_tree_page_search_test.cpp
+//
+// Identification: test/storage/b_plus_tree_page_search_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/index/generic_key.h"
+#include "storage/page/b_plus_tree_internal_page.h"
+#include "storage/page/b_plus_tree_leaf_page.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+namespace {
+
+/** Encodes an integer key the way the key schema below stores it */
+template <size_t KeySize>
+GenericKey<KeySize> MakeKey(int64_t value) {
+  GenericKey<KeySize> key;
+  key.SetFromInteger(value);
+  return key;
+}
+
+/** Key schema of the benchmark for each key width, an INTEGER column only fits in a 4 byte key */
+template <size_t KeySize>
+std::string KeySchema() {
+  return KeySize == 4 ? "a integer" : "a bigint";
+}
+
+/** Sorted, distinct keys spread over negative and positive values */
+std::vector<int64_t> SortedKeys(size_t count, std::mt19937_64 *rng) {
+  std::uniform_int_distribution<int64_t> dist(-1000000, 1000000);
+  std::set<int64_t> keys;
+  while (keys.size() < count) {
+    keys.insert(dist(*rng));
+  }
+  return std::vector<int64_t>(keys.begin(), keys.end());
+}
+
+template <size_t KeySize>
+using Leaf = BPlusTreeLeafPage<GenericKey<KeySize>, RID, GenericComparator<KeySize>>;
+
+template <size_t KeySize>
+using Internal = BPlusTreeInternalPage<GenericKey<KeySize>, page_id_t, GenericComparator<KeySize>>;
+
+template <size_t KeySize>
+constexpr int LeafCapacity() {
+  return (PAGE_SIZE - LEAF_PAGE_HEADER_SIZE) / sizeof(std::pair<GenericKey<KeySize>, RID>);
+}
+
+template <size_t KeySize>
+constexpr int InternalCapacity() {
+  return (PAGE_SIZE - INTERNAL_PAGE_HEADER_SIZE) / sizeof(std::pair<GenericKey<KeySize>, page_id_t>);
+}
+
+/** Fills a leaf page with the given keys, the slot number of each RID is the key's position */
+template <size_t KeySize>
+Leaf<KeySize> *BuildLeaf(char *buffer, const std::vector<int64_t> &keys, const GenericComparator<KeySize> &comparator) {
+  auto *leaf = reinterpret_cast<Leaf<KeySize> *>(buffer);
+  leaf->Init(1, INVALID_PAGE_ID, LeafCapacity<KeySize>());
+  for (size_t i = 0; i < keys.size(); i++) {
+    leaf->Insert(MakeKey<KeySize>(keys[i]), RID(0, i), comparator);
+  }
+  return leaf;
+}
+
+/** Fills an internal page whose separators are keys[1..], child i is page i */
+template <size_t KeySize>
+Internal<KeySize> *BuildInternal(char *buffer, const std::vector<int64_t> &keys) {
+  auto *internal = reinterpret_cast<Internal<KeySize> *>(buffer);
+  internal->Init(1, INVALID_PAGE_ID, InternalCapacity<KeySize>());
+  for (size_t i = 0; i < keys.size(); i++) {
+    internal->AppendNode(MakeKey<KeySize>(keys[i]), static_cast<page_id_t>(i));
+  }
+  return internal;
+}
+
+/** The search every page did before the integer fast path, used as the reference */
+template <size_t KeySize>
+int GenericLowerBound(Leaf<KeySize> *leaf, const GenericKey<KeySize> &key,
+                      const GenericComparator<KeySize> &comparator) {
+  int left = 0;
+  int right = leaf->GetSize();
+  while (left < right) {
+    int mid = left + (right - left) / 2;
+    if (comparator.CompareColumns(leaf->KeyAt(mid), key) < 0) {
+      left = mid + 1;
+    } else {
+      right = mid;
+    }
+  }
+  return left;
+}
+
+template <size_t KeySize>
+void CheckPageSearch(std::mt19937_64 *rng) {
+  auto key_schema = ParseCreateStatement(KeySchema<KeySize>());
+  GenericComparator<KeySize> comparator(key_schema.get());
+  ASSERT_TRUE(comparator.HasIntegerFastPath());
+
+  alignas(8) char leaf_buffer[PAGE_SIZE];
+  alignas(8) char internal_buffer[PAGE_SIZE];
+  std::uniform_int_distribution<int64_t> probe_dist(-1100000, 1100000);
+
+  // Every page size from empty to full, so both the odd and even halving steps are covered
+  for (int size = 0; size <= LeafCapacity<KeySize>(); size += std::max(1, LeafCapacity<KeySize>() / 16)) {
+    auto keys = SortedKeys(size, rng);
+    auto *leaf = BuildLeaf<KeySize>(leaf_buffer, keys, comparator);
+    std::vector<int64_t> probes(keys.begin(), keys.end());
+    for (int i = 0; i < 64; i++) {
+      probes.push_back(probe_dist(*rng));
+    }
+    for (auto probe : probes) {
+      auto key = MakeKey<KeySize>(probe);
+      int expected = std::lower_bound(keys.begin(), keys.end(), probe) - keys.begin();
+      ASSERT_EQ(expected, leaf->KeyIndex(key, comparator)) << "width " << KeySize << " probe " << probe;
+      ASSERT_EQ(expected, GenericLowerBound<KeySize>(leaf, key, comparator));
+    }
+  }
+
+  for (int size = 1; size <= InternalCapacity<KeySize>(); size += std::max(1, InternalCapacity<KeySize>() / 16)) {
+    auto keys = SortedKeys(size, rng);
+    auto *internal = BuildInternal<KeySize>(internal_buffer, keys);
+    std::vector<int64_t> probes(keys.begin(), keys.end());
+    for (int i = 0; i < 64; i++) {
+      probes.push_back(probe_dist(*rng));
+    }
+    for (auto probe : probes) {
+      // The last separator not greater than the probe, the first key of the page is ignored
+      auto expected = std::upper_bound(keys.begin() + 1, keys.end(), probe) - keys.begin() - 1;
+      ASSERT_EQ(expected, internal->Lookup(MakeKey<KeySize>(probe), comparator))
+          << "width " << KeySize << " probe " << probe;
+    }
+  }
+}
+
+template <size_t KeySize>
+void BenchmarkPageSearch(std::mt19937_64 *rng) {
+  auto key_schema = ParseCreateStatement(KeySchema<KeySize>());
+  GenericComparator<KeySize> comparator(key_schema.get());
+  alignas(8) char leaf_buffer[PAGE_SIZE];
+
+  auto keys = SortedKeys(LeafCapacity<KeySize>(), rng);
+  auto *leaf = BuildLeaf<KeySize>(leaf_buffer, keys, comparator);
+  const int num_probes = 200000;
+  std::vector<GenericKey<KeySize>> probes;
+  std::uniform_int_distribution<size_t> pick(0, keys.size() - 1);
+  for (int i = 0; i < num_probes; i++) {
+    probes.push_back(MakeKey<KeySize>(keys[pick(*rng)]));
+  }
+
+  // 对同一批探测键分别测原先的逐列比较和整数快速路径
+  int64_t checksum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (const auto &probe : probes) {
+    checksum += GenericLowerBound<KeySize>(leaf, probe, comparator);
+  }
+  auto generic_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+  start = std::chrono::steady_clock::now();
+  for (const auto &probe : probes) {
+    checksum -= leaf->KeyIndex(probe, comparator);
+  }
+  auto fast_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  EXPECT_EQ(0, checksum);
+
+  printf("key width %2zu, %3d keys per leaf: generic %8.1f ns/search, fast path %6.1f ns/search, speedup %.1fx\n",
+         KeySize, leaf->GetSize(), generic_ns / num_probes, fast_ns / num_probes, generic_ns / fast_ns);
+}
+
+}  // namespace
+
+TEST(BPlusTreePageSearchTest, IntegerFastPathTest) {
+  std::mt19937_64 rng(2021);
+  CheckPageSearch<4>(&rng);
+  CheckPageSearch<8>(&rng);
+  CheckPageSearch<16>(&rng);
+  CheckPageSearch<32>(&rng);
+  CheckPageSearch<64>(&rng);
+}
+
+// Keys the fast path does not apply to still go through Value, and both paths agree on integer keys
+TEST(BPlusTreePageSearchTest, ComparatorTest) {
+  auto composite_schema = ParseCreateStatement("a integer,b integer");
+  GenericComparator<8> composite(composite_schema.get());
+  EXPECT_FALSE(composite.HasIntegerFastPath());
+
+  auto varchar_schema = ParseCreateStatement("a varchar(8)");
+  GenericComparator<16> varchar(varchar_schema.get());
+  EXPECT_FALSE(varchar.HasIntegerFastPath());
+
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+  GenericComparator<8> copy(comparator);
+  EXPECT_TRUE(copy.HasIntegerFastPath());
+  const std::vector<int64_t> values{INT64_MIN + 1, -300, -1, 0, 1, 255, 256, INT64_MAX};
+  for (auto lhs : values) {
+    for (auto rhs : values) {
+      auto lhs_key = MakeKey<8>(lhs);
+      auto rhs_key = MakeKey<8>(rhs);
+      EXPECT_EQ(comparator.CompareColumns(lhs_key, rhs_key), copy(lhs_key, rhs_key)) << lhs << " vs " << rhs;
+    }
+  }
+}
+
+// The (key, rid) entries of a BPlusTreeIndex keep the fast path, with the RID suffix ordering equal columns
+TEST(BPlusTreePageSearchTest, SuffixFastPathTest) {
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> no_room(key_schema.get(), true);
+  EXPECT_FALSE(no_room.HasIntegerFastPath());
+  GenericComparator<16> comparator(key_schema.get(), true);
+  ASSERT_TRUE(comparator.HasIntegerFastPath());
+
+  const std::vector<int64_t> values{INT64_MIN + 1, -1, 0, 1, INT64_MAX};
+  const std::vector<uint64_t> suffixes{0, 1, 0x00FF, 0x8000000000000000, UINT64_MAX};
+  std::vector<GenericKey<16>> keys;
+  for (auto value : values) {
+    for (auto suffix : suffixes) {
+      auto key = MakeKey<16>(value);
+      for (size_t i = 0; i < 8; i++) {
+        key.data_[8 + i] = static_cast<char>(suffix >> (8 * (7 - i)));
+      }
+      keys.push_back(key);
+    }
+  }
+  for (const auto &lhs : keys) {
+    for (const auto &rhs : keys) {
+      int expected = comparator(lhs, rhs);
+      auto lhs_int = comparator.IntegerKey(lhs);
+      auto rhs_int = comparator.IntegerKey(rhs);
+      EXPECT_EQ(expected < 0, lhs_int < rhs_int);
+      EXPECT_EQ(expected == 0, lhs_int == rhs_int);
+    }
+  }
+}
+
+TEST(BPlusTreePageSearchTest, DISABLED_BenchmarkTest) {
+  std::mt19937_64 rng(2021);
+  BenchmarkPageSearch<4>(&rng);
+  BenchmarkPageSearch<8>(&rng);
+  BenchmarkPageSearch<16>(&rng);
+  BenchmarkPageSearch<32>(&rng);
+  BenchmarkPageSearch<64>(&rng);
+}
+
+}  // namespace bustub
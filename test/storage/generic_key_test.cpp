@@ -0,0 +1,168 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// generic_key_test.cpp
+//
+// Identification: test/storage/generic_key_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "storage/index/generic_key.h"
+#include "test_util.h"  // NOLINT
+
+namespace bustub {
+
+namespace {
+
+/** A random non-NULL value of the given type, short strings so that prefixes of each other are common */
+Value RandomValue(TypeId type, std::mt19937_64 *rng) {
+  std::uniform_int_distribution<int64_t> dist(-1000, 1000);
+  switch (type) {
+    case TypeId::BOOLEAN:
+      return Value(type, static_cast<int8_t>(dist(*rng) & 1));
+    case TypeId::TINYINT:
+      return Value(type, static_cast<int8_t>(dist(*rng) % 100));
+    case TypeId::SMALLINT:
+      return Value(type, static_cast<int16_t>(dist(*rng) * 30));
+    case TypeId::INTEGER:
+      return Value(type, static_cast<int32_t>(dist(*rng) * 2000000));
+    case TypeId::BIGINT:
+      return Value(type, static_cast<int64_t>(dist(*rng) * 9000000000000000LL));
+    case TypeId::DECIMAL:
+      return Value(type, static_cast<double>(dist(*rng)) / 7);
+    case TypeId::VARCHAR: {
+      std::string str;
+      for (int64_t i = dist(*rng) & 3; i > 0; i--) {
+        str.push_back("ab\x7f\xe9"[dist(*rng) & 3]);
+      }
+      return Value(type, str);
+    }
+    default:
+      return Value(type);
+  }
+}
+
+/** Keys of random tuples over the schema, checks that every key decodes to the values it was built from */
+template <size_t KeySize>
+std::vector<GenericKey<KeySize>> RandomKeys(Schema *key_schema, size_t count, std::mt19937_64 *rng) {
+  std::vector<GenericKey<KeySize>> keys(count);
+  for (auto &key : keys) {
+    std::vector<Value> values;
+    for (const auto &column : key_schema->GetColumns()) {
+      values.push_back(RandomValue(column.GetType(), rng));
+    }
+    key.SetFromKey(Tuple(values, key_schema), key_schema);
+    for (uint32_t i = 0; i < values.size(); i++) {
+      EXPECT_EQ(CmpBool::CmpTrue, key.ToValue(key_schema, i).CompareEquals(values[i])) << values[i].ToString();
+    }
+  }
+  return keys;
+}
+
+/** The memcmp order of normalized keys must be the order of their values */
+template <size_t KeySize>
+void CheckOrder(Schema *key_schema, std::mt19937_64 *rng) {
+  GenericComparator<KeySize> comparator(key_schema);
+  auto keys = RandomKeys<KeySize>(key_schema, 200, rng);
+  for (const auto &lhs : keys) {
+    for (const auto &rhs : keys) {
+      ASSERT_EQ(comparator.CompareColumns(lhs, rhs), comparator(lhs, rhs)) << key_schema->ToString();
+    }
+  }
+}
+
+}  // namespace
+
+TEST(GenericKeyTest, SingleColumnOrderTest) {
+  std::mt19937_64 rng(2021);
+  // TIMESTAMP values cannot be built yet, the type has no Type instance registered
+  for (auto type :
+       {TypeId::BOOLEAN, TypeId::TINYINT, TypeId::SMALLINT, TypeId::INTEGER, TypeId::BIGINT, TypeId::DECIMAL}) {
+    Schema key_schema({Column("a", type)});
+    CheckOrder<8>(&key_schema, &rng);
+  }
+  Schema varchar_schema({Column("a", TypeId::VARCHAR, 8)});
+  CheckOrder<16>(&varchar_schema, &rng);
+}
+
+TEST(GenericKeyTest, CompositeOrderTest) {
+  std::mt19937_64 rng(2021);
+  auto key_schema = ParseCreateStatement("a varchar(4),b integer,c varchar(4),d double");
+  CheckOrder<32>(key_schema.get(), &rng);
+}
+
+// Zero bytes inside a varchar are escaped, so they sort after the end of the string
+TEST(GenericKeyTest, VarcharEscapeTest) {
+  Schema key_schema({Column("a", TypeId::VARCHAR, 8), Column("b", TypeId::INTEGER)});
+  GenericComparator<16> comparator(&key_schema);
+  GenericKey<16> shorter;
+  GenericKey<16> longer;
+  shorter.SetFromKey(Tuple({Value(TypeId::VARCHAR, "ab"), Value(TypeId::INTEGER, 7)}, &key_schema), &key_schema);
+  longer.SetFromKey(Tuple({Value(TypeId::VARCHAR, std::string("ab\0c", 4)), Value(TypeId::INTEGER, -7)}, &key_schema),
+                    &key_schema);
+  EXPECT_LT(comparator(shorter, longer), 0);
+  EXPECT_EQ(4, longer.ToValue(&key_schema, 0).GetLength() - 1);
+  EXPECT_EQ(-7, longer.ToValue(&key_schema, 1).GetAs<int32_t>());
+}
+
+// Separators are not valid keys, but they order between the two keys they separate
+TEST(GenericKeyTest, ShortestSeparatorTest) {
+  std::mt19937_64 rng(2021);
+  auto key_schema = ParseCreateStatement("a varchar(4),b bigint");
+  GenericComparator<32> comparator(key_schema.get());
+  auto keys = RandomKeys<32>(key_schema.get(), 200, &rng);
+  for (const auto &lhs : keys) {
+    for (const auto &rhs : keys) {
+      if (comparator(lhs, rhs) >= 0) {
+        continue;
+      }
+      auto separator = comparator.ShortestSeparator(lhs, rhs);
+      EXPECT_LT(comparator(lhs, separator), 0);
+      EXPECT_LE(comparator(separator, rhs), 0);
+    }
+  }
+}
+
+TEST(GenericKeyTest, DISABLED_BenchmarkTest) {
+  std::mt19937_64 rng(2021);
+  auto key_schema = ParseCreateStatement("a varchar(8),b integer,c double");
+  GenericComparator<32> comparator(key_schema.get());
+  auto keys = RandomKeys<32>(key_schema.get(), 1024, &rng);
+
+  const int num_compares = 2000000;
+  std::uniform_int_distribution<size_t> pick(0, keys.size() - 1);
+  std::vector<std::pair<size_t, size_t>> pairs;
+  for (int i = 0; i < num_compares; i++) {
+    pairs.emplace_back(pick(rng), pick(rng));
+  }
+
+  // 对同一批键分别测逐列通过 Value 比较和 memcmp 比较
+  int64_t checksum = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (const auto &[lhs, rhs] : pairs) {
+    checksum += comparator.CompareColumns(keys[lhs], keys[rhs]);
+  }
+  auto columns_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+  start = std::chrono::steady_clock::now();
+  for (const auto &[lhs, rhs] : pairs) {
+    checksum -= comparator(keys[lhs], keys[rhs]);
+  }
+  auto memcmp_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  EXPECT_EQ(0, checksum);
+
+  printf("(varchar, integer, double) keys: column by column %7.1f ns/compare, memcmp %5.1f ns/compare\n",
+         columns_ns / num_compares, memcmp_ns / num_compares);
+}
+
+}  // namespace bustub
@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <string>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -19,11 +20,7 @@
 namespace bustub {
 
 // NOLINTNEXTLINE
-TEST(TmpTuplePageTest, DISABLED_BasicTest) {
-  // There are many ways to do this assignment, and this is only one of them.
-  // If you don't like the TmpTuplePage idea, please feel free to delete this test case entirely.
-  // You will get full credit as long as you are correctly using a linear probe hash table.
-
+TEST(TmpTuplePageTest, BasicTest) {
   TmpTuplePage page{};
   page_id_t page_id = 15445;
   page.Init(page_id, PAGE_SIZE);
@@ -46,6 +43,50 @@ TEST(TmpTuplePageTest, DISABLED_BasicTest) {
   ASSERT_EQ(*reinterpret_cast<uint32_t *>(data + sizeof(page_id_t) + sizeof(lsn_t)), PAGE_SIZE - 8);
   ASSERT_EQ(*reinterpret_cast<uint32_t *>(data + PAGE_SIZE - 8), 4);
   ASSERT_EQ(*reinterpret_cast<uint32_t *>(data + PAGE_SIZE - 4), 123);
+  ASSERT_EQ(tmp_tuple, TmpTuple(page_id, PAGE_SIZE - 8));
+}
+
+// NOLINTNEXTLINE
+TEST(TmpTuplePageTest, FillAndReadTest) {
+  TmpTuplePage page{};
+  page_id_t page_id = 15445;
+  page.Init(page_id, PAGE_SIZE);
+
+  std::vector<Column> columns;
+  columns.emplace_back("A", TypeId::INTEGER);
+  columns.emplace_back("B", TypeId::VARCHAR, 64);
+  Schema schema(columns);
+
+  // Insert until the page is full; a tuple takes its size, an integer, a varchar offset and length
+  // and i % 50 + 1 bytes of varchar data
+  std::vector<TmpTuple> inserted;
+  std::vector<std::string> strings;
+  for (int32_t i = 0;; i++) {
+    strings.emplace_back(i % 50, 'a' + i % 26);
+    Tuple tuple({ValueFactory::GetIntegerValue(i), ValueFactory::GetVarcharValue(strings.back())}, &schema);
+    TmpTuple tmp_tuple(INVALID_PAGE_ID, 0);
+    if (!page.Insert(tuple, &tmp_tuple)) {
+      strings.pop_back();
+      break;
+    }
+    ASSERT_EQ(tmp_tuple.GetPageId(), page_id);
+    ASSERT_EQ(tmp_tuple.GetOffset(), page.GetFreeSpacePointer());
+    inserted.push_back(tmp_tuple);
+  }
+  ASSERT_GT(inserted.size(), 50);
+  ASSERT_LT(page.GetFreeSpacePointer(), 12 + 16 + 50 + 1);
+
+  // Tuples are read from the most recently inserted one to the end of the page
+  auto i = static_cast<int32_t>(inserted.size());
+  for (uint32_t offset = page.GetFreeSpacePointer(); offset < PAGE_SIZE;) {
+    i--;
+    ASSERT_EQ(offset, inserted[i].GetOffset());
+    Tuple tuple;
+    offset = page.Get(offset, &tuple);
+    ASSERT_EQ(tuple.GetValue(&schema, 0).GetAs<int32_t>(), i);
+    ASSERT_EQ(tuple.GetValue(&schema, 1).ToString(), strings[i]);
+  }
+  ASSERT_EQ(i, 0);
 }
 
 }  // namespace bustub
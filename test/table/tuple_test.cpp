@@ -21,8 +21,35 @@
 #include "logging/common.h"
 #include "storage/table/table_heap.h"
 #include "storage/table/tuple.h"
+#include "type/value_factory.h"
 
 namespace bustub {
+// A NULL VARCHAR takes only its length field in the tuple
+// NOLINTNEXTLINE
+TEST(TupleTest, NullVarcharTest) {
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::INTEGER};
+  Column col3{"c", TypeId::VARCHAR, 16};
+  std::vector<Column> cols{col1, col2, col3};
+  Schema schema{cols};
+  std::vector<Value> values{ValueFactory::GetNullValueByType(TypeId::VARCHAR), ValueFactory::GetIntegerValue(7),
+                            ValueFactory::GetVarcharValue("abc")};
+  Tuple tuple{values, &schema};
+
+  EXPECT_EQ(schema.GetLength() + 2 * sizeof(uint32_t) + values[2].GetLength(), tuple.GetLength());
+  EXPECT_TRUE(tuple.GetValue(&schema, 0).IsNull());
+  EXPECT_EQ(7, tuple.GetValue(&schema, 1).GetAs<int32_t>());
+  EXPECT_EQ("abc", tuple.GetValue(&schema, 2).ToString());
+
+  // The tuple survives a round trip through its serialized form
+  std::vector<char> storage(sizeof(uint32_t) + tuple.GetLength());
+  tuple.SerializeTo(storage.data());
+  Tuple copy;
+  copy.DeserializeFrom(storage.data());
+  EXPECT_TRUE(copy.GetValue(&schema, 0).IsNull());
+  EXPECT_EQ("abc", copy.GetValue(&schema, 2).ToString());
+}
+
 // NOLINTNEXTLINE
 TEST(TupleTest, DISABLED_TableHeapTest) {
   // test1: parse create sql statement